@@ -2,6 +2,96 @@ import React, { Component, createRef } from 'react';
 import { requireNativeComponent, View, UIManager, findNodeHandle, AppState, Platform } from 'react-native';
 import PropTypes from 'prop-types';
 
+// Native command ids reported by onCommandDone
+export const GstCommand = {
+    INIT: 0,
+    SET_URI: 1,
+    SET_DRAWABLE_SURFACE: 2,
+    SET_PIPELINE_STATE: 3,
+    SET_DEBUGGING: 4,
+    TERMINATE: 5,
+    PREPARE_URI: 6,
+    SET_STANDBY_POOL: 7,
+    SET_RECONNECT_POLICY: 8,
+    SET_SURFACE_SIZE: 9,
+    SET_STATS_REFRESH_RATE: 10,
+    SET_AUDIO_LEVEL_REFRESH_RATE: 11,
+    SUSPEND: 12,
+    RESUME: 13,
+    SET_QOS_POLICY: 14,
+    SET_JITTER_POLICY: 15,
+    SET_TRANSPORT_POLICY: 16,
+    SET_MOSAIC_LAYOUT: 17,
+    SET_MOSAIC_TILE: 18,
+    SET_DVR_POLICY: 19,
+    DVR_PLAY_FROM: 20,
+    DVR_EXPORT: 21,
+    SEEK: 22,
+    SET_RATE: 23,
+    SCRUB: 24,
+    SET_SCRUB_CACHE: 25,
+    SNAPSHOT: 26,
+    DUMP_GRAPH: 27,
+};
+
+// Latency histograms of onStats: bucket i counts latencies below 250 µs << i, the last one is open ended
+export const GST_STATS_FIRST_BUCKET_US = 250;
+
+// How a uri switch was applied, reported by onFirstFrame
+export const GstUriSwitchMode = {
+    SOURCE_ONLY: 0,
+    FULL_RESTART: 1,
+    STANDBY: 2,
+    RESUME: 3,
+    SHARED: 4,
+};
+
+// Jitterbuffer policy: FIXED keeps jitterMinLatency, ADAPTIVE moves between jitterMinLatency and
+// jitterMaxLatency (ms) and toggles retransmission to keep the loss rate under jitterTargetLoss
+export const GstJitterMode = {
+    FIXED: 0,
+    ADAPTIVE: 1,
+};
+
+// RTSP lower transport a session went through, reported by onFirstFrame. The transports prop lists
+// the ones to try in order by name, e.g. "udp,tcp" or "multicast,udp,tcp,http"
+export const GstTransport = {
+    UDP: 0,
+    MULTICAST: 1,
+    TCP: 2,
+    HTTP: 3,
+};
+
+// Degradation ladder under overload, reported by onQos and capped by qosMaxRung
+export const GstQosRung = {
+    NONE: 0,
+    DROP_LATE: 1,
+    SKIP_NON_REFERENCE: 2,
+    KEYFRAMES_ONLY: 3,
+    LOWER_RESOLUTION: 4,
+};
+
+// Container of the clips written by exportClip
+export const GstDvrFormat = {
+    MP4: 0,
+    TS: 1,
+};
+
+// Where seek lands on file and HTTP uris: ACCURATE on the position, KEYFRAME on the nearest keyframe (faster)
+export const GstSeekMode = {
+    ACCURATE: 0,
+    KEYFRAME: 1,
+};
+
+// Encoding of the stills taken by snapshot
+export const GstSnapshotFormat = {
+    JPEG: 0,
+    PNG: 1,
+};
+
+// A snapshot promise is rejected if its onSnapshot has not come by then
+const SNAPSHOT_TIMEOUT_MS = 10000;
+
 export const GstState = {
     VOID_PENDING: 0,
     NULL: 1,
@@ -14,6 +104,8 @@ class GstPlayer extends Component {
     currentGstState = undefined;
     appState = 'active';
     isInitialized = false;
+    snapshotId = 0;
+    pendingSnapshots = {};
 
     constructor(props) {
         super(props);
@@ -27,23 +119,29 @@ class GstPlayer extends Component {
 
     componentWillUnmount() {
         this.appStateListener.remove();
+        Object.keys(this.pendingSnapshots).forEach((id) => {
+            this.settleSnapshot(id).reject(new Error('Player unmounted before the snapshot was taken'));
+        });
     }
 
+    // The session survives backgrounding: decoding and rendering stop, the first frame is back right on resume
     appStateChanged = (nextAppState) => {
         if (this.appState.match(/inactive|background/) && nextAppState === 'active') {
             if (Platform.OS === 'ios') {
                 this.recreateView();
             }
-            this.play();
+            this.resume();
         } else {
-            this.stop();
+            this.suspend();
         }
         this.appState = nextAppState;
     };
 
-    onPlayerInit = () => {
+    // element_chain is the pipeline actually built, e.g. "rtspsrc ! rtph264depay ! h264parse ! avdec_h264 ! glimagesink"
+    onPlayerInit = (_message) => {
+        const { element_chain } = _message.nativeEvent;
         this.isInitialized = true;
-        if (this.props.onPlayerInit) this.props.onPlayerInit();
+        if (this.props.onPlayerInit) this.props.onPlayerInit(element_chain);
     };
 
     onStateChanged = (_message) => {
@@ -72,6 +170,65 @@ class GstPlayer extends Component {
         if (this.props.onElementError) this.props.onElementError(source, message, debug_info);
     };
 
+    onFirstFrame = (_message) => {
+        const { mode, ttff_us, transport } = _message.nativeEvent;
+        if (this.props.onFirstFrame) this.props.onFirstFrame(mode, ttff_us, transport);
+    };
+
+    onCommandDone = (_message) => {
+        const { command, result, latency_us } = _message.nativeEvent;
+        if (this.props.onCommandDone) this.props.onCommandDone(command, result, latency_us);
+    };
+
+    // Reconnect counters, sent when a restart gets scheduled and when the stream recovers
+    onReconnect = (_message) => {
+        if (this.props.onReconnect) this.props.onReconnect(_message.nativeEvent);
+    };
+
+    // Sent every statsRefreshRate ms: frame counters, bitrate, jitterbuffer loss, jitter, latency_ms and
+    // retransmission, and latencies.{network, depay, decode, render} as { count, sum_us, max_us, histogram }
+    onStats = (_message) => {
+        if (this.props.onStats) this.props.onStats(_message.nativeEvent);
+    };
+
+    // Sent every audioLevelRefreshRate ms: the latest { rms, peak, decay } in dB of the loudest channel,
+    // and every measurement taken since the previous event in levels, oldest first
+    onVolumeChanged = (_message) => {
+        if (this.props.onVolumeChanged) this.props.onVolumeChanged(_message.nativeEvent);
+    };
+
+    // Sent on every degradation ladder transition: { rung, rung_name, previous_rung, transitions,
+    // late_ratio, queue_fill, frames_dropped_late, frames_skipped }
+    onQos = (_message) => {
+        if (this.props.onQos) this.props.onQos(_message.nativeEvent);
+    };
+
+    // Sent once a clip export is over: { path, success, duration_us }
+    onDvrExport = (_message) => {
+        if (this.props.onDvrExport) this.props.onDvrExport(_message.nativeEvent);
+    };
+
+    // Sent when the first frame after a seek is displayed: { position_us, duration_us, latency_us }
+    onSeekDone = (_message) => {
+        if (this.props.onSeekDone) this.props.onSeekDone(_message.nativeEvent);
+    };
+
+    // Sent on scrub with the nearest cached thumbnail: { position_us, width, height, uri }, uri is a JPEG data uri
+    onScrubPreview = (_message) => {
+        if (this.props.onScrubPreview) this.props.onScrubPreview(_message.nativeEvent);
+    };
+
+    // Sent once per snapshot: { id, success, error, path, uri, width, height, position_us }
+    onSnapshot = (_message) => {
+        const snapshot = _message.nativeEvent;
+        const pending = this.settleSnapshot(snapshot.id);
+        if (pending) {
+            if (snapshot.success) pending.resolve(snapshot);
+            else pending.reject(new Error(snapshot.error));
+        }
+        if (this.props.onSnapshot) this.props.onSnapshot(snapshot);
+    };
+
     setGstState = (state) => {
         UIManager.dispatchViewManagerCommand(
             this.playerHandle,
@@ -92,6 +249,111 @@ class GstPlayer extends Component {
         this.setGstState(GstState.READY);
     };
 
+    suspend = () => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.suspend,
+            []
+        );
+    };
+
+    resume = () => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.resume,
+            []
+        );
+    };
+
+    // Opens a warm standby session so a later switch to uri is near instant
+    prepareUri = (uri) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.prepareUri,
+            [uri]
+        );
+    };
+
+    // Plays offsetMs behind live from the timeshift ring (dvrMaxDuration / dvrMaxBytes), 0 returns to live
+    timeshift = (offsetMs) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.timeshift,
+            [offsetMs]
+        );
+    };
+
+    // Writes durationMs of the ring starting offsetMs behind live (0 for up to live) to path, see onDvrExport
+    exportClip = (path, offsetMs, durationMs = 0, format = GstDvrFormat.MP4) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.exportClip,
+            [path, offsetMs, durationMs, format]
+        );
+    };
+
+    // File and HTTP uris only, see onSeekDone
+    seek = (positionMs, mode = GstSeekMode.ACCURATE) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.seek,
+            [positionMs, mode]
+        );
+    };
+
+    // Negative rates play backwards, fast and backwards rates only show keyframes
+    setRate = (rate) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.setRate,
+            [rate]
+        );
+    };
+
+    // Call on every move of a scrub bar: a thumbnail comes back through onScrubPreview when scrubCacheBytes
+    // is set, and the picture follows with keyframe seeks
+    scrub = (positionMs) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.scrub,
+            [positionMs]
+        );
+    };
+
+    // Still of the last displayed frame, fitted in maxSize pixels (0 keeps the frame size). Resolves with
+    // the onSnapshot event: the file written when path is set, otherwise a data uri of the image.
+    snapshot = ({ format = GstSnapshotFormat.JPEG, maxSize = 0, path = null } = {}) => {
+        const id = ++this.snapshotId;
+        return new Promise((resolve, reject) => {
+            const timer = setTimeout(() => {
+                this.settleSnapshot(id).reject(new Error('Snapshot timed out'));
+            }, SNAPSHOT_TIMEOUT_MS);
+            this.pendingSnapshots[id] = { resolve, reject, timer };
+            UIManager.dispatchViewManagerCommand(
+                this.playerHandle,
+                UIManager.RCTGstPlayer.Commands.snapshot,
+                [id, format, maxSize, path]
+            );
+        });
+    };
+
+    // Forgets a pending snapshot and returns it, undefined if it was already settled
+    settleSnapshot = (id) => {
+        const pending = this.pendingSnapshots[id];
+        delete this.pendingSnapshots[id];
+        if (pending) clearTimeout(pending.timer);
+        return pending;
+    };
+
+    // Writes the pipeline graph as a dot file to path, see onCommandDone
+    dumpGraph = (path) => {
+        UIManager.dispatchViewManagerCommand(
+            this.playerHandle,
+            UIManager.RCTGstPlayer.Commands.dumpGraph,
+            [path]
+        );
+    };
+
     recreateView = () => {
         UIManager.dispatchViewManagerCommand(
             this.playerHandle,
@@ -103,6 +365,7 @@ class GstPlayer extends Component {
     render() {
         return (
             <RCTGstPlayer
+                {...this.props}
                 autoPlay={this.props.autoPlay}
                 uri={this.props.uri || undefined}
                 isDebugging={this.props.isDebugging !== undefined ? this.props.isDebugging : false}
@@ -111,8 +374,17 @@ class GstPlayer extends Component {
                 onUriChanged={this.onUriChanged}
                 onEOS={this.onEOS}
                 onElementError={this.onElementError}
+                onFirstFrame={this.onFirstFrame}
+                onCommandDone={this.onCommandDone}
+                onReconnect={this.onReconnect}
+                onStats={this.onStats}
+                onVolumeChanged={this.onVolumeChanged}
+                onQos={this.onQos}
+                onDvrExport={this.onDvrExport}
+                onSeekDone={this.onSeekDone}
+                onScrubPreview={this.onScrubPreview}
+                onSnapshot={this.onSnapshot}
                 ref={this.playerViewRef}
-                {...this.props}
             />
         );
     }
@@ -122,15 +394,65 @@ GstPlayer.propTypes = {
     uri: PropTypes.string.isRequired,
     autoPlay: PropTypes.bool,
     isDebugging: PropTypes.bool,
+    standbyPoolSize: PropTypes.number,
+    standbyGopBudget: PropTypes.number,
+    reconnectInitialDelay: PropTypes.number,
+    reconnectMaxDelay: PropTypes.number,
+    reconnectJitter: PropTypes.number,
+    stallTimeout: PropTypes.number,
+    statsRefreshRate: PropTypes.number,
+    audioLevelRefreshRate: PropTypes.number,
+    qosMaxRung: PropTypes.number,
+    jitterMode: PropTypes.number,
+    jitterMinLatency: PropTypes.number,
+    jitterMaxLatency: PropTypes.number,
+    jitterTargetLoss: PropTypes.number,
+    // Shared decode and mosaic tiles only decode H.264, other codecs end in onElementError
+    sharedDecode: PropTypes.bool,
+    transports: PropTypes.string,
+    transportTimeout: PropTypes.number,
+    rememberTransport: PropTypes.bool,
+    // H.264 only, like sharedDecode
+    mosaicColumns: PropTypes.number,
+    mosaicRows: PropTypes.number,
+    mosaicUris: PropTypes.arrayOf(PropTypes.string),
+    dvrMaxDuration: PropTypes.number,
+    dvrMaxBytes: PropTypes.number,
+    scrubCacheBytes: PropTypes.number,
+    scrubThumbnailWidth: PropTypes.number,
+    qosMaxLateness: PropTypes.number,
+    // Native log levels shared by every player: "info" or "info,GStreamerSource:debug",
+    // levels are none, error, info and debug
+    logLevel: PropTypes.string,
     onPlayerInit: PropTypes.func,
     onStateChanged: PropTypes.func,
     onUriChanged: PropTypes.func,
     onEOS: PropTypes.func,
     onElementError: PropTypes.func,
+    onFirstFrame: PropTypes.func,
+    onCommandDone: PropTypes.func,
+    onReconnect: PropTypes.func,
+    onStats: PropTypes.func,
+    onVolumeChanged: PropTypes.func,
+    onQos: PropTypes.func,
+    onDvrExport: PropTypes.func,
+    onSeekDone: PropTypes.func,
+    onScrubPreview: PropTypes.func,
+    onSnapshot: PropTypes.func,
     setGstState: PropTypes.func,
     play: PropTypes.func,
     pause: PropTypes.func,
     stop: PropTypes.func,
+    suspend: PropTypes.func,
+    resume: PropTypes.func,
+    prepareUri: PropTypes.func,
+    timeshift: PropTypes.func,
+    exportClip: PropTypes.func,
+    seek: PropTypes.func,
+    setRate: PropTypes.func,
+    scrub: PropTypes.func,
+    snapshot: PropTypes.func,
+    dumpGraph: PropTypes.func,
     recreateView: PropTypes.func,
     ...View.propTypes,
 };
@@ -0,0 +1,166 @@
+#include "gstreamer_audio_level.h"
+#include <math.h>
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerAudioLevel"
+
+struct _RctGstAudioMeter
+{
+    GstBin *bin;
+    GstElement *decoder, *conv, *level, *sink;
+    GMutex lock;                        // Pad linking happens on streaming threads
+};
+
+static void on_decoder_pad_added(GstElement *decoder, GstPad *pad, gpointer user_data)
+{
+    RctGstAudioMeter *meter = (RctGstAudioMeter *)user_data;
+    GstPad *sink_pad = gst_element_get_static_pad(meter->conv, "sink");
+
+    if (!gst_pad_is_linked(sink_pad) && GST_PAD_LINK_FAILED(gst_pad_link(pad, sink_pad))) {
+        LOGE("Decoded audio could not be linked");
+    }
+    gst_object_unref(sink_pad);
+}
+
+// Loudest channel of a level field
+static gdouble loudest_channel(const GstStructure *structure, const gchar *field)
+{
+    const GValue *value = gst_structure_get_value(structure, field);
+    GValueArray *channels;
+    gdouble loudest = -INFINITY;
+    guint i;
+
+    if (!value) {
+        return loudest;
+    }
+    channels = (GValueArray *)g_value_get_boxed(value);
+    for (i = 0; i < channels->n_values; i++) {
+        loudest = MAX(loudest, g_value_get_double(g_value_array_get_nth(channels, i)));
+    }
+    return loudest;
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstAudioMeter *rct_gst_audio_meter_new(GstBin *bin, guint interval_ms)
+{
+    RctGstAudioMeter *meter = g_new0(RctGstAudioMeter, 1);
+
+    meter->decoder = gst_element_factory_make("decodebin", "audio_decoder");
+    meter->conv = gst_element_factory_make("audioconvert", "audio_conv");
+    meter->level = gst_element_factory_make("level", "audio_level");
+    meter->sink = gst_element_factory_make("fakesink", "audio_sink");
+
+    if (!meter->decoder || !meter->conv || !meter->level || !meter->sink) {
+        LOGE("Failed to create audio level elements");
+        if (meter->decoder) {
+            gst_object_unref(meter->decoder);
+        }
+        if (meter->conv) {
+            gst_object_unref(meter->conv);
+        }
+        if (meter->level) {
+            gst_object_unref(meter->level);
+        }
+        if (meter->sink) {
+            gst_object_unref(meter->sink);
+        }
+        g_free(meter);
+        return NULL;
+    }
+
+    meter->bin = bin;
+    g_mutex_init(&meter->lock);
+    g_object_set(G_OBJECT(meter->level), "post-messages", TRUE, NULL);
+    rct_gst_audio_meter_set_interval(meter, interval_ms);
+    // Nothing is rendered, the branch must never hold the pipeline clock or preroll
+    g_object_set(G_OBJECT(meter->sink), "sync", FALSE, "async", FALSE, NULL);
+
+    gst_bin_add_many(bin, meter->decoder, meter->conv, meter->level, meter->sink, NULL);
+    gst_element_link_many(meter->conv, meter->level, meter->sink, NULL);
+    g_signal_connect(meter->decoder, "pad-added", G_CALLBACK(on_decoder_pad_added), meter);
+
+    gst_element_sync_state_with_parent(meter->sink);
+    gst_element_sync_state_with_parent(meter->level);
+    gst_element_sync_state_with_parent(meter->conv);
+    gst_element_sync_state_with_parent(meter->decoder);
+    LOGD("Audio level branch created, one measurement every %u ms", interval_ms);
+    return meter;
+}
+
+void rct_gst_audio_meter_free(RctGstAudioMeter *meter)
+{
+    GstPad *sink_pad;
+    GstPad *peer;
+
+    if (!meter) {
+        return;
+    }
+
+    g_mutex_lock(&meter->lock);
+    sink_pad = gst_element_get_static_pad(meter->decoder, "sink");
+    if ((peer = gst_pad_get_peer(sink_pad)) != NULL) {
+        gst_pad_unlink(peer, sink_pad);
+        gst_object_unref(peer);
+    }
+    gst_object_unref(sink_pad);
+    g_mutex_unlock(&meter->lock);
+
+    gst_element_set_state(meter->decoder, GST_STATE_NULL);
+    gst_element_set_state(meter->conv, GST_STATE_NULL);
+    gst_element_set_state(meter->level, GST_STATE_NULL);
+    gst_element_set_state(meter->sink, GST_STATE_NULL);
+    gst_bin_remove_many(meter->bin, meter->decoder, meter->conv, meter->level, meter->sink, NULL);
+
+    g_mutex_clear(&meter->lock);
+    g_free(meter);
+    LOGD("Audio level branch removed");
+}
+
+void rct_gst_audio_meter_set_interval(RctGstAudioMeter *meter, guint interval_ms)
+{
+    g_object_set(G_OBJECT(meter->level), "interval", (guint64)interval_ms * GST_MSECOND, NULL);
+}
+
+gboolean rct_gst_audio_meter_link(RctGstAudioMeter *meter, GstPad *pad)
+{
+    GstPad *sink_pad = gst_element_get_static_pad(meter->decoder, "sink");
+    GstPad *peer;
+    gboolean linked = TRUE;
+
+    g_mutex_lock(&meter->lock);
+    peer = gst_pad_get_peer(sink_pad);
+    if (peer != pad) {
+        if (peer) {
+            gst_pad_unlink(peer, sink_pad);
+        }
+        linked = !GST_PAD_LINK_FAILED(gst_pad_link(pad, sink_pad));
+        LOGD("Audio pad %s", linked ? "linked" : "could not be linked");
+    }
+    if (peer) {
+        gst_object_unref(peer);
+    }
+    g_mutex_unlock(&meter->lock);
+
+    gst_object_unref(sink_pad);
+    return linked;
+}
+
+gboolean rct_gst_audio_meter_parse(RctGstAudioMeter *meter, GstMessage *message, RctGstAudioLevel *level)
+{
+    const GstStructure *structure;
+
+    if (GST_MESSAGE_SRC(message) != GST_OBJECT(meter->level)) {
+        return FALSE;
+    }
+    structure = gst_message_get_structure(message);
+    if (!structure || !gst_structure_has_name(structure, "level")) {
+        return FALSE;
+    }
+
+    level->rms = loudest_channel(structure, "rms");
+    level->peak = loudest_channel(structure, "peak");
+    level->decay = loudest_channel(structure, "decay");
+    return TRUE;
+}
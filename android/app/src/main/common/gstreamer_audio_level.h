@@ -0,0 +1,35 @@
+//
+//  gstreamer_audio_level.h
+//
+//  Audio metering branch (decodebin ! audioconvert ! level ! fakesink),
+//  only built while audio levels are requested. Level messages are turned
+//  into one RctGstAudioLevel per measurement, loudest channel first.
+//
+
+#ifndef gstreamer_audio_level_h
+#define gstreamer_audio_level_h
+
+#include <gst/gst.h>
+
+// Audio level definition, in dB
+typedef struct {
+    gdouble rms;
+    gdouble peak;
+    gdouble decay;
+} RctGstAudioLevel;
+
+typedef struct _RctGstAudioMeter RctGstAudioMeter;
+
+// Adds the branch to bin and brings it to the bin state
+RctGstAudioMeter *rct_gst_audio_meter_new(GstBin *bin, guint interval_ms);
+void rct_gst_audio_meter_free(RctGstAudioMeter *meter);
+
+void rct_gst_audio_meter_set_interval(RctGstAudioMeter *meter, guint interval_ms);
+
+// Feeds the branch from an RTP audio pad, the previous one gets unlinked
+gboolean rct_gst_audio_meter_link(RctGstAudioMeter *meter, GstPad *pad);
+
+// TRUE when message is a measurement of this meter
+gboolean rct_gst_audio_meter_parse(RctGstAudioMeter *meter, GstMessage *message, RctGstAudioLevel *level);
+
+#endif /* gstreamer_audio_level_h */
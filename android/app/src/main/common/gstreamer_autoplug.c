@@ -0,0 +1,82 @@
+#include "gstreamer_autoplug.h"
+#include <string.h>
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerAutoplug"
+
+GstElement *rct_gst_autoplug_make(GstElementFactoryListType type, GstCaps *caps, const gchar *name)
+{
+    GList *factories = gst_element_factory_list_get_elements(type, GST_RANK_MARGINAL);
+    GList *candidates = gst_element_factory_list_filter(factories, caps, GST_PAD_SINK, FALSE);
+    GstElement *element = NULL;
+    GList *l;
+
+    candidates = g_list_sort(candidates, (GCompareFunc)gst_plugin_feature_rank_compare_func);
+    for (l = candidates; l != NULL && element == NULL; l = l->next) {
+        GstElementFactory *factory = GST_ELEMENT_FACTORY(l->data);
+
+        // A hardware decoder may be listed and still fail to open, the next rank takes over
+        element = gst_element_factory_create(factory, name);
+        LOGD("%s %s (rank %u)", element ? "Picked" : "Could not create",
+             GST_OBJECT_NAME(factory), gst_plugin_feature_get_rank(GST_PLUGIN_FEATURE(factory)));
+    }
+
+    if (!element) {
+        gchar *caps_string = gst_caps_to_string(caps);
+        LOGE("No element for %s", caps_string);
+        g_free(caps_string);
+    }
+
+    gst_plugin_feature_list_free(candidates);
+    gst_plugin_feature_list_free(factories);
+    return element;
+}
+
+void rct_gst_autoplug_set_boolean(GstElement *element, const gchar *property, gboolean value)
+{
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(element), property)) {
+        g_object_set(G_OBJECT(element), property, value, NULL);
+    }
+}
+
+void rct_gst_autoplug_set_int(GstElement *element, const gchar *property, gint value)
+{
+    if (g_object_class_find_property(G_OBJECT_GET_CLASS(element), property)) {
+        g_object_set(G_OBJECT(element), property, value, NULL);
+    }
+}
+
+gboolean rct_gst_autoplug_factory_is_hardware(GstElementFactory *factory)
+{
+    const gchar *klass;
+
+    if (!factory) {
+        return FALSE;
+    }
+    // MediaCodec decoders predate the Hardware klass, they are matched by name
+    klass = gst_element_factory_get_metadata(factory, GST_ELEMENT_METADATA_KLASS);
+    return (klass && strstr(klass, "Hardware")) || g_str_has_prefix(GST_OBJECT_NAME(factory), "amcviddec");
+}
+
+gboolean rct_gst_autoplug_is_hardware(GstElement *element)
+{
+    return rct_gst_autoplug_factory_is_hardware(gst_element_get_factory(element));
+}
+
+gchar *rct_gst_autoplug_describe(GstElement **elements, guint count)
+{
+    GString *description = g_string_new(NULL);
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        GstElementFactory *factory;
+
+        if (!elements[i]) {
+            continue;
+        }
+        factory = gst_element_get_factory(elements[i]);
+        g_string_append_printf(description, "%s%s", description->len ? " ! " : "",
+                               factory ? GST_OBJECT_NAME(factory) : GST_OBJECT_NAME(elements[i]));
+    }
+    return g_string_free(description, FALSE);
+}
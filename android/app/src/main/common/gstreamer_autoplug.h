@@ -0,0 +1,28 @@
+//
+//  gstreamer_autoplug.h
+//
+//  Element selection from caps. Candidates come from the registry and are
+//  tried by rank, so hardware decoders (ranked above the software ones on
+//  devices that have them) are picked first.
+//
+
+#ifndef gstreamer_autoplug_h
+#define gstreamer_autoplug_h
+
+#include <gst/gst.h>
+
+// Highest ranked element of type whose sink pad accepts caps, NULL when none could be created
+GstElement *rct_gst_autoplug_make(GstElementFactoryListType type, GstCaps *caps, const gchar *name);
+
+// Autoplugged elements don't share properties, these are only set when the element has them
+void rct_gst_autoplug_set_boolean(GstElement *element, const gchar *property, gboolean value);
+void rct_gst_autoplug_set_int(GstElement *element, const gchar *property, gint value);
+
+// Hardware decoders output GPU memory, nothing raw can be placed right after them
+gboolean rct_gst_autoplug_is_hardware(GstElement *element);
+gboolean rct_gst_autoplug_factory_is_hardware(GstElementFactory *factory);
+
+// "rtspsrc ! rtph264depay ! ..." from the factory names of the given elements, NULL ones are skipped
+gchar *rct_gst_autoplug_describe(GstElement **elements, guint count);
+
+#endif /* gstreamer_autoplug_h */
@@ -1,370 +1,3071 @@
 #include "gstreamer_backend.h"
-#include <android/log.h>
+#include "gstreamer_log.h"
 #include <gst/gst.h>
 
 #define LOG_TAG "GStreamerBackend"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
-// Globals items
-RctGstConfiguration* configuration;
+// Function to reset the pipeline
+void reset_pipeline(RctGstPlayer *player);
 
-GstElement *pipeline;
-GstElement *source, *depay, *parser, *decoder, *conv, *sink;
-GMainLoop *main_loop;
-guint bus_watch_id;
-GstBus *bus;
+// Source front ends
+static RctGstSource *create_front_end(RctGstPlayer *player, const gchar *uri);
+static gboolean use_front_end(RctGstPlayer *player, RctGstSource *front_end);
+static gboolean restart_front_end(RctGstPlayer *player);
 
-// Video
-guintptr drawable_surface;
-GstVideoOverlay* video_overlay;
+// Codec switch
+static void front_end_codec_known(RctGstPlayer *player, GstObject *source);
 
-// Function declaration for the pad-added callback
-void on_pad_added(GstElement *src, GstPad *new_pad, gpointer depay);
+// Suspension
+static gboolean player_resume(RctGstPlayer *player);
+static void wake_front_end(RctGstPlayer *player);
 
-// Function to reset the pipeline
-void reset_pipeline();
+// Player thread side of the posted commands
+static void handle_command(RctGstCommand *command, gpointer user_data);
+
+// Reconnect engine
+static void cb_restart(RctGstRestartKind kind, gpointer user_data);
+static void cb_reconnect_notify(const RctGstReconnectStats *stats, gpointer user_data);
+
+// Degradation ladder
+static void apply_surface_size(RctGstPlayer *player);
+static void cb_qos_notify(const RctGstQosStatus *status, gpointer user_data);
+static void cb_qos_resolution(gint divisor, gpointer user_data);
+
+// Transport selection
+static void cb_transport_fallback(RctGstTransport transport, gpointer user_data);
+
+// Shared decode mode
+static gboolean attach_shared_view(RctGstPlayer *player);
+static void detach_shared_view(RctGstPlayer *player);
+
+// Seeking
+static void seek_prerolled(RctGstPlayer *player);
+static void report_seek_done(RctGstPlayer *player, const GstStructure *structure);
+
+// Debugging
+static void count_debugging_player(gboolean is_debugging);
+
+static gpointer player_run_loop(gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    LOGD("Starting GStreamer main loop for player %p", player);
+    // Bus watches created from this thread attach to the player context
+    g_main_context_push_thread_default(player->context);
+    g_main_loop_run(player->main_loop);
+    g_main_context_pop_thread_default(player->context);
+    LOGD("GStreamer main loop terminated");
+    return NULL;
+}
+
+// Lifecycle
+RctGstPlayer *rct_gst_player_new()
+{
+    RctGstPlayer *player = g_new0(RctGstPlayer, 1);
+    rct_gst_get_configuration(player);
+    g_mutex_init(&player->info_lock);
+
+    player->context = g_main_context_new();
+    player->main_loop = g_main_loop_new(player->context, FALSE);
+    player->commands = rct_gst_command_queue_new(player->context, handle_command, player);
+    player->reconnect = rct_gst_reconnect_new(player->context, cb_restart, cb_reconnect_notify, player);
+    player->stats = rct_gst_stats_new();
+    player->qos = rct_gst_qos_new(player->context, cb_qos_notify, cb_qos_resolution, player);
+    rct_gst_qos_configure(player->qos, player->configuration->qosMaxRung, player->configuration->qosMaxLateness);
+    player->resolution_divisor = 1;
+    player->rate = 1.0;
+    player->scrub_target_us = -1;
+    player->jitter = rct_gst_jitter_new();
+    player->transport = rct_gst_transport_selector_new(player->context, cb_transport_fallback, player);
+    rct_gst_transport_configure(player->transport, player->configuration->transports,
+                                player->configuration->transportTimeout, player->configuration->rememberTransport);
+    rct_gst_jitter_configure(player->jitter, player->configuration->jitterMode, player->configuration->jitterMinLatency,
+                             player->configuration->jitterMaxLatency, player->configuration->jitterTargetLoss);
+    player->mosaic_uris = g_ptr_array_new_with_free_func(g_free);
+    player->snapshotter = rct_gst_snapshotter_new();
+    player->thread = g_thread_new("rct-gst-player", player_run_loop, player);
+
+    rct_gst_startup_mark(RCT_GST_STARTUP_PLAYER_CREATED);
+    LOGD("Created player %p", player);
+    return player;
+}
+
+void rct_gst_player_free(RctGstPlayer *player)
+{
+    if (!player) {
+        return;
+    }
+    LOGD("Freeing player %p", player);
+
+    // Commands are handled in order, so the pipeline is down before the loop quits
+    rct_gst_terminate(player);
+    rct_gst_command_queue_push(player->commands, rct_gst_command_new(RCT_GST_COMMAND_QUIT));
+    g_thread_join(player->thread);
+    if (player->configuration->isDebugging) {
+        count_debugging_player(FALSE);
+    }
+
+    rct_gst_command_queue_free(player->commands);
+    rct_gst_reconnect_free(player->reconnect);
+    rct_gst_stats_free(player->stats);
+    rct_gst_qos_free(player->qos);
+    rct_gst_jitter_free(player->jitter);
+    rct_gst_transport_selector_free(player->transport);
+    g_ptr_array_free(player->mosaic_uris, TRUE);
+    rct_gst_snapshotter_free(player->snapshotter);                  // The player outlives every snapshot callback
+    g_main_loop_unref(player->main_loop);
+    g_main_context_unref(player->context);
+
+    g_mutex_clear(&player->info_lock);
+    g_free(player->element_chain);
+    g_free(player->configuration->uri);
+    g_free(player->configuration->videoSink);
+    g_free(player->configuration->transports);
+    g_free(player->configuration);
+    g_free(player);
+
+    // What the player logged on its way down is not left waiting for the flushing thread
+    rct_gst_log_flush();
+}
 
 // Getters
-RctGstConfiguration *rct_gst_get_configuration()
+RctGstConfiguration *rct_gst_get_configuration(RctGstPlayer *player)
 {
-    if (!configuration) {
-        configuration = g_malloc(sizeof(RctGstConfiguration));
+    if (!player->configuration) {
+        RctGstConfiguration *configuration = g_malloc(sizeof(RctGstConfiguration));
         configuration->uri = NULL;
+        configuration->audioLevelRefreshRate = 0;
+        configuration->initialDrawableSurface = 0;
         configuration->isDebugging = FALSE;
-        
+        configuration->uriSwitchMode = RCT_GST_URI_SWITCH_SOURCE_ONLY;
+        configuration->standbyPoolSize = 0;
+        configuration->standbyGopBudget = 8 * 1024 * 1024;
+        configuration->reconnectInitialDelay = 500;
+        configuration->reconnectMaxDelay = 30000;
+        configuration->reconnectJitter = 0.2;
+        configuration->stallTimeout = 10000;
+        configuration->videoSink = NULL;
+        configuration->forceVideoConvert = FALSE;
+        configuration->scalingPolicy = RCT_GST_SCALING_DISPLAY;
+        configuration->pipelineMode = RCT_GST_PIPELINE_SINGLE_THREAD;
+        configuration->decodeQueueDepth = 16;
+        configuration->decodeQueueLeaky = FALSE;                    // A dropped access unit smears the picture until the next keyframe
+        configuration->renderQueueDepth = 2;
+        configuration->renderQueueLeaky = TRUE;                     // A late frame is better dropped than displayed
+        configuration->decoderMaxThreads = 0;
+        configuration->decoderThreadType = RCT_GST_DECODER_THREADS_AUTO;
+        configuration->statsRefreshRate = 0;
+        configuration->qosMaxRung = RCT_GST_QOS_RUNG_LOWER_RESOLUTION;
+        configuration->qosMaxLateness = 100;
+        configuration->jitterMode = RCT_GST_JITTER_FIXED;
+        configuration->jitterMinLatency = 0;
+        configuration->jitterMaxLatency = 1000;
+        configuration->jitterTargetLoss = 0.01;
+        configuration->transports = g_strdup("udp,tcp");
+        configuration->transportTimeout = 3000;
+        configuration->rememberTransport = TRUE;
+        configuration->sharedDecode = FALSE;
+        configuration->mosaicColumns = 0;
+        configuration->mosaicRows = 0;
+        configuration->dvrMaxDuration = 0;
+        configuration->dvrMaxBytes = 0;
+        configuration->scrubCacheBytes = 0;
+        configuration->scrubThumbnailWidth = 160;
+        configuration->userData = NULL;
+
         configuration->onElementError = NULL;
         configuration->onStateChanged = NULL;
+        configuration->onVolumeChanged = NULL;
         configuration->onUriChanged = NULL;
-        
+
         configuration->onInit = NULL;
         configuration->onEOS = NULL;
+        configuration->onFirstFrame = NULL;
+        configuration->onCommandDone = NULL;
+        configuration->onReconnect = NULL;
+        configuration->onStats = NULL;
+        configuration->onQos = NULL;
+        configuration->onDvrExport = NULL;
+        configuration->onSeekDone = NULL;
+        configuration->onScrubPreview = NULL;
+        player->configuration = configuration;
     }
-    return configuration;
+    return player->configuration;
 }
 
 // Setters
-void rct_gst_set_uri(gchar* _uri) {
-    LOGD("Setting URI: %s", _uri);
-    rct_gst_get_configuration()->uri = g_strdup(_uri); // Duplicate the URI to avoid issues with the original string.
-    if (pipeline) {
-        apply_uri();
-    }
+void rct_gst_set_uri(RctGstPlayer *player, gchar* _uri) {
+    LOGD("Posting URI: %s", _uri);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_URI);
+    command->args.uri = g_strdup(_uri);   // Callers keep theirs, player_set_uri replaces the configured one
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-void rct_gst_set_debugging(gboolean is_debugging)
+void rct_gst_set_debugging(RctGstPlayer *player, gboolean is_debugging)
 {
-    LOGD("Setting debugging: %s", is_debugging ? "true" : "false");
-    rct_gst_get_configuration()->isDebugging = is_debugging;
-    // TODO: Recreate pipeline...
+    LOGD("Posting debugging: %s", is_debugging ? "true" : "false");
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_DEBUGGING);
+    command->args.is_debugging = is_debugging;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-/**********************
- VIDEO HANDLING METHODS
- *********************/
-void rct_gst_set_drawable_surface(guintptr _drawableSurface) {
-    LOGD("Setting drawable surface from C: %p", (void*)_drawableSurface);
-    drawable_surface = _drawableSurface;
-    
-    if (pipeline && GST_IS_VIDEO_OVERLAY(sink)) {
-        LOGD("Setting window handle on video overlay");
-        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(sink), drawable_surface);
-    } else {
-        LOGE("Pipeline or video overlay is NULL, cannot set drawable surface");
-    }
+void rct_gst_set_standby_pool(RctGstPlayer *player, guint capacity, gsize gop_budget)
+{
+    LOGD("Posting standby pool: %u sources, %lu bytes", capacity, (unsigned long)gop_budget);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_STANDBY_POOL);
+    command->args.standby_pool.capacity = capacity;
+    command->args.standby_pool.gop_budget = gop_budget;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-GstBusSyncReply cb_create_window(GstBus *bus, GstMessage *message, gpointer user_data)
+void rct_gst_set_reconnect_policy(RctGstPlayer *player, guint initial_delay, guint max_delay,
+                                  gdouble jitter, guint stall_timeout)
 {
-    if (!gst_is_video_overlay_prepare_window_handle_message(message)) {
-        return GST_BUS_PASS;
-    }
+    LOGD("Posting reconnect policy: %u-%u ms, jitter %.2f, stall timeout %u ms", initial_delay, max_delay, jitter, stall_timeout);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_RECONNECT_POLICY);
+    command->args.reconnect_policy.initial_delay = initial_delay;
+    command->args.reconnect_policy.max_delay = max_delay;
+    command->args.reconnect_policy.jitter = jitter;
+    command->args.reconnect_policy.stall_timeout = stall_timeout;
+    rct_gst_command_queue_push(player->commands, command);
+}
 
-    if (drawable_surface != 0) {
-        LOGD("Setting window handle from message sync");
-        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(sink), drawable_surface);
-    }
-    
-    gst_message_unref(message);
-    return GST_BUS_DROP;
+void rct_gst_set_stats_refresh_rate(RctGstPlayer *player, guint refresh_rate)
+{
+    LOGD("Posting stats refresh rate: %u ms", refresh_rate);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_STATS_REFRESH_RATE);
+    command->args.refresh_rate = refresh_rate;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-/*********************
- APPLICATION CALLBACKS
- ********************/
-static void cb_error(GstBus *bus, GstMessage *msg, gpointer *user_data)
+void rct_gst_set_qos_policy(RctGstPlayer *player, RctGstQosRung max_rung, guint max_lateness)
 {
-    GError *err;
-    gchar *debug_info;
-    
-    gst_message_parse_error(msg, &err, &debug_info);
-    LOGE("Error received from element %s: %s", GST_OBJECT_NAME(msg->src), err->message);
-    if (rct_gst_get_configuration()->onElementError) {
-        rct_gst_get_configuration()->onElementError(GST_OBJECT_NAME(msg->src), err->message, debug_info);
-    }
-    g_clear_error(&err);
-    g_free(debug_info);
-    reset_pipeline(); // Reset pipeline on error
+    LOGD("Posting QoS policy: up to %s, %u ms lateness", rct_gst_qos_rung_get_name(max_rung), max_lateness);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_QOS_POLICY);
+    command->args.qos_policy.max_rung = max_rung;
+    command->args.qos_policy.max_lateness = max_lateness;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-static void cb_eos(GstBus *bus, GstMessage *msg, gpointer *user_data)
+void rct_gst_set_jitter_policy(RctGstPlayer *player, RctGstJitterMode mode, guint min_latency,
+                               guint max_latency, gdouble target_loss)
 {
-    LOGD("End of stream (EOS) received");
-    if (rct_gst_get_configuration()->onEOS) {
-        rct_gst_get_configuration()->onEOS();
-    }
-    reset_pipeline(); // Reset pipeline on EOS
+    LOGD("Posting jitter policy: %s, %u-%u ms, %.2f%% loss", mode == RCT_GST_JITTER_ADAPTIVE ? "adaptive" : "fixed",
+         min_latency, max_latency, target_loss * 100);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_JITTER_POLICY);
+    command->args.jitter_policy.mode = mode;
+    command->args.jitter_policy.min_latency = min_latency;
+    command->args.jitter_policy.max_latency = max_latency;
+    command->args.jitter_policy.target_loss = target_loss;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-static void cb_state_changed(GstBus *bus, GstMessage *msg, gpointer *user_data)
+void rct_gst_set_transport_policy(RctGstPlayer *player, const gchar *transports, guint timeout, gboolean remember)
 {
-    GstState old_state, new_state, pending_state;
-    gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
+    LOGD("Posting transport policy: %s, %u ms each%s", transports, timeout, remember ? ", remembered" : "");
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_TRANSPORT_POLICY);
+    command->args.transport_policy.order = g_strdup(transports);
+    command->args.transport_policy.timeout = timeout;
+    command->args.transport_policy.remember = remember;
+    rct_gst_command_queue_push(player->commands, command);
+}
 
-    if (GST_MESSAGE_SRC(msg) == GST_OBJECT(pipeline)) {
-        LOGD("Pipeline state changed from %s to %s", gst_element_state_get_name(old_state), gst_element_state_get_name(new_state));
-        if (rct_gst_get_configuration()->onStateChanged) {
-            rct_gst_get_configuration()->onStateChanged(old_state, new_state);
+void rct_gst_set_mosaic_layout(RctGstPlayer *player, guint columns, guint rows)
+{
+    LOGD("Posting mosaic layout: %ux%u", columns, rows);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_MOSAIC_LAYOUT);
+    command->args.mosaic_layout.columns = columns;
+    command->args.mosaic_layout.rows = rows;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_set_mosaic_tile(RctGstPlayer *player, guint index, const gchar *uri)
+{
+    LOGD("Posting mosaic tile %u: %s", index, uri ? uri : "none");
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_MOSAIC_TILE);
+    command->args.mosaic_tile.index = index;
+    command->args.mosaic_tile.uri = g_strdup(uri);
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_set_dvr_policy(RctGstPlayer *player, guint max_duration, gsize max_bytes)
+{
+    LOGD("Posting DVR policy: %u ms, %" G_GSIZE_FORMAT " bytes", max_duration, max_bytes);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_DVR_POLICY);
+    command->args.dvr_policy.max_duration = max_duration;
+    command->args.dvr_policy.max_bytes = max_bytes;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_set_scrub_cache(RctGstPlayer *player, gsize max_bytes, gint thumbnail_width)
+{
+    LOGD("Posting scrub cache: %" G_GSIZE_FORMAT " bytes, %d px wide", max_bytes, thumbnail_width);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_SCRUB_CACHE);
+    command->args.scrub_cache.max_bytes = max_bytes;
+    command->args.scrub_cache.width = thumbnail_width;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_set_audio_level_refresh_rate(RctGstPlayer *player, guint audio_level_refresh_rate)
+{
+    LOGD("Posting audio level refresh rate: %u ms", audio_level_refresh_rate);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_AUDIO_LEVEL_REFRESH_RATE);
+    command->args.refresh_rate = audio_level_refresh_rate;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_prepare_uri(RctGstPlayer *player, gchar *_uri)
+{
+    LOGD("Posting standby URI: %s", _uri);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_PREPARE_URI);
+    command->args.uri = g_strdup(_uri);
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+static gboolean player_set_uri(RctGstPlayer *player, gchar *uri)
+{
+    LOGD("Setting URI: %s", uri);
+    g_free(rct_gst_get_configuration(player)->uri);
+    rct_gst_get_configuration(player)->uri = g_strdup(uri);
+    if (player->shared) {
+        detach_shared_view(player);
+        return attach_shared_view(player);
+    }
+    // Tiles carry their own uris
+    if (player->mosaic) {
+        return TRUE;
+    }
+    if (player->pipeline) {
+        if (player->suspended) {
+            wake_front_end(player);
         }
+        // Another stream, what was recorded is not its past
+        if (player->dvr) {
+            rct_gst_dvr_clear(player->dvr);
+        }
+        apply_uri(player);
     }
+    return TRUE;
 }
 
-static gboolean cb_message_element(GstBus *bus, GstMessage *msg, gpointer user_data)
+static gboolean player_set_standby_pool(RctGstPlayer *player, guint capacity, gsize gop_budget)
 {
+    rct_gst_get_configuration(player)->standbyPoolSize = capacity;
+    rct_gst_get_configuration(player)->standbyGopBudget = gop_budget;
+    if (player->standby_pool) {
+        rct_gst_standby_pool_configure(player->standby_pool, capacity, gop_budget);
+    }
     return TRUE;
 }
 
-static gboolean cb_async_done(GstBus *bus, GstMessage *message, gpointer user_data)
+static gboolean player_set_reconnect_policy(RctGstPlayer *player, guint initial_delay, guint max_delay,
+                                            gdouble jitter, guint stall_timeout)
 {
-    LOGD("Async done message received");
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    configuration->reconnectInitialDelay = initial_delay;
+    configuration->reconnectMaxDelay = max_delay;
+    configuration->reconnectJitter = jitter;
+    configuration->stallTimeout = stall_timeout;
+    rct_gst_reconnect_configure(player->reconnect, initial_delay, max_delay, jitter, stall_timeout);
     return TRUE;
 }
 
-static gboolean cb_bus_watch(GstBus *bus, GstMessage *message, gpointer user_data)
+/*********
+ STATISTICS
+ ********/
+static gboolean cb_stats_tick(gpointer user_data)
 {
-    switch (GST_MESSAGE_TYPE(message)) {
-        case GST_MESSAGE_ERROR:
-            cb_error(bus, message, user_data);
-            break;
-            
-        case GST_MESSAGE_EOS:
-            cb_eos(bus, message, user_data);
-            break;
-            
-        case GST_MESSAGE_STATE_CHANGED:
-            cb_state_changed(bus, message, user_data);
-            break;
-            
-        case GST_MESSAGE_ELEMENT:
-            cb_message_element(bus, message, user_data);
-            break;
-            
-        case GST_MESSAGE_ASYNC_DONE:
-            cb_async_done(bus, message, user_data);
-            break;
-            
-        default:
-            LOGD("Unhandled message type: %s", GST_MESSAGE_TYPE_NAME(message));
-            break;
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    RctGstStats stats;
+
+    rct_gst_stats_poll(player->stats, player->source, &stats);
+    if (rct_gst_get_configuration(player)->onStats) {
+        rct_gst_get_configuration(player)->onStats(player, &stats);
     }
-    
-    return TRUE;
+    return G_SOURCE_CONTINUE;
 }
 
-/*************
- OTHER METHODS
- ************/
-GstStateChangeReturn rct_gst_set_pipeline_state(GstState state)
+static void stop_stats(RctGstPlayer *player)
 {
-    LOGD("Setting pipeline state: %s", gst_element_state_get_name(state));
-    GstStateChangeReturn validity = gst_element_set_state(pipeline, state);
-    LOGD("State change return: %s", gst_element_state_change_return_get_name(validity));
-    return validity;
+    if (player->stats_source) {
+        g_source_destroy(player->stats_source);
+        g_source_unref(player->stats_source);
+        player->stats_source = NULL;
+    }
+    rct_gst_stats_detach(player->stats);
 }
 
-void rct_gst_init(RctGstConfiguration *configuration)
+// Probes and timer only exist while a refresh rate is set, disabled statistics cost nothing
+static void start_stats(RctGstPlayer *player)
 {
-    LOGD("Initializing GStreamer pipeline");
+    guint refresh_rate = rct_gst_get_configuration(player)->statsRefreshRate;
 
-    // Create the elements
-    pipeline = gst_pipeline_new("pipeline");
-    source = gst_element_factory_make("rtspsrc", "source");
-    depay = gst_element_factory_make("rtph264depay", "depay");
-    parser = gst_element_factory_make("h264parse", "parser");
-    decoder = gst_element_factory_make("avdec_h264", "decoder");
-    conv = gst_element_factory_make("videoconvert", "conv");
-    sink = gst_element_factory_make("glimagesink", "video_sink");
-
-    if (!pipeline || !source || !depay || !parser || !decoder || !conv || !sink) {
-        LOGE("Failed to create elements");
+    stop_stats(player);
+    if (refresh_rate == 0 || !player->pipeline || player->mosaic) {
         return;
     }
 
-    // Set the URI property on the source element
-    gchar *uri = rct_gst_get_configuration()->uri;
-    LOGD("Setting URI on source element: %s", uri);
-    g_object_set(G_OBJECT(source), "location", uri, NULL);
-    g_object_set(G_OBJECT(source), "buffer-size", 2097152, NULL);
-    g_object_set(G_OBJECT(source), "latency", 0, NULL);
+    rct_gst_stats_attach(player->stats, player->parser, player->decoder, player->sink);
+    player->stats_source = g_timeout_source_new(refresh_rate);
+    g_source_set_callback(player->stats_source, cb_stats_tick, player, NULL);
+    g_source_attach(player->stats_source, player->context);
+}
 
-    // Enable low-latency mode where possible
-    g_object_set(G_OBJECT(source), "do-retransmission", FALSE, NULL);
-    g_object_set(G_OBJECT(parser), "disable-passthrough", TRUE, NULL);
-    g_object_set(G_OBJECT(decoder), "low-latency", TRUE, NULL);
-    g_object_set(G_OBJECT(sink), "sync", FALSE, NULL);
-    g_object_set(G_OBJECT(sink), "max-lateness", -1, NULL);
-
-    // Build the pipeline
-    gst_bin_add_many(GST_BIN(pipeline), source, depay, parser, decoder, conv, sink, NULL);
-    if (!gst_element_link_many(depay, parser, decoder, conv, sink, NULL)) {
-        LOGE("Elements could not be linked");
-        gst_object_unref(pipeline);
-        return;
+static gboolean player_set_stats_refresh_rate(RctGstPlayer *player, guint refresh_rate)
+{
+    LOGD("Setting stats refresh rate: %u ms", refresh_rate);
+    rct_gst_get_configuration(player)->statsRefreshRate = refresh_rate;
+    start_stats(player);
+    return player->pipeline != NULL || refresh_rate == 0;
+}
+
+/******************
+ QUALITY OF SERVICE
+ *****************/
+static void cb_qos_notify(const RctGstQosStatus *status, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    if (rct_gst_get_configuration(player)->onQos) {
+        rct_gst_get_configuration(player)->onQos(player, status);
     }
+}
 
-    // Connect the source element's pad-added signal to the depay element
-    g_signal_connect(source, "pad-added", G_CALLBACK(on_pad_added), depay);
+static void cb_qos_resolution(gint divisor, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
 
-    gchar *pipeline_description = gst_debug_bin_to_dot_data(GST_BIN(pipeline), GST_DEBUG_GRAPH_SHOW_ALL);
-    LOGD("Pipeline description:\n%s", pipeline_description);
+    player->resolution_divisor = divisor;
+    apply_surface_size(player);
+}
 
-    bus = gst_element_get_bus(pipeline);
-    bus_watch_id = gst_bus_add_watch(bus, cb_bus_watch, NULL);
-    
-    gst_bus_set_sync_handler(bus, (GstBusSyncHandler)cb_create_window, pipeline, NULL);
-    gst_object_unref(bus);
+static gboolean player_set_qos_policy(RctGstPlayer *player, RctGstQosRung max_rung, guint max_lateness)
+{
+    rct_gst_get_configuration(player)->qosMaxRung = max_rung;
+    rct_gst_get_configuration(player)->qosMaxLateness = max_lateness;
+    rct_gst_qos_configure(player->qos, max_rung, max_lateness);
+    return TRUE;
+}
+
+/****************
+ JITTERBUFFER LATENCY
+ ***************/
+#define JITTER_SAMPLE_PERIOD_MS 1000
+
+static gboolean cb_jitter_tick(gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    rct_gst_jitter_update(player->jitter, player->source);
+    return G_SOURCE_CONTINUE;
+}
+
+static void stop_jitter_control(RctGstPlayer *player)
+{
+    if (player->jitter_source) {
+        g_source_destroy(player->jitter_source);
+        g_source_unref(player->jitter_source);
+        player->jitter_source = NULL;
+    }
+}
 
-    if (drawable_surface != 0) {
-        rct_gst_set_drawable_surface(drawable_surface);
+// Fixed latency needs no sampling, the session keeps what it was created with
+static void start_jitter_control(RctGstPlayer *player)
+{
+    stop_jitter_control(player);
+    if (rct_gst_get_configuration(player)->jitterMode != RCT_GST_JITTER_ADAPTIVE || !player->pipeline || player->mosaic ||
+        (player->front_end && !player->front_end->live)) {
+        return;
     }
+    player->jitter_source = g_timeout_source_new(JITTER_SAMPLE_PERIOD_MS);
+    g_source_set_callback(player->jitter_source, cb_jitter_tick, player, NULL);
+    g_source_attach(player->jitter_source, player->context);
+}
 
-    apply_uri();
-    
-    if (rct_gst_get_configuration()->onInit) {
-        rct_gst_get_configuration()->onInit();
+static gboolean player_set_jitter_policy(RctGstPlayer *player, RctGstJitterMode mode, guint min_latency,
+                                         guint max_latency, gdouble target_loss)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    configuration->jitterMode = mode;
+    configuration->jitterMinLatency = min_latency;
+    configuration->jitterMaxLatency = max_latency;
+    configuration->jitterTargetLoss = target_loss;
+    rct_gst_jitter_configure(player->jitter, mode, min_latency, max_latency, target_loss);
+    if (!player->front_end || player->front_end->live) {
+        rct_gst_jitter_apply(player->jitter, player->source);
     }
-    LOGD("GStreamer initialization complete");
+    start_jitter_control(player);
+    return TRUE;
+}
+
+/*****************
+ TRANSPORT SELECTION
+ ****************/
+// The attempt over the previous transport timed out or was refused, the next one gets a fresh session
+static void cb_transport_fallback(RctGstTransport transport, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    GstState current_state = GST_STATE_NULL;
+
+    if (!player->pipeline || player->suspended || GST_STATE_TARGET(player->pipeline) != GST_STATE_PLAYING) {
+        return;
+    }
+    gst_element_get_state(player->pipeline, &current_state, NULL, 0);
+    if (current_state < GST_STATE_PAUSED || !restart_front_end(player)) {
+        reset_pipeline(player);
+    }
+}
 
-    // Log the pipeline description
-    gchar *pipeline_description2 = gst_debug_bin_to_dot_data(GST_BIN(pipeline), GST_DEBUG_GRAPH_SHOW_ALL);
-    LOGD("Pipeline description2:\n%s", pipeline_description2);
-    g_free(pipeline_description);
+// Applies to the sessions opened from now on, the running one keeps its transport
+static gboolean player_set_transport_policy(RctGstPlayer *player, gchar *transports, guint timeout, gboolean remember)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    g_free(configuration->transports);
+    configuration->transports = g_strdup(transports);
+    configuration->transportTimeout = timeout;
+    configuration->rememberTransport = remember;
+    rct_gst_transport_attempt_cancelled(player->transport);
+    rct_gst_transport_configure(player->transport, transports, timeout, remember);
+    return TRUE;
 }
 
+/***********
+ AUDIO LEVELS
+ **********/
+// Measurements taken faster than this are batched into one onVolumeChanged call
+#define AUDIO_LEVEL_MAX_INTERVAL_MS 50
 
-void rct_gst_run_loop()
+static gboolean cb_audio_level_tick(gpointer user_data)
 {
-    LOGD("Starting GStreamer main loop");
-    main_loop = g_main_loop_new(NULL, FALSE);
-    g_main_loop_run(main_loop);
-    LOGD("GStreamer main loop terminated");
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    if (player->audio_levels->len > 0 && rct_gst_get_configuration(player)->onVolumeChanged) {
+        rct_gst_get_configuration(player)->onVolumeChanged(player, (const RctGstAudioLevel *)player->audio_levels->data,
+                                                            player->audio_levels->len);
+    }
+    g_array_set_size(player->audio_levels, 0);
+    return G_SOURCE_CONTINUE;
+}
+
+// Streaming thread, the pad is linked from the player thread where the meter lives
+static void cb_audio_pad(RctGstSource *source, GstPad *pad, gpointer user_data)
+{
+    GstStructure *structure = gst_structure_new("rct-audio-pad", "pad", GST_TYPE_PAD, pad, NULL);
+    gst_element_post_message(source->source, gst_message_new_application(GST_OBJECT(source->source), structure));
+}
+
+static void cb_codec(RctGstSource *source, RctGstCodec codec, gpointer user_data)
+{
+    GstStructure *structure = gst_structure_new("rct-codec", "codec", G_TYPE_INT, codec, NULL);
+    gst_element_post_message(source->source, gst_message_new_application(GST_OBJECT(source->source), structure));
 }
 
-void rct_gst_terminate()
+static void link_audio_pad(RctGstPlayer *player, GstPad *pad)
 {
-    LOGD("Terminating GStreamer");
-    if (sink != NULL) {
-        gst_object_unref(sink);
+    GstObject *parent = gst_pad_get_parent(pad);
+
+    // Pads of a replaced or standby front end arrive late, only the active one is metered
+    if (player->audio_meter && parent == GST_OBJECT(player->source)) {
+        rct_gst_audio_meter_link(player->audio_meter, pad);
     }
-    if (video_overlay != NULL) {
-        gst_object_unref(video_overlay);
+    if (parent) {
+        gst_object_unref(parent);
     }
-    drawable_surface = 0;
-    
-    rct_gst_set_pipeline_state(GST_STATE_NULL);
-    gst_object_unref(pipeline);
-    
-    g_source_remove(bus_watch_id);
-    g_main_loop_unref(main_loop);
-    
-    g_free(configuration);
-    
-    pipeline = NULL;
-    configuration = NULL;
-    LOGD("GStreamer terminated");
 }
 
-gchar *rct_gst_get_info()
+static void stop_audio_levels(RctGstPlayer *player)
 {
-    LOGD("Entered rct_gst_get_info function");
+    if (player->audio_level_source) {
+        g_source_destroy(player->audio_level_source);
+        g_source_unref(player->audio_level_source);
+        player->audio_level_source = NULL;
+    }
+    if (player->audio_levels) {
+        g_array_free(player->audio_levels, TRUE);
+        player->audio_levels = NULL;
+    }
+    rct_gst_audio_meter_free(player->audio_meter);
+    player->audio_meter = NULL;
+}
 
-    gchar *version = gst_version_string();
-    if (version != NULL) {
-        LOGI("GStreamer version from C: %s", version);
+// The branch only exists while a refresh rate is set
+static gboolean start_audio_levels(RctGstPlayer *player)
+{
+    guint refresh_rate = rct_gst_get_configuration(player)->audioLevelRefreshRate;
+    guint interval = MIN(refresh_rate, AUDIO_LEVEL_MAX_INTERVAL_MS);
+
+    if (refresh_rate == 0 || !player->pipeline) {
+        stop_audio_levels(player);
+        return refresh_rate == 0;
+    }
+
+    if (player->audio_meter) {
+        rct_gst_audio_meter_set_interval(player->audio_meter, interval);
     } else {
-        LOGE("Failed to get GStreamer version string");
+        player->audio_meter = rct_gst_audio_meter_new(GST_BIN(player->pipeline), interval);
+        if (!player->audio_meter) {
+            return FALSE;
+        }
+        player->audio_levels = g_array_new(FALSE, FALSE, sizeof(RctGstAudioLevel));
     }
 
-    return version;
+    if (player->audio_level_source) {
+        g_source_destroy(player->audio_level_source);
+        g_source_unref(player->audio_level_source);
+    }
+    player->audio_level_source = g_timeout_source_new(refresh_rate);
+    g_source_set_callback(player->audio_level_source, cb_audio_level_tick, player, NULL);
+    g_source_attach(player->audio_level_source, player->context);
+    return TRUE;
 }
 
-void apply_uri() {
-    gchar* uri = rct_gst_get_configuration()->uri;
-    LOGD("Applying URI: %s", uri);
-    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_NULL);
-    LOGD("Set pipeline state to NULL, return value: %s", gst_element_state_change_return_get_name(ret));
-    g_object_set(source, "location", uri, NULL);
-    LOGD("URI set on pipeline");
-    ret = gst_element_set_state(pipeline, GST_STATE_PLAYING);
-    LOGD("Set pipeline state to PLAYING, return value: %s", gst_element_state_change_return_get_name(ret));
-    if (rct_gst_get_configuration()->onUriChanged) {
-        rct_gst_get_configuration()->onUriChanged(uri);
+static gboolean player_set_audio_level_refresh_rate(RctGstPlayer *player, guint refresh_rate)
+{
+    GstPad *pad;
+
+    LOGD("Setting audio level refresh rate: %u ms", refresh_rate);
+    rct_gst_get_configuration(player)->audioLevelRefreshRate = refresh_rate;
+    if (!start_audio_levels(player)) {
+        return FALSE;
+    }
+    if (refresh_rate == 0 || !player->front_end) {
+        return TRUE;
     }
 
-    // Log the pipeline description
-    gchar *pipeline_description = gst_debug_bin_to_dot_data(GST_BIN(pipeline), GST_DEBUG_GRAPH_SHOW_ALL);
-    LOGD("Pipeline description after setting URI:\n%s", pipeline_description);
-    g_free(pipeline_description);
+    if (player->front_end->audio_handler) {
+        pad = rct_gst_source_get_audio_pad(player->front_end);
+        if (pad) {
+            link_audio_pad(player, pad);
+            gst_object_unref(pad);
+        }
+        return TRUE;
+    }
+    // The running session was set up without its audio stream
+    if (GST_STATE(player->pipeline) < GST_STATE_PAUSED) {
+        rct_gst_source_set_audio_handler(player->front_end, cb_audio_pad, player);
+        return TRUE;
+    }
+    LOGD("Reopening the session with its audio stream");
+    return restart_front_end(player);
 }
 
-void on_pad_added(GstElement *src, GstPad *new_pad, gpointer depay) {
-    GstPad *sink_pad = gst_element_get_static_pad(GST_ELEMENT(depay), "sink");
-    GstPadLinkReturn ret;
-    GstCaps *new_pad_caps = NULL;
-    GstStructure *new_pad_struct = NULL;
-    const gchar *new_pad_type = NULL;
+// Opens a standby session, its GOP cache starts filling right away
+static gboolean player_prepare_uri(RctGstPlayer *player, gchar *uri)
+{
+    RctGstSource *front_end;
 
-    LOGD("Received new pad '%s' from '%s':", GST_PAD_NAME(new_pad), GST_ELEMENT_NAME(src));
+    if (!player->pipeline || !player->front_end || !player->standby_pool || player->standby_pool->capacity == 0 ||
+        uri == NULL) {
+        return FALSE;
+    }
+    if (g_strcmp0(player->front_end->uri, uri) == 0) {
+        return TRUE;
+    }
 
-    // Check the new pad's type
-    new_pad_caps = gst_pad_get_current_caps(new_pad);
-    new_pad_struct = gst_caps_get_structure(new_pad_caps, 0);
-    new_pad_type = gst_structure_get_name(new_pad_struct);
-    if (!g_str_has_prefix(new_pad_type, "application/x-rtp")) {
-        LOGD("  It has type '%s' which is not application/x-rtp. Ignoring.", new_pad_type);
-        if (new_pad_caps != NULL) {
-            gst_caps_unref(new_pad_caps);
+    front_end = rct_gst_standby_pool_take(player->standby_pool, uri);
+    if (!front_end) {
+        LOGD("Preparing standby URI: %s", uri);
+        front_end = create_front_end(player, uri);
+        if (!front_end) {
+            return FALSE;
         }
-        return;
+        rct_gst_source_start(front_end);
     }
+    rct_gst_standby_pool_put(player->standby_pool, front_end);
+    return TRUE;
+}
 
-    // Attempt to link
-    ret = gst_pad_link(new_pad, sink_pad);
-    if (GST_PAD_LINK_FAILED(ret)) {
-        LOGE("  Type is '%s' but link failed.");
-    } else {
-        LOGD("  Link succeeded (type '%s').");
+// GStreamer's debug log is process wide: active and at INFO at least while any player debugs, as it was after
+static GMutex debugging_lock;
+static guint debugging_players;
+static gboolean active_before_debugging;
+static GstDebugLevel threshold_before_debugging;
+
+static void count_debugging_player(gboolean is_debugging)
+{
+    g_mutex_lock(&debugging_lock);
+    if (is_debugging && debugging_players++ == 0) {
+        active_before_debugging = gst_debug_is_active();
+        threshold_before_debugging = gst_debug_get_default_threshold();
+        gst_debug_set_active(TRUE);
+        gst_debug_set_default_threshold(MAX(threshold_before_debugging, GST_LEVEL_INFO));
+    } else if (!is_debugging && --debugging_players == 0) {
+        gst_debug_set_default_threshold(threshold_before_debugging);
+        gst_debug_set_active(active_before_debugging);
     }
+    g_mutex_unlock(&debugging_lock);
+}
+
+static gboolean player_set_debugging(RctGstPlayer *player, gboolean is_debugging)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
 
-    if (new_pad_caps != NULL) {
-        gst_caps_unref(new_pad_caps);
+    LOGD("Setting debugging: %s", is_debugging ? "true" : "false");
+    if (configuration->isDebugging == is_debugging) {
+        return TRUE;
     }
+    configuration->isDebugging = is_debugging;
+    count_debugging_player(is_debugging);
+    return TRUE;
+}
 
-    gst_object_unref(sink_pad);
+/**********************
+ VIDEO HANDLING METHODS
+ *********************/
+void rct_gst_set_drawable_surface(RctGstPlayer *player, guintptr _drawableSurface) {
+    LOGD("Posting drawable surface from C: %p", (void*)_drawableSurface);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_DRAWABLE_SURFACE);
+    command->args.drawable_surface = _drawableSurface;
+    rct_gst_command_queue_push(player->commands, command);
 }
 
-void reset_pipeline() {
-    LOGD("Resetting pipeline");
+static gboolean player_set_drawable_surface(RctGstPlayer *player, guintptr _drawableSurface) {
+    LOGD("Setting drawable surface from C: %p", (void*)_drawableSurface);
+    player->drawable_surface = _drawableSurface;
+
+    // The sink gets its window back on resume
+    if (player->suspended) {
+        return !player->resume_pending || _drawableSurface == 0 || player_resume(player);
+    }
+
+    if (player->shared_view) {
+        rct_gst_shared_view_set_window(player->shared_view, player->drawable_surface);
+        return TRUE;
+    }
+    
+    if (player->pipeline && GST_IS_VIDEO_OVERLAY(player->sink)) {
+        LOGD("Setting window handle on video overlay");
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), player->drawable_surface);
+        return TRUE;
+    }
+    LOGD("Pipeline not built yet, drawable surface will be applied on init");
+    return FALSE;
+}
 
-    // Set pipeline to NULL state
-    gst_element_set_state(pipeline, GST_STATE_NULL);
+void rct_gst_set_surface_size(RctGstPlayer *player, gint width, gint height)
+{
+    LOGD("Posting surface size: %dx%d", width, height);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_SURFACE_SIZE);
+    command->args.surface_size.width = width;
+    command->args.surface_size.height = height;
+    rct_gst_command_queue_push(player->commands, command);
+}
 
-    // Set the URI again
-    apply_uri();
+// Bounds the scaler output to the surface, divided while QoS lowers the resolution. Ranges let videoscale
+// keep the display aspect ratio, and frames that already fit go through untouched. Changing the caps renegotiates live.
+static void apply_surface_size(RctGstPlayer *player)
+{
+    GstCaps *caps = NULL;
+    gint width = player->surface_width / player->resolution_divisor;
+    gint height = player->surface_height / player->resolution_divisor;
 
-    // Set pipeline to PLAYING state
-    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    if (!player->scale_filter) {
+        return;
+    }
+    if (width > 0 && height > 0) {
+        caps = gst_caps_new_simple("video/x-raw",
+                                   "width", GST_TYPE_INT_RANGE, 16, MAX(width, 16),
+                                   "height", GST_TYPE_INT_RANGE, 16, MAX(height, 16),
+                                   NULL);
+    }
+    LOGD("Scaling frames to fit %dx%d", width, height);
+    g_object_set(G_OBJECT(player->scale_filter), "caps", caps, NULL);
+    if (caps) {
+        gst_caps_unref(caps);
+    }
+}
 
-    LOGD("Pipeline reset complete");
+static gboolean player_set_surface_size(RctGstPlayer *player, gint width, gint height)
+{
+    if (width == player->surface_width && height == player->surface_height) {
+        return TRUE;
+    }
+    player->surface_width = width;
+    player->surface_height = height;
+    if (player->mosaic) {
+        rct_gst_mosaic_set_output_size(player->mosaic, width, height);
+        return TRUE;
+    }
+    apply_surface_size(player);
+    return player->scale_filter != NULL;
 }
+
+GstBusSyncReply cb_create_window(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    if (!gst_is_video_overlay_prepare_window_handle_message(message)) {
+        return GST_BUS_PASS;
+    }
+
+    if (player->drawable_surface != 0) {
+        LOGD("Setting window handle from message sync");
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), player->drawable_surface);
+    }
+    
+    gst_message_unref(message);
+    return GST_BUS_DROP;
+}
+
+/*********************
+ APPLICATION CALLBACKS
+ ********************/
+// Errors of rtspsrc (and of the elements it spawns) or of the depayloader only need a new front end
+static gboolean is_front_end_object(RctGstPlayer *player, GstObject *object)
+{
+    if (!player->front_end) {
+        return FALSE;
+    }
+    return object == GST_OBJECT(player->source) || object == GST_OBJECT(player->depay) ||
+           gst_object_has_as_ancestor(object, GST_OBJECT(player->source));
+}
+
+static gboolean is_degraded(RctGstPlayer *player)
+{
+    RctGstReconnectStats stats;
+    rct_gst_reconnect_get_stats(player->reconnect, &stats);
+    return stats.degraded;
+}
+
+// Restarts are scheduled with backoff, only the first failure of a degraded episode reaches the callbacks
+static void cb_error(GstBus *bus, GstMessage *msg, RctGstPlayer *player)
+{
+    GError *err;
+    gchar *debug_info;
+    gboolean degraded = is_degraded(player);
+    
+    gst_message_parse_error(msg, &err, &debug_info);
+    LOGE("Error received from element %s: %s", GST_OBJECT_NAME(msg->src), err->message);
+
+    // Tiles recover on their own, the other ones keep playing
+    if (player->mosaic) {
+        if (rct_gst_get_configuration(player)->onElementError) {
+            rct_gst_get_configuration(player)->onElementError(player, GST_OBJECT_NAME(msg->src), err->message, debug_info);
+        }
+        if (!rct_gst_mosaic_failure(player->mosaic, msg->src, err->message)) {
+            LOGE("Mosaic error outside of any tile");
+        }
+        g_clear_error(&err);
+        g_free(debug_info);
+        return;
+    }
+
+    // A session that never showed a frame moves on to the next transport right away
+    if (is_front_end_object(player, msg->src) && rct_gst_transport_failed(player->transport)) {
+        g_clear_error(&err);
+        g_free(debug_info);
+        return;
+    }
+    if (!degraded && rct_gst_get_configuration(player)->onElementError) {
+        rct_gst_get_configuration(player)->onElementError(player, GST_OBJECT_NAME(msg->src), err->message, debug_info);
+    }
+    rct_gst_reconnect_failure(player->reconnect,
+                              is_front_end_object(player, msg->src) ? RCT_GST_RESTART_SOURCE : RCT_GST_RESTART_PIPELINE,
+                              err->message);
+    g_clear_error(&err);
+    g_free(debug_info);
+}
+
+static void cb_eos(GstBus *bus, GstMessage *msg, RctGstPlayer *player)
+{
+    gboolean degraded = is_degraded(player);
+
+    LOGD("End of stream (EOS) received");
+    if (!degraded && rct_gst_get_configuration(player)->onEOS) {
+        rct_gst_get_configuration(player)->onEOS(player);
+    }
+    // Every tile ended, their watchdogs bring them back one by one
+    if (player->mosaic) {
+        return;
+    }
+    // A file or HTTP uri played to its end, it stays there until seeked
+    if (player->front_end && !player->front_end->live) {
+        rct_gst_reconnect_set_armed(player->reconnect, FALSE);
+        return;
+    }
+    // A live session that ended, the pipeline itself is fine
+    rct_gst_reconnect_failure(player->reconnect, RCT_GST_RESTART_SOURCE, "end of stream");
+}
+
+static void cb_state_changed(GstBus *bus, GstMessage *msg, RctGstPlayer *player)
+{
+    GstState old_state, new_state, pending_state;
+    gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
+
+    if (GST_MESSAGE_SRC(msg) == GST_OBJECT(player->pipeline)) {
+        LOGD("Pipeline state changed from %s to %s", gst_element_state_get_name(old_state), gst_element_state_get_name(new_state));
+        if (rct_gst_get_configuration(player)->onStateChanged) {
+            rct_gst_get_configuration(player)->onStateChanged(player, old_state, new_state);
+        }
+    }
+}
+
+static gboolean cb_message_element(GstBus *bus, GstMessage *msg, RctGstPlayer *player)
+{
+    RctGstAudioLevel level;
+
+    if (player->audio_meter && rct_gst_audio_meter_parse(player->audio_meter, msg, &level)) {
+        g_array_append_val(player->audio_levels, level);
+        g_mutex_lock(&player->info_lock);
+        player->audio_level = level;
+        player->has_audio_level = TRUE;
+        g_mutex_unlock(&player->info_lock);
+    }
+    return TRUE;
+}
+
+static void update_element_chain(RctGstPlayer *player)
+{
+    GstElement *elements[] = { player->source, player->depay, player->parser, player->decode_queue, player->decoder,
+                               player->scale, player->scale_filter, player->render_queue, player->conv, player->sink };
+    gchar *element_chain = player->mosaic ? rct_gst_mosaic_describe(player->mosaic)
+                                          : rct_gst_autoplug_describe(elements, G_N_ELEMENTS(elements));
+
+    LOGI("Element chain: %s", element_chain);
+    g_mutex_lock(&player->info_lock);
+    g_free(player->element_chain);
+    player->element_chain = element_chain;
+    g_mutex_unlock(&player->info_lock);
+}
+
+static void cb_application(GstBus *bus, GstMessage *msg, RctGstPlayer *player)
+{
+    const GstStructure *structure = gst_message_get_structure(msg);
+    gint64 ttff_us = 0;
+
+    if (gst_structure_has_name(structure, "rct-seek-frame")) {
+        report_seek_done(player, structure);
+        return;
+    }
+    if (gst_structure_has_name(structure, "rct-codec")) {
+        front_end_codec_known(player, GST_MESSAGE_SRC(msg));
+        return;
+    }
+    if (gst_structure_has_name(structure, "rct-audio-pad")) {
+        GstPad *pad = NULL;
+        if (gst_structure_get(structure, "pad", GST_TYPE_PAD, &pad, NULL)) {
+            link_audio_pad(player, pad);
+            gst_object_unref(pad);
+        }
+        return;
+    }
+    if (!gst_structure_has_name(structure, "rct-first-frame")) {
+        return;
+    }
+
+    gst_structure_get_int64(structure, "ttff", &ttff_us);
+    player->last_switch_ttff_us = ttff_us;
+    rct_gst_transport_first_frame(player->transport, ttff_us);
+    LOGI("First frame after uri switch (mode %d) in %lld us over %s", player->switch_mode, (long long)ttff_us,
+         rct_gst_transport_get_name(rct_gst_transport_get_current(player->transport)));
+    if (rct_gst_get_configuration(player)->onFirstFrame) {
+        rct_gst_get_configuration(player)->onFirstFrame(player, player->switch_mode, ttff_us,
+                                                        rct_gst_transport_get_current(player->transport));
+    }
+}
+
+static gboolean cb_async_done(GstBus *bus, GstMessage *message, RctGstPlayer *player)
+{
+    LOGD("Async done message received");
+    if (GST_MESSAGE_SRC(message) == GST_OBJECT(player->pipeline)) {
+        seek_prerolled(player);
+    }
+    return TRUE;
+}
+
+static gboolean cb_bus_watch(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    switch (GST_MESSAGE_TYPE(message)) {
+        case GST_MESSAGE_ERROR:
+            cb_error(bus, message, player);
+            break;
+            
+        case GST_MESSAGE_EOS:
+            cb_eos(bus, message, player);
+            break;
+            
+        case GST_MESSAGE_STATE_CHANGED:
+            cb_state_changed(bus, message, player);
+            break;
+            
+        case GST_MESSAGE_ELEMENT:
+            cb_message_element(bus, message, player);
+            break;
+            
+        case GST_MESSAGE_ASYNC_DONE:
+            cb_async_done(bus, message, player);
+            break;
+
+        case GST_MESSAGE_APPLICATION:
+            cb_application(bus, message, player);
+            break;
+
+        case GST_MESSAGE_QOS:
+            rct_gst_stats_on_qos(player->stats, message);
+            rct_gst_qos_on_message(player->qos, message);
+            break;
+
+        case GST_MESSAGE_LATENCY:
+            // A jitterbuffer latency changed while playing
+            gst_bin_recalculate_latency(GST_BIN(player->pipeline));
+            break;
+            
+        default:
+            LOGD("Unhandled message type: %s", GST_MESSAGE_TYPE_NAME(message));
+            break;
+    }
+    
+    return TRUE;
+}
+
+/***************
+ URI SWITCH PROBES
+ **************/
+// Decoder input: after a switch, delta frames are dropped so the sink keeps the last
+// picture of the previous uri instead of showing a smeared one
+static GstPadProbeReturn cb_keyframe_gate(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    if (!g_atomic_int_get(&player->awaiting_keyframe)) {
+        return GST_PAD_PROBE_OK;
+    }
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        return GST_PAD_PROBE_DROP;
+    }
+    g_atomic_int_set(&player->awaiting_keyframe, FALSE);
+    return GST_PAD_PROBE_OK;
+}
+
+// Sink input: first decoded frame after a switch, reported through the bus
+static GstPadProbeReturn cb_first_frame(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    if (g_atomic_int_compare_and_exchange(&player->seek_frame_pending, TRUE, FALSE)) {
+        GstStructure *structure = gst_structure_new("rct-seek-frame",
+                                                    "latency", G_TYPE_INT64, g_get_monotonic_time() - player->seek_started_at,
+                                                    NULL);
+        gst_element_post_message(player->sink, gst_message_new_application(GST_OBJECT(player->sink), structure));
+    }
+    if (!g_atomic_int_compare_and_exchange(&player->first_frame_pending, TRUE, FALSE)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    rct_gst_startup_mark(RCT_GST_STARTUP_FIRST_FRAME);
+    GstStructure *structure = gst_structure_new("rct-first-frame",
+                                                "ttff", G_TYPE_INT64, g_get_monotonic_time() - player->switch_started_at,
+                                                NULL);
+    gst_element_post_message(player->sink, gst_message_new_application(GST_OBJECT(player->sink), structure));
+    return GST_PAD_PROBE_OK;
+}
+
+/*****************
+ CONVERSION FALLBACK
+ ****************/
+// Element right before the sink when there is no converter
+static GstElement *raw_output(RctGstPlayer *player)
+{
+    if (player->render_queue) {
+        return player->render_queue;
+    }
+    return player->scale_filter ? player->scale_filter : player->decoder;
+}
+
+// Raw output: the decoder (or the scaler) is linked straight to the sink and videoconvert
+// only gets inserted when the sink refuses the caps being negotiated
+typedef struct {
+    RctGstPlayer *player;
+    GstPad *pad;                        // Raw output src pad, blocked until the chain is relinked
+    gulong block_id;
+} ConverterInsertion;
+
+#define CONVERTER_PENDING "rct-converter-pending"
+
+static void converter_insertion_free(gpointer user_data)
+{
+    ConverterInsertion *insertion = (ConverterInsertion *)user_data;
+
+    gst_object_unref(insertion->pad);
+    g_free(insertion);
+}
+
+static GstPadProbeReturn cb_block(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    return GST_PAD_PROBE_OK;
+}
+
+// Player thread, the streaming thread waits on the block. Relinking resends the sticky caps either
+// to videoconvert or, when it could not go in, to the sink that refuses them again and errors.
+static gboolean cb_insert_converter_idle(gpointer user_data)
+{
+    ConverterInsertion *insertion = (ConverterInsertion *)user_data;
+    RctGstPlayer *player = insertion->player;
+    GstElement *upstream = gst_pad_get_parent_element(insertion->pad);
+    GstElement *conv;
+
+    // Torn down or decode path replaced in the meantime
+    if (!upstream || !player->pipeline || player->conv || upstream != raw_output(player)) {
+        gst_pad_remove_probe(insertion->pad, insertion->block_id);
+        if (upstream) {
+            gst_object_unref(upstream);
+        }
+        return G_SOURCE_REMOVE;
+    }
+
+    gst_element_unlink(upstream, player->sink);
+    conv = gst_element_factory_make("videoconvert", "conv");
+    if (!conv) {
+        LOGE("Sink refused decoder caps and videoconvert is missing");
+    } else {
+        LOGI("Sink refused decoder caps, inserting videoconvert");
+        gst_bin_add(GST_BIN(player->pipeline), conv);
+        if (gst_element_link_many(upstream, conv, player->sink, NULL)) {
+            gst_element_sync_state_with_parent(conv);
+            g_atomic_pointer_set(&player->conv, conv);
+        } else {
+            LOGE("videoconvert could not be linked, restoring the direct link");
+            // Removing it unlinks whatever part got linked
+            gst_element_set_state(conv, GST_STATE_NULL);
+            gst_bin_remove(GST_BIN(player->pipeline), conv);
+            conv = NULL;
+        }
+    }
+    if (!conv) {
+        gst_element_link(upstream, player->sink);
+    }
+
+    g_object_set_data(G_OBJECT(insertion->pad), CONVERTER_PENDING, NULL);
+    gst_pad_remove_probe(insertion->pad, insertion->block_id);
+    gst_object_unref(upstream);
+    update_element_chain(player);
+    return G_SOURCE_REMOVE;
+}
+
+// Streaming thread: the refused caps are dropped, they stay sticky on the pad, and the next item
+// is held back while the player thread changes the chain
+static GstPadProbeReturn cb_raw_caps(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+    ConverterInsertion *insertion;
+    GstCaps *caps;
+
+    if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS || g_atomic_pointer_get(&player->conv)) {
+        return GST_PAD_PROBE_OK;
+    }
+    if (g_object_get_data(G_OBJECT(pad), CONVERTER_PENDING)) {
+        return GST_PAD_PROBE_DROP;
+    }
+
+    gst_event_parse_caps(event, &caps);
+    if (gst_pad_peer_query_accept_caps(pad, caps)) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    insertion = g_new0(ConverterInsertion, 1);
+    insertion->player = player;
+    insertion->pad = gst_object_ref(pad);
+    insertion->block_id = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM, cb_block, NULL, NULL);
+    g_object_set_data(G_OBJECT(pad), CONVERTER_PENDING, GINT_TO_POINTER(TRUE));
+    g_main_context_invoke_full(player->context, G_PRIORITY_DEFAULT, cb_insert_converter_idle, insertion,
+                               converter_insertion_free);
+    return GST_PAD_PROBE_DROP;
+}
+
+static void start_switch_tracking(RctGstPlayer *player, RctGstUriSwitchMode mode)
+{
+    player->switch_mode = mode;
+    player->switch_started_at = g_get_monotonic_time();
+    // Only a new RTSP session has a transport to prove
+    if ((mode == RCT_GST_URI_SWITCH_SOURCE_ONLY || mode == RCT_GST_URI_SWITCH_FULL_RESTART) &&
+        rct_gst_source_uri_is_live(rct_gst_get_configuration(player)->uri)) {
+        rct_gst_transport_attempt_started(player->transport, rct_gst_get_configuration(player)->uri);
+    } else {
+        rct_gst_transport_attempt_cancelled(player->transport);
+    }
+    g_atomic_int_set(&player->awaiting_keyframe, TRUE);
+    g_atomic_int_set(&player->first_frame_pending, TRUE);
+}
+
+/*****
+ SEEKING
+ ****/
+// Only non-live front ends can move back and forth, tiles and shared decodes follow their sessions
+static gboolean is_seekable(RctGstPlayer *player)
+{
+    if (!player->pipeline || !player->front_end || player->front_end->live || player->suspended) {
+        LOGE("Seeking needs a file or HTTP uri playing");
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean do_seek(RctGstPlayer *player, gint64 position_us, RctGstSeekMode mode)
+{
+    GstSeekFlags flags = GST_SEEK_FLAG_FLUSH;
+    GstClockTime position = MAX(position_us, 0) * GST_USECOND;
+    gboolean done;
+
+    flags |= mode == RCT_GST_SEEK_KEYFRAME ? GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_NEAREST : GST_SEEK_FLAG_ACCURATE;
+
+    // Past twice the speed or backwards, decoding every frame can't keep up: keyframes only
+    if (player->rate > 2.0 || player->rate < 0) {
+        flags |= GST_SEEK_FLAG_TRICKMODE | GST_SEEK_FLAG_TRICKMODE_KEY_UNITS;
+    }
+    if (player->rate > 0) {
+        done = gst_element_seek(player->pipeline, player->rate, GST_FORMAT_TIME, flags,
+                                GST_SEEK_TYPE_SET, position, GST_SEEK_TYPE_NONE, GST_CLOCK_TIME_NONE);
+    } else {
+        // Backwards plays the segment from its end down to the start of the stream
+        done = gst_element_seek(player->pipeline, player->rate, GST_FORMAT_TIME, flags,
+                                GST_SEEK_TYPE_SET, 0, GST_SEEK_TYPE_SET, position);
+    }
+    if (!done) {
+        LOGE("Seek to %lld us refused", (long long)position_us);
+        return FALSE;
+    }
+
+    player->seek_pending = TRUE;
+    player->seek_started_at = g_get_monotonic_time();
+    g_atomic_int_set(&player->seek_frame_pending, TRUE);
+
+    // Seeking back from the end of stream plays again
+    if (GST_STATE_TARGET(player->pipeline) == GST_STATE_PLAYING) {
+        rct_gst_reconnect_set_armed(player->reconnect, TRUE);
+    }
+    return TRUE;
+}
+
+// The pipeline prerolled on the last seek, a scrub that came meanwhile goes to its latest position only
+static void seek_prerolled(RctGstPlayer *player)
+{
+    gint64 target_us = player->scrub_target_us;
+
+    if (!player->seek_pending) {
+        return;
+    }
+    player->seek_pending = FALSE;
+    player->scrub_target_us = -1;
+    if (target_us >= 0) {
+        do_seek(player, target_us, RCT_GST_SEEK_KEYFRAME);
+    }
+}
+
+static void report_seek_done(RctGstPlayer *player, const GstStructure *structure)
+{
+    gint64 latency_us = 0, position = 0, duration = 0;
+
+    gst_structure_get_int64(structure, "latency", &latency_us);
+    gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &position);
+    gst_element_query_duration(player->pipeline, GST_FORMAT_TIME, &duration);
+    LOGD("First frame after seek to %lld ms in %lld us", (long long)(position / GST_MSECOND), (long long)latency_us);
+    if (rct_gst_get_configuration(player)->onSeekDone) {
+        rct_gst_get_configuration(player)->onSeekDone(player, position / GST_USECOND, duration / GST_USECOND, latency_us);
+    }
+}
+
+// The cache follows the uri, the thumbnails of another one are worth nothing
+static void update_scrub_cache(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    gboolean wanted = configuration->scrubCacheBytes > 0 && configuration->uri && player->front_end &&
+                      !player->front_end->live;
+
+    if (player->scrub_cache &&
+        (!wanted || g_strcmp0(rct_gst_scrub_cache_get_uri(player->scrub_cache), configuration->uri) != 0)) {
+        rct_gst_scrub_cache_free(player->scrub_cache);
+        player->scrub_cache = NULL;
+    }
+    if (wanted && !player->scrub_cache) {
+        player->scrub_cache = rct_gst_scrub_cache_new(configuration->uri, configuration->scrubThumbnailWidth,
+                                                      configuration->scrubCacheBytes);
+    }
+}
+
+static gboolean player_set_scrub_cache(RctGstPlayer *player, gsize max_bytes, gint thumbnail_width)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    configuration->scrubCacheBytes = max_bytes;
+    configuration->scrubThumbnailWidth = thumbnail_width;
+
+    // Thumbnails of another size are decoded again
+    rct_gst_scrub_cache_free(player->scrub_cache);
+    player->scrub_cache = NULL;
+    update_scrub_cache(player);
+    return TRUE;
+}
+
+static gboolean player_seek(RctGstPlayer *player, gint64 position_us, RctGstSeekMode mode)
+{
+    if (!is_seekable(player)) {
+        return FALSE;
+    }
+    player->scrub_target_us = -1;
+    return do_seek(player, position_us, mode);
+}
+
+static gboolean player_set_rate(RctGstPlayer *player, gdouble rate)
+{
+    gint64 position = 0;
+
+    if (rate == 0 || !is_seekable(player) ||
+        !gst_element_query_position(player->pipeline, GST_FORMAT_TIME, &position)) {
+        return FALSE;
+    }
+    player->rate = rate;
+    return do_seek(player, position / GST_USECOND, RCT_GST_SEEK_ACCURATE);
+}
+
+// The preview comes from the cache right away. Seeks are issued one at a time, a fast drag
+// only seeks as often as the decoder prerolls, always towards its latest position.
+static gboolean player_scrub(RctGstPlayer *player, gint64 position_us)
+{
+    RctGstScrubThumbnail thumbnail;
+
+    if (!is_seekable(player)) {
+        return FALSE;
+    }
+    if (player->scrub_cache && rct_gst_scrub_cache_lookup(player->scrub_cache, position_us, &thumbnail)) {
+        if (rct_gst_get_configuration(player)->onScrubPreview) {
+            rct_gst_get_configuration(player)->onScrubPreview(player, &thumbnail);
+        }
+        gst_buffer_unref(thumbnail.pixels);
+    }
+    if (player->seek_pending) {
+        player->scrub_target_us = position_us;
+        return TRUE;
+    }
+    return do_seek(player, position_us, RCT_GST_SEEK_KEYFRAME);
+}
+
+/*****
+ SNAPSHOTS
+ ****/
+// The sink keeps the last frame it rendered, only a reference to it leaves the player thread
+static gboolean player_snapshot(RctGstPlayer *player, RctGstSnapshotFormat format, gint max_size, const gchar *path,
+                                RctGstSnapshotFunc done, gpointer user_data)
+{
+    GstSample *sample = NULL;
+
+    if (player->shared_view) {
+        sample = rct_gst_shared_view_get_last_sample(player->shared_view);
+    } else if (player->sink && g_object_class_find_property(G_OBJECT_GET_CLASS(player->sink), "last-sample")) {
+        g_object_get(G_OBJECT(player->sink), "last-sample", &sample, NULL);
+    }
+    if (!sample) {
+        rct_gst_snapshotter_fail("no frame displayed", done, user_data);
+        return FALSE;
+    }
+    rct_gst_snapshotter_take(player->snapshotter, sample, format, max_size, path, done, user_data);
+    gst_sample_unref(sample);
+    return TRUE;
+}
+
+/*****
+ DEBUGGING
+ ****/
+// Only on request, a description of the whole graph is too large to log on every start
+static gboolean player_dump_graph(RctGstPlayer *player, const gchar *path)
+{
+    GError *error = NULL;
+    gchar *description;
+    gboolean written;
+
+    if (!player->pipeline || !path) {
+        LOGE("No pipeline graph to dump");
+        return FALSE;
+    }
+    description = gst_debug_bin_to_dot_data(GST_BIN(player->pipeline), GST_DEBUG_GRAPH_SHOW_ALL);
+    written = g_file_set_contents(path, description, -1, &error);
+    if (!written) {
+        LOGE("Pipeline graph could not be written to %s: %s", path, error->message);
+        g_clear_error(&error);
+    }
+    g_free(description);
+    return written;
+}
+
+/*****
+ DVR
+ ****/
+typedef struct {
+    RctGstPlayer *player;
+    gchar *path;
+    gboolean success;
+    gint64 duration_us;
+} DvrExportEvent;
+
+static void dvr_export_event_free(gpointer data)
+{
+    DvrExportEvent *event = (DvrExportEvent *)data;
+
+    g_free(event->path);
+    g_free(event);
+}
+
+// Player thread: reports the exports finished so far, in completion order
+static void deliver_dvr_exports(RctGstPlayer *player)
+{
+    GQueue finished;
+    DvrExportEvent *event;
+
+    g_mutex_lock(&player->info_lock);
+    finished = player->dvr_exports;
+    g_queue_init(&player->dvr_exports);
+    g_mutex_unlock(&player->info_lock);
+
+    while ((event = (DvrExportEvent *)g_queue_pop_head(&finished))) {
+        if (rct_gst_get_configuration(player)->onDvrExport) {
+            rct_gst_get_configuration(player)->onDvrExport(player, event->path, event->success, event->duration_us);
+        }
+        dvr_export_event_free(event);
+    }
+}
+
+static gboolean cb_dvr_export_idle(gpointer user_data)
+{
+    deliver_dvr_exports((RctGstPlayer *)user_data);
+    return G_SOURCE_REMOVE;
+}
+
+// Export thread. Queued for the player thread, which reports it on its next iteration, or right after
+// terminate joined the export workers when the loop is about to quit.
+static void cb_dvr_export(RctGstDvr *dvr, const gchar *path, gboolean success, gint64 duration_us,
+                          gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    DvrExportEvent *event = g_new0(DvrExportEvent, 1);
+
+    (void)dvr;
+    event->player = player;
+    event->path = g_strdup(path);
+    event->success = success;
+    event->duration_us = duration_us;
+
+    g_mutex_lock(&player->info_lock);
+    g_queue_push_tail(&player->dvr_exports, event);
+    g_mutex_unlock(&player->info_lock);
+    g_main_context_invoke_full(player->context, G_PRIORITY_DEFAULT, cb_dvr_export_idle, player, NULL);
+}
+
+// Bounds apply right away, enabling or disabling the ring waits for the next init
+static gboolean player_set_dvr_policy(RctGstPlayer *player, guint max_duration, gsize max_bytes)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    configuration->dvrMaxDuration = max_duration;
+    configuration->dvrMaxBytes = max_bytes;
+    if (!player->dvr) {
+        return player->pipeline == NULL;
+    }
+    if (max_duration > 0 || max_bytes > 0) {
+        rct_gst_dvr_set_limits(player->dvr, max_duration, max_bytes);
+    }
+    return TRUE;
+}
+
+static gboolean player_dvr_play_from(RctGstPlayer *player, guint offset_ms)
+{
+    RctGstDvrStatus status;
+
+    if (!player->dvr || player->suspended) {
+        return FALSE;
+    }
+    rct_gst_dvr_get_status(player->dvr, &status);
+
+    // Live resumes mid GOP, the decoder waits for its next keyframe
+    if (rct_gst_dvr_play_from(player->dvr, offset_ms) == 0 && status.offset_ms > 0) {
+        g_atomic_int_set(&player->awaiting_keyframe, TRUE);
+    }
+    return TRUE;
+}
+
+static gboolean player_dvr_export(RctGstPlayer *player, guint offset_ms, guint duration_ms, const gchar *path,
+                                  RctGstDvrFormat format)
+{
+    if (!player->dvr || !path) {
+        return FALSE;
+    }
+    return rct_gst_dvr_export(player->dvr, offset_ms, duration_ms, path, format, cb_dvr_export, player);
+}
+
+/*****
+ MOSAIC
+ ****/
+static gboolean player_set_mosaic_layout(RctGstPlayer *player, guint columns, guint rows)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    configuration->mosaicColumns = columns;
+    configuration->mosaicRows = rows;
+    if (!player->mosaic) {
+        return player->pipeline == NULL;
+    }
+    // A player stays a mosaic once initialized as one, a 0 grid keeps a single tile
+    rct_gst_mosaic_set_layout(player->mosaic, columns, rows);
+    if (player->mosaic_uris->len > MAX(columns, 1) * MAX(rows, 1)) {
+        g_ptr_array_set_size(player->mosaic_uris, MAX(columns, 1) * MAX(rows, 1));
+    }
+    update_element_chain(player);
+    return TRUE;
+}
+
+static gboolean player_set_mosaic_tile(RctGstPlayer *player, guint index, gchar *uri)
+{
+    gboolean result = TRUE;
+
+    if (index >= player->mosaic_uris->len) {
+        g_ptr_array_set_size(player->mosaic_uris, index + 1);
+    }
+    g_free(g_ptr_array_index(player->mosaic_uris, index));
+    g_ptr_array_index(player->mosaic_uris, index) = g_strdup(uri);
+
+    if (player->mosaic) {
+        result = rct_gst_mosaic_set_tile(player->mosaic, index, uri);
+        update_element_chain(player);
+    }
+    return result;
+}
+
+// compositor ! capsfilter ! [videoconvert !] sink, the tiles plug into the compositor
+static gboolean player_init_mosaic(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    GstElement *upstream;
+    GstBus *bus;
+    guint i;
+
+    LOGD("Initializing %ux%u mosaic for player %p", configuration->mosaicColumns, configuration->mosaicRows, player);
+    player->pipeline = gst_pipeline_new("pipeline");
+    player->sink = gst_element_factory_make(configuration->videoSink ? configuration->videoSink : "glimagesink", "video_sink");
+    if (configuration->forceVideoConvert) {
+        player->conv = gst_element_factory_make("videoconvert", "conv");
+    }
+    player->mosaic = player->pipeline ? rct_gst_mosaic_new(GST_BIN(player->pipeline), player->context,
+                                                           configuration->mosaicColumns, configuration->mosaicRows)
+                                      : NULL;
+    if (!player->mosaic || !player->sink || (configuration->forceVideoConvert && !player->conv)) {
+        LOGE("Failed to create mosaic elements");
+        rct_gst_mosaic_free(player->mosaic);
+        if (player->sink) {
+            gst_object_unref(player->sink);
+        }
+        if (player->conv) {
+            gst_object_unref(player->conv);
+        }
+        if (player->pipeline) {
+            gst_object_unref(player->pipeline);
+        }
+        player->mosaic = NULL;
+        player->pipeline = player->sink = player->conv = NULL;
+        return FALSE;
+    }
+
+    g_object_set(G_OBJECT(player->sink), "sync", FALSE, NULL);
+    g_object_set(G_OBJECT(player->sink), "max-lateness", -1, NULL);
+    upstream = rct_gst_mosaic_get_output(player->mosaic);
+    gst_bin_add(GST_BIN(player->pipeline), player->sink);
+    if (player->conv) {
+        gst_bin_add(GST_BIN(player->pipeline), player->conv);
+        gst_element_link(upstream, player->conv);
+        upstream = player->conv;
+    }
+    if (!gst_element_link(upstream, player->sink)) {
+        LOGE("Mosaic could not be linked to the sink");
+    }
+    rct_gst_mosaic_set_output_size(player->mosaic, player->surface_width, player->surface_height);
+
+    bus = gst_element_get_bus(player->pipeline);
+    player->bus_watch_id = gst_bus_add_watch(bus, cb_bus_watch, player);
+    gst_bus_set_sync_handler(bus, (GstBusSyncHandler)cb_create_window, player, NULL);
+    gst_object_unref(bus);
+
+    if (player->drawable_surface == 0) {
+        player->drawable_surface = configuration->initialDrawableSurface;
+    }
+    if (player->drawable_surface != 0) {
+        player_set_drawable_surface(player, player->drawable_surface);
+    }
+
+    // Tiles join a running pipeline the same way whether they were set before init or not
+    gst_element_set_state(player->pipeline, GST_STATE_PLAYING);
+    rct_gst_mosaic_set_playing(player->mosaic, TRUE);
+    for (i = 0; i < player->mosaic_uris->len; i++) {
+        if (g_ptr_array_index(player->mosaic_uris, i)) {
+            rct_gst_mosaic_set_tile(player->mosaic, i, (const gchar *)g_ptr_array_index(player->mosaic_uris, i));
+        }
+    }
+    update_element_chain(player);
+    rct_gst_startup_mark(RCT_GST_STARTUP_PIPELINE_BUILT);
+
+    if (configuration->onInit) {
+        configuration->onInit(player);
+    }
+    return TRUE;
+}
+
+/************
+ SHARED DECODE
+ ***********/
+// Streaming thread events of the view, handed over to the player thread
+typedef struct {
+    RctGstPlayer *player;
+    RctGstSharedView *view;
+    gint64 ttff_us;
+    gchar *source;
+    gchar *message;
+    gchar *debug_info;
+} SharedViewEvent;
+
+static void shared_view_event_free(gpointer data)
+{
+    SharedViewEvent *event = (SharedViewEvent *)data;
+
+    g_free(event->source);
+    g_free(event->message);
+    g_free(event->debug_info);
+    g_free(event);
+}
+
+static gboolean cb_shared_first_frame_idle(gpointer user_data)
+{
+    SharedViewEvent *event = (SharedViewEvent *)user_data;
+    RctGstPlayer *player = event->player;
+    RctGstTransport transport;
+
+    // The view was replaced in the meantime
+    if (player->shared_view != event->view) {
+        return G_SOURCE_REMOVE;
+    }
+    transport = rct_gst_shared_view_get_transport(player->shared_view);
+    player->last_switch_ttff_us = event->ttff_us;
+    LOGI("First frame of shared view (mode %d) in %lld us", player->switch_mode, (long long)event->ttff_us);
+    rct_gst_startup_mark(RCT_GST_STARTUP_FIRST_FRAME);
+    if (rct_gst_get_configuration(player)->onFirstFrame) {
+        rct_gst_get_configuration(player)->onFirstFrame(player, player->switch_mode, event->ttff_us, transport);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+static void cb_shared_first_frame(RctGstSharedView *view, gint64 ttff_us, gpointer user_data)
+{
+    SharedViewEvent *event = g_new0(SharedViewEvent, 1);
+
+    event->player = (RctGstPlayer *)user_data;
+    event->view = view;
+    event->ttff_us = ttff_us;
+    g_main_context_invoke_full(event->player->context, G_PRIORITY_DEFAULT, cb_shared_first_frame_idle, event,
+                               shared_view_event_free);
+}
+
+static gboolean cb_shared_error_idle(gpointer user_data)
+{
+    SharedViewEvent *event = (SharedViewEvent *)user_data;
+    RctGstPlayer *player = event->player;
+
+    if (player->shared_view == event->view && rct_gst_get_configuration(player)->onElementError) {
+        rct_gst_get_configuration(player)->onElementError(player, event->source, event->message, event->debug_info);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+// The decode recovers by itself, players only get to know
+static void cb_shared_error(RctGstSharedView *view, const gchar *source, const gchar *message,
+                            const gchar *debug_info, gpointer user_data)
+{
+    SharedViewEvent *event = g_new0(SharedViewEvent, 1);
+
+    event->player = (RctGstPlayer *)user_data;
+    event->view = view;
+    event->source = g_strdup(source);
+    event->message = g_strdup(message);
+    event->debug_info = g_strdup(debug_info);
+    g_main_context_invoke_full(event->player->context, G_PRIORITY_DEFAULT, cb_shared_error_idle, event,
+                               shared_view_event_free);
+}
+
+static void report_shared_state(RctGstPlayer *player, GstState state)
+{
+    GstState old_state = player->shared_state;
+
+    if (state == old_state) {
+        return;
+    }
+    player->shared_state = state;
+    if (rct_gst_get_configuration(player)->onStateChanged) {
+        rct_gst_get_configuration(player)->onStateChanged(player, old_state, state);
+    }
+}
+
+// Joins the decode of the configured uri, or opens it
+static gboolean attach_shared_view(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    gchar *element_chain;
+
+    if (!configuration->uri) {
+        return FALSE;
+    }
+    player->shared_view = rct_gst_shared_view_new(configuration->uri, configuration->videoSink,
+                                                  configuration->forceVideoConvert,
+                                                  player->suspended ? 0 : player->drawable_surface,
+                                                  cb_shared_first_frame, cb_shared_error, player);
+    if (!player->shared_view) {
+        LOGE("Shared decode of %s could not be attached", configuration->uri);
+        report_shared_state(player, GST_STATE_NULL);
+        return FALSE;
+    }
+    player->switch_mode = rct_gst_shared_view_is_joined(player->shared_view) ? RCT_GST_URI_SWITCH_SHARED
+                                                                             : RCT_GST_URI_SWITCH_FULL_RESTART;
+    // A paused view keeps its last picture, whatever the uri
+    if (player->suspended || player->shared_state == GST_STATE_PAUSED) {
+        rct_gst_shared_view_set_active(player->shared_view, FALSE);
+    }
+
+    element_chain = rct_gst_shared_view_describe(player->shared_view);
+    LOGI("Element chain: %s", element_chain);
+    g_mutex_lock(&player->info_lock);
+    g_free(player->element_chain);
+    player->element_chain = element_chain;
+    g_mutex_unlock(&player->info_lock);
+
+    report_shared_state(player, player->shared_state == GST_STATE_PAUSED ? GST_STATE_PAUSED : GST_STATE_PLAYING);
+    if (configuration->onUriChanged) {
+        configuration->onUriChanged(player, configuration->uri);
+    }
+    return TRUE;
+}
+
+static void detach_shared_view(RctGstPlayer *player)
+{
+    rct_gst_shared_view_free(player->shared_view);
+    player->shared_view = NULL;
+}
+
+// A view can't change the state of a decode other views watch: PAUSED only freezes its own
+// picture, READY and NULL detach it
+static GstStateChangeReturn set_shared_state(RctGstPlayer *player, GstState state)
+{
+    if (player->suspended) {
+        wake_front_end(player);
+    }
+    if (state < GST_STATE_PAUSED) {
+        detach_shared_view(player);
+        report_shared_state(player, state);
+        return GST_STATE_CHANGE_SUCCESS;
+    }
+    if (!player->shared_view && !attach_shared_view(player)) {
+        return GST_STATE_CHANGE_FAILURE;
+    }
+    rct_gst_shared_view_set_active(player->shared_view, state == GST_STATE_PLAYING);
+    report_shared_state(player, state);
+    return GST_STATE_CHANGE_SUCCESS;
+}
+
+static gboolean player_init_shared(RctGstPlayer *player)
+{
+    LOGD("Initializing player %p on a shared decode", player);
+    player->shared = TRUE;
+    player->shared_state = GST_STATE_NULL;
+    if (player->drawable_surface == 0) {
+        player->drawable_surface = rct_gst_get_configuration(player)->initialDrawableSurface;
+    }
+    // Without a uri yet, the view gets attached once one is set
+    if (rct_gst_get_configuration(player)->uri && !attach_shared_view(player)) {
+        return FALSE;
+    }
+    rct_gst_startup_mark(RCT_GST_STARTUP_PIPELINE_BUILT);
+    if (rct_gst_get_configuration(player)->onInit) {
+        rct_gst_get_configuration(player)->onInit(player);
+    }
+    return TRUE;
+}
+
+/*************
+ OTHER METHODS
+ ************/
+void rct_gst_set_pipeline_state(RctGstPlayer *player, GstState state)
+{
+    LOGD("Posting pipeline state: %s", gst_element_state_get_name(state));
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_PIPELINE_STATE);
+    command->args.state = state;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_init(RctGstPlayer *player)
+{
+    rct_gst_command_queue_push(player->commands, rct_gst_command_new(RCT_GST_COMMAND_INIT));
+}
+
+void rct_gst_terminate(RctGstPlayer *player)
+{
+    rct_gst_command_queue_push(player->commands, rct_gst_command_new(RCT_GST_COMMAND_TERMINATE));
+}
+
+void rct_gst_suspend(RctGstPlayer *player)
+{
+    rct_gst_command_queue_push(player->commands, rct_gst_command_new(RCT_GST_COMMAND_SUSPEND));
+}
+
+void rct_gst_resume(RctGstPlayer *player)
+{
+    rct_gst_command_queue_push(player->commands, rct_gst_command_new(RCT_GST_COMMAND_RESUME));
+}
+
+void rct_gst_timeshift(RctGstPlayer *player, guint offset_ms)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_DVR_PLAY_FROM);
+    command->args.dvr_offset = offset_ms;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_export_clip(RctGstPlayer *player, guint offset_ms, guint duration_ms, const gchar *path,
+                         RctGstDvrFormat format)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_DVR_EXPORT);
+    command->args.dvr_export.offset = offset_ms;
+    command->args.dvr_export.duration = duration_ms;
+    command->args.dvr_export.path = g_strdup(path);
+    command->args.dvr_export.format = format;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_seek(RctGstPlayer *player, gint64 position_us, RctGstSeekMode mode)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SEEK);
+    command->args.seek.position = position_us;
+    command->args.seek.mode = mode;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_set_rate(RctGstPlayer *player, gdouble rate)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_RATE);
+    command->args.rate = rate;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_scrub(RctGstPlayer *player, gint64 position_us)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SCRUB);
+    command->args.scrub_position = position_us;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_snapshot(RctGstPlayer *player, RctGstSnapshotFormat format, gint max_size, const gchar *path,
+                      RctGstSnapshotFunc done, gpointer user_data)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SNAPSHOT);
+    command->args.snapshot.format = format;
+    command->args.snapshot.max_size = max_size;
+    command->args.snapshot.path = g_strdup(path);
+    command->args.snapshot.done = done;
+    command->args.snapshot.user_data = user_data;
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+void rct_gst_dump_graph(RctGstPlayer *player, const gchar *path)
+{
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_DUMP_GRAPH);
+    command->args.graph_path = g_strdup(path);
+    rct_gst_command_queue_push(player->commands, command);
+}
+
+static GstStateChangeReturn player_set_pipeline_state(RctGstPlayer *player, GstState state)
+{
+    if (player->shared) {
+        return set_shared_state(player, state);
+    }
+    if (!player->pipeline) {
+        LOGE("Pipeline is NULL, cannot set state %s", gst_element_state_get_name(state));
+        return GST_STATE_CHANGE_FAILURE;
+    }
+    // An explicit state change ends the suspension, whatever the state
+    if (player->suspended) {
+        wake_front_end(player);
+    }
+    // Leaving PLAYING on purpose is not a failure to recover from
+    if (player->mosaic) {
+        rct_gst_mosaic_set_playing(player->mosaic, state == GST_STATE_PLAYING);
+    } else if (state == GST_STATE_PLAYING) {
+        rct_gst_reconnect_set_armed(player->reconnect, TRUE);
+    } else {
+        rct_gst_reconnect_cancel(player->reconnect);
+    }
+    LOGD("Setting pipeline state: %s", gst_element_state_get_name(state));
+    GstStateChangeReturn validity = gst_element_set_state(player->pipeline, state);
+    LOGD("State change return: %s", gst_element_state_change_return_get_name(validity));
+    return validity;
+}
+
+// Bounded by buffer count only, the depth is what the configuration talks about
+static GstElement *make_queue(const gchar *name, guint depth, gboolean leaky)
+{
+    GstElement *queue = gst_element_factory_make("queue", name);
+
+    if (!queue) {
+        return NULL;
+    }
+    g_object_set(G_OBJECT(queue),
+                 "max-size-buffers", MAX(depth, 1),
+                 "max-size-bytes", 0,
+                 "max-size-time", (guint64)0,
+                 "leaky", leaky ? 2 : 0,                            // 2 is downstream: the oldest buffers go first
+                 NULL);
+    return queue;
+}
+
+// Source and depayloader, the only part of the pipeline rebuilt on a source-only uri switch
+static RctGstSource *create_front_end(RctGstPlayer *player, const gchar *uri)
+{
+    RctGstSource *front_end = rct_gst_source_new(GST_BIN(player->pipeline), uri);
+
+    if (!front_end) {
+        return NULL;
+    }
+
+    LOGD("Setting URI on source element: %s", uri);
+    if (front_end->live) {
+        g_object_set(G_OBJECT(front_end->source), "buffer-size", 2097152, NULL);
+        rct_gst_transport_apply(player->transport, uri, front_end->source);
+
+        // Latency and retransmission as currently targeted, the minimum unless adaptive mode raised it
+        rct_gst_jitter_apply(player->jitter, front_end->source);
+    }
+    if (rct_gst_get_configuration(player)->audioLevelRefreshRate > 0) {
+        rct_gst_source_set_audio_handler(front_end, cb_audio_pad, player);
+    }
+    rct_gst_source_set_codec_handler(front_end, cb_codec, player);
+    return front_end;
+}
+
+// Links front_end to the parser, the previous front end goes to the standby pool
+static gboolean use_front_end(RctGstPlayer *player, RctGstSource *front_end)
+{
+    if (player->front_end) {
+        rct_gst_standby_pool_put(player->standby_pool, player->front_end);
+        player->front_end = NULL;
+        player->source = player->depay = NULL;
+    }
+
+    if (!rct_gst_source_activate(front_end, player->parser)) {
+        rct_gst_source_free(front_end);
+        return FALSE;
+    }
+
+    player->front_end = front_end;
+    player->source = front_end->source;
+    player->depay = front_end->depay;
+
+    // Live frames are shown as soon as decoded, the others at their timestamps
+    g_object_set(G_OBJECT(player->sink), "sync", !front_end->live, NULL);
+    return TRUE;
+}
+
+// Links front_end in place of the current one, which is only freed once that worked. On failure front_end
+// is gone and the current one is linked back, the player always keeps a front end to restart.
+static gboolean switch_front_end(RctGstPlayer *player, RctGstSource *front_end)
+{
+    RctGstSource *previous = player->front_end;
+
+    if (previous) {
+        rct_gst_source_deactivate(previous);
+    }
+    player->front_end = NULL;
+    player->source = player->depay = NULL;
+    if (!use_front_end(player, front_end)) {
+        player->front_end = previous;
+        if (previous) {
+            player->source = previous->source;
+            player->depay = previous->depay;
+            if (!rct_gst_source_activate(previous, player->parser)) {
+                LOGE("Previous front end could not be linked back");
+            }
+        }
+        return FALSE;
+    }
+    rct_gst_source_free(previous);
+    return TRUE;
+}
+
+// In NULL state, for a uri the current front end can't open: a file after an RTSP session or the other way round
+static gboolean replace_front_end(RctGstPlayer *player, const gchar *uri)
+{
+    RctGstSource *front_end = create_front_end(player, uri);
+
+    return front_end && switch_front_end(player, front_end);
+}
+
+// Replaces a broken front end by a new session on the same uri, the old one is not worth pooling
+static gboolean restart_front_end(RctGstPlayer *player)
+{
+    gchar *uri = rct_gst_get_configuration(player)->uri;
+    RctGstSource *front_end = create_front_end(player, uri);
+
+    if (!front_end) {
+        return FALSE;
+    }
+
+    // The new session stays on standby until resumed
+    if (player->suspended) {
+        rct_gst_source_free(player->front_end);
+        rct_gst_source_set_gop_budget(front_end, &player->suspended_gop_bytes,
+                                      rct_gst_get_configuration(player)->standbyGopBudget);
+        player->front_end = front_end;
+        player->source = front_end->source;
+        player->depay = front_end->depay;
+        rct_gst_source_start(front_end);
+        return TRUE;
+    }
+
+    start_switch_tracking(player, RCT_GST_URI_SWITCH_SOURCE_ONLY);
+    if (!switch_front_end(player, front_end)) {
+        return FALSE;
+    }
+    rct_gst_source_start(front_end);
+    return TRUE;
+}
+
+static void cb_restart(RctGstRestartKind kind, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    GstState current_state = GST_STATE_NULL;
+
+    if (!player->pipeline || GST_STATE_TARGET(player->pipeline) != GST_STATE_PLAYING) {
+        LOGD("Pipeline not meant to play anymore, restart skipped");
+        return;
+    }
+
+    gst_element_get_state(player->pipeline, &current_state, NULL, 0);
+    if (kind == RCT_GST_RESTART_SOURCE && current_state >= GST_STATE_PAUSED) {
+        LOGD("Restarting source front end");
+        if (restart_front_end(player)) {
+            return;
+        }
+        LOGE("Source front end could not be restarted, falling back to a pipeline reset");
+    }
+    reset_pipeline(player);
+}
+
+static void cb_reconnect_notify(const RctGstReconnectStats *stats, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+
+    if (rct_gst_get_configuration(player)->onReconnect) {
+        rct_gst_get_configuration(player)->onReconnect(player, stats);
+    }
+}
+
+/**********
+ SUSPENSION
+ *********/
+// Drops the queued access units and the reference frames. Running time is kept: the flush also reaches the
+// DVR branches below the tee and must leave them, and the audio branch, on the pipeline timeline.
+static void flush_from_parser(RctGstPlayer *player)
+{
+    GstPad *pad = gst_element_get_static_pad(player->parser, "sink");
+
+    gst_pad_send_event(pad, gst_event_new_flush_start());
+    gst_pad_send_event(pad, gst_event_new_flush_stop(FALSE));
+    gst_object_unref(pad);
+}
+
+// Drops whatever the decode path holds: queued access units, reference frames and the last rendered sample
+static void flush_decode_path(RctGstPlayer *player)
+{
+    flush_from_parser(player);
+    rct_gst_autoplug_set_boolean(player->sink, "enable-last-sample", FALSE);
+}
+
+static gboolean player_suspend(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    if (player->shared_view && !player->suspended) {
+        LOGI("Suspending shared view of player %p", player);
+        player->suspended = TRUE;
+        player->resume_pending = FALSE;
+        rct_gst_shared_view_set_active(player->shared_view, FALSE);
+        rct_gst_shared_view_set_window(player->shared_view, 0);
+        return TRUE;
+    }
+    // Tiles have no standby, their sessions are closed until the resume
+    if (player->mosaic && !player->suspended) {
+        LOGI("Suspending mosaic of player %p", player);
+        player->suspended = TRUE;
+        player->resume_pending = FALSE;
+        rct_gst_mosaic_set_playing(player->mosaic, FALSE);
+        if (GST_IS_VIDEO_OVERLAY(player->sink)) {
+            gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), 0);
+        }
+        gst_element_set_state(player->pipeline, GST_STATE_READY);
+        return TRUE;
+    }
+    if (!player->pipeline || !player->front_end) {
+        return player->suspended;
+    }
+    if (player->suspended) {
+        return TRUE;
+    }
+
+    LOGI("Suspending player %p", player);
+    player->suspended = TRUE;
+    player->resume_pending = FALSE;
+
+    // No buffers on purpose, that is not a stall, nor a transport failing
+    rct_gst_reconnect_cancel(player->reconnect);
+    rct_gst_transport_attempt_cancelled(player->transport);
+
+    // The session keeps running on standby, its GOP cache makes the resume keyframe immediate
+    rct_gst_source_set_gop_budget(player->front_end, &player->suspended_gop_bytes, configuration->standbyGopBudget);
+    rct_gst_source_deactivate(player->front_end);
+    if (player->dvr) {
+        rct_gst_dvr_play_from(player->dvr, 0);
+    }
+    flush_decode_path(player);
+
+    // Release the window, and the other sessions: they would only be worth keeping once visible again
+    if (GST_IS_VIDEO_OVERLAY(player->sink)) {
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), 0);
+    }
+    rct_gst_standby_pool_configure(player->standby_pool, 0, configuration->standbyGopBudget);
+    return TRUE;
+}
+
+// Links the suspended front end back, its cached GOP is replayed with the next live buffer
+static void wake_front_end(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    player->suspended = FALSE;
+    player->resume_pending = FALSE;
+    if (player->shared) {
+        if (player->shared_view) {
+            rct_gst_shared_view_set_window(player->shared_view, player->drawable_surface);
+            rct_gst_shared_view_set_active(player->shared_view, TRUE);
+        }
+        return;
+    }
+    if (player->mosaic) {
+        if (player->drawable_surface != 0 && GST_IS_VIDEO_OVERLAY(player->sink)) {
+            gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), player->drawable_surface);
+        }
+        gst_element_set_state(player->pipeline, GST_STATE_PLAYING);
+        rct_gst_mosaic_set_playing(player->mosaic, TRUE);
+        return;
+    }
+    rct_gst_autoplug_set_boolean(player->sink, "enable-last-sample", TRUE);
+    if (player->drawable_surface != 0 && GST_IS_VIDEO_OVERLAY(player->sink)) {
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(player->sink), player->drawable_surface);
+    }
+    rct_gst_standby_pool_configure(player->standby_pool, configuration->standbyPoolSize, configuration->standbyGopBudget);
+
+    if (!player->front_end || !rct_gst_source_activate(player->front_end, player->parser)) {
+        LOGE("Suspended front end could not be linked back, restarting it");
+        restart_front_end(player);
+    }
+}
+
+static gboolean player_resume(RctGstPlayer *player)
+{
+    if (!player->suspended) {
+        return player->pipeline != NULL || player->shared_view != NULL;
+    }
+    if (player->drawable_surface == 0) {
+        LOGD("Resume deferred until a drawable surface is set");
+        player->resume_pending = TRUE;
+        return TRUE;
+    }
+
+    LOGI("Resuming player %p", player);
+    start_switch_tracking(player, RCT_GST_URI_SWITCH_RESUME);
+    wake_front_end(player);
+    if (GST_STATE_TARGET(player->pipeline) == GST_STATE_PLAYING) {
+        rct_gst_reconnect_set_armed(player->reconnect, TRUE);
+    }
+    return TRUE;
+}
+
+/***********
+ CODEC SWITCH
+ **********/
+// Settings of the whole decode path, whatever elements the codec brought
+static void configure_decode_path(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+
+    // Enable low-latency mode where possible
+    rct_gst_autoplug_set_boolean(player->parser, "disable-passthrough", TRUE);
+    rct_gst_autoplug_set_boolean(player->decoder, "low-latency", TRUE);
+    rct_gst_autoplug_set_int(player->decoder, "max-threads", configuration->decoderMaxThreads);
+    if (configuration->decoderThreadType != RCT_GST_DECODER_THREADS_AUTO) {
+        rct_gst_autoplug_set_int(player->decoder, "thread-type", configuration->decoderThreadType);
+    }
+}
+
+#define RELINK_TIMEOUT_US G_USEC_PER_SEC
+
+typedef void (*Relink)(RctGstPlayer *player, gpointer data);
+
+typedef struct {
+    RctGstPlayer *player;
+    Relink relink;
+    gpointer data;
+    gboolean done;                      // Guarded by lock
+    GMutex lock;
+    GCond cond;
+} BlockedRelink;
+
+// Runs the relink once, with nothing flowing through the pad. It stays blocked until the probe is removed.
+static GstPadProbeReturn cb_relink_blocked(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    BlockedRelink *blocked = (BlockedRelink *)user_data;
+
+    g_mutex_lock(&blocked->lock);
+    if (!blocked->done) {
+        blocked->relink(blocked->player, blocked->data);
+        blocked->done = TRUE;
+        g_cond_signal(&blocked->cond);
+    }
+    g_mutex_unlock(&blocked->lock);
+    return GST_PAD_PROBE_OK;
+}
+
+// Runs relink with the upstream pad blocked: right away when it is idle, else from its streaming thread once the
+// buffer being pushed is through or the next one reaches it. The player thread waits meanwhile.
+static void relink_blocked(RctGstPlayer *player, GstPad *upstream, Relink relink, gpointer data)
+{
+    BlockedRelink blocked = { player, relink, data, FALSE };
+    gint64 deadline = g_get_monotonic_time() + RELINK_TIMEOUT_US;
+    gulong probe_id;
+
+    if (!upstream) {
+        relink(player, data);
+        return;
+    }
+    g_mutex_init(&blocked.lock);
+    g_cond_init(&blocked.cond);
+    probe_id = gst_pad_add_probe(upstream, GST_PAD_PROBE_TYPE_BLOCK_DOWNSTREAM | GST_PAD_PROBE_TYPE_IDLE,
+                                 cb_relink_blocked, &blocked, NULL);
+
+    g_mutex_lock(&blocked.lock);
+    while (!blocked.done && g_cond_wait_until(&blocked.cond, &blocked.lock, deadline)) {
+    }
+    if (!blocked.done) {
+        LOGE("Pad %s never went idle, relinking anyway", GST_OBJECT_NAME(upstream));
+        relink(player, data);
+        blocked.done = TRUE;
+    }
+    g_mutex_unlock(&blocked.lock);
+
+    gst_pad_remove_probe(upstream, probe_id);
+    g_cond_clear(&blocked.cond);
+    g_mutex_clear(&blocked.lock);
+}
+
+typedef struct {
+    GstElement *element;
+    GstElement *replacement;
+    gboolean linked;
+} ElementSwap;
+
+static void swap_relink(RctGstPlayer *player, gpointer data)
+{
+    ElementSwap *swap = (ElementSwap *)data;
+    GstPad *sink_pad = gst_element_get_static_pad(swap->element, "sink");
+    GstPad *src_pad = gst_element_get_static_pad(swap->element, "src");
+    GstPad *upstream = gst_pad_get_peer(sink_pad);
+    GstPad *downstream = gst_pad_get_peer(src_pad);
+
+    gst_object_unref(sink_pad);
+    gst_object_unref(src_pad);
+    gst_element_set_state(swap->element, GST_STATE_NULL);
+    gst_bin_remove(GST_BIN(player->pipeline), swap->element);
+    gst_bin_add(GST_BIN(player->pipeline), swap->replacement);
+
+    swap->linked = TRUE;
+    if (upstream) {
+        sink_pad = gst_element_get_static_pad(swap->replacement, "sink");
+        swap->linked = GST_PAD_LINK_SUCCESSFUL(gst_pad_link(upstream, sink_pad));
+        gst_object_unref(sink_pad);
+        gst_object_unref(upstream);
+    }
+    if (downstream) {
+        src_pad = gst_element_get_static_pad(swap->replacement, "src");
+        swap->linked = GST_PAD_LINK_SUCCESSFUL(gst_pad_link(src_pad, downstream)) && swap->linked;
+        gst_object_unref(src_pad);
+        gst_object_unref(downstream);
+    }
+    gst_element_sync_state_with_parent(swap->replacement);
+}
+
+// Puts replacement in place of element, linked to the same peers (the DVR tee and selector included)
+static gboolean swap_element(RctGstPlayer *player, GstElement *element, GstElement *replacement)
+{
+    ElementSwap swap = { element, replacement, FALSE };
+    GstPad *sink_pad = gst_element_get_static_pad(element, "sink");
+    GstPad *upstream = gst_pad_get_peer(sink_pad);
+
+    gst_object_unref(sink_pad);
+    relink_blocked(player, upstream, swap_relink, &swap);
+    if (upstream) {
+        gst_object_unref(upstream);
+    }
+    return swap.linked;
+}
+
+// Software decoders get a downscaler, hardware ones output GPU memory that the sink scales for free
+static gboolean wants_scaler(RctGstPlayer *player)
+{
+    return rct_gst_get_configuration(player)->scalingPolicy == RCT_GST_SCALING_DISPLAY &&
+           !rct_gst_autoplug_is_hardware(player->decoder);
+}
+
+// Floating until added, FALSE leaves neither element
+static gboolean make_scaler(RctGstPlayer *player)
+{
+    player->scale = gst_element_factory_make("videoscale", "scale");
+    player->scale_filter = gst_element_factory_make("capsfilter", "scale_filter");
+    if (!player->scale || !player->scale_filter) {
+        LOGE("videoscale not available, frames stay at stream resolution");
+        if (player->scale) {
+            gst_object_unref(gst_object_ref_sink(player->scale));
+        }
+        if (player->scale_filter) {
+            gst_object_unref(gst_object_ref_sink(player->scale_filter));
+        }
+        player->scale = player->scale_filter = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void scaler_link(RctGstPlayer *player, gpointer data)
+{
+    gboolean *linked = (gboolean *)data;
+    GstPad *src_pad = gst_element_get_static_pad(player->decoder, "src");
+    GstPad *downstream = gst_pad_get_peer(src_pad);
+    GstPad *pad;
+
+    if (downstream) {
+        gst_pad_unlink(src_pad, downstream);
+    }
+    *linked = gst_element_link_many(player->decoder, player->scale, player->scale_filter, NULL);
+    if (*linked && downstream) {
+        pad = gst_element_get_static_pad(player->scale_filter, "src");
+        *linked = GST_PAD_LINK_SUCCESSFUL(gst_pad_link(pad, downstream));
+        gst_object_unref(pad);
+    }
+    if (*linked) {
+        gst_element_sync_state_with_parent(player->scale);
+        gst_element_sync_state_with_parent(player->scale_filter);
+    } else {
+        // Removing them unlinks whatever part got linked
+        gst_bin_remove_many(GST_BIN(player->pipeline), player->scale, player->scale_filter, NULL);
+        if (downstream && GST_PAD_LINK_FAILED(gst_pad_link(src_pad, downstream))) {
+            LOGE("Decoder could not be linked back to its peer");
+        }
+    }
+    gst_object_unref(src_pad);
+    if (downstream) {
+        gst_object_unref(downstream);
+    }
+}
+
+// A software decoder taking over from a hardware one gets the scaler back, between it and its peer
+static void insert_scaler(RctGstPlayer *player)
+{
+    GstPad *src_pad;
+    gboolean linked = FALSE;
+
+    if (!make_scaler(player)) {
+        return;
+    }
+    gst_bin_add_many(GST_BIN(player->pipeline), player->scale, player->scale_filter, NULL);
+    src_pad = gst_element_get_static_pad(player->decoder, "src");
+    relink_blocked(player, src_pad, scaler_link, &linked);
+    gst_object_unref(src_pad);
+
+    if (linked) {
+        apply_surface_size(player);
+    } else {
+        LOGE("Scaler could not be linked, frames stay at stream resolution");
+        player->scale = player->scale_filter = NULL;
+    }
+}
+
+static void scaler_unlink(RctGstPlayer *player, gpointer data)
+{
+    GstPad *src_pad = gst_element_get_static_pad(player->scale_filter, "src");
+    GstPad *downstream = gst_pad_get_peer(src_pad);
+    GstPad *pad;
+
+    (void)data;
+    gst_object_unref(src_pad);
+    gst_element_set_state(player->scale, GST_STATE_NULL);
+    gst_element_set_state(player->scale_filter, GST_STATE_NULL);
+    gst_bin_remove_many(GST_BIN(player->pipeline), player->scale, player->scale_filter, NULL);
+    if (downstream) {
+        pad = gst_element_get_static_pad(player->decoder, "src");
+        if (GST_PAD_LINK_FAILED(gst_pad_link(pad, downstream))) {
+            LOGE("Decoder could not be linked past the scaler");
+        }
+        gst_object_unref(pad);
+        gst_object_unref(downstream);
+    }
+}
+
+// A hardware decoder outputs GPU memory, the scaler of the software one it replaced goes
+static void drop_scaler(RctGstPlayer *player)
+{
+    GstPad *src_pad = gst_element_get_static_pad(player->decoder, "src");
+
+    relink_blocked(player, src_pad, scaler_unlink, NULL);
+    gst_object_unref(src_pad);
+    player->scale = player->scale_filter = NULL;
+}
+
+// Parser and decoder for codec, the rest of the pipeline stays. The front end is on standby meanwhile.
+static gboolean replace_decode_path(RctGstPlayer *player, RctGstCodec codec)
+{
+    GstElement *parser = rct_gst_codec_make_parser(codec, "parser");
+    GstElement *decoder = rct_gst_codec_make_decoder(codec, "decoder");
+    GstElement *output;
+    gboolean linked;
+    GstPad *pad;
+
+    if (!parser || !decoder) {
+        if (parser) {
+            gst_object_unref(gst_object_ref_sink(parser));
+        }
+        if (decoder) {
+            gst_object_unref(gst_object_ref_sink(decoder));
+        }
+        return FALSE;
+    }
+
+    LOGI("Rebuilding the decode path for %s", rct_gst_codec_get_name(codec));
+    if (player->dvr) {
+        // The ring holds the previous codec, it empties itself on the new caps
+        rct_gst_dvr_play_from(player->dvr, 0);
+    }
+    flush_from_parser(player);
+    stop_stats(player);
+    rct_gst_qos_detach(player->qos);
+
+    output = raw_output(player);
+    linked = swap_element(player, player->parser, parser);
+    linked = swap_element(player, player->decoder, decoder) && linked;
+    player->parser = parser;
+    player->decoder = decoder;
+    player->codec = codec;
+    configure_decode_path(player);
+    if (player->scale && !wants_scaler(player)) {
+        drop_scaler(player);
+    } else if (!player->scale && wants_scaler(player)) {
+        insert_scaler(player);
+    }
+
+    // Probes of the replaced elements went with them
+    pad = gst_element_get_static_pad(player->decoder, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_keyframe_gate, player, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(player->parser, "sink");
+    rct_gst_reconnect_watch_pad(player->reconnect, pad);
+    gst_object_unref(pad);
+    if (raw_output(player) != output) {
+        pad = gst_element_get_static_pad(raw_output(player), "src");
+        gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, cb_raw_caps, player, NULL);
+        gst_object_unref(pad);
+    }
+
+    start_stats(player);
+    rct_gst_qos_attach(player->qos, player->pipeline, player->decoder, player->sink, player->decode_queue,
+                       player->scale_filter != NULL);
+    if (!linked) {
+        LOGE("Decode path for %s could not be linked", rct_gst_codec_get_name(codec));
+    }
+    return linked;
+}
+
+// The video pad of the front end showed its codec, or the front end was refused for it
+static void front_end_codec_known(RctGstPlayer *player, GstObject *source)
+{
+    RctGstSource *front_end = player->front_end;
+    RctGstCodec codec;
+
+    // Pooled front ends get their turn when promoted
+    if (!front_end || source != GST_OBJECT(front_end->source)) {
+        return;
+    }
+    codec = g_atomic_int_get(&front_end->codec);
+    player->depay = front_end->depay;
+    if (codec != player->codec && !replace_decode_path(player, codec)) {
+        gchar *message = g_strdup_printf("No decoder for %s", rct_gst_codec_get_name(codec));
+
+        LOGE("%s, the front end stays on standby", message);
+        if (rct_gst_get_configuration(player)->onElementError) {
+            rct_gst_get_configuration(player)->onElementError(player, GST_OBJECT_NAME(source), message, NULL);
+        }
+        g_free(message);
+    }
+
+    // Promoted again, the GOP cached meanwhile goes to the new decoder
+    if (codec == player->codec && !player->suspended &&
+        g_atomic_int_get(&front_end->mode) == RCT_GST_SOURCE_STANDBY &&
+        !rct_gst_source_activate(front_end, player->parser)) {
+        LOGE("Front end could not be linked to the new decode path, restarting it");
+        restart_front_end(player);
+    }
+    update_element_chain(player);
+}
+
+// Undoes a player_init that stopped half way. Elements not added to the pipeline yet are still floating,
+// the commands that follow find no pipeline.
+static void abandon_pipeline(RctGstPlayer *player)
+{
+    GstElement *elements[] = { player->parser, player->decoder, player->scale, player->scale_filter,
+                               player->decode_queue, player->render_queue, player->conv, player->sink };
+    RctGstDvr *dvr;
+    guint i;
+
+    // Its request pads and export pool go before the bin holding its elements
+    g_mutex_lock(&player->info_lock);
+    dvr = player->dvr;
+    player->dvr = NULL;
+    g_mutex_unlock(&player->info_lock);
+    rct_gst_dvr_free(dvr);
+    deliver_dvr_exports(player);
+
+    for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+        if (elements[i] && !GST_OBJECT_PARENT(elements[i])) {
+            gst_object_unref(gst_object_ref_sink(elements[i]));
+        }
+    }
+    if (player->pipeline) {
+        gst_object_unref(gst_object_ref_sink(player->pipeline));
+    }
+    player->pipeline = NULL;
+    player->source = player->depay = player->parser = player->decoder = player->conv = player->sink = NULL;
+    player->scale = player->scale_filter = NULL;
+    player->decode_queue = player->render_queue = NULL;
+}
+
+static gboolean player_init(RctGstPlayer *player)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player);
+    GstBus *bus;
+    GstPad *pad;
+    GstElement *chain[8];
+    guint length = 0, i;
+    gboolean linked = TRUE;
+
+    if (configuration->sharedDecode) {
+        return player_init_shared(player);
+    }
+    if (configuration->mosaicColumns > 0 && configuration->mosaicRows > 0) {
+        return player_init_mosaic(player);
+    }
+    LOGD("Initializing GStreamer pipeline for player %p", player);
+
+    // Create the elements. Element names only need to be unique inside their own bin,
+    // so every player can reuse the same ones.
+    player->pipeline = gst_pipeline_new("pipeline");
+    // H.264 until the first video pad tells otherwise, the decode path is then rebuilt for its codec
+    player->codec = RCT_GST_CODEC_H264;
+    if (!rct_gst_startup_clone_template(configuration->videoSink, &player->parser, &player->decoder, &player->sink)) {
+        player->parser = rct_gst_codec_make_parser(player->codec, "parser");
+        player->sink = gst_element_factory_make(configuration->videoSink ? configuration->videoSink : "glimagesink", "video_sink");
+        player->decoder = rct_gst_codec_make_decoder(player->codec, "decoder");
+    }
+
+    if (player->decoder && wants_scaler(player)) {
+        make_scaler(player);
+    }
+
+    // Thread boundaries between network, decode and render
+    if (configuration->pipelineMode == RCT_GST_PIPELINE_PIPELINED) {
+        player->decode_queue = make_queue("decode_queue", configuration->decodeQueueDepth, configuration->decodeQueueLeaky);
+        player->render_queue = make_queue("render_queue", configuration->renderQueueDepth, configuration->renderQueueLeaky);
+        if (!player->decode_queue || !player->render_queue) {
+            LOGE("Failed to create queues");
+            abandon_pipeline(player);
+            return FALSE;
+        }
+    }
+
+    // Colour conversion costs a CPU pass per frame, it is only built up front when forced
+    if (configuration->forceVideoConvert) {
+        player->conv = gst_element_factory_make("videoconvert", "conv");
+    }
+
+    if (!player->pipeline || !player->parser || !player->decoder || !player->sink ||
+        (configuration->forceVideoConvert && !player->conv)) {
+        LOGE("Failed to create elements");
+        abandon_pipeline(player);
+        return FALSE;
+    }
+
+    configure_decode_path(player);
+    g_object_set(G_OBJECT(player->sink), "sync", FALSE, NULL);
+    g_object_set(G_OBJECT(player->sink), "max-lateness", -1, NULL);
+
+    // Build the pipeline, the source front end plugs into the parser
+    player->standby_pool = rct_gst_standby_pool_new(configuration->standbyPoolSize, configuration->standbyGopBudget);
+    chain[length++] = player->parser;
+    if (player->decode_queue) {
+        chain[length++] = player->decode_queue;
+    }
+    chain[length++] = player->decoder;
+    if (player->scale) {
+        chain[length++] = player->scale;
+        chain[length++] = player->scale_filter;
+    }
+    if (player->render_queue) {
+        chain[length++] = player->render_queue;
+    }
+    if (player->conv) {
+        chain[length++] = player->conv;
+    }
+    chain[length++] = player->sink;
+    for (i = 0; i < length; i++) {
+        gst_bin_add(GST_BIN(player->pipeline), chain[i]);
+    }
+    for (i = 0; i + 1 < length && linked; i++) {
+        linked = gst_element_link(chain[i], chain[i + 1]);
+    }
+    if (linked && (configuration->dvrMaxDuration > 0 || configuration->dvrMaxBytes > 0)) {
+        RctGstDvr *dvr = rct_gst_dvr_new(GST_BIN(player->pipeline), player->parser, chain[1],
+                                         configuration->dvrMaxDuration, configuration->dvrMaxBytes);
+        g_mutex_lock(&player->info_lock);
+        player->dvr = dvr;
+        g_mutex_unlock(&player->info_lock);
+    }
+    RctGstSource *front_end = linked ? create_front_end(player, configuration->uri) : NULL;
+    if (!front_end || !use_front_end(player, front_end)) {
+        LOGE("Elements could not be linked");
+        rct_gst_standby_pool_free(player->standby_pool);
+        player->standby_pool = NULL;
+        abandon_pipeline(player);
+        return FALSE;
+    }
+
+    // Uri switch probes stay installed for the whole pipeline life
+    pad = gst_element_get_static_pad(player->decoder, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_keyframe_gate, player, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(player->sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_first_frame, player, NULL);
+    gst_object_unref(pad);
+
+    // Stall watchdog, whatever front end is active feeds the parser
+    pad = gst_element_get_static_pad(player->parser, "sink");
+    rct_gst_reconnect_watch_pad(player->reconnect, pad);
+    gst_object_unref(pad);
+
+    pad = gst_element_get_static_pad(raw_output(player), "src");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, cb_raw_caps, player, NULL);
+    gst_object_unref(pad);
+    apply_surface_size(player);
+    update_element_chain(player);
+    start_stats(player);
+    start_jitter_control(player);
+    rct_gst_qos_attach(player->qos, player->pipeline, player->decoder, player->sink, player->decode_queue,
+                       player->scale_filter != NULL);
+    start_audio_levels(player);
+
+    bus = gst_element_get_bus(player->pipeline);
+    player->bus_watch_id = gst_bus_add_watch(bus, cb_bus_watch, player);
+    
+    gst_bus_set_sync_handler(bus, (GstBusSyncHandler)cb_create_window, player, NULL);
+    gst_object_unref(bus);
+
+    if (player->drawable_surface == 0) {
+        player->drawable_surface = rct_gst_get_configuration(player)->initialDrawableSurface;
+    }
+    if (player->drawable_surface != 0) {
+        player_set_drawable_surface(player, player->drawable_surface);
+    }
+
+    apply_uri(player);
+    rct_gst_startup_mark(RCT_GST_STARTUP_PIPELINE_BUILT);
+    
+    if (rct_gst_get_configuration(player)->onInit) {
+        rct_gst_get_configuration(player)->onInit(player);
+    }
+    LOGD("GStreamer initialization complete");
+    return TRUE;
+}
+
+static gboolean player_terminate(RctGstPlayer *player)
+{
+    if (player->shared) {
+        LOGD("Detaching player %p from its shared decode", player);
+        set_shared_state(player, GST_STATE_NULL);
+        player->shared = FALSE;
+        player->drawable_surface = 0;
+        player->suspended = player->resume_pending = FALSE;
+        return TRUE;
+    }
+    if (!player->pipeline) {
+        return FALSE;
+    }
+
+    // The elements belong to the pipeline, they go with it
+    LOGD("Terminating GStreamer for player %p", player);
+    player->drawable_surface = 0;
+    player->suspended = player->resume_pending = FALSE;
+    
+    player_set_pipeline_state(player, GST_STATE_NULL);     // Also cancels any pending restart
+    stop_stats(player);
+    stop_jitter_control(player);
+    rct_gst_transport_attempt_cancelled(player->transport);
+    rct_gst_qos_detach(player->qos);
+    player->resolution_divisor = 1;
+    stop_audio_levels(player);
+
+    // Tiles before the pipeline, they release their compositor pads
+    rct_gst_mosaic_free(player->mosaic);
+    player->mosaic = NULL;
+
+    // Waits for the exports in progress, they only hold buffers, and reports them before a QUIT can follow
+    g_mutex_lock(&player->info_lock);
+    RctGstDvr *dvr = player->dvr;
+    player->dvr = NULL;
+    g_mutex_unlock(&player->info_lock);
+    rct_gst_dvr_free(dvr);
+    deliver_dvr_exports(player);
+    rct_gst_scrub_cache_free(player->scrub_cache);
+    player->scrub_cache = NULL;
+    player->seek_pending = FALSE;
+    player->scrub_target_us = -1;
+    g_atomic_int_set(&player->seek_frame_pending, FALSE);
+
+    // Active front end first, it may still account GOP bytes in the pool budget
+    rct_gst_source_free(player->front_end);
+    rct_gst_standby_pool_free(player->standby_pool);
+    player->front_end = NULL;
+    player->standby_pool = NULL;
+    gst_object_unref(player->pipeline);
+    
+    // The watch lives on the player context, not the default one
+    g_source_destroy(g_main_context_find_source_by_id(player->context, player->bus_watch_id));
+    
+    player->pipeline = NULL;
+    player->source = player->depay = player->parser = player->decoder = player->conv = player->sink = NULL;
+    player->scale = player->scale_filter = NULL;
+    player->decode_queue = player->render_queue = NULL;
+    player->bus_watch_id = 0;
+    LOGD("GStreamer terminated");
+    return TRUE;
+}
+
+static void handle_command(RctGstCommand *command, gpointer user_data)
+{
+    RctGstPlayer *player = (RctGstPlayer *)user_data;
+    gint result = FALSE;
+
+    switch (command->type) {
+        case RCT_GST_COMMAND_INIT:
+            result = player_init(player);
+            break;
+
+        case RCT_GST_COMMAND_SET_URI:
+            result = player_set_uri(player, command->args.uri);
+            break;
+
+        case RCT_GST_COMMAND_SET_DRAWABLE_SURFACE:
+            result = player_set_drawable_surface(player, command->args.drawable_surface);
+            break;
+
+        case RCT_GST_COMMAND_SET_PIPELINE_STATE:
+            result = player_set_pipeline_state(player, command->args.state);
+            break;
+
+        case RCT_GST_COMMAND_SET_DEBUGGING:
+            result = player_set_debugging(player, command->args.is_debugging);
+            break;
+
+        case RCT_GST_COMMAND_PREPARE_URI:
+            result = player_prepare_uri(player, command->args.uri);
+            break;
+
+        case RCT_GST_COMMAND_SET_STANDBY_POOL:
+            result = player_set_standby_pool(player, command->args.standby_pool.capacity,
+                                             command->args.standby_pool.gop_budget);
+            break;
+
+        case RCT_GST_COMMAND_SET_RECONNECT_POLICY:
+            result = player_set_reconnect_policy(player, command->args.reconnect_policy.initial_delay,
+                                                 command->args.reconnect_policy.max_delay,
+                                                 command->args.reconnect_policy.jitter,
+                                                 command->args.reconnect_policy.stall_timeout);
+            break;
+
+        case RCT_GST_COMMAND_SET_SURFACE_SIZE:
+            result = player_set_surface_size(player, command->args.surface_size.width,
+                                             command->args.surface_size.height);
+            break;
+
+        case RCT_GST_COMMAND_SET_STATS_REFRESH_RATE:
+            result = player_set_stats_refresh_rate(player, command->args.refresh_rate);
+            break;
+
+        case RCT_GST_COMMAND_SET_AUDIO_LEVEL_REFRESH_RATE:
+            result = player_set_audio_level_refresh_rate(player, command->args.refresh_rate);
+            break;
+
+        case RCT_GST_COMMAND_SUSPEND:
+            result = player_suspend(player);
+            break;
+
+        case RCT_GST_COMMAND_RESUME:
+            result = player_resume(player);
+            break;
+
+        case RCT_GST_COMMAND_SET_QOS_POLICY:
+            result = player_set_qos_policy(player, command->args.qos_policy.max_rung,
+                                           command->args.qos_policy.max_lateness);
+            break;
+
+        case RCT_GST_COMMAND_SET_JITTER_POLICY:
+            result = player_set_jitter_policy(player, command->args.jitter_policy.mode,
+                                              command->args.jitter_policy.min_latency,
+                                              command->args.jitter_policy.max_latency,
+                                              command->args.jitter_policy.target_loss);
+            break;
+
+        case RCT_GST_COMMAND_SET_TRANSPORT_POLICY:
+            result = player_set_transport_policy(player, command->args.transport_policy.order,
+                                                 command->args.transport_policy.timeout,
+                                                 command->args.transport_policy.remember);
+            break;
+
+        case RCT_GST_COMMAND_SET_MOSAIC_LAYOUT:
+            result = player_set_mosaic_layout(player, command->args.mosaic_layout.columns,
+                                              command->args.mosaic_layout.rows);
+            break;
+
+        case RCT_GST_COMMAND_SET_MOSAIC_TILE:
+            result = player_set_mosaic_tile(player, command->args.mosaic_tile.index, command->args.mosaic_tile.uri);
+            break;
+
+        case RCT_GST_COMMAND_SET_DVR_POLICY:
+            result = player_set_dvr_policy(player, command->args.dvr_policy.max_duration,
+                                           command->args.dvr_policy.max_bytes);
+            break;
+
+        case RCT_GST_COMMAND_DVR_PLAY_FROM:
+            result = player_dvr_play_from(player, command->args.dvr_offset);
+            break;
+
+        case RCT_GST_COMMAND_DVR_EXPORT:
+            result = player_dvr_export(player, command->args.dvr_export.offset, command->args.dvr_export.duration,
+                                       command->args.dvr_export.path,
+                                       (RctGstDvrFormat)command->args.dvr_export.format);
+            break;
+
+        case RCT_GST_COMMAND_SEEK:
+            result = player_seek(player, command->args.seek.position, (RctGstSeekMode)command->args.seek.mode);
+            break;
+
+        case RCT_GST_COMMAND_SET_RATE:
+            result = player_set_rate(player, command->args.rate);
+            break;
+
+        case RCT_GST_COMMAND_SCRUB:
+            result = player_scrub(player, command->args.scrub_position);
+            break;
+
+        case RCT_GST_COMMAND_SET_SCRUB_CACHE:
+            result = player_set_scrub_cache(player, command->args.scrub_cache.max_bytes,
+                                            command->args.scrub_cache.width);
+            break;
+
+        case RCT_GST_COMMAND_SNAPSHOT:
+            result = player_snapshot(player, (RctGstSnapshotFormat)command->args.snapshot.format,
+                                     command->args.snapshot.max_size, command->args.snapshot.path,
+                                     command->args.snapshot.done, command->args.snapshot.user_data);
+            break;
+
+        case RCT_GST_COMMAND_DUMP_GRAPH:
+            result = player_dump_graph(player, command->args.graph_path);
+            break;
+
+        case RCT_GST_COMMAND_TERMINATE:
+            result = player_terminate(player);
+            break;
+
+        case RCT_GST_COMMAND_QUIT:
+            g_main_loop_quit(player->main_loop);
+            return;
+    }
+
+    gint64 latency_us = g_get_monotonic_time() - command->posted_at;
+    LOGD("Command %s done in %lld us (result %d)", rct_gst_command_type_get_name(command->type), (long long)latency_us, result);
+    if (rct_gst_get_configuration(player)->onCommandDone) {
+        rct_gst_get_configuration(player)->onCommandDone(player, command->type, result, latency_us);
+    }
+}
+
+gchar *rct_gst_get_info()
+{
+    LOGD("Entered rct_gst_get_info function");
+
+    gchar *version = gst_version_string();
+    if (version != NULL) {
+        LOGI("GStreamer version from C: %s", version);
+    } else {
+        LOGE("Failed to get GStreamer version string");
+    }
+
+    return version;
+}
+
+void rct_gst_get_stats(RctGstPlayer *player, RctGstStats *stats)
+{
+    rct_gst_stats_get(player->stats, stats);
+}
+
+void rct_gst_get_qos_status(RctGstPlayer *player, RctGstQosStatus *status)
+{
+    rct_gst_qos_get_status(player->qos, status);
+}
+
+void rct_gst_get_jitter_status(RctGstPlayer *player, RctGstJitterStatus *status)
+{
+    rct_gst_jitter_get_status(player->jitter, status);
+}
+
+gboolean rct_gst_get_dvr_status(RctGstPlayer *player, RctGstDvrStatus *status)
+{
+    gboolean has_dvr;
+
+    g_mutex_lock(&player->info_lock);
+    has_dvr = player->dvr != NULL;
+    if (has_dvr) {
+        rct_gst_dvr_get_status(player->dvr, status);
+    }
+    g_mutex_unlock(&player->info_lock);
+    return has_dvr;
+}
+
+void rct_gst_get_transport_stats(RctGstPlayer *player, RctGstTransportStats stats[RCT_GST_TRANSPORT_COUNT])
+{
+    rct_gst_transport_get_stats(player->transport, stats);
+}
+
+gboolean rct_gst_get_audio_level(RctGstPlayer *player, RctGstAudioLevel *level)
+{
+    gboolean has_audio_level;
+
+    g_mutex_lock(&player->info_lock);
+    has_audio_level = player->has_audio_level;
+    *level = player->audio_level;
+    g_mutex_unlock(&player->info_lock);
+    return has_audio_level;
+}
+
+gchar *rct_gst_get_element_chain(RctGstPlayer *player)
+{
+    gchar *element_chain;
+
+    g_mutex_lock(&player->info_lock);
+    element_chain = g_strdup(player->element_chain);
+    g_mutex_unlock(&player->info_lock);
+    return element_chain;
+}
+
+gint64 rct_gst_get_last_switch_ttff(RctGstPlayer *player)
+{
+    return player->last_switch_ttff_us;
+}
+
+void rct_gst_get_reconnect_stats(RctGstPlayer *player, RctGstReconnectStats *stats)
+{
+    rct_gst_reconnect_get_stats(player->reconnect, stats);
+}
+
+// Replaces rtspsrc and the depayloader while parser, decoder and sink stay in their current state.
+// A warm standby front end of the uri is promoted when there is one.
+static gboolean swap_source_front_end(RctGstPlayer *player, const gchar *uri)
+{
+    RctGstSource *front_end = rct_gst_standby_pool_take(player->standby_pool, uri);
+
+    if (front_end) {
+        LOGD("Promoting standby front end");
+        start_switch_tracking(player, RCT_GST_URI_SWITCH_STANDBY);
+        return use_front_end(player, front_end);
+    }
+
+    LOGD("Swapping source front end");
+    start_switch_tracking(player, RCT_GST_URI_SWITCH_SOURCE_ONLY);
+    front_end = create_front_end(player, uri);
+    if (!front_end || !use_front_end(player, front_end)) {
+        return FALSE;
+    }
+    rct_gst_source_start(front_end);
+    return TRUE;
+}
+
+void apply_uri(RctGstPlayer *player) {
+    gchar* uri = rct_gst_get_configuration(player)->uri;
+    GstState current_state = GST_STATE_NULL;
+
+    gst_element_get_state(player->pipeline, &current_state, NULL, 0);
+    // Another uri starts at normal speed, whatever was seeked before is over
+    player->rate = 1.0;
+    player->seek_pending = FALSE;
+    player->scrub_target_us = -1;
+    g_atomic_int_set(&player->seek_frame_pending, FALSE);
+
+    // Only RTSP sessions are swapped under a running decoder, files and HTTP uris bring their own segment
+    if (rct_gst_get_configuration(player)->uriSwitchMode == RCT_GST_URI_SWITCH_SOURCE_ONLY &&
+        current_state >= GST_STATE_PAUSED && rct_gst_source_uri_is_live(uri) && player->front_end &&
+        player->front_end->live) {
+        LOGD("Applying URI on source only: %s", uri);
+        if (!swap_source_front_end(player, uri)) {
+            LOGE("Source front end could not be rebuilt for %s", uri);
+            return;
+        }
+        update_scrub_cache(player);
+        if (rct_gst_get_configuration(player)->onUriChanged) {
+            rct_gst_get_configuration(player)->onUriChanged(player, uri);
+        }
+        return;
+    }
+
+    LOGD("Applying URI: %s", uri);
+    start_switch_tracking(player, RCT_GST_URI_SWITCH_FULL_RESTART);
+    GstStateChangeReturn ret = gst_element_set_state(player->pipeline, GST_STATE_NULL);
+    LOGD("Set pipeline state to NULL, return value: %s", gst_element_state_change_return_get_name(ret));
+    if ((!player->front_end || !rct_gst_source_set_uri(player->front_end, uri)) && !replace_front_end(player, uri)) {
+        LOGE("Source front end could not be rebuilt for %s", uri);
+        return;
+    }
+    if (player->front_end->live) {
+        rct_gst_transport_apply(player->transport, uri, player->source);
+    }
+    update_scrub_cache(player);
+    LOGD("URI set on pipeline");
+    rct_gst_reconnect_set_armed(player->reconnect, TRUE);
+    ret = gst_element_set_state(player->pipeline, GST_STATE_PLAYING);
+    LOGD("Set pipeline state to PLAYING, return value: %s", gst_element_state_change_return_get_name(ret));
+    if (rct_gst_get_configuration(player)->onUriChanged) {
+        rct_gst_get_configuration(player)->onUriChanged(player, uri);
+    }
+}
+void reset_pipeline(RctGstPlayer *player) {
+    LOGD("Resetting pipeline");
+
+    // From NULL, apply_uri takes the full restart path and brings the pipeline back to PLAYING
+    gst_element_set_state(player->pipeline, GST_STATE_NULL);
+    apply_uri(player);
+
+    LOGD("Pipeline reset complete");
+}
\ No newline at end of file
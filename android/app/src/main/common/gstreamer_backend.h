@@ -12,49 +12,275 @@
 #include <math.h>
 #include <gst/gst.h>
 #include <gst/video/video.h>
+#include "gstreamer_audio_level.h"
+#include "gstreamer_autoplug.h"
+#include "gstreamer_codec.h"
+#include "gstreamer_command_queue.h"
+#include "gstreamer_dvr.h"
+#include "gstreamer_jitter.h"
+#include "gstreamer_mosaic.h"
+#include "gstreamer_qos.h"
+#include "gstreamer_reconnect.h"
+#include "gstreamer_scrub.h"
+#include "gstreamer_shared_decode.h"
+#include "gstreamer_snapshot.h"
+#include "gstreamer_source.h"
+#include "gstreamer_startup.h"
+#include "gstreamer_stats.h"
+#include "gstreamer_transport.h"
+#include "gstreamer_standby_pool.h"
 
-// Audio level definition
-typedef struct {
-    gdouble rms;
-    gdouble peak;
-    gdouble decay;
-} RctGstAudioLevel;
+typedef struct _RctGstPlayer RctGstPlayer;
+
+// How a new uri is applied on a running pipeline
+typedef enum {
+    RCT_GST_URI_SWITCH_SOURCE_ONLY,     // Only rtspsrc and the depayloader are rebuilt, decoder and sink keep running
+    RCT_GST_URI_SWITCH_FULL_RESTART,    // Whole pipeline goes through NULL
+    RCT_GST_URI_SWITCH_STANDBY,         // Reported only: a warm standby front end was promoted
+    RCT_GST_URI_SWITCH_RESUME,          // Reported only: the suspended front end was promoted back
+    RCT_GST_URI_SWITCH_SHARED           // Reported only: joined a shared decode other views had opened
+} RctGstUriSwitchMode;
+
+// How decoded frames are fitted to the surface
+typedef enum {
+    RCT_GST_SCALING_NONE,               // Frames reach the sink at stream resolution
+    RCT_GST_SCALING_DISPLAY             // Software decoded frames larger than the surface are downscaled first
+} RctGstScalingPolicy;
+
+// Thread layout of the pipeline
+typedef enum {
+    RCT_GST_PIPELINE_SINGLE_THREAD,     // Depay, parse, decode and render all run on the rtspsrc streaming thread
+    RCT_GST_PIPELINE_PIPELINED          // Queues split network, decode and render onto their own threads
+} RctGstPipelineMode;
+
+// avdec thread-type flags, other decoders ignore them
+typedef enum {
+    RCT_GST_DECODER_THREADS_AUTO = 0,
+    RCT_GST_DECODER_THREADS_FRAME = 1,  // Best throughput, adds one frame of latency per thread
+    RCT_GST_DECODER_THREADS_SLICE = 2   // No added latency, only scales with sliced streams
+} RctGstDecoderThreadType;
+
+// Where a seek of a file or HTTP uri lands
+typedef enum {
+    RCT_GST_SEEK_ACCURATE,              // Exactly on the position, decodes from the previous keyframe
+    RCT_GST_SEEK_KEYFRAME               // On the nearest keyframe, the first frame shows without decoding up to it
+} RctGstSeekMode;
 
 // Plugin configurator
 typedef struct
 {
     gchar *uri;                                                     // Uri of the resource
-    gint *audioLevelRefreshRate;                                    // Time in ms between each call of onVolumeChanged
+    guint audioLevelRefreshRate;                                    // Time in ms between each call of onVolumeChanged, 0 disables metering
     guintptr initialDrawableSurface;                                // Pointer to drawable surface
-    gboolean isDebugging;                                           // Loads debugging pipeline
-    
+    gboolean isDebugging;                                           // GStreamer debug log at INFO at least
+    RctGstUriSwitchMode uriSwitchMode;                              // How uri changes are applied once playing
+    guint standbyPoolSize;                                          // Number of warm standby RTSP sessions kept open
+    gsize standbyGopBudget;                                         // Bytes of GOP cache shared by standby sessions
+    guint reconnectInitialDelay;                                    // First reconnect delay in ms, doubled on every failure
+    guint reconnectMaxDelay;                                        // Reconnect delay cap in ms
+    gdouble reconnectJitter;                                        // Random spread of each delay, 0.2 is ±20%
+    guint stallTimeout;                                             // Time in ms PLAYING may go without buffers, 0 disables
+    gchar *videoSink;                                               // Sink factory name, NULL for glimagesink
+    gboolean forceVideoConvert;                                     // Always run videoconvert, even when the sink takes the decoder output
+    RctGstScalingPolicy scalingPolicy;                              // Applied on init
+    RctGstPipelineMode pipelineMode;                                // Applied on init
+    guint decodeQueueDepth;                                         // Buffers between network and decode (pipelined mode)
+    gboolean decodeQueueLeaky;                                      // Drop the oldest access units when full instead of blocking
+    guint renderQueueDepth;                                         // Frames between decode and render (pipelined mode)
+    gboolean renderQueueLeaky;                                      // Drop the oldest frames when full instead of blocking
+    guint decoderMaxThreads;                                        // 0 lets the decoder decide
+    RctGstDecoderThreadType decoderThreadType;
+    guint statsRefreshRate;                                         // Time in ms between each call of onStats, 0 disables statistics
+    RctGstQosRung qosMaxRung;                                       // Highest degradation under overload, NONE disables it
+    guint qosMaxLateness;                                           // Time in ms past which a frame counts as late
+    RctGstJitterMode jitterMode;                                    // Jitterbuffer latency and retransmission policy
+    guint jitterMinLatency;                                         // Jitterbuffer latency bounds in ms, fixed mode
+    guint jitterMaxLatency;                                         // stays on the minimum
+    gdouble jitterTargetLoss;                                       // Loss rate adaptive mode stays under, 0.01 is 1%
+    gchar *transports;                                              // RTSP transports tried in order, "udp,multicast,tcp,http"
+    guint transportTimeout;                                         // Time in ms a transport gets to show a frame, 0 waits forever
+    gboolean rememberTransport;                                     // Start from the last transport that worked for the host
+    gboolean sharedDecode;                                          // Applied on init: views of the same uri share one
+                                                                    // session and decoder, the pipeline settings above
+                                                                    // (queues, scaling, QoS, statistics...) don't apply
+    guint mosaicColumns;                                            // Grid of the mosaic, a player with one set on init
+    guint mosaicRows;                                               // composites its tiles instead of playing uri
+    guint dvrMaxDuration;                                           // Applied on init: ring of the parsed stream kept
+    gsize dvrMaxBytes;                                              // for timeshift and export, bounded in ms and bytes,
+                                                                    // 0 and 0 leave the branch out
+    gsize scrubCacheBytes;                                          // Thumbnails kept for scrubbing non-live uris, 0 disables
+    gint scrubThumbnailWidth;                                       // Pixels, the height follows the aspect ratio
+    gpointer userData;                                              // Owner data, available to every callback through the player
+
     // Callbacks
-    void(*onInit)(void);                                            // Called when the player is ready
-    void(*onStateChanged)(GstState old_state, GstState new_state);  // Called method when GStreamer state changes
-    void(*onVolumeChanged)(RctGstAudioLevel* audioLevel);           // Called method when current media volume changes
-    void(*onUriChanged)(gchar *new_uri);                            // Called when changing uri is over
-    void(*onEOS)(void);                                             // Called when EOS occurs
-    void(*onElementError)(gchar *source, gchar *message,            // Called when an error occurs
-                          gchar *debug_info);
+    void(*onInit)(RctGstPlayer *player);                            // Called when the player is ready
+    void(*onStateChanged)(RctGstPlayer *player,                     // Called method when GStreamer state changes
+                          GstState old_state, GstState new_state);
+    void(*onVolumeChanged)(RctGstPlayer *player,                    // Called every audioLevelRefreshRate ms with the
+                           const RctGstAudioLevel *levels,          // measurements taken since the previous call,
+                           guint count);                            // oldest first
+    void(*onUriChanged)(RctGstPlayer *player, gchar *new_uri);      // Called when changing uri is over
+    void(*onEOS)(RctGstPlayer *player);                             // Called when EOS occurs
+    void(*onElementError)(RctGstPlayer *player, gchar *source,      // Called when an error occurs
+                          gchar *message, gchar *debug_info);
+    void(*onFirstFrame)(RctGstPlayer *player,                       // Called when the first frame of a new uri
+                        RctGstUriSwitchMode mode, gint64 ttff_us,   // reaches the sink, with the time it took and
+                        RctGstTransport transport);                 // the transport of the session
+    void(*onCommandDone)(RctGstPlayer *player,                      // Called on the player thread once a posted
+                         RctGstCommandType command,                 // command has been applied, result is the
+                         gint result, gint64 latency_us);           // GstStateChangeReturn or a gboolean
+    void(*onReconnect)(RctGstPlayer *player,                        // Called when a restart gets scheduled and
+                       const RctGstReconnectStats *stats);          // when the stream recovers
+    void(*onStats)(RctGstPlayer *player, const RctGstStats *stats); // Called every statsRefreshRate ms
+    void(*onQos)(RctGstPlayer *player,                              // Called on every degradation ladder
+                 const RctGstQosStatus *status);                    // transition
+    void(*onDvrExport)(RctGstPlayer *player, const gchar *path,     // Called once an export file is closed
+                       gboolean success, gint64 duration_us);
+    void(*onSeekDone)(RctGstPlayer *player, gint64 position_us,     // Called when the first frame after a seek
+                      gint64 duration_us, gint64 latency_us);       // reaches the sink
+    void(*onScrubPreview)(RctGstPlayer *player,                     // Called on scrub with the nearest cached
+                          const RctGstScrubThumbnail *thumbnail);   // thumbnail, ref the pixels to keep them
 } RctGstConfiguration;
 
+// Player instance, one per view. Nothing is shared between two players, unless they use shared decodes.
+struct _RctGstPlayer
+{
+    RctGstConfiguration *configuration;
+
+    GstElement *pipeline;
+    GstElement *source, *depay, *parser, *decoder, *conv, *sink;   // source and depay belong to front_end, conv may be NULL
+    GstElement *scale, *scale_filter;                               // Display size downscaler, NULL unless needed
+    GstElement *decode_queue, *render_queue;                        // Thread boundaries, NULL unless pipelined
+    RctGstCodec codec;                                              // Taken by parser and decoder, rebuilt for another one
+    guint bus_watch_id;
+
+    // Sources
+    RctGstSource *front_end;                                        // Linked to the parser
+    RctGstStandbyPool *standby_pool;
+    RctGstReconnect *reconnect;                                     // Lives as long as the player
+    RctGstStatsCollector *stats;                                    // Lives as long as the player, probes only while enabled
+    GSource *stats_source;
+    RctGstQosController *qos;                                       // Lives as long as the player, probes only while a pipeline exists
+    gint resolution_divisor;                                        // Set by the last QoS rung, divides the surface bounds
+    RctGstJitterController *jitter;                                 // Lives as long as the player
+    GSource *jitter_source;
+    RctGstTransportSelector *transport;                             // Lives as long as the player
+
+    // Shared decode mode, the view stands in for the pipeline
+    gboolean shared;                                                // Initialized in shared mode
+    RctGstSharedView *shared_view;                                  // NULL while detached
+    GstState shared_state;                                          // Last state reported for the view
+
+    // Mosaic mode, the tiles stand in for the front end
+    RctGstMosaic *mosaic;
+    GPtrArray *mosaic_uris;                                         // Uri of every tile, applied on init
+
+    // Timeshift ring after the parser, NULL unless enabled on init. Set under info_lock.
+    RctGstDvr *dvr;
+    GQueue dvr_exports;                                             // Finished, not reported yet. Under info_lock.
+
+    // Stills of the last frame, lives as long as the player
+    RctGstSnapshotter *snapshotter;
+
+    // Seeking, non-live front ends only
+    RctGstScrubCache *scrub_cache;                                  // NULL unless scrubCacheBytes is set
+    gdouble rate;
+    gboolean seek_pending;                                          // Flushing seek not prerolled yet
+    gint64 scrub_target_us;                                         // Issued once the pending seek is done, -1 for none
+    volatile gint seek_frame_pending;                               // Set once seek_started_at is valid
+    gint64 seek_started_at;                                         // Monotonic µs
+
+    // Audio metering, NULL unless audioLevelRefreshRate is set
+    RctGstAudioMeter *audio_meter;
+    GArray *audio_levels;                                           // RctGstAudioLevel measured since the last delivery
+    GSource *audio_level_source;
+
+    // Suspension, player thread only. The front end stays on standby and nothing reaches the parser.
+    gboolean suspended;
+    gboolean resume_pending;                                        // Resume asked before a surface came back
+    volatile gint suspended_gop_bytes;                              // GOP cached by the suspended front end
+
+    // Player thread, every pipeline operation runs there
+    GMainContext *context;
+    GMainLoop *main_loop;
+    GThread *thread;
+    RctGstCommandQueue *commands;
+
+    // Element chain actually built, read from any thread
+    GMutex info_lock;
+    gchar *element_chain;
+    RctGstAudioLevel audio_level;                                   // Last measurement
+    gboolean has_audio_level;
+
+    // Video
+    guintptr drawable_surface;
+    gint surface_width, surface_height;                             // Pixels, 0 until the surface reports its size
+
+    // Uri switch tracking, written on the player thread and read by streaming threads
+    volatile gint awaiting_keyframe;                                // Delta frames are dropped until a keyframe shows up
+    volatile gint first_frame_pending;                              // Set once switch_started_at is valid
+    gint64 switch_started_at;                                       // Monotonic µs
+    RctGstUriSwitchMode switch_mode;
+    gint64 last_switch_ttff_us;                                     // Time to first frame of the last switch
+};
+
+// Lifecycle
+RctGstPlayer *rct_gst_player_new();
+void rct_gst_player_free(RctGstPlayer *player);
+
 // Getters
-RctGstConfiguration *rct_gst_get_configuration();
-RctGstAudioLevel *rct_gst_get_audio_level();
+RctGstConfiguration *rct_gst_get_configuration(RctGstPlayer *player);
+gboolean rct_gst_get_audio_level(RctGstPlayer *player, RctGstAudioLevel *level);  // FALSE until a measurement exists
 
-// Setters
-void rct_gst_set_drawable_surface(guintptr _drawableSurface);
-void rct_gst_set_uri(gchar* _uri);
-void rct_gst_set_audio_level_refresh_rate(gint rct_gst_set_audio_level_refresh_rate);
-void rct_gst_set_debugging(gboolean is_debugging);
+// Setters, posted to the player thread and applied asynchronously
+void rct_gst_set_drawable_surface(RctGstPlayer *player, guintptr _drawableSurface);
+void rct_gst_set_surface_size(RctGstPlayer *player, gint width, gint height);
+void rct_gst_set_stats_refresh_rate(RctGstPlayer *player, guint refresh_rate);
+void rct_gst_set_uri(RctGstPlayer *player, gchar* _uri);
+void rct_gst_set_audio_level_refresh_rate(RctGstPlayer *player, guint audio_level_refresh_rate);
+void rct_gst_set_transport_policy(RctGstPlayer *player, const gchar *transports, guint timeout, gboolean remember);
+void rct_gst_set_debugging(RctGstPlayer *player, gboolean is_debugging);
+void rct_gst_set_standby_pool(RctGstPlayer *player, guint capacity, gsize gop_budget);
+void rct_gst_set_reconnect_policy(RctGstPlayer *player, guint initial_delay, guint max_delay,
+                                  gdouble jitter, guint stall_timeout);
+void rct_gst_set_qos_policy(RctGstPlayer *player, RctGstQosRung max_rung, guint max_lateness);
+void rct_gst_set_jitter_policy(RctGstPlayer *player, RctGstJitterMode mode, guint min_latency,
+                               guint max_latency, gdouble target_loss);
+void rct_gst_set_mosaic_layout(RctGstPlayer *player, guint columns, guint rows);
+void rct_gst_set_mosaic_tile(RctGstPlayer *player, guint index, const gchar *uri);  // NULL removes the tile
+void rct_gst_set_dvr_policy(RctGstPlayer *player, guint max_duration, gsize max_bytes);
+void rct_gst_set_scrub_cache(RctGstPlayer *player, gsize max_bytes, gint thumbnail_width);
 
-// Other
-GstStateChangeReturn rct_gst_set_pipeline_state(GstState state);
-void rct_gst_init(RctGstConfiguration *configuration);
-void rct_gst_run_loop();
-void rct_gst_terminate();
+// Other, posted to the player thread as well
+void rct_gst_set_pipeline_state(RctGstPlayer *player, GstState state);
+void rct_gst_init(RctGstPlayer *player);
+void rct_gst_prepare_uri(RctGstPlayer *player, gchar *_uri);       // Opens a standby session for a later switch
+void rct_gst_terminate(RctGstPlayer *player);
+void rct_gst_suspend(RctGstPlayer *player);                          // Keeps the session, stops decoding and rendering
+void rct_gst_resume(RctGstPlayer *player);                           // Waits for a drawable surface if there is none
+void rct_gst_timeshift(RctGstPlayer *player, guint offset_ms);       // Plays offset_ms behind live, 0 returns to live
+void rct_gst_export_clip(RctGstPlayer *player, guint offset_ms,      // Writes the ring from offset_ms behind live,
+                         guint duration_ms, const gchar *path,       // onDvrExport tells the outcome
+                         RctGstDvrFormat format);
+void rct_gst_seek(RctGstPlayer *player, gint64 position_us,          // Non-live uris only
+                  RctGstSeekMode mode);
+void rct_gst_set_rate(RctGstPlayer *player, gdouble rate);           // Fast and backwards rates only show keyframes
+void rct_gst_scrub(RctGstPlayer *player, gint64 position_us);        // Preview from the cache, then a keyframe seek
+void rct_gst_snapshot(RctGstPlayer *player,                          // Encodes the last displayed frame off the
+                      RctGstSnapshotFormat format, gint max_size,    // player thread, to path or to bytes when
+                      const gchar *path, RctGstSnapshotFunc done,    // path is NULL. done is always called, on a
+                      gpointer user_data);                           // worker thread or the player thread
+void rct_gst_dump_graph(RctGstPlayer *player, const gchar *path);  // Writes the pipeline as a dot file
 
 gchar *rct_gst_get_info();
-void apply_uri();
+gchar *rct_gst_get_element_chain(RctGstPlayer *player);            // NULL before init, free with g_free
+gint64 rct_gst_get_last_switch_ttff(RctGstPlayer *player);
+void rct_gst_get_reconnect_stats(RctGstPlayer *player, RctGstReconnectStats *stats);
+void rct_gst_get_stats(RctGstPlayer *player, RctGstStats *stats);
+void rct_gst_get_qos_status(RctGstPlayer *player, RctGstQosStatus *status);
+void rct_gst_get_jitter_status(RctGstPlayer *player, RctGstJitterStatus *status);
+gboolean rct_gst_get_dvr_status(RctGstPlayer *player, RctGstDvrStatus *status);   // FALSE without a ring
+void rct_gst_get_transport_stats(RctGstPlayer *player, RctGstTransportStats stats[RCT_GST_TRANSPORT_COUNT]);
+void apply_uri(RctGstPlayer *player);
 
 #endif /* gstreamer_backend_h */
@@ -0,0 +1,105 @@
+#include "gstreamer_codec.h"
+#include "gstreamer_autoplug.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerCodec"
+
+typedef struct {
+    const gchar *name;
+    const gchar *encoding_name;         // RTP, as in the SDP
+    const gchar *media_type;            // Demuxed and parsed
+    const gchar *depay;
+    const gchar *parser;
+} CodecInfo;
+
+// Indexed by RctGstCodec
+static const CodecInfo codecs[] = {
+    { "unknown", NULL, NULL, NULL, NULL },
+    { "H.264", "H264", "video/x-h264", "rtph264depay", "h264parse" },
+    { "H.265", "H265", "video/x-h265", "rtph265depay", "h265parse" },
+    { "MJPEG", "JPEG", "image/jpeg", "rtpjpegdepay", "jpegparse" }
+};
+
+RctGstCodec rct_gst_codec_from_caps(const GstCaps *caps)
+{
+    const GstStructure *structure;
+    const gchar *encoding_name;
+    guint i;
+
+    if (!caps || gst_caps_is_empty(caps) || gst_caps_is_any(caps)) {
+        return RCT_GST_CODEC_UNKNOWN;
+    }
+    structure = gst_caps_get_structure(caps, 0);
+    encoding_name = gst_structure_get_string(structure, "encoding-name");
+
+    for (i = RCT_GST_CODEC_H264; i < G_N_ELEMENTS(codecs); i++) {
+        if (gst_structure_has_name(structure, "application/x-rtp")
+                ? g_ascii_strcasecmp(encoding_name ? encoding_name : "", codecs[i].encoding_name) == 0
+                : gst_structure_has_name(structure, codecs[i].media_type)) {
+            return (RctGstCodec)i;
+        }
+    }
+    return RCT_GST_CODEC_UNKNOWN;
+}
+
+const gchar *rct_gst_codec_get_name(RctGstCodec codec)
+{
+    return codecs[codec].name;
+}
+
+GstCaps *rct_gst_codec_get_caps(RctGstCodec codec)
+{
+    return codec == RCT_GST_CODEC_UNKNOWN ? NULL : gst_caps_new_empty_simple(codecs[codec].media_type);
+}
+
+// Caps query rather than accept-caps: a parser accepts its media type without the fields its decoder restricts
+gboolean rct_gst_codec_accepted_by(RctGstCodec codec, GstPad *pad)
+{
+    GstCaps *caps = rct_gst_codec_get_caps(codec);
+    GstCaps *allowed;
+    gboolean accepted;
+
+    if (!caps) {
+        return FALSE;
+    }
+    allowed = gst_pad_query_caps(pad, NULL);
+    accepted = gst_caps_can_intersect(caps, allowed);
+    gst_caps_unref(allowed);
+    gst_caps_unref(caps);
+    return accepted;
+}
+
+static GstElement *make_element(const gchar *factory, const gchar *name)
+{
+    GstElement *element = factory ? gst_element_factory_make(factory, name) : NULL;
+
+    if (factory && !element) {
+        LOGE("%s is not available", factory);
+    }
+    return element;
+}
+
+GstElement *rct_gst_codec_make_depay(RctGstCodec codec, const gchar *name)
+{
+    return make_element(codecs[codec].depay, name);
+}
+
+GstElement *rct_gst_codec_make_parser(RctGstCodec codec, const gchar *name)
+{
+    return make_element(codecs[codec].parser, name);
+}
+
+// Picked by rank among the ones taking the parser output, hardware ones first. jpegdec is an image decoder.
+GstElement *rct_gst_codec_make_decoder(RctGstCodec codec, const gchar *name)
+{
+    GstCaps *caps = rct_gst_codec_get_caps(codec);
+    GstElement *decoder;
+
+    if (!caps) {
+        return NULL;
+    }
+    decoder = rct_gst_autoplug_make(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO |
+                                    GST_ELEMENT_FACTORY_TYPE_MEDIA_IMAGE, caps, name);
+    gst_caps_unref(caps);
+    return decoder;
+}
@@ -0,0 +1,37 @@
+//
+//  gstreamer_codec.h
+//
+//  Video codecs the player takes, and the elements each one needs: the RTP
+//  depayloader picked from the encoding-name of the session caps, the
+//  parser, and a decoder autoplugged from the parsed caps.
+//
+
+#ifndef gstreamer_codec_h
+#define gstreamer_codec_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_CODEC_UNKNOWN,
+    RCT_GST_CODEC_H264,
+    RCT_GST_CODEC_H265,
+    RCT_GST_CODEC_MJPEG,
+    RCT_GST_CODEC_COUNT
+} RctGstCodec;
+
+// RTP caps by their encoding-name, demuxed ones by their media type. UNKNOWN for the other codecs.
+RctGstCodec rct_gst_codec_from_caps(const GstCaps *caps);
+const gchar *rct_gst_codec_get_name(RctGstCodec codec);
+
+// Caps of the parsed stream, NULL for UNKNOWN
+GstCaps *rct_gst_codec_get_caps(RctGstCodec codec);
+
+// TRUE when pad could take the parsed stream
+gboolean rct_gst_codec_accepted_by(RctGstCodec codec, GstPad *pad);
+
+// NULL when the element is not available
+GstElement *rct_gst_codec_make_depay(RctGstCodec codec, const gchar *name);
+GstElement *rct_gst_codec_make_parser(RctGstCodec codec, const gchar *name);
+GstElement *rct_gst_codec_make_decoder(RctGstCodec codec, const gchar *name);
+
+#endif /* gstreamer_codec_h */
@@ -0,0 +1,179 @@
+#include "gstreamer_command_queue.h"
+
+struct _RctGstCommandQueue
+{
+    GSource source;                     // Must stay first, the queue is the GSource itself
+    RctGstCommand *pending;             // LIFO stack, only touched through atomics
+    RctGstCommandHandler handler;
+    gpointer user_data;
+    GMainContext *context;
+};
+
+static gboolean queue_is_pending(RctGstCommandQueue *queue)
+{
+    return g_atomic_pointer_get(&queue->pending) != NULL;
+}
+
+// Takes every pending command at once and returns them in posting order
+static RctGstCommand *queue_take_all(RctGstCommandQueue *queue)
+{
+    RctGstCommand *stack;
+    RctGstCommand *ordered = NULL;
+
+    do {
+        stack = g_atomic_pointer_get(&queue->pending);
+    } while (!g_atomic_pointer_compare_and_exchange(&queue->pending, stack, NULL));
+
+    while (stack) {
+        RctGstCommand *next = stack->next;
+        stack->next = ordered;
+        ordered = stack;
+        stack = next;
+    }
+    return ordered;
+}
+
+static void command_free(RctGstCommand *command)
+{
+    if (command->type == RCT_GST_COMMAND_SET_URI || command->type == RCT_GST_COMMAND_PREPARE_URI) {
+        g_free(command->args.uri);
+    } else if (command->type == RCT_GST_COMMAND_SET_TRANSPORT_POLICY) {
+        g_free(command->args.transport_policy.order);
+    } else if (command->type == RCT_GST_COMMAND_SET_MOSAIC_TILE) {
+        g_free(command->args.mosaic_tile.uri);
+    } else if (command->type == RCT_GST_COMMAND_DVR_EXPORT) {
+        g_free(command->args.dvr_export.path);
+    } else if (command->type == RCT_GST_COMMAND_SNAPSHOT) {
+        g_free(command->args.snapshot.path);
+    } else if (command->type == RCT_GST_COMMAND_DUMP_GRAPH) {
+        g_free(command->args.graph_path);
+    }
+    g_free(command);
+}
+
+/*************
+ GSOURCE FUNCS
+ ************/
+static gboolean queue_prepare(GSource *source, gint *timeout)
+{
+    *timeout = -1;
+    return queue_is_pending((RctGstCommandQueue *)source);
+}
+
+static gboolean queue_check(GSource *source)
+{
+    return queue_is_pending((RctGstCommandQueue *)source);
+}
+
+static gboolean queue_dispatch(GSource *source, GSourceFunc callback, gpointer user_data)
+{
+    RctGstCommandQueue *queue = (RctGstCommandQueue *)source;
+    RctGstCommand *command = queue_take_all(queue);
+
+    while (command) {
+        RctGstCommand *next = command->next;
+        queue->handler(command, queue->user_data);
+        command_free(command);
+        command = next;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void queue_finalize(GSource *source)
+{
+    RctGstCommand *command = queue_take_all((RctGstCommandQueue *)source);
+
+    while (command) {
+        RctGstCommand *next = command->next;
+        command_free(command);
+        command = next;
+    }
+}
+
+static GSourceFuncs queue_source_funcs = {
+    queue_prepare,
+    queue_check,
+    queue_dispatch,
+    queue_finalize
+};
+
+/**********
+ PUBLIC API
+ *********/
+RctGstCommandQueue *rct_gst_command_queue_new(GMainContext *context, RctGstCommandHandler handler, gpointer user_data)
+{
+    RctGstCommandQueue *queue = (RctGstCommandQueue *)g_source_new(&queue_source_funcs, sizeof(RctGstCommandQueue));
+    queue->pending = NULL;
+    queue->handler = handler;
+    queue->user_data = user_data;
+    queue->context = context;
+
+    g_source_set_priority((GSource *)queue, G_PRIORITY_HIGH);
+    g_source_attach((GSource *)queue, context);
+    return queue;
+}
+
+void rct_gst_command_queue_free(RctGstCommandQueue *queue)
+{
+    g_source_destroy((GSource *)queue);
+    g_source_unref((GSource *)queue);
+}
+
+RctGstCommand *rct_gst_command_new(RctGstCommandType type)
+{
+    RctGstCommand *command = g_new0(RctGstCommand, 1);
+    command->type = type;
+    command->posted_at = g_get_monotonic_time();
+    return command;
+}
+
+void rct_gst_command_queue_push(RctGstCommandQueue *queue, RctGstCommand *command)
+{
+    RctGstCommand *head;
+
+    do {
+        head = g_atomic_pointer_get(&queue->pending);
+        command->next = head;
+    } while (!g_atomic_pointer_compare_and_exchange(&queue->pending, head, command));
+
+    // Only the first command of a batch has to wake the context up
+    if (head == NULL) {
+        g_main_context_wakeup(queue->context);
+    }
+}
+
+const gchar *rct_gst_command_type_get_name(RctGstCommandType type)
+{
+    switch (type) {
+        case RCT_GST_COMMAND_INIT: return "init";
+        case RCT_GST_COMMAND_SET_URI: return "set_uri";
+        case RCT_GST_COMMAND_SET_DRAWABLE_SURFACE: return "set_drawable_surface";
+        case RCT_GST_COMMAND_SET_PIPELINE_STATE: return "set_pipeline_state";
+        case RCT_GST_COMMAND_SET_DEBUGGING: return "set_debugging";
+        case RCT_GST_COMMAND_PREPARE_URI: return "prepare_uri";
+        case RCT_GST_COMMAND_SET_STANDBY_POOL: return "set_standby_pool";
+        case RCT_GST_COMMAND_SET_RECONNECT_POLICY: return "set_reconnect_policy";
+        case RCT_GST_COMMAND_SET_SURFACE_SIZE: return "set_surface_size";
+        case RCT_GST_COMMAND_SET_STATS_REFRESH_RATE: return "set_stats_refresh_rate";
+        case RCT_GST_COMMAND_SET_AUDIO_LEVEL_REFRESH_RATE: return "set_audio_level_refresh_rate";
+        case RCT_GST_COMMAND_SUSPEND: return "suspend";
+        case RCT_GST_COMMAND_RESUME: return "resume";
+        case RCT_GST_COMMAND_SET_QOS_POLICY: return "set_qos_policy";
+        case RCT_GST_COMMAND_SET_JITTER_POLICY: return "set_jitter_policy";
+        case RCT_GST_COMMAND_SET_TRANSPORT_POLICY: return "set_transport_policy";
+        case RCT_GST_COMMAND_SET_MOSAIC_LAYOUT: return "set_mosaic_layout";
+        case RCT_GST_COMMAND_SET_MOSAIC_TILE: return "set_mosaic_tile";
+        case RCT_GST_COMMAND_SET_DVR_POLICY: return "set_dvr_policy";
+        case RCT_GST_COMMAND_DVR_PLAY_FROM: return "dvr_play_from";
+        case RCT_GST_COMMAND_DVR_EXPORT: return "dvr_export";
+        case RCT_GST_COMMAND_SEEK: return "seek";
+        case RCT_GST_COMMAND_SET_RATE: return "set_rate";
+        case RCT_GST_COMMAND_SCRUB: return "scrub";
+        case RCT_GST_COMMAND_SET_SCRUB_CACHE: return "set_scrub_cache";
+        case RCT_GST_COMMAND_SNAPSHOT: return "snapshot";
+        case RCT_GST_COMMAND_DUMP_GRAPH: return "dump_graph";
+        case RCT_GST_COMMAND_TERMINATE: return "terminate";
+        case RCT_GST_COMMAND_QUIT: return "quit";
+    }
+    return "unknown";
+}
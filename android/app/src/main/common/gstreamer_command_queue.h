@@ -0,0 +1,143 @@
+//
+//  gstreamer_command_queue.h
+//
+//  Control operations posted to a player thread. Producers never lock:
+//  commands are pushed on an atomic stack that the player's GMainContext
+//  drains in posting order.
+//
+
+#ifndef gstreamer_command_queue_h
+#define gstreamer_command_queue_h
+
+#include <gst/gst.h>
+#include "gstreamer_snapshot.h"
+
+// Command kinds, also reported to onCommandDone.
+// Values are mirrored by GstCommand in GstPlayer.js: append new kinds before QUIT.
+typedef enum {
+    RCT_GST_COMMAND_INIT,
+    RCT_GST_COMMAND_SET_URI,
+    RCT_GST_COMMAND_SET_DRAWABLE_SURFACE,
+    RCT_GST_COMMAND_SET_PIPELINE_STATE,
+    RCT_GST_COMMAND_SET_DEBUGGING,
+    RCT_GST_COMMAND_TERMINATE,
+    RCT_GST_COMMAND_PREPARE_URI,
+    RCT_GST_COMMAND_SET_STANDBY_POOL,
+    RCT_GST_COMMAND_SET_RECONNECT_POLICY,
+    RCT_GST_COMMAND_SET_SURFACE_SIZE,
+    RCT_GST_COMMAND_SET_STATS_REFRESH_RATE,
+    RCT_GST_COMMAND_SET_AUDIO_LEVEL_REFRESH_RATE,
+    RCT_GST_COMMAND_SUSPEND,
+    RCT_GST_COMMAND_RESUME,
+    RCT_GST_COMMAND_SET_QOS_POLICY,
+    RCT_GST_COMMAND_SET_JITTER_POLICY,
+    RCT_GST_COMMAND_SET_TRANSPORT_POLICY,
+    RCT_GST_COMMAND_SET_MOSAIC_LAYOUT,
+    RCT_GST_COMMAND_SET_MOSAIC_TILE,
+    RCT_GST_COMMAND_SET_DVR_POLICY,
+    RCT_GST_COMMAND_DVR_PLAY_FROM,
+    RCT_GST_COMMAND_DVR_EXPORT,
+    RCT_GST_COMMAND_SEEK,
+    RCT_GST_COMMAND_SET_RATE,
+    RCT_GST_COMMAND_SCRUB,
+    RCT_GST_COMMAND_SET_SCRUB_CACHE,
+    RCT_GST_COMMAND_SNAPSHOT,
+    RCT_GST_COMMAND_DUMP_GRAPH,
+    RCT_GST_COMMAND_QUIT                // Internal, never reported
+} RctGstCommandType;
+
+typedef struct _RctGstCommand RctGstCommand;
+struct _RctGstCommand
+{
+    RctGstCommandType type;
+    union {
+        gchar *uri;                     // Owned by the command until handled (set_uri, prepare_uri)
+        guintptr drawable_surface;
+        GstState state;
+        gboolean is_debugging;
+        struct {
+            guint capacity;
+            gsize gop_budget;
+        } standby_pool;
+        struct {
+            guint initial_delay;        // ms
+            guint max_delay;            // ms
+            gdouble jitter;
+            guint stall_timeout;        // ms
+        } reconnect_policy;
+        struct {
+            gint width;
+            gint height;
+        } surface_size;
+        guint refresh_rate;             // ms (set_stats_refresh_rate, set_audio_level_refresh_rate)
+        struct {
+            guint max_rung;             // RctGstQosRung
+            guint max_lateness;         // ms
+        } qos_policy;
+        struct {
+            guint mode;                 // RctGstJitterMode
+            guint min_latency;          // ms
+            guint max_latency;          // ms
+            gdouble target_loss;
+        } jitter_policy;
+        struct {
+            gchar *order;               // Owned by the command until handled
+            guint timeout;              // ms
+            gboolean remember;
+        } transport_policy;
+        struct {
+            guint columns;
+            guint rows;
+        } mosaic_layout;
+        struct {
+            guint index;
+            gchar *uri;                 // Owned by the command until handled, NULL removes the tile
+        } mosaic_tile;
+        struct {
+            guint max_duration;         // ms
+            gsize max_bytes;
+        } dvr_policy;
+        guint dvr_offset;               // ms behind live (dvr_play_from)
+        struct {
+            guint offset;               // ms behind live
+            guint duration;             // ms, 0 up to live
+            gchar *path;                // Owned by the command until handled
+            guint format;               // RctGstDvrFormat
+        } dvr_export;
+        struct {
+            gint64 position;            // µs
+            guint mode;                 // RctGstSeekMode
+        } seek;
+        gdouble rate;                   // Negative plays backwards (set_rate)
+        gint64 scrub_position;          // µs
+        struct {
+            gsize max_bytes;
+            gint width;                 // Thumbnail width in pixels
+        } scrub_cache;
+        struct {
+            guint format;               // RctGstSnapshotFormat
+            gint max_size;              // Pixels, 0 keeps the frame size
+            gchar *path;                // Owned by the command until handled, NULL for bytes
+            RctGstSnapshotFunc done;    // Always called once handled
+            gpointer user_data;
+        } snapshot;
+        gchar *graph_path;              // Owned by the command until handled (dump_graph)
+    } args;
+    gint64 posted_at;                   // Monotonic time in µs, used for latency reporting
+    RctGstCommand *next;
+};
+
+typedef struct _RctGstCommandQueue RctGstCommandQueue;
+
+// Called on the context thread for every command, in posting order
+typedef void (*RctGstCommandHandler)(RctGstCommand *command, gpointer user_data);
+
+RctGstCommandQueue *rct_gst_command_queue_new(GMainContext *context, RctGstCommandHandler handler, gpointer user_data);
+void rct_gst_command_queue_free(RctGstCommandQueue *queue);
+
+RctGstCommand *rct_gst_command_new(RctGstCommandType type);
+void rct_gst_command_queue_push(RctGstCommandQueue *queue, RctGstCommand *command);
+
+const gchar *rct_gst_command_type_get_name(RctGstCommandType type);
+
+#endif /* gstreamer_command_queue_h */
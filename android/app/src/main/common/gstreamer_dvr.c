@@ -0,0 +1,605 @@
+#include "gstreamer_dvr.h"
+#include "gstreamer_log.h"
+#include "gstreamer_autoplug.h"
+#include "gstreamer_codec.h"
+
+#define LOG_TAG "GStreamerDvr"
+
+// Units the recording branch may lag behind the live path before the oldest are dropped
+#define RECORD_QUEUE_DEPTH 64
+
+// Time an export pipeline gets to write its file once every unit was pushed
+#define EXPORT_TIMEOUT (10 * GST_SECOND)
+
+typedef struct {
+    GstBuffer *buffer;                  // Shared with the live path, never written to
+    gint64 arrival;                     // Monotonic µs
+} DvrUnit;
+
+typedef struct {
+    RctGstDvr *dvr;
+    GPtrArray *units;                   // DvrUnit, oldest first, starting on a keyframe
+    GstCaps *caps;
+    gchar *path;
+    RctGstDvrFormat format;
+    RctGstDvrExportFunc done;
+    gpointer user_data;
+} DvrExport;
+
+struct _RctGstDvr
+{
+    GstBin *bin;
+    GstElement *tee, *selector, *queue, *sink, *appsrc;
+    GstPad *live_pad, *dvr_pad;         // Selector inputs
+    GstPad *tee_live_pad, *tee_record_pad;
+
+    // Ring, filled by the recording branch streaming thread
+    GMutex lock;
+    GCond cond;
+    GQueue units;                       // DvrUnit, oldest first, starting on a keyframe
+    gsize bytes;
+    guint gops;
+    guint64 evicted_gops;
+    guint max_duration;                 // ms, 0 for no bound
+    gsize max_bytes;                    // 0 for no bound
+    GstCaps *caps;                      // Of every unit in the ring
+
+    // Playback, guarded by lock
+    GThread *playback;
+    gboolean playing_back;
+    GList *cursor;                      // Next unit to push, NULL once caught up with the recording
+    gint64 offset_us;                   // A unit is pushed that long after it was recorded
+
+    GThreadPool *exports;               // One at a time, in order
+};
+
+static void unit_free(gpointer data)
+{
+    DvrUnit *unit = (DvrUnit *)data;
+
+    gst_buffer_unref(unit->buffer);
+    g_free(unit);
+}
+
+static gboolean unit_is_keyframe(DvrUnit *unit)
+{
+    return !GST_BUFFER_FLAG_IS_SET(unit->buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+}
+
+/*****
+ RING
+ ****/
+// With lock held
+static gboolean over_limits(RctGstDvr *dvr)
+{
+    DvrUnit *head = (DvrUnit *)g_queue_peek_head(&dvr->units);
+    DvrUnit *tail = (DvrUnit *)g_queue_peek_tail(&dvr->units);
+
+    if (!head) {
+        return FALSE;
+    }
+    if (dvr->max_bytes > 0 && dvr->bytes > dvr->max_bytes) {
+        return TRUE;
+    }
+    return dvr->max_duration > 0 && tail->arrival - head->arrival > (gint64)dvr->max_duration * 1000;
+}
+
+// With lock held. Returns TRUE when the playback cursor was in the dropped GOP.
+static gboolean drop_head_gop(RctGstDvr *dvr)
+{
+    gboolean cursor_dropped = FALSE;
+    GList *link;
+
+    do {
+        link = g_queue_pop_head_link(&dvr->units);
+        cursor_dropped |= link == dvr->cursor;
+        dvr->bytes -= gst_buffer_get_size(((DvrUnit *)link->data)->buffer);
+        unit_free(link->data);
+        g_list_free_1(link);
+        link = dvr->units.head;
+    } while (link && !unit_is_keyframe((DvrUnit *)link->data));
+    dvr->gops--;
+    dvr->evicted_gops++;
+    return cursor_dropped;
+}
+
+// With lock held. Whole GOPs only, the one being recorded stays.
+static void trim(RctGstDvr *dvr)
+{
+    gboolean cursor_dropped = FALSE;
+
+    while (dvr->gops > 1 && over_limits(dvr)) {
+        cursor_dropped |= drop_head_gop(dvr);
+    }
+
+    // Playback fell out of the ring, it goes on from the oldest GOP left
+    if (cursor_dropped) {
+        dvr->cursor = dvr->units.head;
+        dvr->offset_us = g_get_monotonic_time() - ((DvrUnit *)dvr->cursor->data)->arrival;
+        LOGD("Playback moved to the oldest GOP, %lld ms behind live", (long long)dvr->offset_us / 1000);
+    }
+}
+
+// With lock held
+static void clear_units(RctGstDvr *dvr)
+{
+    g_queue_clear_full(&dvr->units, unit_free);
+    dvr->bytes = 0;
+    dvr->gops = 0;
+    dvr->cursor = NULL;
+}
+
+// With lock held. Last keyframe recorded at or before target, the oldest one when there is none.
+static GList *find_gop(RctGstDvr *dvr, gint64 target)
+{
+    GList *link, *found = dvr->units.head;
+
+    for (link = dvr->units.head; link; link = link->next) {
+        DvrUnit *unit = (DvrUnit *)link->data;
+        if (unit->arrival > target) {
+            break;
+        }
+        if (unit_is_keyframe(unit)) {
+            found = link;
+        }
+    }
+    return found;
+}
+
+// Recording branch streaming thread
+static GstPadProbeReturn cb_record(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstDvr *dvr = (RctGstDvr *)user_data;
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+        GstCaps *caps;
+
+        if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) {
+            return GST_PAD_PROBE_OK;
+        }
+        gst_event_parse_caps(event, &caps);
+        g_mutex_lock(&dvr->lock);
+        // Units of other caps could not be muxed or decoded with the new ones
+        if (dvr->caps && !gst_caps_is_equal(dvr->caps, caps)) {
+            LOGD("Stream caps changed, ring emptied");
+            clear_units(dvr);
+        }
+        gst_caps_replace(&dvr->caps, caps);
+        g_mutex_unlock(&dvr->lock);
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    gboolean keyframe = !GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+    DvrUnit *unit;
+
+    g_mutex_lock(&dvr->lock);
+    if (!keyframe && g_queue_is_empty(&dvr->units)) {
+        g_mutex_unlock(&dvr->lock);
+        return GST_PAD_PROBE_OK;
+    }
+    unit = g_new(DvrUnit, 1);
+    unit->buffer = gst_buffer_ref(buffer);
+    unit->arrival = g_get_monotonic_time();
+    g_queue_push_tail(&dvr->units, unit);
+    dvr->bytes += gst_buffer_get_size(buffer);
+    if (keyframe) {
+        dvr->gops++;
+    }
+    if (dvr->playing_back && !dvr->cursor) {
+        dvr->cursor = dvr->units.tail;
+        g_cond_signal(&dvr->cond);
+    }
+    trim(dvr);
+    g_mutex_unlock(&dvr->lock);
+    return GST_PAD_PROBE_OK;
+}
+
+/*****
+ PLAYBACK
+ ****/
+// Timestamps are moved to the running time of now, the payload is shared with the ring
+static void push_unit(RctGstDvr *dvr, GstBuffer *buffer)
+{
+    GstBuffer *copy = gst_buffer_copy(buffer);
+    GstClock *clock = gst_element_get_clock(dvr->appsrc);
+    GstFlowReturn ret;
+
+    if (clock) {
+        GstClockTime now = gst_clock_get_time(clock) - gst_element_get_base_time(dvr->appsrc);
+        GstClockTime pts_offset = GST_BUFFER_PTS_IS_VALID(buffer) && GST_BUFFER_DTS_IS_VALID(buffer) &&
+                                  GST_BUFFER_PTS(buffer) > GST_BUFFER_DTS(buffer)
+                                  ? GST_BUFFER_PTS(buffer) - GST_BUFFER_DTS(buffer) : 0;
+        GST_BUFFER_DTS(copy) = now;
+        GST_BUFFER_PTS(copy) = now + pts_offset;
+        gst_object_unref(clock);
+    }
+    g_signal_emit_by_name(dvr->appsrc, "push-buffer", copy, &ret);
+    gst_buffer_unref(copy);
+}
+
+static gpointer playback_loop(gpointer user_data)
+{
+    RctGstDvr *dvr = (RctGstDvr *)user_data;
+
+    g_mutex_lock(&dvr->lock);
+    while (dvr->playing_back) {
+        DvrUnit *unit = dvr->cursor ? (DvrUnit *)dvr->cursor->data : NULL;
+        GstBuffer *buffer;
+
+        if (!unit) {
+            g_cond_wait(&dvr->cond, &dvr->lock);
+            continue;
+        }
+        // The cursor may move while waiting, it is looked at again
+        if (g_get_monotonic_time() < unit->arrival + dvr->offset_us) {
+            g_cond_wait_until(&dvr->cond, &dvr->lock, unit->arrival + dvr->offset_us);
+            continue;
+        }
+        buffer = gst_buffer_ref(unit->buffer);
+        dvr->cursor = dvr->cursor->next;
+        g_mutex_unlock(&dvr->lock);
+        push_unit(dvr, buffer);
+        gst_buffer_unref(buffer);
+        g_mutex_lock(&dvr->lock);
+    }
+    g_mutex_unlock(&dvr->lock);
+    return NULL;
+}
+
+static void stop_playback(RctGstDvr *dvr)
+{
+    GThread *thread;
+
+    g_mutex_lock(&dvr->lock);
+    dvr->playing_back = FALSE;
+    dvr->cursor = NULL;
+    thread = dvr->playback;
+    dvr->playback = NULL;
+    g_cond_broadcast(&dvr->cond);
+    g_mutex_unlock(&dvr->lock);
+    if (thread) {
+        g_thread_join(thread);
+    }
+    g_object_set(G_OBJECT(dvr->selector), "active-pad", dvr->live_pad, NULL);
+}
+
+guint rct_gst_dvr_play_from(RctGstDvr *dvr, guint offset_ms)
+{
+    gint64 now = g_get_monotonic_time();
+    GList *start;
+
+    g_mutex_lock(&dvr->lock);
+    if (offset_ms == 0 || g_queue_is_empty(&dvr->units) || !dvr->caps) {
+        g_mutex_unlock(&dvr->lock);
+        stop_playback(dvr);
+        LOGD("Playing live");
+        return 0;
+    }
+    start = find_gop(dvr, now - (gint64)offset_ms * 1000);
+    dvr->cursor = start;
+    dvr->offset_us = now - ((DvrUnit *)start->data)->arrival;
+    g_object_set(G_OBJECT(dvr->appsrc), "caps", dvr->caps, NULL);
+    if (!dvr->playback) {
+        dvr->playing_back = TRUE;
+        dvr->playback = g_thread_new("rct-gst-dvr", playback_loop, dvr);
+    }
+    g_cond_broadcast(&dvr->cond);
+    offset_ms = (guint)(dvr->offset_us / 1000);
+    g_mutex_unlock(&dvr->lock);
+
+    g_object_set(G_OBJECT(dvr->selector), "active-pad", dvr->dvr_pad, NULL);
+    LOGD("Playing %u ms behind live", offset_ms);
+    return offset_ms;
+}
+
+/*****
+ EXPORT
+ ****/
+static void export_free(DvrExport *job)
+{
+    g_ptr_array_unref(job->units);
+    gst_caps_unref(job->caps);
+    g_free(job->path);
+    g_free(job);
+}
+
+// appsrc ! parser ! mp4mux|mpegtsmux ! filesink, the parser of the recorded codec, timestamps start from 0
+static gboolean export_write(DvrExport *job, gint64 *duration_us)
+{
+    GstElement *pipeline = gst_pipeline_new("dvr_export");
+    GstElement *src = gst_element_factory_make("appsrc", "src");
+    GstElement *parser = rct_gst_codec_make_parser(rct_gst_codec_from_caps(job->caps), "parser");
+    GstElement *mux = gst_element_factory_make(job->format == RCT_GST_DVR_FORMAT_MP4 ? "mp4mux" : "mpegtsmux", "mux");
+    GstElement *sink = gst_element_factory_make("filesink", "sink");
+    DvrUnit *first = (DvrUnit *)g_ptr_array_index(job->units, 0);
+    GstClockTime base = GST_BUFFER_DTS_OR_PTS(first->buffer);
+    GstClockTime last = 0;
+    GstFlowReturn ret = GST_FLOW_OK;
+    GstMessage *message;
+    GstBus *bus;
+    gboolean success;
+    guint i;
+
+    if (!pipeline || !src || !parser || !mux || !sink) {
+        LOGE("Export elements are missing");
+        if (pipeline) {
+            gst_object_unref(pipeline);
+        }
+        if (src) {
+            gst_object_unref(src);
+        }
+        if (parser) {
+            gst_object_unref(parser);
+        }
+        if (mux) {
+            gst_object_unref(mux);
+        }
+        if (sink) {
+            gst_object_unref(sink);
+        }
+        return FALSE;
+    }
+    g_object_set(G_OBJECT(src), "caps", job->caps, "format", GST_FORMAT_TIME, "block", TRUE, NULL);
+    rct_gst_autoplug_set_int(parser, "config-interval", -1);
+    g_object_set(G_OBJECT(sink), "location", job->path, NULL);
+    gst_bin_add_many(GST_BIN(pipeline), src, parser, mux, sink, NULL);
+    if (!gst_element_link_many(src, parser, mux, sink, NULL) ||
+        gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE) {
+        LOGE("Export pipeline could not be started");
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+        gst_object_unref(pipeline);
+        return FALSE;
+    }
+
+    for (i = 0; i < job->units->len && ret == GST_FLOW_OK; i++) {
+        DvrUnit *unit = (DvrUnit *)g_ptr_array_index(job->units, i);
+        GstBuffer *copy = gst_buffer_copy(unit->buffer);
+
+        // Arrival times stand in for the stream timestamps when there are none
+        if (GST_CLOCK_TIME_IS_VALID(base) && GST_BUFFER_DTS_OR_PTS(unit->buffer) >= base) {
+            if (GST_BUFFER_DTS_IS_VALID(copy)) {
+                GST_BUFFER_DTS(copy) -= base;
+            }
+            if (GST_BUFFER_PTS_IS_VALID(copy)) {
+                GST_BUFFER_PTS(copy) = GST_BUFFER_PTS(copy) >= base ? GST_BUFFER_PTS(copy) - base : 0;
+            }
+        } else {
+            GST_BUFFER_DTS(copy) = GST_BUFFER_PTS(copy) = (unit->arrival - first->arrival) * GST_USECOND;
+        }
+        last = MAX(last, GST_BUFFER_DTS_OR_PTS(copy));
+        g_signal_emit_by_name(src, "push-buffer", copy, &ret);
+        gst_buffer_unref(copy);
+    }
+    g_signal_emit_by_name(src, "end-of-stream", &ret);
+
+    bus = gst_element_get_bus(pipeline);
+    message = gst_bus_timed_pop_filtered(bus, EXPORT_TIMEOUT, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    success = message && GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS;
+    if (message && !success) {
+        GError *err = NULL;
+        gst_message_parse_error(message, &err, NULL);
+        LOGE("Export to %s failed: %s", job->path, err->message);
+        g_clear_error(&err);
+    }
+    if (message) {
+        gst_message_unref(message);
+    }
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    *duration_us = (gint64)(last / GST_USECOND);
+    return success;
+}
+
+static void export_run(gpointer data, gpointer user_data)
+{
+    DvrExport *job = (DvrExport *)data;
+    gint64 duration_us = 0;
+    gboolean success;
+
+    (void)user_data;
+    LOGD("Exporting %u units to %s", job->units->len, job->path);
+    success = export_write(job, &duration_us);
+    LOGI("Export to %s %s, %lld ms", job->path, success ? "done" : "failed", (long long)duration_us / 1000);
+    job->done(job->dvr, job->path, success, duration_us, job->user_data);
+    export_free(job);
+}
+
+gboolean rct_gst_dvr_export(RctGstDvr *dvr, guint offset_ms, guint duration_ms, const gchar *path,
+                            RctGstDvrFormat format, RctGstDvrExportFunc done, gpointer user_data)
+{
+    gint64 now = g_get_monotonic_time();
+    DvrExport *job;
+    GList *link;
+    gint64 end = G_MAXINT64;
+
+    g_mutex_lock(&dvr->lock);
+    if (g_queue_is_empty(&dvr->units) || !dvr->caps) {
+        g_mutex_unlock(&dvr->lock);
+        LOGE("Nothing recorded to export to %s", path);
+        return FALSE;
+    }
+    job = g_new0(DvrExport, 1);
+    job->dvr = dvr;
+    job->units = g_ptr_array_new_with_free_func(unit_free);
+    job->caps = gst_caps_ref(dvr->caps);
+    job->path = g_strdup(path);
+    job->format = format;
+    job->done = done;
+    job->user_data = user_data;
+
+    // The job holds references, the ring can go on dropping GOPs
+    link = find_gop(dvr, now - (gint64)offset_ms * 1000);
+    if (duration_ms > 0) {
+        end = ((DvrUnit *)link->data)->arrival + (gint64)duration_ms * 1000;
+    }
+    for (; link && ((DvrUnit *)link->data)->arrival < end; link = link->next) {
+        DvrUnit *unit = g_new(DvrUnit, 1);
+        unit->buffer = gst_buffer_ref(((DvrUnit *)link->data)->buffer);
+        unit->arrival = ((DvrUnit *)link->data)->arrival;
+        g_ptr_array_add(job->units, unit);
+    }
+    g_mutex_unlock(&dvr->lock);
+
+    g_thread_pool_push(dvr->exports, job, NULL);
+    return TRUE;
+}
+
+/*****
+ LIFECYCLE
+ ****/
+RctGstDvr *rct_gst_dvr_new(GstBin *bin, GstElement *upstream, GstElement *downstream,
+                           guint max_duration, gsize max_bytes)
+{
+    RctGstDvr *dvr;
+    GstElement *tee = gst_element_factory_make("tee", "dvr_tee");
+    GstElement *selector = gst_element_factory_make("input-selector", "dvr_selector");
+    GstElement *queue = gst_element_factory_make("queue", "dvr_queue");
+    GstElement *sink = gst_element_factory_make("fakesink", "dvr_sink");
+    GstElement *appsrc = gst_element_factory_make("appsrc", "dvr_src");
+    GstElement *elements[] = { tee, selector, queue, sink, appsrc };
+    GstPad *pad;
+    gboolean linked;
+    guint i;
+
+    if (!tee || !selector || !queue || !sink || !appsrc) {
+        LOGE("Failed to create DVR elements");
+        for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+            if (elements[i]) {
+                gst_object_unref(elements[i]);
+            }
+        }
+        return NULL;
+    }
+
+    dvr = g_new0(RctGstDvr, 1);
+    dvr->bin = bin;
+    dvr->tee = tee;
+    dvr->selector = selector;
+    dvr->queue = queue;
+    dvr->sink = sink;
+    dvr->appsrc = appsrc;
+    dvr->max_duration = max_duration;
+    dvr->max_bytes = max_bytes;
+    g_mutex_init(&dvr->lock);
+    g_cond_init(&dvr->cond);
+    g_queue_init(&dvr->units);
+    dvr->exports = g_thread_pool_new(export_run, dvr, 1, FALSE, NULL);
+
+    // Inactive inputs are dropped right away instead of being held back to their running time
+    rct_gst_autoplug_set_boolean(selector, "sync-streams", FALSE);
+    rct_gst_autoplug_set_boolean(selector, "cache-buffers", FALSE);
+    g_object_set(G_OBJECT(tee), "allow-not-linked", TRUE, NULL);
+    g_object_set(G_OBJECT(queue),
+                 "max-size-buffers", RECORD_QUEUE_DEPTH,
+                 "max-size-bytes", 0,
+                 "max-size-time", (guint64)0,
+                 "leaky", 2,                                        // 2 is downstream: the oldest units go first
+                 NULL);
+    g_object_set(G_OBJECT(sink), "sync", FALSE, "async", FALSE, NULL);
+    g_object_set(G_OBJECT(appsrc), "format", GST_FORMAT_TIME, "is-live", TRUE, NULL);
+
+    for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+        gst_bin_add(bin, elements[i]);
+    }
+    gst_element_unlink(upstream, downstream);
+    dvr->tee_live_pad = gst_element_get_request_pad(tee, "src_%u");
+    dvr->tee_record_pad = gst_element_get_request_pad(tee, "src_%u");
+    dvr->live_pad = gst_element_get_request_pad(selector, "sink_%u");
+    dvr->dvr_pad = gst_element_get_request_pad(selector, "sink_%u");
+
+    linked = gst_element_link(upstream, tee) && gst_element_link(selector, downstream) &&
+             gst_element_link(queue, sink);
+    pad = gst_element_get_static_pad(queue, "sink");
+    linked = linked && GST_PAD_LINK_SUCCESSFUL(gst_pad_link(dvr->tee_live_pad, dvr->live_pad)) &&
+             GST_PAD_LINK_SUCCESSFUL(gst_pad_link(dvr->tee_record_pad, pad));
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(appsrc, "src");
+    linked = linked && GST_PAD_LINK_SUCCESSFUL(gst_pad_link(pad, dvr->dvr_pad));
+    gst_object_unref(pad);
+    // The player goes on without a ring
+    if (!linked) {
+        LOGE("DVR branch could not be linked");
+        rct_gst_dvr_free(dvr);
+        for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+            gst_bin_remove(bin, elements[i]);
+        }
+        gst_element_link(upstream, downstream);
+        return NULL;
+    }
+    g_object_set(G_OBJECT(selector), "active-pad", dvr->live_pad, NULL);
+
+    pad = gst_element_get_static_pad(sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, cb_record, dvr, NULL);
+    gst_object_unref(pad);
+    LOGI("DVR ring bounded by %u ms and %" G_GSIZE_FORMAT " bytes", max_duration, max_bytes);
+    return dvr;
+}
+
+// Elements belong to the bin, they go with it
+void rct_gst_dvr_free(RctGstDvr *dvr)
+{
+    GstPad *pads[4];
+    guint i;
+
+    if (!dvr) {
+        return;
+    }
+    stop_playback(dvr);
+    g_thread_pool_free(dvr->exports, FALSE, TRUE);
+
+    pads[0] = dvr->tee_live_pad;
+    pads[1] = dvr->tee_record_pad;
+    pads[2] = dvr->live_pad;
+    pads[3] = dvr->dvr_pad;
+    for (i = 0; i < G_N_ELEMENTS(pads); i++) {
+        if (pads[i]) {
+            gst_element_release_request_pad(i < 2 ? dvr->tee : dvr->selector, pads[i]);
+            gst_object_unref(pads[i]);
+        }
+    }
+
+    g_mutex_lock(&dvr->lock);
+    clear_units(dvr);
+    gst_caps_replace(&dvr->caps, NULL);
+    g_mutex_unlock(&dvr->lock);
+    g_mutex_clear(&dvr->lock);
+    g_cond_clear(&dvr->cond);
+    g_free(dvr);
+}
+
+void rct_gst_dvr_set_limits(RctGstDvr *dvr, guint max_duration, gsize max_bytes)
+{
+    g_mutex_lock(&dvr->lock);
+    dvr->max_duration = max_duration;
+    dvr->max_bytes = max_bytes;
+    trim(dvr);
+    g_mutex_unlock(&dvr->lock);
+    LOGD("DVR ring bounded by %u ms and %" G_GSIZE_FORMAT " bytes", max_duration, max_bytes);
+}
+
+void rct_gst_dvr_clear(RctGstDvr *dvr)
+{
+    stop_playback(dvr);
+    g_mutex_lock(&dvr->lock);
+    clear_units(dvr);
+    g_mutex_unlock(&dvr->lock);
+}
+
+void rct_gst_dvr_get_status(RctGstDvr *dvr, RctGstDvrStatus *status)
+{
+    DvrUnit *head, *tail;
+
+    g_mutex_lock(&dvr->lock);
+    head = (DvrUnit *)g_queue_peek_head(&dvr->units);
+    tail = (DvrUnit *)g_queue_peek_tail(&dvr->units);
+    status->duration_us = head ? tail->arrival - head->arrival : 0;
+    status->bytes = dvr->bytes;
+    status->gops = dvr->gops;
+    status->evicted_gops = dvr->evicted_gops;
+    status->offset_ms = dvr->playing_back ? (guint)(dvr->offset_us / 1000) : 0;
+    g_mutex_unlock(&dvr->lock);
+}
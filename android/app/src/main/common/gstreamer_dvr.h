@@ -0,0 +1,62 @@
+//
+//  gstreamer_dvr.h
+//
+//  Timeshift and recording branch of a player. A tee after the parser keeps
+//  the parsed access units in a ring that starts and ends on whole GOPs and
+//  is bounded by time and bytes. Units are kept by reference: nothing is
+//  copied or re-encoded. The decoder takes its input from an input-selector,
+//  so playback can move back into the ring and return to live, and segments
+//  of the ring can be written to MP4 or MPEG-TS files off the player thread.
+//
+
+#ifndef gstreamer_dvr_h
+#define gstreamer_dvr_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_DVR_FORMAT_MP4,
+    RCT_GST_DVR_FORMAT_TS
+} RctGstDvrFormat;
+
+typedef struct _RctGstDvr RctGstDvr;
+
+typedef struct {
+    gint64 duration_us;                 // Time covered by the ring
+    gsize bytes;
+    guint gops;
+    guint64 evicted_gops;               // Dropped to stay within the bounds
+    guint offset_ms;                    // Delay of the playback behind live, 0 when live
+} RctGstDvrStatus;
+
+// Export thread, once the file is closed. path is only valid during the call.
+typedef void (*RctGstDvrExportFunc)(RctGstDvr *dvr, const gchar *path, gboolean success, gint64 duration_us,
+                                    gpointer user_data);
+
+// Splices tee ! input-selector between upstream and downstream, already linked in bin and still in NULL state.
+// max_duration in ms and max_bytes bound the ring, 0 leaves a bound out. NULL when it could not be built,
+// upstream and downstream are then linked again.
+RctGstDvr *rct_gst_dvr_new(GstBin *bin, GstElement *upstream, GstElement *downstream,
+                           guint max_duration, gsize max_bytes);
+
+// After the bin went to NULL, waits for the exports in progress
+void rct_gst_dvr_free(RctGstDvr *dvr);
+
+// The GOP being recorded is always kept, older ones go first
+void rct_gst_dvr_set_limits(RctGstDvr *dvr, guint max_duration, gsize max_bytes);
+
+// Empties the ring and returns to live, for a stream that changed
+void rct_gst_dvr_clear(RctGstDvr *dvr);
+
+// Plays from the last keyframe offset_ms behind live (the oldest one when the ring is shorter), paced
+// in real time. 0 returns to live. Returns the actual offset in ms, 0 when live.
+guint rct_gst_dvr_play_from(RctGstDvr *dvr, guint offset_ms);
+
+// Writes the GOPs from offset_ms behind live to path, duration_ms long or up to live when 0.
+// FALSE when there is nothing to write, otherwise done is always called.
+gboolean rct_gst_dvr_export(RctGstDvr *dvr, guint offset_ms, guint duration_ms, const gchar *path,
+                            RctGstDvrFormat format, RctGstDvrExportFunc done, gpointer user_data);
+
+void rct_gst_dvr_get_status(RctGstDvr *dvr, RctGstDvrStatus *status);
+
+#endif /* gstreamer_dvr_h */
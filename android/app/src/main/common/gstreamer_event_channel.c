@@ -0,0 +1,298 @@
+#include "gstreamer_event_channel.h"
+#include <string.h>
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerEventChannel"
+
+// A cell is free for position p when its sequence is p, and holds the event of p when it is p + 1.
+// Positions wrap around, they are only ever compared through their difference.
+typedef struct {
+    volatile gint sequence;
+    RctGstEvent event;
+} RctGstEventCell;
+
+struct _RctGstEventChannel
+{
+    RctGstEventCell *cells;
+    guint mask;
+    volatile gint enqueue_pos;
+    gint dequeue_pos;                   // Consumer only
+
+    // Only taken to sleep and to wake a sleeping consumer up
+    GMutex lock;
+    GCond cond;
+    volatile gint waiting;
+
+    volatile gint pushed;
+    volatile gint dropped;
+    guint64 coalesced;                  // Consumer only
+    guint64 batches;
+};
+
+static gint position_distance(gint a, gint b)
+{
+    return (gint)((guint)a - (guint)b);
+}
+
+static gboolean try_push(RctGstEventChannel *channel, RctGstEvent *event)
+{
+    RctGstEventCell *cell;
+    gint pos = g_atomic_int_get(&channel->enqueue_pos);
+    gint distance;
+
+    for (;;) {
+        cell = &channel->cells[(guint)pos & channel->mask];
+        distance = position_distance(g_atomic_int_get(&cell->sequence), pos);
+        if (distance == 0) {
+            if (g_atomic_int_compare_and_exchange(&channel->enqueue_pos, pos, (gint)((guint)pos + 1))) {
+                break;
+            }
+            pos = g_atomic_int_get(&channel->enqueue_pos);
+        } else if (distance < 0) {
+            return FALSE;
+        } else {
+            pos = g_atomic_int_get(&channel->enqueue_pos);
+        }
+    }
+
+    cell->event = *event;
+    g_atomic_int_set(&cell->sequence, (gint)((guint)pos + 1));
+    return TRUE;
+}
+
+static gboolean try_pop(RctGstEventChannel *channel, RctGstEvent *event)
+{
+    gint pos = channel->dequeue_pos;
+    RctGstEventCell *cell = &channel->cells[(guint)pos & channel->mask];
+
+    if (position_distance(g_atomic_int_get(&cell->sequence), (gint)((guint)pos + 1)) < 0) {
+        return FALSE;
+    }
+    *event = cell->event;
+    g_atomic_int_set(&cell->sequence, (gint)((guint)pos + channel->mask + 1));
+    channel->dequeue_pos = (gint)((guint)pos + 1);
+    return TRUE;
+}
+
+static gboolean is_empty(RctGstEventChannel *channel)
+{
+    gint pos = channel->dequeue_pos;
+    RctGstEventCell *cell = &channel->cells[(guint)pos & channel->mask];
+    return position_distance(g_atomic_int_get(&cell->sequence), (gint)((guint)pos + 1)) < 0;
+}
+
+// Folds earlier into later, both of the same type and target. Returns FALSE when the pair must stay apart.
+static gboolean coalesce_pair(RctGstEvent *earlier, RctGstEvent *later)
+{
+    RctGstAudioLevel *levels;
+
+    switch (later->type) {
+        case RCT_GST_EVENT_RECONNECT:
+        case RCT_GST_EVENT_STATS:
+        case RCT_GST_EVENT_SCRUB_PREVIEW:
+            return TRUE;
+
+        case RCT_GST_EVENT_VOLUME_CHANGED:
+            levels = g_new(RctGstAudioLevel, earlier->args.volume.count + later->args.volume.count);
+            memcpy(levels, earlier->args.volume.levels, earlier->args.volume.count * sizeof(RctGstAudioLevel));
+            memcpy(levels + earlier->args.volume.count, later->args.volume.levels,
+                   later->args.volume.count * sizeof(RctGstAudioLevel));
+            g_free(later->args.volume.levels);
+            later->args.volume.levels = levels;
+            later->args.volume.count += earlier->args.volume.count;
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+// A coalescible event is only folded into the one queued right before it, when of the same kind and target,
+// so listeners still see every other event in between in order
+static void coalesce(RctGstEventChannel *channel, RctGstEvent *events, guint count)
+{
+    RctGstEvent *previous = NULL;
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        if (previous && previous->type == events[i].type && previous->target == events[i].target &&
+            coalesce_pair(previous, &events[i])) {
+            rct_gst_event_clear(previous);
+            previous->dropped = TRUE;
+            channel->coalesced++;
+        }
+        previous = &events[i];
+    }
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstEventChannel *rct_gst_event_channel_new(guint capacity)
+{
+    RctGstEventChannel *channel = g_new0(RctGstEventChannel, 1);
+    guint size = 2;
+    guint i;
+
+    while (size < capacity) {
+        size <<= 1;
+    }
+    channel->cells = g_new0(RctGstEventCell, size);
+    channel->mask = size - 1;
+    for (i = 0; i < size; i++) {
+        channel->cells[i].sequence = (gint)i;
+    }
+    g_mutex_init(&channel->lock);
+    g_cond_init(&channel->cond);
+    LOGD("Event channel of %u events created", size);
+    return channel;
+}
+
+void rct_gst_event_channel_free(RctGstEventChannel *channel)
+{
+    RctGstEvent event;
+
+    if (!channel) {
+        return;
+    }
+    while (try_pop(channel, &event)) {
+        rct_gst_event_clear(&event);
+    }
+    g_mutex_clear(&channel->lock);
+    g_cond_clear(&channel->cond);
+    g_free(channel->cells);
+    g_free(channel);
+}
+
+gboolean rct_gst_event_channel_push(RctGstEventChannel *channel, RctGstEvent *event)
+{
+    event->dropped = FALSE;
+    if (!try_push(channel, event)) {
+        // Once a target is released nothing may refer to it, wait for room rather than lose it
+        if (event->type == RCT_GST_EVENT_RELEASE) {
+            while (!try_push(channel, event)) {
+                rct_gst_event_channel_wakeup(channel);
+                g_usleep(1000);
+            }
+        } else {
+            if (g_atomic_int_add(&channel->dropped, 1) == 0) {
+                LOGE("Event channel full, events are being dropped");
+            }
+            rct_gst_event_clear(event);
+            return FALSE;
+        }
+    }
+    g_atomic_int_inc(&channel->pushed);
+
+    // The lock is only taken when the consumer sleeps
+    if (g_atomic_int_get(&channel->waiting)) {
+        rct_gst_event_channel_wakeup(channel);
+    }
+    return TRUE;
+}
+
+guint rct_gst_event_channel_drain(RctGstEventChannel *channel, RctGstEvent *events, guint max_events, gint64 timeout_us)
+{
+    guint count = 0;
+
+    if (is_empty(channel) && timeout_us > 0) {
+        gint64 end_time = g_get_monotonic_time() + timeout_us;
+
+        g_mutex_lock(&channel->lock);
+        g_atomic_int_set(&channel->waiting, 1);
+        // Checked again once waiting is visible, a producer either sees the flag or its event is seen here
+        while (is_empty(channel)) {
+            if (!g_cond_wait_until(&channel->cond, &channel->lock, end_time)) {
+                break;
+            }
+            // Woken up on purpose with nothing to deliver
+            if (is_empty(channel) && g_atomic_int_get(&channel->waiting) == 0) {
+                break;
+            }
+        }
+        g_atomic_int_set(&channel->waiting, 0);
+        g_mutex_unlock(&channel->lock);
+    }
+
+    while (count < max_events && try_pop(channel, &events[count])) {
+        count++;
+    }
+    if (count > 0) {
+        coalesce(channel, events, count);
+        channel->batches++;
+    }
+    return count;
+}
+
+void rct_gst_event_channel_wakeup(RctGstEventChannel *channel)
+{
+    g_mutex_lock(&channel->lock);
+    g_atomic_int_set(&channel->waiting, 0);
+    g_cond_signal(&channel->cond);
+    g_mutex_unlock(&channel->lock);
+}
+
+void rct_gst_event_channel_get_stats(RctGstEventChannel *channel, RctGstEventChannelStats *stats)
+{
+    stats->pushed = (guint)g_atomic_int_get(&channel->pushed);
+    stats->dropped = (guint)g_atomic_int_get(&channel->dropped);
+    stats->coalesced = channel->coalesced;
+    stats->batches = channel->batches;
+}
+
+void rct_gst_event_clear(RctGstEvent *event)
+{
+    switch (event->type) {
+        case RCT_GST_EVENT_INIT:
+            g_free(event->args.element_chain);
+            event->args.element_chain = NULL;
+            break;
+
+        case RCT_GST_EVENT_URI_CHANGED:
+            g_free(event->args.uri);
+            event->args.uri = NULL;
+            break;
+
+        case RCT_GST_EVENT_ELEMENT_ERROR:
+            g_free(event->args.error.source);
+            g_free(event->args.error.message);
+            g_free(event->args.error.debug_info);
+            event->args.error.source = event->args.error.message = event->args.error.debug_info = NULL;
+            break;
+
+        case RCT_GST_EVENT_STATS:
+            g_free(event->args.stats);
+            event->args.stats = NULL;
+            break;
+
+        case RCT_GST_EVENT_VOLUME_CHANGED:
+            g_free(event->args.volume.levels);
+            event->args.volume.levels = NULL;
+            break;
+
+        case RCT_GST_EVENT_DVR_EXPORT:
+            g_free(event->args.dvr_export.path);
+            event->args.dvr_export.path = NULL;
+            break;
+
+        case RCT_GST_EVENT_SCRUB_PREVIEW:
+            if (event->args.scrub_preview.pixels) {
+                gst_buffer_unref(event->args.scrub_preview.pixels);
+            }
+            event->args.scrub_preview.pixels = NULL;
+            break;
+
+        case RCT_GST_EVENT_SNAPSHOT:
+            g_free(event->args.snapshot.error);
+            g_free(event->args.snapshot.path);
+            if (event->args.snapshot.bytes) {
+                g_bytes_unref(event->args.snapshot.bytes);
+            }
+            event->args.snapshot.error = event->args.snapshot.path = NULL;
+            event->args.snapshot.bytes = NULL;
+            break;
+
+        default:
+            break;
+    }
+}
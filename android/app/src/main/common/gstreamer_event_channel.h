@@ -0,0 +1,118 @@
+//
+//  gstreamer_event_channel.h
+//
+//  Player callbacks turned into events on a bounded lock-free ring.
+//  Producers (player and streaming threads) never block: a full ring drops
+//  the event. A single consumer drains batches in posting order, with
+//  redundant events of the same target coalesced on the way out.
+//
+
+#ifndef gstreamer_event_channel_h
+#define gstreamer_event_channel_h
+
+#include "gstreamer_backend.h"
+
+typedef enum {
+    RCT_GST_EVENT_INIT,
+    RCT_GST_EVENT_STATE_CHANGED,        // Never coalesced, listeners see every transition
+    RCT_GST_EVENT_URI_CHANGED,
+    RCT_GST_EVENT_EOS,
+    RCT_GST_EVENT_ELEMENT_ERROR,
+    RCT_GST_EVENT_FIRST_FRAME,
+    RCT_GST_EVENT_COMMAND_DONE,
+    RCT_GST_EVENT_RECONNECT,            // Coalesced: latest counters win
+    RCT_GST_EVENT_STATS,                // Coalesced: latest snapshot wins
+    RCT_GST_EVENT_VOLUME_CHANGED,       // Coalesced: measurements are concatenated
+    RCT_GST_EVENT_QOS,                  // Never coalesced, every ladder transition is reported
+    RCT_GST_EVENT_DVR_EXPORT,
+    RCT_GST_EVENT_SEEK_DONE,
+    RCT_GST_EVENT_SCRUB_PREVIEW,        // Coalesced: latest thumbnail wins
+    RCT_GST_EVENT_SNAPSHOT,
+    RCT_GST_EVENT_RELEASE               // Last event of a target, never dropped
+} RctGstEventType;
+
+typedef struct {
+    RctGstEventType type;
+    gpointer target;                    // Receiver, opaque to the channel
+    gboolean dropped;                   // Set by coalescing, skip it
+    union {
+        gchar *element_chain;           // init
+        struct {
+            GstState old_state;
+            GstState new_state;
+        } state;
+        gchar *uri;                     // uri_changed
+        struct {
+            gchar *source;
+            gchar *message;
+            gchar *debug_info;
+        } error;
+        struct {
+            RctGstUriSwitchMode mode;
+            gint64 ttff_us;
+            RctGstTransport transport;
+        } first_frame;
+        struct {
+            RctGstCommandType command;
+            gint result;
+            gint64 latency_us;
+        } command_done;
+        RctGstReconnectStats reconnect;
+        RctGstStats *stats;
+        RctGstQosStatus qos;
+        struct {
+            RctGstAudioLevel *levels;
+            guint count;
+        } volume;
+        struct {
+            gchar *path;
+            gboolean success;
+            gint64 duration_us;
+        } dvr_export;
+        struct {
+            gint64 position_us;
+            gint64 duration_us;
+            gint64 latency_us;
+        } seek_done;
+        RctGstScrubThumbnail scrub_preview;
+        struct {
+            gint id;                    // Request of the Java side
+            gboolean success;
+            gchar *error;
+            gchar *path;
+            GBytes *bytes;
+            gint width;
+            gint height;
+            gint64 position_us;
+        } snapshot;
+    } args;                             // Pointers are owned by the event
+} RctGstEvent;
+
+typedef struct _RctGstEventChannel RctGstEventChannel;
+
+typedef struct {
+    guint64 pushed;
+    guint64 dropped;                    // Ring was full
+    guint64 coalesced;
+    guint64 batches;
+} RctGstEventChannelStats;
+
+// capacity is rounded up to a power of two
+RctGstEventChannel *rct_gst_event_channel_new(guint capacity);
+void rct_gst_event_channel_free(RctGstEventChannel *channel);
+
+// Any thread. Takes ownership of the event payloads, freed right away when the ring is full.
+gboolean rct_gst_event_channel_push(RctGstEventChannel *channel, RctGstEvent *event);
+
+// Single consumer. Waits up to timeout_us for events, then takes at most max_events of them
+// and coalesces them. Returns the number written to events, dropped ones included.
+guint rct_gst_event_channel_drain(RctGstEventChannel *channel, RctGstEvent *events, guint max_events, gint64 timeout_us);
+
+// Makes a waiting drain return
+void rct_gst_event_channel_wakeup(RctGstEventChannel *channel);
+
+void rct_gst_event_channel_get_stats(RctGstEventChannel *channel, RctGstEventChannelStats *stats);
+
+void rct_gst_event_clear(RctGstEvent *event);
+
+#endif /* gstreamer_event_channel_h */
@@ -0,0 +1,286 @@
+#include "gstreamer_jitter.h"
+#include <string.h>
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerJitter"
+
+#define MIN_SAMPLE_PACKETS 50           // Fewer packets than this carry over to the next period
+#define RAISE_STEP_MS 20
+#define LOWER_STEP_MS 10
+#define LOWER_AFTER_PERIODS 5           // Clean periods in a row before the latency goes down
+#define JITTER_MARGIN 4                 // The target never goes below this many times the jitter
+#define RTX_MIN_LATENCY_MS 60           // Below this a retransmitted packet cannot arrive in time
+#define RTX_PROBATION_PERIODS 5         // Periods of requests without any success before giving up on it
+
+typedef struct {
+    guint64 pushed;
+    guint64 lost;
+    guint64 late;
+    guint64 rtx_requests;
+    guint64 rtx_successes;
+    guint64 jitter_ns;
+    guint streams;
+} RctGstJitterCounters;
+
+struct _RctGstJitterController
+{
+    // Policy
+    RctGstJitterMode mode;
+    guint min_latency;
+    guint max_latency;
+    gdouble target_loss;
+
+    // Player thread only
+    GstElement *source;                 // Session the baseline belongs to, never dereferenced
+    RctGstJitterCounters baseline;
+    guint clean_periods;
+    guint rtx_failed_periods;
+    gboolean rtx_unsupported;           // Server ignored every request of this session
+
+    // Guarded by lock, read from any thread
+    GMutex lock;
+    RctGstJitterStatus status;
+};
+
+/**********
+ JITTERBUFFERS
+ *********/
+static void read_counters(GstElement *jitterbuffer, gpointer user_data)
+{
+    RctGstJitterCounters *counters = (RctGstJitterCounters *)user_data;
+    GstStructure *structure = NULL;
+    guint64 value;
+
+    g_object_get(G_OBJECT(jitterbuffer), "stats", &structure, NULL);
+    if (!structure) {
+        return;
+    }
+    if (gst_structure_get_uint64(structure, "num-pushed", &value)) {
+        counters->pushed += value;
+    }
+    if (gst_structure_get_uint64(structure, "num-lost", &value)) {
+        counters->lost += value;
+    }
+    if (gst_structure_get_uint64(structure, "num-late", &value)) {
+        counters->late += value;
+    }
+    if (gst_structure_get_uint64(structure, "rtx-count", &value)) {
+        counters->rtx_requests += value;
+    }
+    if (gst_structure_get_uint64(structure, "rtx-success-count", &value)) {
+        counters->rtx_successes += value;
+    }
+    if (gst_structure_get_uint64(structure, "avg-jitter", &value)) {
+        counters->jitter_ns += value;
+        counters->streams++;
+    }
+    gst_structure_free(structure);
+}
+
+static void apply_to_buffer(GstElement *jitterbuffer, gpointer user_data)
+{
+    RctGstJitterStatus *status = (RctGstJitterStatus *)user_data;
+
+    // The jitterbuffer posts a latency message, the pipeline redistributes it
+    g_object_set(G_OBJECT(jitterbuffer), "latency", status->latency_ms,
+                 "do-retransmission", status->retransmission, NULL);
+}
+
+/******
+ POLICY
+ *****/
+static guint raise_latency(RctGstJitterController *jitter, guint latency, gdouble jitter_ms)
+{
+    guint target = MAX(latency + RAISE_STEP_MS, latency * 3 / 2);
+    target = MAX(target, (guint)(jitter_ms * JITTER_MARGIN));
+    return CLAMP(target, jitter->min_latency, jitter->max_latency);
+}
+
+static guint lower_latency(RctGstJitterController *jitter, guint latency, gdouble jitter_ms)
+{
+    guint step = MAX(LOWER_STEP_MS, latency / 10);
+    guint target = latency > step ? latency - step : 0;
+    target = MAX(target, (guint)(jitter_ms * JITTER_MARGIN));
+    return CLAMP(target, jitter->min_latency, MIN(latency, jitter->max_latency));
+}
+
+static void reset_baseline(RctGstJitterController *jitter, GstElement *source)
+{
+    jitter->source = source;
+    jitter->clean_periods = 0;
+    jitter->rtx_failed_periods = 0;
+    jitter->rtx_unsupported = FALSE;
+    memset(&jitter->baseline, 0, sizeof(jitter->baseline));
+    if (source) {
+        rct_gst_jitter_foreach_buffer(source, read_counters, &jitter->baseline);
+    }
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstJitterController *rct_gst_jitter_new(void)
+{
+    RctGstJitterController *jitter = g_new0(RctGstJitterController, 1);
+    g_mutex_init(&jitter->lock);
+    rct_gst_jitter_configure(jitter, RCT_GST_JITTER_FIXED, 0, 1000, 0.01);
+    return jitter;
+}
+
+void rct_gst_jitter_free(RctGstJitterController *jitter)
+{
+    if (!jitter) {
+        return;
+    }
+    g_mutex_clear(&jitter->lock);
+    g_free(jitter);
+}
+
+void rct_gst_jitter_configure(RctGstJitterController *jitter, RctGstJitterMode mode, guint min_latency,
+                              guint max_latency, gdouble target_loss)
+{
+    jitter->mode = mode;
+    jitter->min_latency = min_latency;
+    jitter->max_latency = MAX(min_latency, max_latency);
+    jitter->target_loss = CLAMP(target_loss, 0, 1);
+    jitter->clean_periods = jitter->rtx_failed_periods = 0;
+
+    g_mutex_lock(&jitter->lock);
+    jitter->status.latency_ms = min_latency;
+    jitter->status.retransmission = FALSE;
+    g_mutex_unlock(&jitter->lock);
+}
+
+void rct_gst_jitter_apply(RctGstJitterController *jitter, GstElement *source)
+{
+    RctGstJitterStatus status;
+
+    if (!source) {
+        return;
+    }
+    rct_gst_jitter_get_status(jitter, &status);
+    g_object_set(G_OBJECT(source), "latency", status.latency_ms, "do-retransmission", status.retransmission, NULL);
+    rct_gst_jitter_foreach_buffer(source, apply_to_buffer, &status);
+}
+
+gboolean rct_gst_jitter_update(RctGstJitterController *jitter, GstElement *source)
+{
+    RctGstJitterCounters counters = { 0 };
+    guint64 lost, late, packets;
+    gdouble loss_rate, late_rate, jitter_ms;
+    guint latency, target;
+    gboolean retransmission, rtx_target, rtx_unanswered;
+
+    if (source != jitter->source) {
+        reset_baseline(jitter, source);
+        return FALSE;
+    }
+    if (!source) {
+        return FALSE;
+    }
+
+    rct_gst_jitter_foreach_buffer(source, read_counters, &counters);
+    // Counters of a restarted session start over
+    if (counters.pushed < jitter->baseline.pushed || counters.lost < jitter->baseline.lost) {
+        reset_baseline(jitter, source);
+        return FALSE;
+    }
+    lost = counters.lost - jitter->baseline.lost;
+    late = counters.late - jitter->baseline.late;
+    packets = counters.pushed - jitter->baseline.pushed + lost;
+    jitter_ms = counters.streams ? (gdouble)counters.jitter_ns / counters.streams / 1000000.0 : 0;
+    loss_rate = packets ? (gdouble)lost / packets : 0;
+    late_rate = packets ? (gdouble)late / packets : 0;           // Arrived after their deadline, dropped
+
+    g_mutex_lock(&jitter->lock);
+    jitter->status.jitter_ms = jitter_ms;
+    jitter->status.packets_lost = counters.lost;
+    jitter->status.packets_late = counters.late;
+    jitter->status.rtx_requests = counters.rtx_requests;
+    jitter->status.rtx_successes = counters.rtx_successes;
+    if (packets >= MIN_SAMPLE_PACKETS) {
+        jitter->status.loss_rate = loss_rate;
+    }
+    latency = jitter->status.latency_ms;
+    retransmission = jitter->status.retransmission;
+    g_mutex_unlock(&jitter->lock);
+
+    if (packets < MIN_SAMPLE_PACKETS) {
+        return FALSE;
+    }
+    rtx_unanswered = counters.rtx_requests > jitter->baseline.rtx_requests &&
+                     counters.rtx_successes == jitter->baseline.rtx_successes;
+    jitter->baseline = counters;
+    if (jitter->mode != RCT_GST_JITTER_ADAPTIVE) {
+        return FALSE;
+    }
+
+    // Requests that never get answered only add traffic
+    if (retransmission && rtx_unanswered) {
+        if (++jitter->rtx_failed_periods >= RTX_PROBATION_PERIODS) {
+            LOGI("Retransmission requests are not answered, disabling it for this session");
+            jitter->rtx_unsupported = TRUE;
+        }
+    } else {
+        jitter->rtx_failed_periods = 0;
+    }
+
+    target = latency;
+    // Late packets mean the latency is too short even when retransmission recovers the losses
+    if (loss_rate > jitter->target_loss || late_rate > jitter->target_loss / 2) {
+        jitter->clean_periods = 0;
+        target = raise_latency(jitter, latency, jitter_ms);
+    } else if (loss_rate <= jitter->target_loss / 2 && late == 0) {
+        if (++jitter->clean_periods >= LOWER_AFTER_PERIODS) {
+            jitter->clean_periods = 0;
+            target = lower_latency(jitter, latency, jitter_ms);
+        }
+    } else {
+        jitter->clean_periods = 0;
+    }
+    rtx_target = target >= RTX_MIN_LATENCY_MS && !jitter->rtx_unsupported &&
+                 (retransmission || loss_rate > jitter->target_loss);
+
+    if (target == latency && rtx_target == retransmission) {
+        return FALSE;
+    }
+
+    LOGI("Jitterbuffer latency %u -> %u ms, retransmission %s (loss %.2f%%, jitter %.1f ms)",
+         latency, target, rtx_target ? "on" : "off", loss_rate * 100, jitter_ms);
+    g_mutex_lock(&jitter->lock);
+    jitter->status.latency_ms = target;
+    jitter->status.retransmission = rtx_target;
+    g_mutex_unlock(&jitter->lock);
+    rct_gst_jitter_apply(jitter, source);
+    return TRUE;
+}
+
+void rct_gst_jitter_get_status(RctGstJitterController *jitter, RctGstJitterStatus *status)
+{
+    g_mutex_lock(&jitter->lock);
+    *status = jitter->status;
+    g_mutex_unlock(&jitter->lock);
+}
+
+void rct_gst_jitter_foreach_buffer(GstElement *source, RctGstJitterBufferFunc func, gpointer user_data)
+{
+    GstIterator *iterator;
+    GValue item = G_VALUE_INIT;
+
+    if (!source || !GST_IS_BIN(source)) {
+        return;
+    }
+
+    iterator = gst_bin_iterate_recurse(GST_BIN(source));
+    while (gst_iterator_next(iterator, &item) == GST_ITERATOR_OK) {
+        GstElement *element = GST_ELEMENT(g_value_get_object(&item));
+        GstElementFactory *factory = gst_element_get_factory(element);
+
+        if (factory && g_strcmp0(GST_OBJECT_NAME(factory), "rtpjitterbuffer") == 0) {
+            func(element, user_data);
+        }
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(iterator);
+}
@@ -0,0 +1,55 @@
+//
+//  gstreamer_jitter.h
+//
+//  Jitterbuffer latency controller of a player. In adaptive mode the
+//  rtpjitterbuffers of the active session are sampled periodically: losses
+//  above the target raise the latency (and turn retransmission on once
+//  there is room for it), a clean link lowers it back step by step. The
+//  result is the lowest latency keeping the loss rate under the target.
+//
+
+#ifndef gstreamer_jitter_h
+#define gstreamer_jitter_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_JITTER_FIXED,               // Minimum latency, no retransmission, as set up on the session
+    RCT_GST_JITTER_ADAPTIVE             // Latency and retransmission follow the link quality
+} RctGstJitterMode;
+
+typedef struct {
+    guint latency_ms;                   // Current target
+    gboolean retransmission;
+    gdouble loss_rate;                  // Lost packets over the last period
+    gdouble jitter_ms;                  // Interarrival jitter, averaged over the session streams
+    guint64 packets_lost;               // Session totals
+    guint64 packets_late;
+    guint64 rtx_requests;
+    guint64 rtx_successes;
+} RctGstJitterStatus;
+
+typedef struct _RctGstJitterController RctGstJitterController;
+
+// Called for every rtpjitterbuffer found inside an rtspsrc
+typedef void (*RctGstJitterBufferFunc)(GstElement *jitterbuffer, gpointer user_data);
+
+RctGstJitterController *rct_gst_jitter_new(void);
+void rct_gst_jitter_free(RctGstJitterController *jitter);
+
+// Latencies in ms, target_loss is a fraction of the packets (0.01 is 1%). Back to min_latency.
+void rct_gst_jitter_configure(RctGstJitterController *jitter, RctGstJitterMode mode, guint min_latency,
+                              guint max_latency, gdouble target_loss);
+
+// Sets the current target on a session, before it starts or while it runs
+void rct_gst_jitter_apply(RctGstJitterController *jitter, GstElement *source);
+
+// Samples the session of source and adapts, TRUE when the target changed. A new source starts a new baseline.
+gboolean rct_gst_jitter_update(RctGstJitterController *jitter, GstElement *source);
+
+// Any thread
+void rct_gst_jitter_get_status(RctGstJitterController *jitter, RctGstJitterStatus *status);
+
+void rct_gst_jitter_foreach_buffer(GstElement *source, RctGstJitterBufferFunc func, gpointer user_data);
+
+#endif /* gstreamer_jitter_h */
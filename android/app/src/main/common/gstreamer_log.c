@@ -0,0 +1,319 @@
+#include "gstreamer_log.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#endif
+
+#define LOG_TAG "GStreamerLog"
+
+// Lines the ring holds until they are written out, a power of two
+#define RING_SIZE 1024
+
+// Longer lines are cut
+#define MESSAGE_SIZE 256
+
+// How often the flushing thread looks at the ring, an error wakes it up at once
+#define FLUSH_PERIOD (100 * G_TIME_SPAN_MILLISECOND)
+
+#define MAX_OVERRIDES 32
+#define MAX_CATEGORY_LENGTH 64
+#define DEFAULT_LEVEL RCT_GST_LOG_INFO
+
+typedef struct {
+    volatile gint sequence;             // Reserving index + 1 once the line is complete
+    gint level;
+    const gchar *category;
+    gchar message[MESSAGE_SIZE];
+} LogEntry;
+
+typedef struct {
+    gchar category[MAX_CATEGORY_LENGTH];
+    gint level;
+} LogOverride;
+
+static LogEntry ring[RING_SIZE];
+static volatile gint write_index;       // Next entry a producer reserves
+static volatile gint read_index;        // Next entry written out, only moved under drain_lock
+static volatile gint dropped;
+
+// Serializes writing out, so rct_gst_log_flush and the thread never interleave
+static GMutex drain_lock;
+static RctGstLogOutputFunc output_func;
+static gpointer output_data;
+static guint reported_dropped;
+
+static GMutex wake_lock;
+static GCond wake_cond;
+
+// Guards the levels and the registered sites
+static GMutex config_lock;
+static gint default_level = DEFAULT_LEVEL;
+static LogOverride overrides[MAX_OVERRIDES];
+static guint override_count;
+static RctGstLogSite *sites;
+
+static const gchar *level_names[] = { "none", "error", "info", "debug" };
+
+static void platform_output(gint level, const gchar *category, const gchar *message, gpointer user_data)
+{
+#ifdef __ANDROID__
+    static const int priorities[] = { ANDROID_LOG_SILENT, ANDROID_LOG_ERROR, ANDROID_LOG_INFO, ANDROID_LOG_DEBUG };
+
+    __android_log_write(priorities[level], category, message);
+#else
+    static const gchar letters[] = "-EID";
+
+    fprintf(stderr, "%c/%s: %s\n", letters[level], category, message);
+#endif
+}
+
+/*****
+ RING
+ ****/
+
+static void drain(void)
+{
+    RctGstLogOutputFunc output;
+    gpointer user_data;
+    guint lost;
+
+    g_mutex_lock(&drain_lock);
+    output = output_func ? output_func : platform_output;
+    user_data = output_func ? output_data : NULL;
+
+    for (;;) {
+        guint index = (guint)g_atomic_int_get(&read_index);
+        LogEntry *entry = &ring[index & (RING_SIZE - 1)];
+
+        // Stops at the first line still being formatted, the later ones wait for it
+        if ((guint)g_atomic_int_get(&entry->sequence) != index + 1) {
+            break;
+        }
+        output(entry->level, entry->category, entry->message, user_data);
+        g_atomic_int_set(&read_index, (gint)(index + 1));
+    }
+
+    lost = (guint)g_atomic_int_get(&dropped);
+    if (lost != reported_dropped) {
+        gchar message[64];
+
+        g_snprintf(message, sizeof(message), "%u lines dropped, the ring was full", lost - reported_dropped);
+        output(RCT_GST_LOG_ERROR, LOG_TAG, message, user_data);
+        reported_dropped = lost;
+    }
+    g_mutex_unlock(&drain_lock);
+}
+
+static gpointer flush_loop(gpointer data)
+{
+    for (;;) {
+        g_mutex_lock(&wake_lock);
+        g_cond_wait_until(&wake_cond, &wake_lock, g_get_monotonic_time() + FLUSH_PERIOD);
+        g_mutex_unlock(&wake_lock);
+        drain();
+    }
+    return NULL;
+}
+
+static void ensure_flushing_thread(void)
+{
+    static gsize started = 0;
+
+    if (g_once_init_enter(&started)) {
+        g_thread_unref(g_thread_new("rct-gst-log", flush_loop, NULL));
+        g_once_init_leave(&started, 1);
+    }
+}
+
+/*****
+ SITES
+ ****/
+
+// Called with config_lock held
+static gint resolve_level(const gchar *category)
+{
+    for (guint i = 0; i < override_count; i++) {
+        if (strcmp(overrides[i].category, category) == 0) {
+            return overrides[i].level;
+        }
+    }
+    return default_level;
+}
+
+// Called with config_lock held
+static void update_sites(void)
+{
+    for (RctGstLogSite *site = sites; site; site = site->next) {
+        g_atomic_int_set(&site->level, resolve_level(site->category));
+    }
+}
+
+static void register_site(RctGstLogSite *site)
+{
+    g_mutex_lock(&config_lock);
+    // Two threads may reach a new site at once, the second finds it resolved
+    if (g_atomic_int_get(&site->level) == G_MAXINT) {
+        site->next = sites;
+        sites = site;
+        g_atomic_int_set(&site->level, resolve_level(site->category));
+    }
+    g_mutex_unlock(&config_lock);
+}
+
+void rct_gst_log_write(RctGstLogSite *site, gint level, const gchar *format, ...)
+{
+    LogEntry *entry;
+    guint index;
+    va_list args;
+
+    if (g_atomic_int_get(&site->level) == G_MAXINT) {
+        register_site(site);
+        if (level > g_atomic_int_get(&site->level)) {
+            return;
+        }
+    }
+    ensure_flushing_thread();
+
+    // Reserves an entry, a full ring drops the line before it is formatted
+    do {
+        index = (guint)g_atomic_int_get(&write_index);
+        if (index - (guint)g_atomic_int_get(&read_index) >= RING_SIZE) {
+            g_atomic_int_inc(&dropped);
+            return;
+        }
+    } while (!g_atomic_int_compare_and_exchange(&write_index, (gint)index, (gint)(index + 1)));
+
+    entry = &ring[index & (RING_SIZE - 1)];
+    entry->level = level;
+    entry->category = site->category;
+    va_start(args, format);
+    g_vsnprintf(entry->message, MESSAGE_SIZE, format, args);
+    va_end(args);
+    g_atomic_int_set(&entry->sequence, (gint)(index + 1));
+
+    if (level == RCT_GST_LOG_ERROR) {
+        g_mutex_lock(&wake_lock);
+        g_cond_signal(&wake_cond);
+        g_mutex_unlock(&wake_lock);
+    }
+}
+
+/*****
+ CONFIGURATION
+ ****/
+
+static gboolean parse_level(const gchar *name, gint *level)
+{
+    for (gint i = 0; i < (gint)G_N_ELEMENTS(level_names); i++) {
+        if (g_ascii_strcasecmp(name, level_names[i]) == 0) {
+            *level = i;
+            return TRUE;
+        }
+    }
+    if (name[0] >= '0' && name[0] <= '3' && name[1] == '\0') {
+        *level = name[0] - '0';
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gboolean rct_gst_log_configure(const gchar *spec)
+{
+    LogOverride parsed[MAX_OVERRIDES];
+    guint parsed_count = 0;
+    gint level = DEFAULT_LEVEL;
+    gchar **items;
+    gboolean valid = TRUE;
+
+    if (!spec) {
+        return FALSE;
+    }
+
+    items = g_strsplit(spec, ",", -1);
+    for (gchar **item = items; *item && valid; item++) {
+        gchar *separator;
+
+        g_strstrip(*item);
+        if (**item == '\0') {
+            continue;
+        }
+        separator = strrchr(*item, ':');
+        if (!separator) {
+            valid = parse_level(*item, &level);
+            continue;
+        }
+        *separator = '\0';
+        valid = separator != *item &&
+                strlen(*item) < MAX_CATEGORY_LENGTH &&
+                parsed_count < MAX_OVERRIDES &&
+                parse_level(separator + 1, &parsed[parsed_count].level);
+        if (valid) {
+            g_strlcpy(parsed[parsed_count].category, *item, MAX_CATEGORY_LENGTH);
+            parsed_count++;
+        }
+    }
+    g_strfreev(items);
+
+    if (!valid) {
+        LOGE("Log levels \"%s\" not understood", spec);
+        return FALSE;
+    }
+
+    // The spec replaces the whole configuration, applying it twice changes nothing
+    g_mutex_lock(&config_lock);
+    default_level = level;
+    memcpy(overrides, parsed, parsed_count * sizeof(LogOverride));
+    override_count = parsed_count;
+    update_sites();
+    g_mutex_unlock(&config_lock);
+    return TRUE;
+}
+
+void rct_gst_log_set_level(gint level)
+{
+    g_mutex_lock(&config_lock);
+    default_level = CLAMP(level, RCT_GST_LOG_NONE, RCT_GST_LOG_DEBUG);
+    update_sites();
+    g_mutex_unlock(&config_lock);
+}
+
+void rct_gst_log_set_category_level(const gchar *category, gint level)
+{
+    guint i;
+
+    if (!category || strlen(category) >= MAX_CATEGORY_LENGTH) {
+        return;
+    }
+
+    g_mutex_lock(&config_lock);
+    for (i = 0; i < override_count && strcmp(overrides[i].category, category) != 0; i++) {
+    }
+    if (i < MAX_OVERRIDES) {
+        g_strlcpy(overrides[i].category, category, MAX_CATEGORY_LENGTH);
+        overrides[i].level = CLAMP(level, RCT_GST_LOG_NONE, RCT_GST_LOG_DEBUG);
+        override_count = MAX(override_count, i + 1);
+        update_sites();
+    }
+    g_mutex_unlock(&config_lock);
+}
+
+void rct_gst_log_set_output(RctGstLogOutputFunc output, gpointer user_data)
+{
+    g_mutex_lock(&drain_lock);
+    output_func = output;
+    output_data = user_data;
+    g_mutex_unlock(&drain_lock);
+}
+
+void rct_gst_log_flush(void)
+{
+    drain();
+}
+
+guint rct_gst_log_get_dropped(void)
+{
+    return (guint)g_atomic_int_get(&dropped);
+}
@@ -0,0 +1,68 @@
+//
+//  gstreamer_log.h
+//
+//  LOGI, LOGE and LOGD of the native sources, tagged with the LOG_TAG the
+//  including file defines, which is also their category. A line above
+//  RCT_GST_LOG_MAX_LEVEL is compiled out; one above the runtime level of
+//  its category costs a load and a compare, arguments are not evaluated.
+//  Lines that pass are formatted into a preallocated ring and written to
+//  logcat, or stderr on the host build, by a thread of their own.
+//
+
+#ifndef gstreamer_log_h
+#define gstreamer_log_h
+
+#include <glib.h>
+
+#define RCT_GST_LOG_NONE 0
+#define RCT_GST_LOG_ERROR 1
+#define RCT_GST_LOG_INFO 2
+#define RCT_GST_LOG_DEBUG 3
+
+#ifndef RCT_GST_LOG_MAX_LEVEL
+#define RCT_GST_LOG_MAX_LEVEL RCT_GST_LOG_DEBUG
+#endif
+
+// One per call site, registered on its first call
+typedef struct _RctGstLogSite {
+    const gchar *category;
+    volatile gint level;                // Runtime level of the category, G_MAXINT until registered
+    struct _RctGstLogSite *next;
+} RctGstLogSite;
+
+// Writes a line the flushing thread picked from the ring
+typedef void (*RctGstLogOutputFunc)(gint level, const gchar *category, const gchar *message, gpointer user_data);
+
+void rct_gst_log_write(RctGstLogSite *site, gint level, const gchar *format, ...) G_GNUC_PRINTF(3, 4);
+
+// "info" or "info,GStreamerSource:debug,GStreamerQos:none", levels are none, error, info and debug.
+// The level without category applies to the categories not named. FALSE when the spec did not parse,
+// nothing is changed then.
+gboolean rct_gst_log_configure(const gchar *spec);
+void rct_gst_log_set_level(gint level);
+void rct_gst_log_set_category_level(const gchar *category, gint level);
+
+// NULL restores logcat (stderr on the host)
+void rct_gst_log_set_output(RctGstLogOutputFunc output, gpointer user_data);
+
+// Writes out what the ring holds on the calling thread
+void rct_gst_log_flush(void);
+
+// Lines lost because the ring was full
+guint rct_gst_log_get_dropped(void);
+
+#define RCT_GST_LOG(severity, ...)                                              \
+    G_STMT_START {                                                              \
+        if ((severity) <= RCT_GST_LOG_MAX_LEVEL) {                              \
+            static RctGstLogSite rct_gst_log_site = { LOG_TAG, G_MAXINT, NULL }; \
+            if ((severity) <= g_atomic_int_get(&rct_gst_log_site.level)) {      \
+                rct_gst_log_write(&rct_gst_log_site, (severity), __VA_ARGS__);  \
+            }                                                                   \
+        }                                                                       \
+    } G_STMT_END
+
+#define LOGE(...) RCT_GST_LOG(RCT_GST_LOG_ERROR, __VA_ARGS__)
+#define LOGI(...) RCT_GST_LOG(RCT_GST_LOG_INFO, __VA_ARGS__)
+#define LOGD(...) RCT_GST_LOG(RCT_GST_LOG_DEBUG, __VA_ARGS__)
+
+#endif /* gstreamer_log_h */
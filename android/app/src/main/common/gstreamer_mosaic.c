@@ -0,0 +1,527 @@
+#include "gstreamer_mosaic.h"
+#include "gstreamer_log.h"
+#include "gstreamer_autoplug.h"
+#include "gstreamer_reconnect.h"
+#include "gstreamer_source.h"
+
+#define LOG_TAG "GStreamerMosaic"
+
+// Output until the surface reports its size
+#define MOSAIC_DEFAULT_WIDTH 1280
+#define MOSAIC_DEFAULT_HEIGHT 720
+#define MOSAIC_FRAMERATE 30
+
+// Frames a tile may have waiting for the compositor, older ones are dropped
+#define TILE_QUEUE_DEPTH 2
+
+typedef struct {
+    RctGstMosaic *mosaic;
+    guint index;
+    gchar *uri;
+
+    // Decode chain, rebuilt as a whole on errors that are not the session's
+    RctGstSource *front_end;
+    GstElement *parser, *decoder, *conv, *scale, *filter, *queue;
+    GstPad *mixer_pad;
+    volatile gint awaiting_keyframe;    // Delta frames are dropped until the session of a new uri shows a keyframe
+
+    RctGstReconnect *reconnect;         // Lives as long as the tile
+} MosaicTile;
+
+struct _RctGstMosaic
+{
+    GstBin *bin;
+    GMainContext *context;
+    GstElement *mixer, *output_filter;
+    guint columns, rows;
+    gint width, height;
+    gboolean playing;
+    GPtrArray *tiles;                   // MosaicTile by index, NULL where there is none
+};
+
+static gboolean tile_build(MosaicTile *tile);
+static void tile_destroy(MosaicTile *tile);
+
+/*****
+ LAYOUT
+ ****/
+static void tile_geometry(RctGstMosaic *mosaic, guint index, gint *x, gint *y, gint *width, gint *height)
+{
+    *width = mosaic->width / (gint)mosaic->columns;
+    *height = mosaic->height / (gint)mosaic->rows;
+    *x = (gint)(index % mosaic->columns) * *width;
+    *y = (gint)(index / mosaic->columns) * *height;
+}
+
+// Tiles are scaled down before the compositor, it only copies them. Square pixels make
+// videoscale keep the stream aspect ratio with borders.
+static void tile_layout(MosaicTile *tile)
+{
+    gint x, y, width, height;
+    GstCaps *caps;
+
+    tile_geometry(tile->mosaic, tile->index, &x, &y, &width, &height);
+    width = MAX(width, 16);
+    height = MAX(height, 16);
+    caps = gst_caps_new_simple("video/x-raw",
+                               "width", G_TYPE_INT, width,
+                               "height", G_TYPE_INT, height,
+                               "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                               NULL);
+    g_object_set(G_OBJECT(tile->filter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+    g_object_set(G_OBJECT(tile->mixer_pad), "xpos", x, "ypos", y, "width", width, "height", height, NULL);
+}
+
+static void apply_output_caps(RctGstMosaic *mosaic)
+{
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+                                        "width", G_TYPE_INT, mosaic->width,
+                                        "height", G_TYPE_INT, mosaic->height,
+                                        "framerate", GST_TYPE_FRACTION, MOSAIC_FRAMERATE, 1,
+                                        NULL);
+
+    g_object_set(G_OBJECT(mosaic->output_filter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+}
+
+static void relayout(RctGstMosaic *mosaic)
+{
+    guint i;
+
+    LOGD("Laying out %ux%u tiles on %dx%d", mosaic->columns, mosaic->rows, mosaic->width, mosaic->height);
+    apply_output_caps(mosaic);
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        MosaicTile *tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, i);
+        if (tile && tile->mixer_pad) {
+            tile_layout(tile);
+        }
+    }
+}
+
+/****
+ TILES
+ ***/
+// Decoder input, see the player keyframe gate
+static GstPadProbeReturn cb_keyframe_gate(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    MosaicTile *tile = (MosaicTile *)user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+
+    if (!g_atomic_int_get(&tile->awaiting_keyframe)) {
+        return GST_PAD_PROBE_OK;
+    }
+    if (GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        return GST_PAD_PROBE_DROP;
+    }
+    g_atomic_int_set(&tile->awaiting_keyframe, FALSE);
+    return GST_PAD_PROBE_OK;
+}
+
+// Opens a session on the tile uri in place of the current one, the decode chain keeps running
+static gboolean tile_start_session(MosaicTile *tile)
+{
+    RctGstSource *front_end = rct_gst_source_new(tile->mosaic->bin, tile->uri);
+
+    if (!front_end) {
+        return FALSE;
+    }
+    g_object_set(G_OBJECT(front_end->source), "buffer-size", 2097152, "latency", 0, NULL);
+
+    rct_gst_source_free(tile->front_end);
+    tile->front_end = NULL;
+    g_atomic_int_set(&tile->awaiting_keyframe, TRUE);
+    if (!rct_gst_source_activate(front_end, tile->parser)) {
+        rct_gst_source_free(front_end);
+        return FALSE;
+    }
+    tile->front_end = front_end;
+    rct_gst_source_start(front_end);
+    return TRUE;
+}
+
+// rtspsrc ! depay ! h264parse ! decoder ! videoconvert ! videoscale ! capsfilter ! queue ! compositor
+// H.264 only: the front end of a tile of another codec posts an error
+static gboolean tile_build(MosaicTile *tile)
+{
+    RctGstMosaic *mosaic = tile->mosaic;
+    GstCaps *caps = gst_caps_new_empty_simple("video/x-h264");
+    GstElement *chain[6];
+    GstPad *pad;
+    guint i;
+
+    tile->parser = gst_element_factory_make("h264parse", NULL);
+    tile->decoder = rct_gst_autoplug_make(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+                                          caps, NULL);
+    tile->conv = gst_element_factory_make("videoconvert", NULL);
+    tile->scale = gst_element_factory_make("videoscale", NULL);
+    tile->filter = gst_element_factory_make("capsfilter", NULL);
+    tile->queue = gst_element_factory_make("queue", NULL);
+    gst_caps_unref(caps);
+
+    chain[0] = tile->parser;
+    chain[1] = tile->decoder;
+    chain[2] = tile->conv;
+    chain[3] = tile->scale;
+    chain[4] = tile->filter;
+    chain[5] = tile->queue;
+    for (i = 0; i < G_N_ELEMENTS(chain); i++) {
+        if (!chain[i]) {
+            LOGE("Failed to create the elements of tile %u", tile->index);
+            tile_destroy(tile);
+            return FALSE;
+        }
+    }
+
+    g_object_set(G_OBJECT(tile->parser), "disable-passthrough", TRUE, NULL);
+    rct_gst_autoplug_set_boolean(tile->decoder, "low-latency", TRUE);
+    g_object_set(G_OBJECT(tile->queue),
+                 "max-size-buffers", TILE_QUEUE_DEPTH,
+                 "max-size-bytes", 0,
+                 "max-size-time", (guint64)0,
+                 "leaky", 2,                                        // 2 is downstream: the oldest frames go first
+                 NULL);
+
+    for (i = 0; i < G_N_ELEMENTS(chain); i++) {
+        gst_bin_add(mosaic->bin, chain[i]);
+    }
+    for (i = 0; i + 1 < G_N_ELEMENTS(chain); i++) {
+        if (!gst_element_link(chain[i], chain[i + 1])) {
+            LOGE("Tile %u could not be linked", tile->index);
+            tile_destroy(tile);
+            return FALSE;
+        }
+    }
+
+    tile->mixer_pad = gst_element_get_request_pad(mosaic->mixer, "sink_%u");
+    pad = gst_element_get_static_pad(tile->queue, "src");
+    if (!tile->mixer_pad || GST_PAD_LINK_FAILED(gst_pad_link(pad, tile->mixer_pad))) {
+        LOGE("Tile %u could not be linked to the compositor", tile->index);
+        gst_object_unref(pad);
+        tile_destroy(tile);
+        return FALSE;
+    }
+    gst_object_unref(pad);
+    tile_layout(tile);
+
+    pad = gst_element_get_static_pad(tile->decoder, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_keyframe_gate, tile, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(tile->parser, "sink");
+    rct_gst_reconnect_watch_pad(tile->reconnect, pad);
+    gst_object_unref(pad);
+
+    // Downstream first, every element is ready for data before the one feeding it
+    for (i = G_N_ELEMENTS(chain); i > 0; i--) {
+        gst_element_sync_state_with_parent(chain[i - 1]);
+    }
+    if (!tile_start_session(tile)) {
+        LOGE("Session of tile %u could not be opened", tile->index);
+        tile_destroy(tile);
+        return FALSE;
+    }
+    rct_gst_reconnect_set_armed(tile->reconnect, mosaic->playing);
+    return TRUE;
+}
+
+// Upstream first: once an element is down, nothing pushes into the next one anymore
+static void tile_destroy(MosaicTile *tile)
+{
+    GstElement *chain[] = { tile->parser, tile->decoder, tile->conv, tile->scale, tile->filter, tile->queue };
+    guint i;
+
+    rct_gst_reconnect_set_armed(tile->reconnect, FALSE);
+    rct_gst_source_free(tile->front_end);
+    tile->front_end = NULL;
+
+    for (i = 0; i < G_N_ELEMENTS(chain); i++) {
+        if (chain[i]) {
+            gst_element_set_state(chain[i], GST_STATE_NULL);
+        }
+    }
+    if (tile->mixer_pad) {
+        gst_element_release_request_pad(tile->mosaic->mixer, tile->mixer_pad);
+        gst_object_unref(tile->mixer_pad);
+        tile->mixer_pad = NULL;
+    }
+    for (i = 0; i < G_N_ELEMENTS(chain); i++) {
+        if (!chain[i]) {
+            continue;
+        }
+        if (GST_OBJECT_PARENT(chain[i])) {
+            gst_bin_remove(tile->mosaic->bin, chain[i]);
+        } else {
+            gst_object_unref(chain[i]);
+        }
+    }
+    tile->parser = tile->decoder = tile->conv = tile->scale = tile->filter = tile->queue = NULL;
+}
+
+static void cb_tile_restart(RctGstRestartKind kind, gpointer user_data)
+{
+    MosaicTile *tile = (MosaicTile *)user_data;
+
+    if (!tile->mosaic->playing) {
+        return;
+    }
+    if (kind == RCT_GST_RESTART_SOURCE && tile->parser && tile_start_session(tile)) {
+        return;
+    }
+    LOGD("Rebuilding tile %u", tile->index);
+    tile_destroy(tile);
+    tile_build(tile);
+}
+
+static MosaicTile *tile_new(RctGstMosaic *mosaic, guint index, const gchar *uri)
+{
+    MosaicTile *tile = g_new0(MosaicTile, 1);
+
+    tile->mosaic = mosaic;
+    tile->index = index;
+    tile->uri = g_strdup(uri);
+    tile->reconnect = rct_gst_reconnect_new(mosaic->context, cb_tile_restart, NULL, tile);
+    return tile;
+}
+
+static void tile_free(MosaicTile *tile)
+{
+    if (!tile) {
+        return;
+    }
+    // Elements first, their probes point at the reconnect engine
+    tile_destroy(tile);
+    rct_gst_reconnect_free(tile->reconnect);
+    g_free(tile->uri);
+    g_free(tile);
+}
+
+static gboolean tile_owns(MosaicTile *tile, GstObject *object)
+{
+    GstElement *elements[] = { tile->front_end ? tile->front_end->source : NULL,
+                               tile->front_end ? tile->front_end->depay : NULL,
+                               tile->parser, tile->decoder, tile->conv, tile->scale, tile->filter, tile->queue };
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+        if (elements[i] && (object == GST_OBJECT(elements[i]) || gst_object_has_as_ancestor(object, GST_OBJECT(elements[i])))) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static gboolean tile_owns_session(MosaicTile *tile, GstObject *object)
+{
+    if (!tile->front_end) {
+        return FALSE;
+    }
+    return object == GST_OBJECT(tile->front_end->source) || object == GST_OBJECT(tile->front_end->depay) ||
+           gst_object_has_as_ancestor(object, GST_OBJECT(tile->front_end->source));
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstMosaic *rct_gst_mosaic_new(GstBin *bin, GMainContext *context, guint columns, guint rows)
+{
+    RctGstMosaic *mosaic;
+    GstElement *mixer = gst_element_factory_make("compositor", "mixer");
+    GstElement *output_filter = gst_element_factory_make("capsfilter", "mosaic_filter");
+
+    if (!mixer || !output_filter) {
+        LOGE("compositor not available");
+        if (mixer) {
+            gst_object_unref(mixer);
+        }
+        if (output_filter) {
+            gst_object_unref(output_filter);
+        }
+        return NULL;
+    }
+
+    mosaic = g_new0(RctGstMosaic, 1);
+    mosaic->bin = bin;
+    mosaic->context = context;
+    mosaic->mixer = mixer;
+    mosaic->output_filter = output_filter;
+    mosaic->columns = MAX(columns, 1);
+    mosaic->rows = MAX(rows, 1);
+    mosaic->width = MOSAIC_DEFAULT_WIDTH;
+    mosaic->height = MOSAIC_DEFAULT_HEIGHT;
+    mosaic->tiles = g_ptr_array_new();
+    g_ptr_array_set_size(mosaic->tiles, mosaic->columns * mosaic->rows);
+
+    // Black between tiles, and a tile whose session is down must not hold the others back
+    rct_gst_autoplug_set_int(mixer, "background", 1);
+    rct_gst_autoplug_set_boolean(mixer, "ignore-inactive-pads", TRUE);
+    rct_gst_autoplug_set_int(mixer, "start-time-selection", 1);            // First buffer
+    gst_bin_add_many(bin, mixer, output_filter, NULL);
+    if (!gst_element_link(mixer, output_filter)) {
+        LOGE("compositor could not be linked");
+        gst_bin_remove_many(bin, mixer, output_filter, NULL);
+        g_ptr_array_free(mosaic->tiles, TRUE);
+        g_free(mosaic);
+        return NULL;
+    }
+    apply_output_caps(mosaic);
+    return mosaic;
+}
+
+void rct_gst_mosaic_free(RctGstMosaic *mosaic)
+{
+    guint i;
+
+    if (!mosaic) {
+        return;
+    }
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        tile_free((MosaicTile *)g_ptr_array_index(mosaic->tiles, i));
+    }
+    g_ptr_array_free(mosaic->tiles, TRUE);
+    g_free(mosaic);
+}
+
+GstElement *rct_gst_mosaic_get_output(RctGstMosaic *mosaic)
+{
+    return mosaic->output_filter;
+}
+
+void rct_gst_mosaic_set_layout(RctGstMosaic *mosaic, guint columns, guint rows)
+{
+    guint i;
+
+    columns = MAX(columns, 1);
+    rows = MAX(rows, 1);
+    if (columns == mosaic->columns && rows == mosaic->rows) {
+        return;
+    }
+    for (i = columns * rows; i < mosaic->tiles->len; i++) {
+        tile_free((MosaicTile *)g_ptr_array_index(mosaic->tiles, i));
+    }
+    g_ptr_array_set_size(mosaic->tiles, columns * rows);
+    mosaic->columns = columns;
+    mosaic->rows = rows;
+    relayout(mosaic);
+}
+
+void rct_gst_mosaic_set_output_size(RctGstMosaic *mosaic, gint width, gint height)
+{
+    if (width <= 0 || height <= 0 || (width == mosaic->width && height == mosaic->height)) {
+        return;
+    }
+    mosaic->width = width;
+    mosaic->height = height;
+    relayout(mosaic);
+}
+
+gboolean rct_gst_mosaic_set_tile(RctGstMosaic *mosaic, guint index, const gchar *uri)
+{
+    MosaicTile *tile;
+
+    if (index >= mosaic->tiles->len) {
+        LOGE("Tile %u is off the %ux%u grid", index, mosaic->columns, mosaic->rows);
+        return FALSE;
+    }
+    tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, index);
+
+    if (!uri) {
+        LOGD("Removing tile %u", index);
+        tile_free(tile);
+        g_ptr_array_index(mosaic->tiles, index) = NULL;
+        return TRUE;
+    }
+    if (tile && g_strcmp0(tile->uri, uri) == 0) {
+        return TRUE;
+    }
+
+    if (tile && tile->parser) {
+        LOGD("Replacing the session of tile %u: %s", index, uri);
+        g_free(tile->uri);
+        tile->uri = g_strdup(uri);
+        if (tile_start_session(tile)) {
+            return TRUE;
+        }
+        tile_destroy(tile);
+        return tile_build(tile);
+    }
+
+    LOGD("Adding tile %u: %s", index, uri);
+    if (!tile) {
+        tile = tile_new(mosaic, index, uri);
+        g_ptr_array_index(mosaic->tiles, index) = tile;
+    } else {
+        g_free(tile->uri);
+        tile->uri = g_strdup(uri);
+    }
+    return tile_build(tile);
+}
+
+void rct_gst_mosaic_set_playing(RctGstMosaic *mosaic, gboolean playing)
+{
+    guint i;
+
+    mosaic->playing = playing;
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        MosaicTile *tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, i);
+        if (!tile) {
+            continue;
+        }
+        if (playing) {
+            rct_gst_reconnect_set_armed(tile->reconnect, tile->parser != NULL);
+        } else {
+            rct_gst_reconnect_cancel(tile->reconnect);
+        }
+    }
+}
+
+gboolean rct_gst_mosaic_failure(RctGstMosaic *mosaic, GstObject *object, const gchar *reason)
+{
+    guint i;
+
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        MosaicTile *tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, i);
+        if (!tile || !tile_owns(tile, object)) {
+            continue;
+        }
+        LOGE("Tile %u failed: %s", tile->index, reason);
+        rct_gst_reconnect_failure(tile->reconnect,
+                                  tile_owns_session(tile, object) ? RCT_GST_RESTART_SOURCE : RCT_GST_RESTART_PIPELINE,
+                                  reason);
+        return TRUE;
+    }
+    return FALSE;
+}
+
+gchar *rct_gst_mosaic_describe(RctGstMosaic *mosaic)
+{
+    GString *description = g_string_new("compositor ! capsfilter");
+    guint i;
+
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        MosaicTile *tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, i);
+        gchar *chain;
+        if (!tile || !tile->parser) {
+            continue;
+        }
+        GstElement *elements[] = { tile->front_end ? tile->front_end->source : NULL,
+                                   tile->front_end ? tile->front_end->depay : NULL,
+                                   tile->parser, tile->decoder, tile->conv, tile->scale, tile->filter, tile->queue };
+        chain = rct_gst_autoplug_describe(elements, G_N_ELEMENTS(elements));
+        g_string_append_printf(description, ", tile %u: %s", i, chain);
+        g_free(chain);
+    }
+    return g_string_free(description, FALSE);
+}
+
+guint rct_gst_mosaic_count_tiles(RctGstMosaic *mosaic)
+{
+    guint i, count = 0;
+
+    for (i = 0; i < mosaic->tiles->len; i++) {
+        MosaicTile *tile = (MosaicTile *)g_ptr_array_index(mosaic->tiles, i);
+        if (tile && tile->parser) {
+            count++;
+        }
+    }
+    return count;
+}
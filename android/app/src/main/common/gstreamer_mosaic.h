@@ -0,0 +1,41 @@
+//
+//  gstreamer_mosaic.h
+//
+//  Mosaic of a player: N uris decoded in its pipeline and composited
+//  into a single picture, laid out as a grid, for one sink and one
+//  surface. Every tile has its own session, decode chain and reconnect
+//  engine, so tiles are set, replaced and removed without the others
+//  noticing.
+//
+
+#ifndef gstreamer_mosaic_h
+#define gstreamer_mosaic_h
+
+#include <gst/gst.h>
+
+typedef struct _RctGstMosaic RctGstMosaic;
+
+// Builds compositor ! capsfilter into bin, the capsfilter is left for the caller to link to the sink
+RctGstMosaic *rct_gst_mosaic_new(GstBin *bin, GMainContext *context, guint columns, guint rows);
+void rct_gst_mosaic_free(RctGstMosaic *mosaic);
+GstElement *rct_gst_mosaic_get_output(RctGstMosaic *mosaic);
+
+// Tiles are numbered row by row, the ones falling outside a smaller grid are removed
+void rct_gst_mosaic_set_layout(RctGstMosaic *mosaic, guint columns, guint rows);
+void rct_gst_mosaic_set_output_size(RctGstMosaic *mosaic, gint width, gint height);
+
+// NULL removes the tile, a new uri only replaces the session of the tile. FALSE when index is off the grid
+// or the tile could not be built.
+gboolean rct_gst_mosaic_set_tile(RctGstMosaic *mosaic, guint index, const gchar *uri);
+
+// Arms the stall watchdogs of the tiles while the pipeline is meant to play
+void rct_gst_mosaic_set_playing(RctGstMosaic *mosaic, gboolean playing);
+
+// Bus error from object, TRUE when a tile owns it and its restart has been scheduled
+gboolean rct_gst_mosaic_failure(RctGstMosaic *mosaic, GstObject *object, const gchar *reason);
+
+// "compositor ! capsfilter" and the chain of every tile, free with g_free
+gchar *rct_gst_mosaic_describe(RctGstMosaic *mosaic);
+guint rct_gst_mosaic_count_tiles(RctGstMosaic *mosaic);
+
+#endif /* gstreamer_mosaic_h */
@@ -0,0 +1,468 @@
+#include "gstreamer_qos.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerQos"
+
+#define SAMPLE_PERIOD_MS 500
+#define STEP_UP_PERIODS 2               // Overload has to last a second before degrading
+#define FIRST_HOLD_PERIODS 6            // Calm has to last 3 s before recovering a rung...
+#define MAX_HOLD_PERIODS 120            // ...up to a minute once the ladder started bouncing
+
+// Sampling thresholds
+#define LATE_RATIO_OVERLOADED 0.1
+#define QUEUE_FILL_OVERLOADED 0.75
+#define QUEUE_FILL_CALM 0.25
+
+typedef struct {
+    GstPad *pad;
+    gulong probe_id;
+} RctGstQosProbe;
+
+struct _RctGstQosController
+{
+    GMainContext *context;
+    RctGstQosNotify notify;
+    RctGstQosResolutionFunc set_resolution_divisor;
+    gpointer user_data;
+
+    // Policy
+    RctGstQosRung max_rung;
+    volatile gint max_lateness_ms;
+
+    // Elements, player thread only
+    GstElement *pipeline, *sink, *decode_queue;
+    RctGstQosProbe sink_probe, decoder_probe;
+    gboolean can_lower_resolution;
+    GSource *sample_source;
+
+    // Ladder state, player thread only
+    guint overloaded_periods;
+    guint calm_periods;
+    guint hold_periods;
+    gint64 stepped_down_at;
+
+    // Read by the streaming threads
+    volatile gint rung;
+    volatile gint awaiting_keyframe;    // Set when leaving keyframes only, references are missing until the next one
+    volatile gint latency_ms;           // Pipeline latency, subtracted from the lateness
+
+    // Streaming threads only
+    GstSegment segment;
+    gboolean is_h264;
+    gboolean is_avc;
+    guint nal_length_size;
+
+    // Sampled counters, reset every period
+    volatile gint frames;
+    volatile gint late_frames;
+    volatile gint qos_messages;
+
+    // Guarded by lock, read from any thread
+    GMutex lock;
+    RctGstQosStatus status;
+};
+
+static void reset_counters(RctGstQosController *qos)
+{
+    g_atomic_int_set(&qos->frames, 0);
+    g_atomic_int_set(&qos->late_frames, 0);
+    g_atomic_int_set(&qos->qos_messages, 0);
+}
+
+static gint take_counter(volatile gint *counter)
+{
+    return (gint)g_atomic_int_and((volatile guint *)counter, 0);
+}
+
+/*******************
+ NON REFERENCE FRAMES
+ ******************/
+static gboolean is_slice_non_reference(guint8 header, gboolean *found)
+{
+    guint8 type = header & 0x1f;
+
+    *found = type == 1 || type == 5;
+    return *found && (header & 0x60) == 0;          // nal_ref_idc of 0: nothing is predicted from it
+}
+
+// Looks at the first slice of an access unit
+static gboolean is_non_reference(RctGstQosController *qos, GstBuffer *buffer)
+{
+    GstMapInfo map;
+    gboolean non_reference = FALSE;
+    gboolean found = FALSE;
+    gsize offset = 0;
+
+    if (!qos->is_h264 || !gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        return FALSE;
+    }
+
+    if (qos->is_avc) {
+        while (!found && offset + qos->nal_length_size < map.size) {
+            gsize length = 0;
+            guint i;
+
+            for (i = 0; i < qos->nal_length_size; i++) {
+                length = (length << 8) | map.data[offset + i];
+            }
+            offset += qos->nal_length_size;
+            if (length == 0 || offset + length > map.size) {
+                break;
+            }
+            non_reference = is_slice_non_reference(map.data[offset], &found);
+            offset += length;
+        }
+    } else {
+        while (!found && offset + 3 < map.size) {
+            if (map.data[offset] == 0 && map.data[offset + 1] == 0 && map.data[offset + 2] == 1) {
+                non_reference = is_slice_non_reference(map.data[offset + 3], &found);
+                offset += 3;
+            } else {
+                offset++;
+            }
+        }
+    }
+
+    gst_buffer_unmap(buffer, &map);
+    return non_reference;
+}
+
+static void read_decoder_caps(RctGstQosController *qos, GstCaps *caps)
+{
+    GstStructure *structure = gst_caps_get_structure(caps, 0);
+    const GValue *codec_data = gst_structure_get_value(structure, "codec_data");
+    GstMapInfo map;
+
+    qos->is_h264 = gst_structure_has_name(structure, "video/x-h264");
+    qos->is_avc = g_strcmp0(gst_structure_get_string(structure, "stream-format"), "byte-stream") != 0;
+    qos->nal_length_size = 4;
+
+    // avcC: the low bits of its fifth byte hold the NAL length size minus one
+    if (qos->is_avc && codec_data && G_VALUE_HOLDS(codec_data, GST_TYPE_BUFFER)) {
+        GstBuffer *buffer = gst_value_get_buffer(codec_data);
+        if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            if (map.size > 4) {
+                qos->nal_length_size = (map.data[4] & 0x03) + 1;
+            }
+            gst_buffer_unmap(buffer, &map);
+        }
+    }
+}
+
+/******
+ PROBES
+ *****/
+static GstPadProbeReturn cb_decoder_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstQosController *qos = (RctGstQosController *)user_data;
+    GstBuffer *buffer;
+    gint rung;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+            GstCaps *caps;
+            gst_event_parse_caps(event, &caps);
+            read_decoder_caps(qos, caps);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        g_atomic_int_set(&qos->awaiting_keyframe, FALSE);
+        return GST_PAD_PROBE_OK;
+    }
+
+    rung = g_atomic_int_get(&qos->rung);
+    if (rung >= RCT_GST_QOS_RUNG_KEYFRAMES_ONLY || g_atomic_int_get(&qos->awaiting_keyframe) ||
+        (rung >= RCT_GST_QOS_RUNG_SKIP_NON_REFERENCE && is_non_reference(qos, buffer))) {
+        g_mutex_lock(&qos->lock);
+        qos->status.frames_skipped++;
+        g_mutex_unlock(&qos->lock);
+        return GST_PAD_PROBE_DROP;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// The sink does not sync, so it never measures lateness itself: it is computed here against the pipeline clock
+static GstPadProbeReturn cb_sink_input(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstQosController *qos = (RctGstQosController *)user_data;
+    GstClockTime running_time;
+    GstClock *clock;
+    GstClockTimeDiff lateness;
+
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_SEGMENT) {
+            gst_event_copy_segment(event, &qos->segment);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    running_time = gst_segment_to_running_time(&qos->segment, GST_FORMAT_TIME,
+                                               GST_BUFFER_PTS(GST_PAD_PROBE_INFO_BUFFER(info)));
+    clock = gst_element_get_clock(qos->sink);
+    if (!GST_CLOCK_TIME_IS_VALID(running_time) || !clock) {
+        if (clock) {
+            gst_object_unref(clock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+    lateness = GST_CLOCK_DIFF(gst_element_get_base_time(qos->sink) + running_time, gst_clock_get_time(clock)) -
+               (GstClockTimeDiff)g_atomic_int_get(&qos->latency_ms) * GST_MSECOND;
+    gst_object_unref(clock);
+
+    g_atomic_int_inc(&qos->frames);
+    if (lateness <= (GstClockTimeDiff)g_atomic_int_get(&qos->max_lateness_ms) * GST_MSECOND) {
+        return GST_PAD_PROBE_OK;
+    }
+    g_atomic_int_inc(&qos->late_frames);
+    if (g_atomic_int_get(&qos->rung) >= RCT_GST_QOS_RUNG_DROP_LATE) {
+        g_mutex_lock(&qos->lock);
+        qos->status.frames_dropped_late++;
+        g_mutex_unlock(&qos->lock);
+        return GST_PAD_PROBE_DROP;
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+static void add_probe(RctGstQosProbe *probe, GstElement *element, GstPadProbeCallback callback, gpointer user_data)
+{
+    probe->pad = gst_element_get_static_pad(element, "sink");
+    probe->probe_id = gst_pad_add_probe(probe->pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                                        callback, user_data, NULL);
+}
+
+static void remove_probe(RctGstQosProbe *probe)
+{
+    if (probe->pad) {
+        gst_pad_remove_probe(probe->pad, probe->probe_id);
+        gst_object_unref(probe->pad);
+        probe->pad = NULL;
+    }
+}
+
+/******
+ LADDER
+ *****/
+static RctGstQosRung top_rung(RctGstQosController *qos)
+{
+    if (!qos->can_lower_resolution) {
+        return MIN(qos->max_rung, RCT_GST_QOS_RUNG_KEYFRAMES_ONLY);
+    }
+    return qos->max_rung;
+}
+
+static void set_rung(RctGstQosController *qos, RctGstQosRung rung)
+{
+    RctGstQosRung previous = (RctGstQosRung)g_atomic_int_get(&qos->rung);
+    RctGstQosStatus status;
+
+    if (rung == previous) {
+        return;
+    }
+
+    LOGI("QoS rung %s -> %s", rct_gst_qos_rung_get_name(previous), rct_gst_qos_rung_get_name(rung));
+    if (previous >= RCT_GST_QOS_RUNG_KEYFRAMES_ONLY && rung < RCT_GST_QOS_RUNG_KEYFRAMES_ONLY) {
+        g_atomic_int_set(&qos->awaiting_keyframe, TRUE);
+    }
+    g_atomic_int_set(&qos->rung, rung);
+    if ((previous >= RCT_GST_QOS_RUNG_LOWER_RESOLUTION) != (rung >= RCT_GST_QOS_RUNG_LOWER_RESOLUTION) &&
+        qos->set_resolution_divisor) {
+        qos->set_resolution_divisor(rung >= RCT_GST_QOS_RUNG_LOWER_RESOLUTION ? 2 : 1, qos->user_data);
+    }
+
+    g_mutex_lock(&qos->lock);
+    qos->status.previous_rung = previous;
+    qos->status.rung = rung;
+    qos->status.transitions++;
+    status = qos->status;
+    g_mutex_unlock(&qos->lock);
+
+    if (qos->notify) {
+        qos->notify(&status, qos->user_data);
+    }
+}
+
+static gdouble read_queue_fill(RctGstQosController *qos)
+{
+    guint level = 0, max = 0;
+
+    if (!qos->decode_queue) {
+        return 0;
+    }
+    g_object_get(G_OBJECT(qos->decode_queue), "current-level-buffers", &level, "max-size-buffers", &max, NULL);
+    return max > 0 ? (gdouble)level / max : 0;
+}
+
+static gboolean cb_sample(gpointer user_data)
+{
+    RctGstQosController *qos = (RctGstQosController *)user_data;
+    gint frames = take_counter(&qos->frames);
+    gint late_frames = take_counter(&qos->late_frames);
+    gint qos_messages = take_counter(&qos->qos_messages);
+    gdouble late_ratio = frames > 0 ? (gdouble)late_frames / frames : 0;
+    gdouble queue_fill = read_queue_fill(qos);
+    RctGstQosRung rung = (RctGstQosRung)g_atomic_int_get(&qos->rung);
+    gint64 now = g_get_monotonic_time();
+
+    g_atomic_int_set(&qos->latency_ms, (gint)(gst_pipeline_get_latency(GST_PIPELINE(qos->pipeline)) / GST_MSECOND));
+
+    g_mutex_lock(&qos->lock);
+    qos->status.late_ratio = late_ratio;
+    qos->status.queue_fill = queue_fill;
+    g_mutex_unlock(&qos->lock);
+
+    if (late_ratio > LATE_RATIO_OVERLOADED || queue_fill >= QUEUE_FILL_OVERLOADED || qos_messages > 0) {
+        qos->calm_periods = 0;
+        if (++qos->overloaded_periods >= STEP_UP_PERIODS && rung < top_rung(qos)) {
+            // Degrading again soon after recovering: wait longer before the next recovery
+            if (qos->stepped_down_at > 0 &&
+                now - qos->stepped_down_at < (gint64)qos->hold_periods * SAMPLE_PERIOD_MS * 2000) {
+                qos->hold_periods = MIN(qos->hold_periods * 2, MAX_HOLD_PERIODS);
+            }
+            qos->overloaded_periods = 0;
+            set_rung(qos, rung + 1);
+        }
+    } else if (late_frames == 0 && queue_fill < QUEUE_FILL_CALM) {
+        qos->overloaded_periods = 0;
+        qos->calm_periods++;
+        if (rung > RCT_GST_QOS_RUNG_NONE && qos->calm_periods >= qos->hold_periods) {
+            qos->calm_periods = 0;
+            qos->stepped_down_at = now;
+            set_rung(qos, rung - 1);
+        } else if (rung == RCT_GST_QOS_RUNG_NONE && qos->calm_periods >= MAX_HOLD_PERIODS) {
+            qos->hold_periods = FIRST_HOLD_PERIODS;
+        }
+    } else {
+        qos->overloaded_periods = 0;
+        qos->calm_periods = 0;
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static void stop_sampling(RctGstQosController *qos)
+{
+    if (qos->sample_source) {
+        g_source_destroy(qos->sample_source);
+        g_source_unref(qos->sample_source);
+        qos->sample_source = NULL;
+    }
+}
+
+static void start_sampling(RctGstQosController *qos)
+{
+    stop_sampling(qos);
+    if (qos->max_rung == RCT_GST_QOS_RUNG_NONE || !qos->pipeline) {
+        return;
+    }
+    reset_counters(qos);
+    qos->overloaded_periods = qos->calm_periods = 0;
+    qos->sample_source = g_timeout_source_new(SAMPLE_PERIOD_MS);
+    g_source_set_callback(qos->sample_source, cb_sample, qos, NULL);
+    g_source_attach(qos->sample_source, qos->context);
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstQosController *rct_gst_qos_new(GMainContext *context, RctGstQosNotify notify,
+                                     RctGstQosResolutionFunc set_resolution_divisor, gpointer user_data)
+{
+    RctGstQosController *qos = g_new0(RctGstQosController, 1);
+    qos->context = context;
+    qos->notify = notify;
+    qos->set_resolution_divisor = set_resolution_divisor;
+    qos->user_data = user_data;
+    qos->hold_periods = FIRST_HOLD_PERIODS;
+    g_mutex_init(&qos->lock);
+    gst_segment_init(&qos->segment, GST_FORMAT_TIME);
+    rct_gst_qos_configure(qos, RCT_GST_QOS_RUNG_LOWER_RESOLUTION, 100);
+    return qos;
+}
+
+void rct_gst_qos_free(RctGstQosController *qos)
+{
+    if (!qos) {
+        return;
+    }
+    rct_gst_qos_detach(qos);
+    g_mutex_clear(&qos->lock);
+    g_free(qos);
+}
+
+void rct_gst_qos_configure(RctGstQosController *qos, RctGstQosRung max_rung, guint max_lateness_ms)
+{
+    qos->max_rung = MIN(max_rung, RCT_GST_QOS_RUNG_COUNT - 1);
+    g_atomic_int_set(&qos->max_lateness_ms, (gint)max_lateness_ms);
+    if ((RctGstQosRung)g_atomic_int_get(&qos->rung) > top_rung(qos)) {
+        set_rung(qos, top_rung(qos));
+    }
+    if (qos->pipeline) {
+        start_sampling(qos);
+    }
+}
+
+void rct_gst_qos_attach(RctGstQosController *qos, GstElement *pipeline, GstElement *decoder, GstElement *sink,
+                        GstElement *decode_queue, gboolean can_lower_resolution)
+{
+    rct_gst_qos_detach(qos);
+
+    qos->pipeline = pipeline;
+    qos->sink = sink;
+    qos->decode_queue = decode_queue;
+    qos->can_lower_resolution = can_lower_resolution;
+    qos->hold_periods = FIRST_HOLD_PERIODS;
+    qos->stepped_down_at = 0;
+    gst_segment_init(&qos->segment, GST_FORMAT_TIME);
+    add_probe(&qos->decoder_probe, decoder, cb_decoder_input, qos);
+    add_probe(&qos->sink_probe, sink, cb_sink_input, qos);
+    start_sampling(qos);
+}
+
+// Back on the first rung, the pipeline is being torn down so resolution is left alone
+void rct_gst_qos_detach(RctGstQosController *qos)
+{
+    if (!qos->pipeline) {
+        return;
+    }
+    stop_sampling(qos);
+    remove_probe(&qos->decoder_probe);
+    remove_probe(&qos->sink_probe);
+    g_atomic_int_set(&qos->rung, RCT_GST_QOS_RUNG_NONE);
+    g_atomic_int_set(&qos->awaiting_keyframe, FALSE);
+    qos->pipeline = qos->sink = qos->decode_queue = NULL;
+
+    g_mutex_lock(&qos->lock);
+    qos->status.rung = qos->status.previous_rung = RCT_GST_QOS_RUNG_NONE;
+    g_mutex_unlock(&qos->lock);
+}
+
+void rct_gst_qos_on_message(RctGstQosController *qos, GstMessage *message)
+{
+    if (qos->pipeline) {
+        g_atomic_int_inc(&qos->qos_messages);
+    }
+}
+
+void rct_gst_qos_get_status(RctGstQosController *qos, RctGstQosStatus *status)
+{
+    g_mutex_lock(&qos->lock);
+    *status = qos->status;
+    g_mutex_unlock(&qos->lock);
+}
+
+const gchar *rct_gst_qos_rung_get_name(RctGstQosRung rung)
+{
+    switch (rung) {
+        case RCT_GST_QOS_RUNG_NONE: return "none";
+        case RCT_GST_QOS_RUNG_DROP_LATE: return "drop_late";
+        case RCT_GST_QOS_RUNG_SKIP_NON_REFERENCE: return "skip_non_reference";
+        case RCT_GST_QOS_RUNG_KEYFRAMES_ONLY: return "keyframes_only";
+        case RCT_GST_QOS_RUNG_LOWER_RESOLUTION: return "lower_resolution";
+        case RCT_GST_QOS_RUNG_COUNT: break;
+    }
+    return "unknown";
+}
@@ -0,0 +1,59 @@
+//
+//  gstreamer_qos.h
+//
+//  Overload controller of a player. Frame lateness at the sink, the decode
+//  queue fill level and QoS messages are sampled periodically; sustained
+//  overload climbs a degradation ladder one rung at a time, sustained calm
+//  climbs back down. The wait before stepping down doubles every time a
+//  step down has to be undone shortly after, so the ladder does not bounce.
+//
+
+#ifndef gstreamer_qos_h
+#define gstreamer_qos_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_QOS_RUNG_NONE,
+    RCT_GST_QOS_RUNG_DROP_LATE,         // Frames later than the max lateness are not rendered
+    RCT_GST_QOS_RUNG_SKIP_NON_REFERENCE,// Non reference access units are not decoded (H.264 only)
+    RCT_GST_QOS_RUNG_KEYFRAMES_ONLY,    // Only keyframes are decoded
+    RCT_GST_QOS_RUNG_LOWER_RESOLUTION,  // Frames are scaled down to half the surface size (software decoders only)
+    RCT_GST_QOS_RUNG_COUNT
+} RctGstQosRung;
+
+typedef struct {
+    RctGstQosRung rung;
+    RctGstQosRung previous_rung;
+    guint transitions;
+    gdouble late_ratio;                 // Part of the frames later than the max lateness, last period
+    gdouble queue_fill;                 // Decode queue fill level, last period, 0 without queue
+    guint64 frames_dropped_late;
+    guint64 frames_skipped;             // Access units never decoded
+} RctGstQosStatus;
+
+typedef struct _RctGstQosController RctGstQosController;
+
+// Both called on the context thread
+typedef void (*RctGstQosNotify)(const RctGstQosStatus *status, gpointer user_data);
+typedef void (*RctGstQosResolutionFunc)(gint divisor, gpointer user_data);
+
+RctGstQosController *rct_gst_qos_new(GMainContext *context, RctGstQosNotify notify,
+                                     RctGstQosResolutionFunc set_resolution_divisor, gpointer user_data);
+void rct_gst_qos_free(RctGstQosController *qos);
+
+// max_rung 0 disables the controller
+void rct_gst_qos_configure(RctGstQosController *qos, RctGstQosRung max_rung, guint max_lateness_ms);
+
+// Installs the probes and starts sampling. decode_queue may be NULL.
+void rct_gst_qos_attach(RctGstQosController *qos, GstElement *pipeline, GstElement *decoder, GstElement *sink,
+                        GstElement *decode_queue, gboolean can_lower_resolution);
+void rct_gst_qos_detach(RctGstQosController *qos);
+
+void rct_gst_qos_on_message(RctGstQosController *qos, GstMessage *message);
+
+// Any thread
+void rct_gst_qos_get_status(RctGstQosController *qos, RctGstQosStatus *status);
+const gchar *rct_gst_qos_rung_get_name(RctGstQosRung rung);
+
+#endif /* gstreamer_qos_h */
@@ -0,0 +1,297 @@
+#include "gstreamer_reconnect.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerReconnect"
+
+struct _RctGstReconnect
+{
+    GMainContext *context;
+    RctGstRestartFunc restart;
+    RctGstReconnectNotify notify;
+    gpointer user_data;
+
+    // Policy
+    guint initial_delay_ms;
+    guint max_delay_ms;
+    gdouble jitter;
+    guint stall_timeout_ms;
+
+    // State, player thread only
+    GSource *retry_source;
+    RctGstRestartKind retry_kind;
+    GSource *watchdog_source;
+    gboolean armed;
+    gint last_buffer_count;
+    gint64 last_progress_at;
+    gint64 degraded_since;
+
+    // Written by streaming threads
+    volatile gint buffer_count;
+
+    // Guarded by lock, read from any thread
+    GMutex lock;
+    RctGstReconnectStats stats;
+};
+
+static void notify_stats(RctGstReconnect *reconnect)
+{
+    RctGstReconnectStats stats;
+
+    if (!reconnect->notify) {
+        return;
+    }
+    rct_gst_reconnect_get_stats(reconnect, &stats);
+    reconnect->notify(&stats, reconnect->user_data);
+}
+
+static void leave_degraded(RctGstReconnect *reconnect)
+{
+    gint64 now = g_get_monotonic_time();
+
+    g_mutex_lock(&reconnect->lock);
+    reconnect->stats.degraded = FALSE;
+    reconnect->stats.degraded_us += now - reconnect->degraded_since;
+    reconnect->stats.consecutive_failures = 0;
+    reconnect->stats.recoveries++;
+    g_mutex_unlock(&reconnect->lock);
+
+    LOGI("Recovered after %lld ms", (long long)(now - reconnect->degraded_since) / 1000);
+    notify_stats(reconnect);
+}
+
+// Doubles on every consecutive failure, capped, then scaled by a random factor so players don't reconnect in lockstep
+static guint next_delay_ms(RctGstReconnect *reconnect, guint failures)
+{
+    gdouble delay = reconnect->initial_delay_ms;
+    guint i;
+
+    for (i = 1; i < failures && delay < reconnect->max_delay_ms; i++) {
+        delay *= 2;
+    }
+    delay = MIN(delay, (gdouble)reconnect->max_delay_ms);
+    if (reconnect->jitter > 0) {
+        delay *= g_random_double_range(1.0 - reconnect->jitter, 1.0 + reconnect->jitter);
+    }
+    return (guint)MAX(delay, 0);
+}
+
+static gboolean cb_retry(gpointer user_data)
+{
+    RctGstReconnect *reconnect = (RctGstReconnect *)user_data;
+
+    g_source_unref(reconnect->retry_source);
+    reconnect->retry_source = NULL;
+
+    g_mutex_lock(&reconnect->lock);
+    reconnect->stats.attempts++;
+    reconnect->stats.next_attempt_in_us = 0;
+    g_mutex_unlock(&reconnect->lock);
+
+    LOGD("Restarting %s", reconnect->retry_kind == RCT_GST_RESTART_SOURCE ? "source" : "pipeline");
+    // The new session gets a full stall timeout before being judged
+    reconnect->last_progress_at = g_get_monotonic_time();
+    reconnect->restart(reconnect->retry_kind, reconnect->user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean schedule_restart(RctGstReconnect *reconnect, RctGstRestartKind kind, const gchar *reason);
+
+static gboolean cb_watchdog(gpointer user_data)
+{
+    RctGstReconnect *reconnect = (RctGstReconnect *)user_data;
+    gint count = g_atomic_int_get(&reconnect->buffer_count);
+    gint64 now = g_get_monotonic_time();
+
+    if (count != reconnect->last_buffer_count) {
+        reconnect->last_buffer_count = count;
+        reconnect->last_progress_at = now;
+        if (reconnect->stats.degraded && !reconnect->retry_source) {
+            leave_degraded(reconnect);
+        }
+        return G_SOURCE_CONTINUE;
+    }
+
+    if (reconnect->retry_source) {
+        reconnect->last_progress_at = now;
+        return G_SOURCE_CONTINUE;
+    }
+
+    if (reconnect->stall_timeout_ms > 0 &&
+        now - reconnect->last_progress_at > (gint64)reconnect->stall_timeout_ms * 1000) {
+        g_mutex_lock(&reconnect->lock);
+        reconnect->stats.stalls++;
+        g_mutex_unlock(&reconnect->lock);
+        schedule_restart(reconnect, RCT_GST_RESTART_SOURCE, "no buffers");
+    }
+    return G_SOURCE_CONTINUE;
+}
+
+static GstPadProbeReturn cb_count_buffer(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstReconnect *reconnect = (RctGstReconnect *)user_data;
+    g_atomic_int_inc(&reconnect->buffer_count);
+    return GST_PAD_PROBE_OK;
+}
+
+static void stop_watchdog(RctGstReconnect *reconnect)
+{
+    if (reconnect->watchdog_source) {
+        g_source_destroy(reconnect->watchdog_source);
+        g_source_unref(reconnect->watchdog_source);
+        reconnect->watchdog_source = NULL;
+    }
+}
+
+// Only runs while armed, an idle player never wakes up for it.
+// Without a stall timeout it still ticks to notice recoveries.
+static void start_watchdog(RctGstReconnect *reconnect)
+{
+    guint interval_ms = reconnect->stall_timeout_ms > 0 ? MAX(reconnect->stall_timeout_ms / 4, 50) : 500;
+
+    stop_watchdog(reconnect);
+
+    // A quarter of the timeout keeps detection within 125% of it
+    reconnect->last_buffer_count = g_atomic_int_get(&reconnect->buffer_count);
+    reconnect->last_progress_at = g_get_monotonic_time();
+    reconnect->watchdog_source = g_timeout_source_new(interval_ms);
+    g_source_set_callback(reconnect->watchdog_source, cb_watchdog, reconnect, NULL);
+    g_source_attach(reconnect->watchdog_source, reconnect->context);
+}
+
+static void cancel_retry(RctGstReconnect *reconnect)
+{
+    if (reconnect->retry_source) {
+        g_source_destroy(reconnect->retry_source);
+        g_source_unref(reconnect->retry_source);
+        reconnect->retry_source = NULL;
+    }
+}
+
+// Returns FALSE when a restart was already pending
+static gboolean schedule_restart(RctGstReconnect *reconnect, RctGstRestartKind kind, const gchar *reason)
+{
+    guint failures;
+    guint delay_ms;
+
+    g_mutex_lock(&reconnect->lock);
+    if (!reconnect->stats.degraded) {
+        reconnect->stats.degraded = TRUE;
+        reconnect->degraded_since = g_get_monotonic_time();
+    }
+    g_mutex_unlock(&reconnect->lock);
+
+    if (reconnect->retry_source) {
+        // A pipeline restart covers a source one, never the other way around
+        if (kind == RCT_GST_RESTART_PIPELINE) {
+            reconnect->retry_kind = kind;
+        }
+        return FALSE;
+    }
+
+    g_mutex_lock(&reconnect->lock);
+    failures = ++reconnect->stats.consecutive_failures;
+    delay_ms = next_delay_ms(reconnect, failures);
+    reconnect->stats.next_attempt_in_us = (gint64)delay_ms * 1000;
+    g_mutex_unlock(&reconnect->lock);
+
+    LOGI("Failure #%u (%s), restarting in %u ms", failures, reason, delay_ms);
+    reconnect->retry_kind = kind;
+    reconnect->retry_source = g_timeout_source_new(delay_ms);
+    g_source_set_callback(reconnect->retry_source, cb_retry, reconnect, NULL);
+    g_source_attach(reconnect->retry_source, reconnect->context);
+
+    notify_stats(reconnect);
+    return TRUE;
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstReconnect *rct_gst_reconnect_new(GMainContext *context, RctGstRestartFunc restart,
+                                       RctGstReconnectNotify notify, gpointer user_data)
+{
+    RctGstReconnect *reconnect = g_new0(RctGstReconnect, 1);
+    reconnect->context = context;
+    reconnect->restart = restart;
+    reconnect->notify = notify;
+    reconnect->user_data = user_data;
+    g_mutex_init(&reconnect->lock);
+    rct_gst_reconnect_configure(reconnect, 500, 30000, 0.2, 10000);
+    return reconnect;
+}
+
+void rct_gst_reconnect_free(RctGstReconnect *reconnect)
+{
+    if (!reconnect) {
+        return;
+    }
+    cancel_retry(reconnect);
+    stop_watchdog(reconnect);
+    g_mutex_clear(&reconnect->lock);
+    g_free(reconnect);
+}
+
+void rct_gst_reconnect_configure(RctGstReconnect *reconnect, guint initial_delay_ms, guint max_delay_ms,
+                                 gdouble jitter, guint stall_timeout_ms)
+{
+    reconnect->initial_delay_ms = MAX(initial_delay_ms, 1);
+    reconnect->max_delay_ms = MAX(max_delay_ms, reconnect->initial_delay_ms);
+    reconnect->jitter = CLAMP(jitter, 0.0, 1.0);
+    reconnect->stall_timeout_ms = stall_timeout_ms;
+    if (reconnect->armed) {
+        start_watchdog(reconnect);
+    }
+}
+
+// Bus error or EOS
+gboolean rct_gst_reconnect_failure(RctGstReconnect *reconnect, RctGstRestartKind kind, const gchar *reason)
+{
+    g_mutex_lock(&reconnect->lock);
+    reconnect->stats.errors++;
+    g_mutex_unlock(&reconnect->lock);
+    return schedule_restart(reconnect, kind, reason);
+}
+
+void rct_gst_reconnect_set_armed(RctGstReconnect *reconnect, gboolean armed)
+{
+    if (armed == reconnect->armed) {
+        return;
+    }
+    reconnect->armed = armed;
+    if (armed) {
+        start_watchdog(reconnect);
+    } else {
+        stop_watchdog(reconnect);
+    }
+}
+
+// Drops the pending restart and closes the degraded episode without counting a recovery
+void rct_gst_reconnect_cancel(RctGstReconnect *reconnect)
+{
+    cancel_retry(reconnect);
+    rct_gst_reconnect_set_armed(reconnect, FALSE);
+
+    g_mutex_lock(&reconnect->lock);
+    if (reconnect->stats.degraded) {
+        reconnect->stats.degraded = FALSE;
+        reconnect->stats.degraded_us += g_get_monotonic_time() - reconnect->degraded_since;
+    }
+    reconnect->stats.consecutive_failures = 0;
+    reconnect->stats.next_attempt_in_us = 0;
+    g_mutex_unlock(&reconnect->lock);
+}
+
+void rct_gst_reconnect_watch_pad(RctGstReconnect *reconnect, GstPad *pad)
+{
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_count_buffer, reconnect, NULL);
+}
+
+void rct_gst_reconnect_get_stats(RctGstReconnect *reconnect, RctGstReconnectStats *stats)
+{
+    g_mutex_lock(&reconnect->lock);
+    *stats = reconnect->stats;
+    if (stats->degraded) {
+        stats->degraded_us += g_get_monotonic_time() - reconnect->degraded_since;
+    }
+    g_mutex_unlock(&reconnect->lock);
+}
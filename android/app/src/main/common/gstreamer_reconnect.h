@@ -0,0 +1,56 @@
+//
+//  gstreamer_reconnect.h
+//
+//  Reconnect state machine of a player. Failures (bus errors, EOS, stalls
+//  detected by the watchdog) schedule a restart on the player context with
+//  exponential backoff and jitter instead of restarting inline.
+//
+
+#ifndef gstreamer_reconnect_h
+#define gstreamer_reconnect_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_RESTART_SOURCE,             // Only the source front end is rebuilt
+    RCT_GST_RESTART_PIPELINE            // Whole pipeline goes through NULL
+} RctGstRestartKind;
+
+// Counters, all times in µs
+typedef struct {
+    guint errors;                       // Bus errors and EOS
+    guint stalls;                       // Watchdog timeouts
+    guint attempts;                     // Restarts performed
+    guint recoveries;                   // Degraded episodes that ended with buffers flowing again
+    guint consecutive_failures;         // Failures since buffers last flowed
+    gboolean degraded;
+    gint64 degraded_us;                 // Total time spent degraded, current episode included
+    gint64 next_attempt_in_us;          // Delay of the pending restart, 0 when none
+} RctGstReconnectStats;
+
+typedef void (*RctGstRestartFunc)(RctGstRestartKind kind, gpointer user_data);
+typedef void (*RctGstReconnectNotify)(const RctGstReconnectStats *stats, gpointer user_data);
+
+typedef struct _RctGstReconnect RctGstReconnect;
+
+RctGstReconnect *rct_gst_reconnect_new(GMainContext *context, RctGstRestartFunc restart,
+                                       RctGstReconnectNotify notify, gpointer user_data);
+void rct_gst_reconnect_free(RctGstReconnect *reconnect);
+
+// Backoff grows from initial_delay_ms to max_delay_ms, each delay is scaled by 1 ± jitter.
+// stall_timeout_ms is how long PLAYING may go without buffers, 0 disables the watchdog.
+void rct_gst_reconnect_configure(RctGstReconnect *reconnect, guint initial_delay_ms, guint max_delay_ms,
+                                 gdouble jitter, guint stall_timeout_ms);
+
+// Player thread only
+gboolean rct_gst_reconnect_failure(RctGstReconnect *reconnect, RctGstRestartKind kind, const gchar *reason);
+void rct_gst_reconnect_set_armed(RctGstReconnect *reconnect, gboolean armed);   // Watchdog runs while armed
+void rct_gst_reconnect_cancel(RctGstReconnect *reconnect);
+
+// Counts buffers going through pad, this is what the watchdog looks at
+void rct_gst_reconnect_watch_pad(RctGstReconnect *reconnect, GstPad *pad);
+
+// Any thread
+void rct_gst_reconnect_get_stats(RctGstReconnect *reconnect, RctGstReconnectStats *stats);
+
+#endif /* gstreamer_reconnect_h */
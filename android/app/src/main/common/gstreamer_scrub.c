@@ -0,0 +1,391 @@
+#include "gstreamer_scrub.h"
+#include "gstreamer_log.h"
+#include <gst/video/video.h>
+#include "gstreamer_autoplug.h"
+
+#define LOG_TAG "GStreamerScrub"
+
+// Longest blocking wait of the thread, which also bounds how long freeing the cache takes
+#define FRAME_TIMEOUT (500 * GST_MSECOND)
+
+// Waits of FRAME_TIMEOUT the uri gets to open and preroll
+#define PREROLL_ATTEMPTS 20
+
+// A lookup whose nearest thumbnail is further away asks for a closer one
+#define REFINE_DISTANCE_US (2 * G_USEC_PER_SEC)
+
+// Visits in a row snapping to keyframes already cached before the fill is considered complete
+#define MAX_MISSES 16
+
+// decodebin autoplug-select results, the enum is not part of the public headers
+#define AUTOPLUG_SELECT_TRY 0
+#define AUTOPLUG_SELECT_SKIP 2
+
+struct _RctGstScrubCache
+{
+    gchar *uri;
+    gint width;
+    gsize max_bytes;
+    GThread *thread;
+
+    GMutex lock;
+    GCond cond;
+    gboolean stopping;
+    GArray *thumbnails;                 // RctGstScrubThumbnail, sorted by position
+    gsize bytes;
+    gint64 requested_us;                // Position to decode next, -1 for none
+};
+
+static void thumbnail_clear(gpointer data)
+{
+    RctGstScrubThumbnail *thumbnail = (RctGstScrubThumbnail *)data;
+
+    gst_buffer_unref(thumbnail->pixels);
+}
+
+static gboolean is_stopping(RctGstScrubCache *cache)
+{
+    gboolean stopping;
+
+    g_mutex_lock(&cache->lock);
+    stopping = cache->stopping;
+    g_mutex_unlock(&cache->lock);
+    return stopping;
+}
+
+// 1/2, 1/4, 3/4, 1/8, 5/8... every pass halves the gaps left by the previous ones
+static gdouble coarse_to_fine(guint visit)
+{
+    gdouble fraction = 0, step = 0.5;
+
+    for (; visit; visit >>= 1, step /= 2) {
+        if (visit & 1) {
+            fraction += step;
+        }
+    }
+    return fraction;
+}
+
+/*****
+ STORE
+ ****/
+// With lock held, index of the first thumbnail at or after position_us
+static guint find_index(RctGstScrubCache *cache, gint64 position_us)
+{
+    guint low = 0, high = cache->thumbnails->len;
+
+    while (low < high) {
+        guint middle = (low + high) / 2;
+        if (g_array_index(cache->thumbnails, RctGstScrubThumbnail, middle).position_us < position_us) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// With lock held, neighbour of index closest to it, the densest part of the timeline gives up a thumbnail
+static void evict_near(RctGstScrubCache *cache, guint index)
+{
+    GArray *thumbnails = cache->thumbnails;
+    gint64 position_us = g_array_index(thumbnails, RctGstScrubThumbnail, index).position_us;
+    guint victim;
+
+    if (index == 0) {
+        victim = 1;
+    } else if (index + 1 == thumbnails->len) {
+        victim = index - 1;
+    } else {
+        gint64 before = position_us - g_array_index(thumbnails, RctGstScrubThumbnail, index - 1).position_us;
+        gint64 after = g_array_index(thumbnails, RctGstScrubThumbnail, index + 1).position_us - position_us;
+        victim = before <= after ? index - 1 : index + 1;
+    }
+    cache->bytes -= gst_buffer_get_size(g_array_index(thumbnails, RctGstScrubThumbnail, victim).pixels);
+    g_array_remove_index(thumbnails, victim);
+}
+
+// Takes pixels, FALSE when the keyframe was already cached
+static gboolean store(RctGstScrubCache *cache, RctGstScrubThumbnail *thumbnail)
+{
+    guint index;
+
+    g_mutex_lock(&cache->lock);
+    index = find_index(cache, thumbnail->position_us);
+    if (index < cache->thumbnails->len &&
+        g_array_index(cache->thumbnails, RctGstScrubThumbnail, index).position_us == thumbnail->position_us) {
+        g_mutex_unlock(&cache->lock);
+        gst_buffer_unref(thumbnail->pixels);
+        return FALSE;
+    }
+    g_array_insert_val(cache->thumbnails, index, *thumbnail);
+    cache->bytes += gst_buffer_get_size(thumbnail->pixels);
+    while (cache->bytes > cache->max_bytes && cache->thumbnails->len > 1) {
+        evict_near(cache, index);
+        index = find_index(cache, thumbnail->position_us);
+    }
+    g_mutex_unlock(&cache->lock);
+    return TRUE;
+}
+
+/*****
+ DECODING
+ ****/
+// Hardware decoders are left to the player, the cache must not take one from it
+static gint cb_autoplug_select(GstElement *bin, GstPad *pad, GstCaps *caps, GstElementFactory *factory,
+                               gpointer user_data)
+{
+    return rct_gst_autoplug_factory_is_hardware(factory) ? AUTOPLUG_SELECT_SKIP : AUTOPLUG_SELECT_TRY;
+}
+
+// Quarter resolution is plenty for a thumbnail, and one thread keeps it off the player's cores
+static void cb_element_added(GstBin *bin, GstBin *sub_bin, GstElement *element, gpointer user_data)
+{
+    rct_gst_autoplug_set_int(element, "lowres", 2);
+    rct_gst_autoplug_set_int(element, "max-threads", 1);
+}
+
+static void cb_pad_added(GstElement *decodebin, GstPad *pad, gpointer user_data)
+{
+    GstElement *convert = (GstElement *)user_data;
+    GstPad *sink_pad = gst_element_get_static_pad(convert, "sink");
+
+    if (!gst_pad_is_linked(sink_pad) && GST_PAD_LINK_FAILED(gst_pad_link(pad, sink_pad))) {
+        LOGE("Video pad '%s' could not be linked", GST_PAD_NAME(pad));
+    }
+    gst_object_unref(sink_pad);
+}
+
+// uridecodebin ! videoconvert ! videoscale ! RGBA at width ! appsink
+static GstElement *build_pipeline(RctGstScrubCache *cache, GstElement **sink)
+{
+    GstElement *pipeline = gst_pipeline_new("scrub");
+    GstElement *decodebin = gst_element_factory_make("uridecodebin", NULL);
+    GstElement *convert = gst_element_factory_make("videoconvert", NULL);
+    GstElement *scale = gst_element_factory_make("videoscale", NULL);
+    GstElement *filter = gst_element_factory_make("capsfilter", NULL);
+    GstCaps *caps;
+
+    *sink = gst_element_factory_make("appsink", NULL);
+    if (!pipeline || !decodebin || !convert || !scale || !filter || !*sink) {
+        LOGE("Failed to create elements");
+        if (pipeline) {
+            gst_object_unref(pipeline);
+        }
+        if (decodebin) {
+            gst_object_unref(decodebin);
+        }
+        if (convert) {
+            gst_object_unref(convert);
+        }
+        if (scale) {
+            gst_object_unref(scale);
+        }
+        if (filter) {
+            gst_object_unref(filter);
+        }
+        if (*sink) {
+            gst_object_unref(*sink);
+        }
+        return NULL;
+    }
+
+    // Only the video stream is exposed, audio is never decoded
+    caps = gst_caps_new_empty_simple("video/x-raw");
+    g_object_set(G_OBJECT(decodebin), "uri", cache->uri, "caps", caps, "expose-all-streams", FALSE, NULL);
+    gst_caps_unref(caps);
+    caps = gst_caps_new_simple("video/x-raw",
+                               "format", G_TYPE_STRING, "RGBA",
+                               "width", G_TYPE_INT, cache->width,
+                               "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                               NULL);
+    g_object_set(G_OBJECT(filter), "caps", caps, NULL);
+    gst_caps_unref(caps);
+    g_object_set(G_OBJECT(*sink), "sync", FALSE, "max-buffers", 1, "drop", TRUE, "enable-last-sample", FALSE, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), decodebin, convert, scale, filter, *sink, NULL);
+    if (!gst_element_link_many(convert, scale, filter, *sink, NULL)) {
+        LOGE("Elements could not be linked");
+        gst_object_unref(pipeline);
+        return NULL;
+    }
+    g_signal_connect(decodebin, "pad-added", G_CALLBACK(cb_pad_added), convert);
+    g_signal_connect(decodebin, "autoplug-select", G_CALLBACK(cb_autoplug_select), NULL);
+    g_signal_connect(pipeline, "deep-element-added", G_CALLBACK(cb_element_added), NULL);
+    return pipeline;
+}
+
+// Waits in short steps, so a stop is noticed while the uri is still opening
+static gboolean preroll(RctGstScrubCache *cache, GstElement *pipeline)
+{
+    GstStateChangeReturn ret = gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    guint i;
+
+    for (i = 0; ret == GST_STATE_CHANGE_ASYNC && i < PREROLL_ATTEMPTS && !is_stopping(cache); i++) {
+        ret = gst_element_get_state(pipeline, NULL, NULL, FRAME_TIMEOUT);
+    }
+    return ret == GST_STATE_CHANGE_SUCCESS;
+}
+
+// Keyframe at or before position_us, FALSE when it could not be decoded or was already cached
+static gboolean decode_at(RctGstScrubCache *cache, GstElement *pipeline, GstElement *sink, gint64 position_us)
+{
+    RctGstScrubThumbnail thumbnail;
+    GstSample *sample = NULL;
+    GstBuffer *buffer;
+    GstVideoInfo info;
+    const GstSegment *segment;
+
+    if (!gst_element_seek_simple(pipeline, GST_FORMAT_TIME,
+                                 GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT | GST_SEEK_FLAG_SNAP_BEFORE,
+                                 position_us * GST_USECOND)) {
+        return FALSE;
+    }
+    g_signal_emit_by_name(sink, "try-pull-preroll", (GstClockTime)FRAME_TIMEOUT, &sample);
+    if (!sample) {
+        return FALSE;
+    }
+
+    buffer = gst_sample_get_buffer(sample);
+    segment = gst_sample_get_segment(sample);
+    if (!buffer || !gst_video_info_from_caps(&info, gst_sample_get_caps(sample))) {
+        gst_sample_unref(sample);
+        return FALSE;
+    }
+    thumbnail.position_us = position_us;
+    if (GST_BUFFER_PTS_IS_VALID(buffer) && segment) {
+        thumbnail.position_us = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer)) / GST_USECOND;
+    }
+    thumbnail.width = GST_VIDEO_INFO_WIDTH(&info);
+    thumbnail.height = GST_VIDEO_INFO_HEIGHT(&info);
+
+    // Own copy, keeping pool buffers would starve the pipeline
+    thumbnail.pixels = gst_buffer_copy_deep(buffer);
+    gst_sample_unref(sample);
+    return store(cache, &thumbnail);
+}
+
+static gpointer fill_loop(gpointer user_data)
+{
+    RctGstScrubCache *cache = (RctGstScrubCache *)user_data;
+    GstElement *sink = NULL;
+    GstElement *pipeline = build_pipeline(cache, &sink);
+    gint64 duration = 0;
+    guint visit = 0, misses = 0;
+
+    if (!pipeline) {
+        return NULL;
+    }
+    if (!preroll(cache, pipeline) || !gst_element_query_duration(pipeline, GST_FORMAT_TIME, &duration) ||
+        duration <= 0) {
+        LOGE("%s can't be scrubbed", cache->uri);
+        goto exit;
+    }
+    LOGD("Filling scrub cache of %s, %lld ms long", cache->uri, (long long)(duration / GST_MSECOND));
+
+    for (;;) {
+        gint64 position_us;
+        gboolean on_demand;
+
+        // Once full or complete, only lookups far from any thumbnail wake the thread
+        g_mutex_lock(&cache->lock);
+        while (!cache->stopping && cache->requested_us < 0 &&
+               (cache->bytes >= cache->max_bytes || misses >= MAX_MISSES)) {
+            g_cond_wait(&cache->cond, &cache->lock);
+        }
+        if (cache->stopping) {
+            g_mutex_unlock(&cache->lock);
+            break;
+        }
+        on_demand = cache->requested_us >= 0;
+        if (on_demand) {
+            position_us = cache->requested_us;
+            cache->requested_us = -1;
+        } else {
+            position_us = (gint64)(coarse_to_fine(++visit) * duration) / GST_USECOND;
+        }
+        g_mutex_unlock(&cache->lock);
+
+        if (decode_at(cache, pipeline, sink, position_us)) {
+            misses = 0;
+        } else if (!on_demand) {
+            misses++;
+        }
+    }
+
+exit:
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return NULL;
+}
+
+/*****
+ API
+ ****/
+RctGstScrubCache *rct_gst_scrub_cache_new(const gchar *uri, gint width, gsize max_bytes)
+{
+    RctGstScrubCache *cache = g_new0(RctGstScrubCache, 1);
+
+    cache->uri = g_strdup(uri);
+    cache->width = MAX(width, 16) & ~1;                                 // Even, for the chroma planes on the way
+    cache->max_bytes = max_bytes;
+    cache->requested_us = -1;
+    cache->thumbnails = g_array_new(FALSE, FALSE, sizeof(RctGstScrubThumbnail));
+    g_array_set_clear_func(cache->thumbnails, thumbnail_clear);
+    g_mutex_init(&cache->lock);
+    g_cond_init(&cache->cond);
+    cache->thread = g_thread_new("rct-gst-scrub", fill_loop, cache);
+    return cache;
+}
+
+void rct_gst_scrub_cache_free(RctGstScrubCache *cache)
+{
+    if (!cache) {
+        return;
+    }
+
+    g_mutex_lock(&cache->lock);
+    cache->stopping = TRUE;
+    g_cond_signal(&cache->cond);
+    g_mutex_unlock(&cache->lock);
+    g_thread_join(cache->thread);
+
+    g_array_free(cache->thumbnails, TRUE);
+    g_mutex_clear(&cache->lock);
+    g_cond_clear(&cache->cond);
+    g_free(cache->uri);
+    g_free(cache);
+}
+
+const gchar *rct_gst_scrub_cache_get_uri(RctGstScrubCache *cache)
+{
+    return cache->uri;
+}
+
+gboolean rct_gst_scrub_cache_lookup(RctGstScrubCache *cache, gint64 position_us, RctGstScrubThumbnail *thumbnail)
+{
+    RctGstScrubThumbnail *nearest = NULL;
+    guint index;
+
+    g_mutex_lock(&cache->lock);
+    index = find_index(cache, position_us);
+    if (index < cache->thumbnails->len) {
+        nearest = &g_array_index(cache->thumbnails, RctGstScrubThumbnail, index);
+    }
+    if (index > 0 && (!nearest || position_us - g_array_index(cache->thumbnails, RctGstScrubThumbnail, index - 1).position_us <
+                                  nearest->position_us - position_us)) {
+        nearest = &g_array_index(cache->thumbnails, RctGstScrubThumbnail, index - 1);
+    }
+
+    // Served as is, the thread decodes a closer keyframe for the next lookups
+    if (!nearest || ABS(nearest->position_us - position_us) > REFINE_DISTANCE_US) {
+        cache->requested_us = position_us;
+        g_cond_signal(&cache->cond);
+    }
+    if (nearest) {
+        *thumbnail = *nearest;
+        thumbnail->pixels = gst_buffer_ref(nearest->pixels);
+    }
+    g_mutex_unlock(&cache->lock);
+    return nearest != NULL;
+}
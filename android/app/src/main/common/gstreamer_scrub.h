@@ -0,0 +1,36 @@
+//
+//  gstreamer_scrub.h
+//
+//  Scrub preview cache of a seekable uri. A background thread opens the uri
+//  in a pipeline of its own, decodes keyframes only, with a software decoder
+//  at reduced resolution, and keeps them as small RGBA thumbnails. Positions
+//  are visited coarse to fine, so the whole timeline is covered early, and
+//  the last position looked up is decoded next when the cache has nothing
+//  close to it. Lookups never wait for the thread.
+//
+
+#ifndef gstreamer_scrub_h
+#define gstreamer_scrub_h
+
+#include <gst/gst.h>
+
+typedef struct _RctGstScrubCache RctGstScrubCache;
+
+typedef struct {
+    gint64 position_us;                 // Of the keyframe the thumbnail was decoded from
+    gint width, height;
+    GstBuffer *pixels;                  // RGBA, width * 4 bytes per row, owned by the caller
+} RctGstScrubThumbnail;
+
+// Starts filling right away, thumbnails are width pixels wide and take max_bytes at most
+RctGstScrubCache *rct_gst_scrub_cache_new(const gchar *uri, gint width, gsize max_bytes);
+
+// Stops the thread and drops every thumbnail
+void rct_gst_scrub_cache_free(RctGstScrubCache *cache);
+
+const gchar *rct_gst_scrub_cache_get_uri(RctGstScrubCache *cache);
+
+// Nearest thumbnail to position_us, FALSE while there is none. Any thread.
+gboolean rct_gst_scrub_cache_lookup(RctGstScrubCache *cache, gint64 position_us, RctGstScrubThumbnail *thumbnail);
+
+#endif /* gstreamer_scrub_h */
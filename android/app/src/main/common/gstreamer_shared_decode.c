@@ -0,0 +1,746 @@
+#include "gstreamer_shared_decode.h"
+#include "gstreamer_log.h"
+#include <gst/video/video.h>
+#include "gstreamer_autoplug.h"
+#include "gstreamer_jitter.h"
+#include "gstreamer_reconnect.h"
+#include "gstreamer_source.h"
+
+#define LOG_TAG "GStreamerSharedDecode"
+
+// Frames waiting for a view, a slow sink must not hold the decoder (and the other views) back
+#define VIEW_QUEUE_DEPTH 2
+
+// How long a detaching view waits for the tee to go idle
+#define UNLINK_TIMEOUT_US G_USEC_PER_SEC
+
+struct _RctGstSharedDecode
+{
+    gchar *uri;
+    guint views;                        // Guarded by registry_lock
+
+    // Decode thread, every pipeline operation runs there
+    GMainContext *context;
+    GMainLoop *main_loop;
+    GThread *thread;
+
+    GstElement *pipeline, *parser, *decoder, *tee;
+    RctGstSource *front_end;
+    guint bus_watch_id;
+    RctGstReconnect *reconnect;
+    RctGstJitterController *jitter;     // Fixed minimum latency, views can't agree on anything else
+    RctGstTransportSelector *transport;
+    volatile gint first_frame_pending;  // Set while the transport attempt waits for a decoded frame
+    gint64 started_at;
+
+    // Views with a branch, guarded by lock
+    GMutex lock;
+    GCond unlinked;
+    GList *attached;
+};
+
+struct _RctGstSharedView
+{
+    RctGstSharedDecode *decode;
+    GstElement *queue, *conv, *sink;    // conv is NULL unless forced
+    GstPad *tee_pad;
+    gulong unlink_probe_id;
+    gboolean unlinked;                  // Guarded by the decode lock
+    gboolean joined;
+
+    gchar *sink_factory;
+    gboolean force_convert;
+    guintptr window;
+
+    volatile gint active;
+    volatile gint first_frame_pending;
+    gint64 activated_at;                // Monotonic µs, written before first_frame_pending is set
+
+    RctGstSharedViewFirstFrameFunc first_frame;
+    RctGstSharedViewErrorFunc error;
+    gpointer user_data;
+};
+
+// Uri to its decode, shared by every player
+static GMutex registry_lock;
+static GHashTable *registry;
+
+static gboolean start_front_end(RctGstSharedDecode *decode);
+
+/***********
+ DECODE THREAD
+ **********/
+typedef struct {
+    GSourceFunc func;
+    gpointer data;
+    GMutex lock;
+    GCond cond;
+    gboolean done;
+} DecodeCall;
+
+static gpointer decode_run_loop(gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+
+    // Bus watches created from this thread attach to the decode context
+    g_main_context_push_thread_default(decode->context);
+    g_main_loop_run(decode->main_loop);
+    g_main_context_pop_thread_default(decode->context);
+    return NULL;
+}
+
+static gboolean cb_call(gpointer user_data)
+{
+    DecodeCall *call = (DecodeCall *)user_data;
+
+    call->func(call->data);
+    g_mutex_lock(&call->lock);
+    call->done = TRUE;
+    g_cond_signal(&call->cond);
+    g_mutex_unlock(&call->lock);
+    return G_SOURCE_REMOVE;
+}
+
+// Runs func on the decode thread and waits for it. Never called from the decode thread itself.
+static void decode_call(RctGstSharedDecode *decode, GSourceFunc func, gpointer data)
+{
+    DecodeCall call = { func, data };
+    GSource *source = g_idle_source_new();
+
+    g_mutex_init(&call.lock);
+    g_cond_init(&call.cond);
+    g_source_set_priority(source, G_PRIORITY_HIGH);
+    g_source_set_callback(source, cb_call, &call, NULL);
+    g_source_attach(source, decode->context);
+    g_source_unref(source);
+
+    g_mutex_lock(&call.lock);
+    while (!call.done) {
+        g_cond_wait(&call.cond, &call.lock);
+    }
+    g_mutex_unlock(&call.lock);
+    g_mutex_clear(&call.lock);
+    g_cond_clear(&call.cond);
+}
+
+static gboolean decode_quit(gpointer user_data)
+{
+    g_main_loop_quit(((RctGstSharedDecode *)user_data)->main_loop);
+    return G_SOURCE_REMOVE;
+}
+
+/********
+ RECOVERY
+ *******/
+static gboolean is_front_end_object(RctGstSharedDecode *decode, GstObject *object)
+{
+    if (!decode->front_end) {
+        return FALSE;
+    }
+    return object == GST_OBJECT(decode->front_end->source) || object == GST_OBJECT(decode->front_end->depay) ||
+           gst_object_has_as_ancestor(object, GST_OBJECT(decode->front_end->source));
+}
+
+// From NULL, the session is opened again on the transport the selector is at
+static void reset_pipeline(RctGstSharedDecode *decode)
+{
+    LOGD("Resetting shared pipeline of %s", decode->uri);
+    gst_element_set_state(decode->pipeline, GST_STATE_NULL);
+    rct_gst_transport_apply(decode->transport, decode->uri, decode->front_end->source);
+    rct_gst_transport_attempt_started(decode->transport, decode->uri);
+    decode->started_at = g_get_monotonic_time();
+    g_atomic_int_set(&decode->first_frame_pending, TRUE);
+    rct_gst_reconnect_set_armed(decode->reconnect, TRUE);
+    gst_element_set_state(decode->pipeline, GST_STATE_PLAYING);
+}
+
+static void cb_restart(RctGstRestartKind kind, gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+    GstState current_state = GST_STATE_NULL;
+
+    if (!decode->pipeline) {
+        return;
+    }
+    gst_element_get_state(decode->pipeline, &current_state, NULL, 0);
+    if (kind == RCT_GST_RESTART_SOURCE && current_state >= GST_STATE_PAUSED && start_front_end(decode)) {
+        return;
+    }
+    reset_pipeline(decode);
+}
+
+static void cb_transport_fallback(RctGstTransport transport, gpointer user_data)
+{
+    cb_restart(RCT_GST_RESTART_SOURCE, user_data);
+}
+
+static void notify_error(RctGstSharedDecode *decode, const gchar *source, const gchar *message, const gchar *debug_info)
+{
+    GList *l;
+
+    g_mutex_lock(&decode->lock);
+    for (l = decode->attached; l; l = l->next) {
+        RctGstSharedView *view = (RctGstSharedView *)l->data;
+        if (view->error) {
+            view->error(view, source, message, debug_info, view->user_data);
+        }
+    }
+    g_mutex_unlock(&decode->lock);
+}
+
+static void cb_error(RctGstSharedDecode *decode, GstMessage *msg)
+{
+    GError *err;
+    gchar *debug_info;
+    RctGstReconnectStats stats;
+
+    gst_message_parse_error(msg, &err, &debug_info);
+    LOGE("Error received from element %s: %s", GST_OBJECT_NAME(msg->src), err->message);
+
+    // A session that never decoded a frame moves on to the next transport right away
+    if (!is_front_end_object(decode, msg->src) || !rct_gst_transport_failed(decode->transport)) {
+        // Only the first failure of a degraded episode reaches the views
+        rct_gst_reconnect_get_stats(decode->reconnect, &stats);
+        if (!stats.degraded) {
+            notify_error(decode, GST_OBJECT_NAME(msg->src), err->message, debug_info);
+        }
+        rct_gst_reconnect_failure(decode->reconnect,
+                                  is_front_end_object(decode, msg->src) ? RCT_GST_RESTART_SOURCE : RCT_GST_RESTART_PIPELINE,
+                                  err->message);
+    }
+    g_clear_error(&err);
+    g_free(debug_info);
+}
+
+static gboolean cb_bus_watch(GstBus *bus, GstMessage *message, gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+    gint64 ttff_us = 0;
+
+    switch (GST_MESSAGE_TYPE(message)) {
+        case GST_MESSAGE_ERROR:
+            cb_error(decode, message);
+            break;
+
+        case GST_MESSAGE_EOS:
+            // A live session that ended, the decoder itself is fine
+            rct_gst_reconnect_failure(decode->reconnect, RCT_GST_RESTART_SOURCE, "end of stream");
+            break;
+
+        case GST_MESSAGE_APPLICATION:
+            if (gst_structure_get_int64(gst_message_get_structure(message), "ttff", &ttff_us)) {
+                rct_gst_transport_first_frame(decode->transport, ttff_us);
+            }
+            break;
+
+        case GST_MESSAGE_LATENCY:
+            gst_bin_recalculate_latency(GST_BIN(decode->pipeline));
+            break;
+
+        default:
+            break;
+    }
+    return TRUE;
+}
+
+// Tee input: the first decoded frame of a session proves its transport
+static GstPadProbeReturn cb_decoded(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+
+    if (g_atomic_int_compare_and_exchange(&decode->first_frame_pending, TRUE, FALSE)) {
+        GstStructure *structure = gst_structure_new("rct-first-frame",
+                                                    "ttff", G_TYPE_INT64, g_get_monotonic_time() - decode->started_at,
+                                                    NULL);
+        gst_element_post_message(decode->tee, gst_message_new_application(GST_OBJECT(decode->tee), structure));
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+/*******
+ PIPELINE
+ ******/
+// Opens a new session in place of the current one, the decoder and the views keep running
+static gboolean start_front_end(RctGstSharedDecode *decode)
+{
+    RctGstSource *front_end = rct_gst_source_new(GST_BIN(decode->pipeline), decode->uri);
+
+    if (!front_end) {
+        return FALSE;
+    }
+    g_object_set(G_OBJECT(front_end->source), "buffer-size", 2097152, NULL);
+    rct_gst_transport_apply(decode->transport, decode->uri, front_end->source);
+    rct_gst_jitter_apply(decode->jitter, front_end->source);
+
+    rct_gst_source_free(decode->front_end);
+    decode->front_end = NULL;
+    if (!rct_gst_source_activate(front_end, decode->parser)) {
+        rct_gst_source_free(front_end);
+        return FALSE;
+    }
+    decode->front_end = front_end;
+
+    rct_gst_transport_attempt_started(decode->transport, decode->uri);
+    decode->started_at = g_get_monotonic_time();
+    g_atomic_int_set(&decode->first_frame_pending, TRUE);
+    rct_gst_source_start(front_end);
+    return TRUE;
+}
+
+// rtspsrc ! rtph264depay ! h264parse ! decoder ! tee, views branch off the tee
+// H.264 only: the front end of another codec posts an error
+static gboolean decode_build(gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+    GstCaps *caps = gst_caps_new_empty_simple("video/x-h264");
+    GstBus *bus;
+    GstPad *pad;
+
+    decode->pipeline = gst_pipeline_new("shared_pipeline");
+    decode->parser = gst_element_factory_make("h264parse", "parser");
+    decode->decoder = rct_gst_autoplug_make(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+                                            caps, "decoder");
+    decode->tee = gst_element_factory_make("tee", "tee");
+    gst_caps_unref(caps);
+
+    if (!decode->pipeline || !decode->parser || !decode->decoder || !decode->tee) {
+        LOGE("Failed to create shared decode elements");
+        GstElement *elements[] = { decode->pipeline, decode->parser, decode->decoder, decode->tee };
+        for (guint i = 0; i < G_N_ELEMENTS(elements); i++) {
+            if (elements[i]) {
+                gst_object_unref(elements[i]);
+            }
+        }
+        decode->pipeline = decode->parser = decode->decoder = decode->tee = NULL;
+        return G_SOURCE_REMOVE;
+    }
+
+    g_object_set(G_OBJECT(decode->parser), "disable-passthrough", TRUE, NULL);
+    rct_gst_autoplug_set_boolean(decode->decoder, "low-latency", TRUE);
+    // Views come and go, the decoder keeps running while none is linked
+    g_object_set(G_OBJECT(decode->tee), "allow-not-linked", TRUE, NULL);
+
+    gst_bin_add_many(GST_BIN(decode->pipeline), decode->parser, decode->decoder, decode->tee, NULL);
+    if (!gst_element_link_many(decode->parser, decode->decoder, decode->tee, NULL) || !start_front_end(decode)) {
+        LOGE("Shared decode of %s could not be linked", decode->uri);
+        rct_gst_source_free(decode->front_end);
+        decode->front_end = NULL;
+        gst_object_unref(decode->pipeline);
+        decode->pipeline = decode->parser = decode->decoder = decode->tee = NULL;
+        return G_SOURCE_REMOVE;
+    }
+
+    pad = gst_element_get_static_pad(decode->parser, "sink");
+    rct_gst_reconnect_watch_pad(decode->reconnect, pad);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(decode->tee, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_decoded, decode, NULL);
+    gst_object_unref(pad);
+
+    bus = gst_element_get_bus(decode->pipeline);
+    decode->bus_watch_id = gst_bus_add_watch(bus, cb_bus_watch, decode);
+    gst_object_unref(bus);
+
+    rct_gst_reconnect_set_armed(decode->reconnect, TRUE);
+    gst_element_set_state(decode->pipeline, GST_STATE_PLAYING);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean decode_teardown(gpointer user_data)
+{
+    RctGstSharedDecode *decode = (RctGstSharedDecode *)user_data;
+
+    rct_gst_reconnect_cancel(decode->reconnect);
+    rct_gst_transport_attempt_cancelled(decode->transport);
+    if (!decode->pipeline) {
+        return G_SOURCE_REMOVE;
+    }
+
+    gst_element_set_state(decode->pipeline, GST_STATE_NULL);
+    rct_gst_source_free(decode->front_end);
+    decode->front_end = NULL;
+    gst_object_unref(decode->pipeline);
+    g_source_destroy(g_main_context_find_source_by_id(decode->context, decode->bus_watch_id));
+
+    decode->pipeline = decode->parser = decode->decoder = decode->tee = NULL;
+    decode->bus_watch_id = 0;
+    return G_SOURCE_REMOVE;
+}
+
+static void decode_free(RctGstSharedDecode *decode)
+{
+    decode_call(decode, decode_teardown, decode);
+    decode_call(decode, decode_quit, decode);
+    g_thread_join(decode->thread);
+
+    rct_gst_reconnect_free(decode->reconnect);
+    rct_gst_jitter_free(decode->jitter);
+    rct_gst_transport_selector_free(decode->transport);
+    g_main_loop_unref(decode->main_loop);
+    g_main_context_unref(decode->context);
+
+    g_mutex_clear(&decode->lock);
+    g_cond_clear(&decode->unlinked);
+    g_list_free(decode->attached);
+    g_free(decode->uri);
+    g_free(decode);
+}
+
+static RctGstSharedDecode *decode_new(const gchar *uri)
+{
+    RctGstSharedDecode *decode = g_new0(RctGstSharedDecode, 1);
+
+    decode->uri = g_strdup(uri);
+    g_mutex_init(&decode->lock);
+    g_cond_init(&decode->unlinked);
+    decode->context = g_main_context_new();
+    decode->main_loop = g_main_loop_new(decode->context, FALSE);
+    decode->reconnect = rct_gst_reconnect_new(decode->context, cb_restart, NULL, decode);
+    decode->jitter = rct_gst_jitter_new();
+    decode->transport = rct_gst_transport_selector_new(decode->context, cb_transport_fallback, decode);
+    decode->thread = g_thread_new("rct-gst-shared", decode_run_loop, decode);
+
+    decode_call(decode, decode_build, decode);
+    if (!decode->pipeline) {
+        decode_free(decode);
+        return NULL;
+    }
+    LOGI("Opened shared decode of %s", uri);
+    return decode;
+}
+
+/****
+ VIEWS
+ ***/
+// Queue input: frames of an inactive view never reach its sink, which keeps the last one
+static GstPadProbeReturn cb_view_gate(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstSharedView *view = (RctGstSharedView *)user_data;
+
+    return g_atomic_int_get(&view->active) ? GST_PAD_PROBE_OK : GST_PAD_PROBE_DROP;
+}
+
+static GstPadProbeReturn cb_view_first_frame(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstSharedView *view = (RctGstSharedView *)user_data;
+
+    if (g_atomic_int_compare_and_exchange(&view->first_frame_pending, TRUE, FALSE) && view->first_frame) {
+        view->first_frame(view, g_get_monotonic_time() - view->activated_at, view->user_data);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// Tee output of the view, only unlinked between two buffers
+static GstPadProbeReturn cb_unlink(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstSharedView *view = (RctGstSharedView *)user_data;
+    GstPad *peer = gst_pad_get_peer(pad);
+
+    if (peer) {
+        gst_pad_unlink(pad, peer);
+        gst_object_unref(peer);
+    }
+    g_mutex_lock(&view->decode->lock);
+    view->unlinked = TRUE;
+    g_cond_broadcast(&view->decode->unlinked);
+    g_mutex_unlock(&view->decode->lock);
+    return GST_PAD_PROBE_REMOVE;
+}
+
+// Also cleans up after a branch that was only partly built
+static gboolean view_detach(gpointer user_data)
+{
+    RctGstSharedView *view = (RctGstSharedView *)user_data;
+    RctGstSharedDecode *decode = view->decode;
+    GstElement *elements[] = { view->queue, view->conv, view->sink };
+    gint64 deadline = g_get_monotonic_time() + UNLINK_TIMEOUT_US;
+    gboolean unlinked;
+    guint i;
+
+    g_mutex_lock(&decode->lock);
+    decode->attached = g_list_remove(decode->attached, view);
+    g_mutex_unlock(&decode->lock);
+
+    if (view->tee_pad) {
+        view->unlink_probe_id = gst_pad_add_probe(view->tee_pad, GST_PAD_PROBE_TYPE_IDLE, cb_unlink, view, NULL);
+        g_mutex_lock(&decode->lock);
+        while (!view->unlinked && g_cond_wait_until(&decode->unlinked, &decode->lock, deadline)) {
+        }
+        unlinked = view->unlinked;
+        g_mutex_unlock(&decode->lock);
+        if (!unlinked) {
+            LOGE("Tee never went idle, unlinking view %p anyway", view);
+            gst_pad_remove_probe(view->tee_pad, view->unlink_probe_id);
+            cb_unlink(view->tee_pad, NULL, view);
+        }
+        gst_element_release_request_pad(decode->tee, view->tee_pad);
+        gst_object_unref(view->tee_pad);
+        view->tee_pad = NULL;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(elements); i++) {
+        if (!elements[i]) {
+            continue;
+        }
+        gst_element_set_state(elements[i], GST_STATE_NULL);
+        if (GST_OBJECT_PARENT(elements[i])) {
+            gst_bin_remove(GST_BIN(decode->pipeline), elements[i]);
+        } else {
+            gst_object_unref(elements[i]);
+        }
+    }
+    view->queue = view->conv = view->sink = NULL;
+    return G_SOURCE_REMOVE;
+}
+
+// queue ! [videoconvert !] sink, linked to a new tee output once running
+static gboolean view_attach(gpointer user_data)
+{
+    RctGstSharedView *view = (RctGstSharedView *)user_data;
+    RctGstSharedDecode *decode = view->decode;
+    GstPad *pad;
+    gboolean linked;
+
+    view->queue = gst_element_factory_make("queue", NULL);
+    view->sink = gst_element_factory_make(view->sink_factory ? view->sink_factory : "glimagesink", NULL);
+    if (view->force_convert) {
+        view->conv = gst_element_factory_make("videoconvert", NULL);
+    }
+    if (!view->queue || !view->sink || (view->force_convert && !view->conv)) {
+        LOGE("Failed to create view elements");
+        view_detach(view);
+        return G_SOURCE_REMOVE;
+    }
+
+    g_object_set(G_OBJECT(view->queue),
+                 "max-size-buffers", VIEW_QUEUE_DEPTH,
+                 "max-size-bytes", 0,
+                 "max-size-time", (guint64)0,
+                 "leaky", 2,                                        // 2 is downstream: the oldest frames go first
+                 NULL);
+    g_object_set(G_OBJECT(view->sink), "sync", FALSE, NULL);
+    g_object_set(G_OBJECT(view->sink), "max-lateness", -1, NULL);
+    // A view joining late must not take the running pipeline back to PAUSED while it prerolls
+    g_object_set(G_OBJECT(view->sink), "async", FALSE, NULL);
+    if (view->window != 0 && GST_IS_VIDEO_OVERLAY(view->sink)) {
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(view->sink), view->window);
+    }
+
+    gst_bin_add_many(GST_BIN(decode->pipeline), view->queue, view->sink, NULL);
+    if (view->conv) {
+        gst_bin_add(GST_BIN(decode->pipeline), view->conv);
+        linked = gst_element_link_many(view->queue, view->conv, view->sink, NULL);
+    } else {
+        linked = gst_element_link(view->queue, view->sink);
+    }
+    if (!linked) {
+        LOGE("View elements could not be linked");
+        view_detach(view);
+        return G_SOURCE_REMOVE;
+    }
+
+    pad = gst_element_get_static_pad(view->queue, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_view_gate, view, NULL);
+    gst_object_unref(pad);
+    pad = gst_element_get_static_pad(view->sink, "sink");
+    gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER, cb_view_first_frame, view, NULL);
+    gst_object_unref(pad);
+
+    // Downstream first, the branch is ready for data before the tee pushes any
+    gst_element_sync_state_with_parent(view->sink);
+    if (view->conv) {
+        gst_element_sync_state_with_parent(view->conv);
+    }
+    gst_element_sync_state_with_parent(view->queue);
+
+    view->tee_pad = gst_element_get_request_pad(decode->tee, "src_%u");
+    pad = gst_element_get_static_pad(view->queue, "sink");
+    linked = view->tee_pad && GST_PAD_LINK_SUCCESSFUL(gst_pad_link(view->tee_pad, pad));
+    gst_object_unref(pad);
+    if (!linked) {
+        LOGE("View could not be linked to the tee");
+        view_detach(view);
+        return G_SOURCE_REMOVE;
+    }
+
+    g_mutex_lock(&decode->lock);
+    decode->attached = g_list_prepend(decode->attached, view);
+    g_mutex_unlock(&decode->lock);
+    return G_SOURCE_REMOVE;
+}
+
+typedef struct {
+    RctGstSharedView *view;
+    gchar *description;
+} DescribeCall;
+
+static gboolean view_describe(gpointer user_data)
+{
+    DescribeCall *call = (DescribeCall *)user_data;
+    RctGstSharedView *view = call->view;
+    RctGstSharedDecode *decode = view->decode;
+    RctGstSource *front_end = decode->front_end;
+    GstElement *elements[] = { front_end ? front_end->source : NULL, front_end ? front_end->depay : NULL,
+                               decode->parser, decode->decoder, decode->tee, view->queue, view->conv, view->sink };
+
+    call->description = rct_gst_autoplug_describe(elements, G_N_ELEMENTS(elements));
+    return G_SOURCE_REMOVE;
+}
+
+typedef struct {
+    RctGstSharedView *view;
+    GstSample *sample;
+} LastSampleCall;
+
+static gboolean view_last_sample(gpointer user_data)
+{
+    LastSampleCall *call = (LastSampleCall *)user_data;
+
+    if (call->view->sink) {
+        g_object_get(G_OBJECT(call->view->sink), "last-sample", &call->sample, NULL);
+    }
+    return G_SOURCE_REMOVE;
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstSharedView *rct_gst_shared_view_new(const gchar *uri, const gchar *sink_factory, gboolean force_convert,
+                                          guintptr window, RctGstSharedViewFirstFrameFunc first_frame,
+                                          RctGstSharedViewErrorFunc error, gpointer user_data)
+{
+    RctGstSharedDecode *decode;
+    RctGstSharedView *view;
+    gboolean joined;
+    guint views;
+
+    if (!uri) {
+        return NULL;
+    }
+
+    // Held while a new decode gets built, so that a uri never gets two
+    g_mutex_lock(&registry_lock);
+    if (!registry) {
+        registry = g_hash_table_new(g_str_hash, g_str_equal);
+    }
+    decode = (RctGstSharedDecode *)g_hash_table_lookup(registry, uri);
+    joined = decode != NULL;
+    if (!decode) {
+        decode = decode_new(uri);
+        if (!decode) {
+            g_mutex_unlock(&registry_lock);
+            return NULL;
+        }
+        g_hash_table_insert(registry, decode->uri, decode);
+    }
+    views = ++decode->views;
+    g_mutex_unlock(&registry_lock);
+
+    view = g_new0(RctGstSharedView, 1);
+    view->decode = decode;
+    view->joined = joined;
+    view->sink_factory = g_strdup(sink_factory);
+    view->force_convert = force_convert;
+    view->window = window;
+    view->first_frame = first_frame;
+    view->error = error;
+    view->user_data = user_data;
+    view->activated_at = g_get_monotonic_time();
+    view->active = TRUE;
+    view->first_frame_pending = TRUE;
+
+    decode_call(decode, view_attach, view);
+    if (!view->tee_pad) {
+        rct_gst_shared_view_free(view);
+        return NULL;
+    }
+    LOGI("View %p %s the decode of %s, %u views", view, joined ? "joined" : "opened", uri, views);
+    return view;
+}
+
+void rct_gst_shared_view_free(RctGstSharedView *view)
+{
+    RctGstSharedDecode *decode;
+    gboolean last;
+
+    if (!view) {
+        return;
+    }
+    decode = view->decode;
+    decode_call(decode, view_detach, view);
+
+    g_mutex_lock(&registry_lock);
+    last = --decode->views == 0;
+    if (last) {
+        g_hash_table_remove(registry, decode->uri);
+    }
+    g_mutex_unlock(&registry_lock);
+
+    if (last) {
+        LOGI("Last view of %s detached, stopping its decode", decode->uri);
+        decode_free(decode);
+    }
+    g_free(view->sink_factory);
+    g_free(view);
+}
+
+void rct_gst_shared_view_set_window(RctGstSharedView *view, guintptr window)
+{
+    view->window = window;
+    if (view->sink && GST_IS_VIDEO_OVERLAY(view->sink)) {
+        gst_video_overlay_set_window_handle(GST_VIDEO_OVERLAY(view->sink), window);
+    }
+}
+
+void rct_gst_shared_view_set_active(RctGstSharedView *view, gboolean active)
+{
+    if (active && !g_atomic_int_get(&view->active)) {
+        view->activated_at = g_get_monotonic_time();
+        g_atomic_int_set(&view->first_frame_pending, TRUE);
+    }
+    g_atomic_int_set(&view->active, active);
+}
+
+gboolean rct_gst_shared_view_is_joined(RctGstSharedView *view)
+{
+    return view->joined;
+}
+
+RctGstTransport rct_gst_shared_view_get_transport(RctGstSharedView *view)
+{
+    return rct_gst_transport_get_current(view->decode->transport);
+}
+
+gchar *rct_gst_shared_view_describe(RctGstSharedView *view)
+{
+    DescribeCall call = { view, NULL };
+    gchar *description;
+    guint views;
+
+    decode_call(view->decode, view_describe, &call);
+    g_mutex_lock(&registry_lock);
+    views = view->decode->views;
+    g_mutex_unlock(&registry_lock);
+
+    description = g_strdup_printf("%s (shared by %u views)", call.description, views);
+    g_free(call.description);
+    return description;
+}
+
+GstSample *rct_gst_shared_view_get_last_sample(RctGstSharedView *view)
+{
+    LastSampleCall call = { view, NULL };
+
+    decode_call(view->decode, view_last_sample, &call);
+    return call.sample;
+}
+
+guint rct_gst_shared_decode_count(void)
+{
+    guint count;
+
+    g_mutex_lock(&registry_lock);
+    count = registry ? g_hash_table_size(registry) : 0;
+    g_mutex_unlock(&registry_lock);
+    return count;
+}
@@ -0,0 +1,50 @@
+//
+//  gstreamer_shared_decode.h
+//
+//  Decodes shared by the players of a process. The first view of a uri
+//  opens its session and decoder, on a thread of their own, and every
+//  view of the same uri gets a branch (queue ! sink) on a tee after the
+//  decoder. The decode is reference counted by its views: it outlives the
+//  player that created it and stops with the last view detaching.
+//
+
+#ifndef gstreamer_shared_decode_h
+#define gstreamer_shared_decode_h
+
+#include <gst/gst.h>
+#include "gstreamer_transport.h"
+
+typedef struct _RctGstSharedDecode RctGstSharedDecode;
+typedef struct _RctGstSharedView RctGstSharedView;
+
+// Streaming thread, the first frame a view displays after it was attached or activated
+typedef void (*RctGstSharedViewFirstFrameFunc)(RctGstSharedView *view, gint64 ttff_us, gpointer user_data);
+
+// Decode thread, first failure of the decode session, a restart is already scheduled
+typedef void (*RctGstSharedViewErrorFunc)(RctGstSharedView *view, const gchar *source, const gchar *message,
+                                          const gchar *debug_info, gpointer user_data);
+
+// Attaches a view to the decode of uri, opening it when there is none. NULL when the decode could not be built.
+// sink_factory NULL is glimagesink, window 0 until there is one. Starts active.
+RctGstSharedView *rct_gst_shared_view_new(const gchar *uri, const gchar *sink_factory, gboolean force_convert,
+                                          guintptr window, RctGstSharedViewFirstFrameFunc first_frame,
+                                          RctGstSharedViewErrorFunc error, gpointer user_data);
+
+// Detaches the view, no callback runs past this point. The last view stops the decode.
+void rct_gst_shared_view_free(RctGstSharedView *view);
+
+void rct_gst_shared_view_set_window(RctGstSharedView *view, guintptr window);
+
+// Inactive views drop the decoded frames and keep showing the last one
+void rct_gst_shared_view_set_active(RctGstSharedView *view, gboolean active);
+
+// TRUE when the view joined a decode other views had already opened
+gboolean rct_gst_shared_view_is_joined(RctGstSharedView *view);
+
+// Any thread
+RctGstTransport rct_gst_shared_view_get_transport(RctGstSharedView *view);
+gchar *rct_gst_shared_view_describe(RctGstSharedView *view);       // Element chain, free with g_free
+GstSample *rct_gst_shared_view_get_last_sample(RctGstSharedView *view); // Last frame of the view's sink, or NULL
+guint rct_gst_shared_decode_count(void);                            // Decodes currently running
+
+#endif /* gstreamer_shared_decode_h */
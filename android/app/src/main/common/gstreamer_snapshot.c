@@ -0,0 +1,164 @@
+#include "gstreamer_snapshot.h"
+#include "gstreamer_log.h"
+#include <gst/video/video.h>
+
+#define LOG_TAG "GStreamerSnapshot"
+
+// Encoders running at once, a burst of stills is spread over them
+#define MAX_WORKERS 2
+
+// Requests waiting for a worker. Every one holds a decoded frame the decoder may want back.
+#define MAX_PENDING 2
+
+// Time a frame gets to be scaled and encoded
+#define ENCODE_TIMEOUT (2 * GST_SECOND)
+
+typedef struct {
+    GstSample *sample;
+    RctGstSnapshotFormat format;
+    gint max_size;
+    gchar *path;
+    RctGstSnapshotFunc done;
+    gpointer user_data;
+    gint64 requested_at;                // Monotonic µs
+} SnapshotJob;
+
+struct _RctGstSnapshotter
+{
+    GThreadPool *workers;
+};
+
+static void job_free(SnapshotJob *job)
+{
+    gst_sample_unref(job->sample);
+    g_free(job->path);
+    g_free(job);
+}
+
+// Display size of the frame fitted in max_size, square pixels and even dimensions
+static void fit_size(const GstVideoInfo *info, gint max_size, gint *width, gint *height)
+{
+    gdouble display_width = (gdouble)GST_VIDEO_INFO_WIDTH(info) * MAX(GST_VIDEO_INFO_PAR_N(info), 1) /
+                            MAX(GST_VIDEO_INFO_PAR_D(info), 1);
+    gdouble display_height = GST_VIDEO_INFO_HEIGHT(info);
+    gdouble scale = 1.0;
+
+    if (max_size > 0 && MAX(display_width, display_height) > max_size) {
+        scale = max_size / MAX(display_width, display_height);
+    }
+    *width = MAX((gint)(display_width * scale) & ~1, 2);
+    *height = MAX((gint)(display_height * scale) & ~1, 2);
+}
+
+static void encode(gpointer data, gpointer user_data)
+{
+    SnapshotJob *job = (SnapshotJob *)data;
+    RctGstSnapshot snapshot = { FALSE, NULL, NULL, NULL, 0, 0, -1 };
+    GstVideoInfo info;
+    GstCaps *caps;
+    GstSample *image = NULL;
+    GstBuffer *buffer = gst_sample_get_buffer(job->sample);
+    const GstSegment *segment = gst_sample_get_segment(job->sample);
+    GstMapInfo map;
+    GError *error = NULL;
+
+    if (!buffer || !gst_video_info_from_caps(&info, gst_sample_get_caps(job->sample))) {
+        snapshot.error = "no decoded frame";
+        goto done;
+    }
+    if (GST_BUFFER_PTS_IS_VALID(buffer) && segment) {
+        snapshot.position_us = gst_segment_to_stream_time(segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer)) / GST_USECOND;
+    }
+    fit_size(&info, job->max_size, &snapshot.width, &snapshot.height);
+
+    // Builds convert ! scale ! encoder for this frame alone, GPU frames are downloaded on the way
+    caps = gst_caps_new_simple(job->format == RCT_GST_SNAPSHOT_PNG ? "image/png" : "image/jpeg",
+                               "width", G_TYPE_INT, snapshot.width,
+                               "height", G_TYPE_INT, snapshot.height,
+                               "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                               NULL);
+    image = gst_video_convert_sample(job->sample, caps, ENCODE_TIMEOUT, &error);
+    gst_caps_unref(caps);
+    if (!image || !gst_sample_get_buffer(image)) {
+        LOGE("Snapshot could not be encoded: %s", error ? error->message : "timeout");
+        snapshot.error = "encoding failed";
+        goto done;
+    }
+
+    buffer = gst_sample_get_buffer(image);
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        snapshot.error = "encoding failed";
+        goto done;
+    }
+    if (job->path) {
+        snapshot.success = g_file_set_contents(job->path, (const gchar *)map.data, map.size, &error);
+        snapshot.path = job->path;
+        if (!snapshot.success) {
+            LOGE("Snapshot could not be written to %s: %s", job->path, error->message);
+            snapshot.error = "file not written";
+        }
+    } else {
+        snapshot.bytes = g_bytes_new(map.data, map.size);
+        snapshot.success = TRUE;
+    }
+    gst_buffer_unmap(buffer, &map);
+    LOGD("Snapshot %dx%d, %" G_GSIZE_FORMAT " bytes in %lld us", snapshot.width, snapshot.height, map.size,
+         (long long)(g_get_monotonic_time() - job->requested_at));
+
+done:
+    job->done(&snapshot, job->user_data);
+    if (snapshot.bytes) {
+        g_bytes_unref(snapshot.bytes);
+    }
+    if (image) {
+        gst_sample_unref(image);
+    }
+    g_clear_error(&error);
+    job_free(job);
+}
+
+RctGstSnapshotter *rct_gst_snapshotter_new(void)
+{
+    RctGstSnapshotter *snapshotter = g_new0(RctGstSnapshotter, 1);
+
+    snapshotter->workers = g_thread_pool_new(encode, snapshotter, MAX_WORKERS, FALSE, NULL);
+    return snapshotter;
+}
+
+void rct_gst_snapshotter_free(RctGstSnapshotter *snapshotter)
+{
+    if (!snapshotter) {
+        return;
+    }
+    g_thread_pool_free(snapshotter->workers, FALSE, TRUE);
+    g_free(snapshotter);
+}
+
+void rct_gst_snapshotter_take(RctGstSnapshotter *snapshotter, GstSample *sample, RctGstSnapshotFormat format,
+                              gint max_size, const gchar *path, RctGstSnapshotFunc done, gpointer user_data)
+{
+    SnapshotJob *job;
+
+    if (g_thread_pool_unprocessed(snapshotter->workers) >= MAX_PENDING) {
+        rct_gst_snapshotter_fail("too many snapshots in progress", done, user_data);
+        return;
+    }
+
+    job = g_new0(SnapshotJob, 1);
+    job->sample = gst_sample_ref(sample);
+    job->format = format;
+    job->max_size = max_size;
+    job->path = g_strdup(path);
+    job->done = done;
+    job->user_data = user_data;
+    job->requested_at = g_get_monotonic_time();
+    g_thread_pool_push(snapshotter->workers, job, NULL);
+}
+
+void rct_gst_snapshotter_fail(const gchar *error, RctGstSnapshotFunc done, gpointer user_data)
+{
+    RctGstSnapshot snapshot = { FALSE, error, NULL, NULL, 0, 0, -1 };
+
+    LOGE("Snapshot refused: %s", error);
+    done(&snapshot, user_data);
+}
@@ -0,0 +1,47 @@
+//
+//  gstreamer_snapshot.h
+//
+//  Stills of the last decoded frame. The sample the sink keeps is taken
+//  by reference, nothing is copied on the streaming thread; scaling and
+//  JPEG or PNG encoding run on worker threads. A bounded backlog keeps
+//  bursts from piling frames up: requests past it fail right away.
+//
+
+#ifndef gstreamer_snapshot_h
+#define gstreamer_snapshot_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_SNAPSHOT_JPEG,
+    RCT_GST_SNAPSHOT_PNG
+} RctGstSnapshotFormat;
+
+typedef struct {
+    gboolean success;
+    const gchar *error;                 // Why it failed, NULL on success
+    const gchar *path;                  // File written, NULL when the image is in bytes
+    GBytes *bytes;                      // Encoded image, NULL when written to path
+    gint width, height;
+    gint64 position_us;                 // Stream time of the frame, -1 when unknown
+} RctGstSnapshot;
+
+// Worker thread, or the calling one when the request is refused. Pointers are only valid during the call.
+typedef void (*RctGstSnapshotFunc)(const RctGstSnapshot *snapshot, gpointer user_data);
+
+typedef struct _RctGstSnapshotter RctGstSnapshotter;
+
+RctGstSnapshotter *rct_gst_snapshotter_new(void);
+
+// Waits for the snapshots in progress, their callbacks have all been called on return
+void rct_gst_snapshotter_free(RctGstSnapshotter *snapshotter);
+
+// Takes a reference on sample. The image fits in max_size x max_size, 0 keeps the frame size.
+// path NULL delivers the encoded bytes instead of writing a file. done is always called.
+void rct_gst_snapshotter_take(RctGstSnapshotter *snapshotter, GstSample *sample, RctGstSnapshotFormat format,
+                              gint max_size, const gchar *path, RctGstSnapshotFunc done, gpointer user_data);
+
+// For requests that never got a sample: reports error through done on the calling thread
+void rct_gst_snapshotter_fail(const gchar *error, RctGstSnapshotFunc done, gpointer user_data);
+
+#endif /* gstreamer_snapshot_h */
@@ -0,0 +1,545 @@
+#include "gstreamer_source.h"
+#include "gstreamer_codec.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerSource"
+
+// Without an audio handler the audio stream is never set up, metering off costs nothing.
+// Only the first video stream is set up, streams of other media (ONVIF metadata) never are.
+static gboolean on_select_stream(GstElement *src, guint num, GstCaps *caps, gpointer user_data) {
+    RctGstSource *source = (RctGstSource *)user_data;
+    const gchar *media = gst_structure_get_string(gst_caps_get_structure(caps, 0), "media");
+
+    if (g_strcmp0(media, "audio") == 0) {
+        return source->audio_handler != NULL;
+    }
+    if (g_strcmp0(media, "video") != 0) {
+        LOGD("Stream %u of %s carries %s, not set up", num, source->uri, media ? media : "no media");
+        return FALSE;
+    }
+    if (source->video_stream >= 0 && source->video_stream != (gint)num) {
+        LOGD("Stream %u of %s is another video stream, not set up", num, source->uri);
+        return FALSE;
+    }
+    source->video_stream = num;
+    return TRUE;
+}
+
+static void on_audio_pad_added(RctGstSource *source, GstPad *pad) {
+    gboolean active;
+
+    g_mutex_lock(&source->gop_lock);
+    if (source->audio_pad) {
+        gst_object_unref(source->audio_pad);
+    }
+    source->audio_pad = gst_object_ref(pad);
+    active = g_atomic_int_get(&source->mode) == RCT_GST_SOURCE_ACTIVE;
+    g_mutex_unlock(&source->gop_lock);
+
+    if (active && source->audio_handler) {
+        source->audio_handler(source, pad, source->audio_handler_data);
+    }
+}
+
+// Depayloaders are kept once created, a new session with the same codec reuses its own
+static GstElement *get_depay(RctGstSource *source, RctGstCodec codec)
+{
+    GstElement *depay = source->depays[codec];
+
+    if (!depay) {
+        depay = rct_gst_codec_make_depay(codec, NULL);
+        if (!depay) {
+            return NULL;
+        }
+        gst_bin_add(source->bin, depay);
+        gst_element_sync_state_with_parent(depay);
+        source->depays[codec] = depay;
+    }
+    return depay;
+}
+
+// TRUE while a video stream feeds the output, the one of a finished RTSP session left its depayloader unlinked
+static gboolean has_video_input(RctGstSource *source)
+{
+    GstPad *output_pad = gst_element_get_static_pad(source->output, "sink");
+    GstPad *peer = gst_pad_get_peer(output_pad);
+    gboolean linked = peer != NULL;
+
+    if (peer && source->live) {
+        GstElement *depay = gst_pad_get_parent_element(peer);
+        GstPad *depay_pad = gst_element_get_static_pad(depay, "sink");
+
+        linked = gst_pad_is_linked(depay_pad);
+        gst_object_unref(depay_pad);
+        gst_object_unref(depay);
+    }
+    if (peer) {
+        gst_object_unref(peer);
+    }
+    gst_object_unref(output_pad);
+    return linked;
+}
+
+// Called with gop_lock held. An active front end the parser can't take goes back to standby.
+static gboolean refuse_codec(RctGstSource *source, RctGstCodec codec)
+{
+    GstPad *src_pad = gst_element_get_static_pad(source->output, "src");
+    GstPad *peer = gst_pad_get_peer(src_pad);
+    gboolean refused = peer && !rct_gst_codec_accepted_by(codec, peer);
+
+    if (refused) {
+        LOGI("%s of %s not taken by the parser, front end back on standby", rct_gst_codec_get_name(codec), source->uri);
+        g_atomic_int_set(&source->mode, RCT_GST_SOURCE_STANDBY);
+        gst_pad_unlink(src_pad, peer);
+    }
+    if (peer) {
+        gst_object_unref(peer);
+    }
+    gst_object_unref(src_pad);
+    return refused;
+}
+
+static void report_codec(RctGstSource *source, RctGstCodec codec, gboolean refused)
+{
+    if (source->codec_handler) {
+        source->codec_handler(source, codec, source->codec_handler_data);
+    } else if (refused) {
+        GST_ELEMENT_ERROR(source->source, STREAM, CODEC_NOT_FOUND,
+                          ("%s is not decoded by this pipeline", rct_gst_codec_get_name(codec)), (NULL));
+    }
+}
+
+static void on_video_pad_added(RctGstSource *source, GstPad *pad, RctGstCodec codec, const gchar *type)
+{
+    GstElement *depay = NULL;
+    GstPad *output_pad, *peer, *sink_pad;
+    gboolean refused;
+
+    if (codec == RCT_GST_CODEC_UNKNOWN) {
+        GST_ELEMENT_ERROR(source->source, STREAM, CODEC_NOT_FOUND, ("Video codec not supported"),
+                          ("Pad '%s' has caps %s", GST_PAD_NAME(pad), type));
+        return;
+    }
+    if (has_video_input(source)) {
+        LOGD("  Another video stream already plays. Ignoring.");
+        return;
+    }
+    if (source->live && !(depay = get_depay(source, codec))) {
+        GST_ELEMENT_ERROR(source->source, CORE, MISSING_PLUGIN,
+                          ("No depayloader for %s", rct_gst_codec_get_name(codec)), (NULL));
+        return;
+    }
+
+    g_mutex_lock(&source->gop_lock);
+    source->depay = depay;
+    g_atomic_int_set(&source->codec, codec);
+    refused = refuse_codec(source, codec);
+    g_mutex_unlock(&source->gop_lock);
+
+    // The output takes the depayloader of this codec, or the decodebin pad itself
+    output_pad = gst_element_get_static_pad(source->output, "sink");
+    if ((peer = gst_pad_get_peer(output_pad)) != NULL) {
+        gst_pad_unlink(peer, output_pad);
+        gst_object_unref(peer);
+    }
+    if (depay) {
+        GstPad *depay_pad = gst_element_get_static_pad(depay, "src");
+        gst_pad_link(depay_pad, output_pad);
+        gst_object_unref(depay_pad);
+        sink_pad = gst_element_get_static_pad(depay, "sink");
+    } else {
+        sink_pad = gst_object_ref(output_pad);
+    }
+    gst_object_unref(output_pad);
+
+    if (GST_PAD_LINK_FAILED(gst_pad_link(pad, sink_pad))) {
+        LOGE("  Type is '%s' but link failed.", type);
+    } else {
+        LOGD("  Link succeeded (%s).", rct_gst_codec_get_name(codec));
+    }
+    gst_object_unref(sink_pad);
+    report_codec(source, codec, refused);
+}
+
+static void on_pad_added(GstElement *src, GstPad *new_pad, gpointer user_data) {
+    RctGstSource *source = (RctGstSource *)user_data;
+    GstCaps *new_pad_caps = NULL;
+    GstStructure *new_pad_struct = NULL;
+    const gchar *new_pad_type = NULL;
+    const gchar *media;
+
+    LOGD("Received new pad '%s' from '%s':", GST_PAD_NAME(new_pad), GST_ELEMENT_NAME(src));
+
+    // Check the new pad's type
+    new_pad_caps = gst_pad_get_current_caps(new_pad);
+    if (!new_pad_caps) {
+        new_pad_caps = gst_pad_query_caps(new_pad, NULL);
+    }
+    new_pad_struct = gst_caps_get_structure(new_pad_caps, 0);
+    new_pad_type = gst_structure_get_name(new_pad_struct);
+    if (!source->live) {
+        // uridecodebin exposes the demuxed video and the decoded audio
+        media = g_str_has_prefix(new_pad_type, "audio/") ? "audio" : "video";
+    } else if (!g_str_has_prefix(new_pad_type, "application/x-rtp")) {
+        LOGD("  It has type '%s' which is not application/x-rtp. Ignoring.", new_pad_type);
+        goto exit;
+    } else {
+        media = gst_structure_get_string(new_pad_struct, "media");
+    }
+
+    if (g_strcmp0(media, "audio") == 0) {
+        LOGD("  Audio stream, handed to the audio branch.");
+        on_audio_pad_added(source, new_pad);
+    } else if (g_strcmp0(media, "video") == 0) {
+        on_video_pad_added(source, new_pad, rct_gst_codec_from_caps(new_pad_caps), new_pad_type);
+    } else {
+        LOGD("  It carries %s, not audio nor video. Ignoring.", media ? media : "no media");
+    }
+
+exit:
+    if (new_pad_caps != NULL) {
+        gst_caps_unref(new_pad_caps);
+    }
+}
+
+/*********
+ GOP CACHE
+ ********/
+void rct_gst_source_clear_gop(RctGstSource *source)
+{
+    GstBuffer *buffer;
+
+    g_mutex_lock(&source->gop_lock);
+    while ((buffer = g_queue_pop_head(&source->gop)) != NULL) {
+        gst_buffer_unref(buffer);
+    }
+    if (source->budget_used) {
+        g_atomic_int_add(source->budget_used, -(gint)source->gop_bytes);
+    }
+    source->gop_bytes = 0;
+    g_mutex_unlock(&source->gop_lock);
+}
+
+// Keeps every access unit since the last keyframe, within the shared budget
+static void cache_buffer(RctGstSource *source, GstBuffer *buffer)
+{
+    gsize size = gst_buffer_get_size(buffer);
+
+    if (!GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT)) {
+        rct_gst_source_clear_gop(source);
+    } else if (g_queue_is_empty(&source->gop)) {
+        // No keyframe to start from (not received yet, or the GOP went over budget)
+        return;
+    }
+
+    if (source->budget_used && source->budget > 0 &&
+        (gsize)g_atomic_int_get(source->budget_used) + size > source->budget) {
+        LOGD("GOP cache of %s over budget, dropped until next keyframe", source->uri);
+        rct_gst_source_clear_gop(source);
+        return;
+    }
+
+    g_mutex_lock(&source->gop_lock);
+    g_queue_push_tail(&source->gop, gst_buffer_ref(buffer));
+    source->gop_bytes += size;
+    if (source->budget_used) {
+        g_atomic_int_add(source->budget_used, (gint)size);
+    }
+    g_mutex_unlock(&source->gop_lock);
+}
+
+// Pushes the cached GOP downstream right after promotion, from the streaming thread
+static void replay_gop(RctGstSource *source, GstPad *pad)
+{
+    GQueue gop;
+    GstBuffer *buffer;
+
+    g_mutex_lock(&source->gop_lock);
+    gop = source->gop;
+    g_queue_init(&source->gop);
+    if (source->budget_used) {
+        g_atomic_int_add(source->budget_used, -(gint)source->gop_bytes);
+    }
+    source->gop_bytes = 0;
+    g_mutex_unlock(&source->gop_lock);
+
+    if (g_queue_is_empty(&gop)) {
+        return;
+    }
+
+    LOGD("Replaying %u cached access units of %s", g_queue_get_length(&gop), source->uri);
+    source->replaying = TRUE;
+    while ((buffer = g_queue_pop_head(&gop)) != NULL) {
+        if (gst_pad_push(pad, buffer) != GST_FLOW_OK) {
+            break;
+        }
+    }
+    source->replaying = FALSE;
+
+    while ((buffer = g_queue_pop_head(&gop)) != NULL) {
+        gst_buffer_unref(buffer);
+    }
+}
+
+static GstPadProbeReturn cb_output(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstSource *source = (RctGstSource *)user_data;
+
+    // A new session (or a flush) makes the cached access units useless
+    if (GST_PAD_PROBE_INFO_TYPE(info) & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEventType type = GST_EVENT_TYPE(GST_PAD_PROBE_INFO_EVENT(info));
+        if (type == GST_EVENT_STREAM_START || type == GST_EVENT_FLUSH_STOP) {
+            rct_gst_source_clear_gop(source);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    if (source->replaying) {
+        return GST_PAD_PROBE_OK;
+    }
+
+    if (g_atomic_int_get(&source->mode) == RCT_GST_SOURCE_ACTIVE) {
+        replay_gop(source, pad);
+        return GST_PAD_PROBE_OK;
+    }
+
+    // Standby: the pad is not linked, keep the access unit and report success upstream
+    cache_buffer(source, GST_PAD_PROBE_INFO_BUFFER(info));
+    return GST_PAD_PROBE_DROP;
+}
+
+/*************
+ OTHER METHODS
+ ************/
+// Demuxed streams are exposed as they are, decoding stays with the player
+static void apply_decodebin_caps(RctGstSource *source)
+{
+    GstCaps *caps = gst_caps_new_empty();
+    RctGstCodec codec;
+
+    for (codec = RCT_GST_CODEC_H264; codec < RCT_GST_CODEC_COUNT; codec++) {
+        gst_caps_append(caps, rct_gst_codec_get_caps(codec));
+    }
+    if (source->audio_handler) {
+        gst_caps_append(caps, gst_caps_new_empty_simple("audio/x-raw"));
+    }
+
+    g_object_set(G_OBJECT(source->source), "caps", caps, "expose-all-streams", FALSE, NULL);
+    gst_caps_unref(caps);
+}
+
+gboolean rct_gst_source_uri_is_live(const gchar *uri)
+{
+    return uri && g_str_has_prefix(uri, "rtsp");
+}
+
+RctGstSource *rct_gst_source_new(GstBin *bin, const gchar *uri)
+{
+    RctGstSource *source = g_new0(RctGstSource, 1);
+    GstPad *pad;
+
+    source->live = rct_gst_source_uri_is_live(uri);
+    source->source = gst_element_factory_make(source->live ? "rtspsrc" : "uridecodebin", NULL);
+    source->output = gst_element_factory_make("identity", NULL);
+
+    if (!source->source || !source->output) {
+        LOGE("Failed to create source elements");
+        if (source->source) {
+            gst_object_unref(source->source);
+        }
+        if (source->output) {
+            gst_object_unref(source->output);
+        }
+        g_free(source);
+        return NULL;
+    }
+
+    source->uri = g_strdup(uri);
+    source->bin = bin;
+    source->mode = RCT_GST_SOURCE_STANDBY;
+    source->codec = RCT_GST_CODEC_UNKNOWN;
+    source->video_stream = -1;
+    source->last_used = g_get_monotonic_time();
+    g_mutex_init(&source->gop_lock);
+    g_queue_init(&source->gop);
+
+    if (source->live) {
+        g_object_set(G_OBJECT(source->source), "location", uri, NULL);
+        g_signal_connect(source->source, "select-stream", G_CALLBACK(on_select_stream), source);
+    } else {
+        g_object_set(G_OBJECT(source->source), "uri", uri, NULL);
+        apply_decodebin_caps(source);
+    }
+    gst_bin_add_many(bin, source->source, source->output, NULL);
+
+    // The depayloader is only known from the caps of the first video pad
+    g_signal_connect(source->source, "pad-added", G_CALLBACK(on_pad_added), source);
+
+    pad = gst_element_get_static_pad(source->output, "src");
+    source->probe_id = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                                         cb_output, source, NULL);
+    gst_object_unref(pad);
+
+    LOGD("Created source front end for %s", uri);
+    return source;
+}
+
+void rct_gst_source_free(RctGstSource *source)
+{
+    RctGstCodec codec;
+
+    if (!source) {
+        return;
+    }
+
+    LOGD("Freeing source front end for %s", source->uri);
+    gst_element_set_state(source->source, GST_STATE_NULL);
+    gst_element_set_state(source->output, GST_STATE_NULL);
+    gst_bin_remove_many(source->bin, source->source, source->output, NULL);
+    for (codec = RCT_GST_CODEC_H264; codec < RCT_GST_CODEC_COUNT; codec++) {
+        if (source->depays[codec]) {
+            gst_element_set_state(source->depays[codec], GST_STATE_NULL);
+            gst_bin_remove(source->bin, source->depays[codec]);
+        }
+    }
+
+    rct_gst_source_clear_gop(source);
+    if (source->audio_pad) {
+        gst_object_unref(source->audio_pad);
+    }
+    g_mutex_clear(&source->gop_lock);
+    g_free(source->uri);
+    g_free(source);
+}
+
+void rct_gst_source_start(RctGstSource *source)
+{
+    RctGstCodec codec;
+
+    gst_element_sync_state_with_parent(source->output);
+    for (codec = RCT_GST_CODEC_H264; codec < RCT_GST_CODEC_COUNT; codec++) {
+        if (source->depays[codec]) {
+            gst_element_sync_state_with_parent(source->depays[codec]);
+        }
+    }
+    gst_element_sync_state_with_parent(source->source);
+}
+
+gboolean rct_gst_source_activate(RctGstSource *source, GstElement *downstream)
+{
+    GstPad *src_pad = gst_element_get_static_pad(source->output, "src");
+    GstPad *sink_pad = gst_element_get_static_pad(downstream, "sink");
+    GstPadLinkReturn ret = GST_PAD_LINK_REFUSED;
+    RctGstCodec codec;
+    gboolean accepted;
+    GstPad *audio_pad;
+
+    // Under gop_lock, so a video pad showing up now sees either the link or the standby
+    g_mutex_lock(&source->gop_lock);
+    codec = g_atomic_int_get(&source->codec);
+    accepted = codec == RCT_GST_CODEC_UNKNOWN || rct_gst_codec_accepted_by(codec, sink_pad);
+    if (accepted) {
+        ret = gst_pad_link(src_pad, sink_pad);
+    }
+    // Linked first: the streaming thread only pushes once it sees the active mode
+    if (GST_PAD_LINK_SUCCESSFUL(ret)) {
+        g_atomic_int_set(&source->mode, RCT_GST_SOURCE_ACTIVE);
+    }
+    g_mutex_unlock(&source->gop_lock);
+    gst_object_unref(src_pad);
+    gst_object_unref(sink_pad);
+
+    if (!accepted) {
+        LOGI("%s of %s not taken by the parser, front end kept on standby", rct_gst_codec_get_name(codec), source->uri);
+        if (!source->codec_handler) {
+            return FALSE;
+        }
+        source->codec_handler(source, codec, source->codec_handler_data);
+        return TRUE;
+    }
+    if (GST_PAD_LINK_FAILED(ret)) {
+        LOGE("Source front end for %s could not be linked", source->uri);
+        return FALSE;
+    }
+    source->last_used = g_get_monotonic_time();
+
+    // An audio pad that showed up on standby gets its branch now
+    audio_pad = rct_gst_source_get_audio_pad(source);
+    if (audio_pad) {
+        if (source->audio_handler) {
+            source->audio_handler(source, audio_pad, source->audio_handler_data);
+        }
+        gst_object_unref(audio_pad);
+    }
+    return TRUE;
+}
+
+void rct_gst_source_deactivate(RctGstSource *source)
+{
+    GstPad *src_pad = gst_element_get_static_pad(source->output, "src");
+    GstPad *peer;
+
+    // Standby first: the streaming thread stops pushing before the pad gets unlinked
+    g_atomic_int_set(&source->mode, RCT_GST_SOURCE_STANDBY);
+    peer = gst_pad_get_peer(src_pad);
+    if (peer) {
+        gst_pad_unlink(src_pad, peer);
+        gst_object_unref(peer);
+    }
+    gst_object_unref(src_pad);
+
+    // Standby audio goes nowhere, rtspsrc keeps running while one of its pads is linked
+    g_mutex_lock(&source->gop_lock);
+    if (source->audio_pad && (peer = gst_pad_get_peer(source->audio_pad)) != NULL) {
+        gst_pad_unlink(source->audio_pad, peer);
+        gst_object_unref(peer);
+    }
+    g_mutex_unlock(&source->gop_lock);
+    source->last_used = g_get_monotonic_time();
+}
+
+void rct_gst_source_set_audio_handler(RctGstSource *source, RctGstSourceAudioPadFunc handler, gpointer user_data)
+{
+    source->audio_handler = handler;
+    source->audio_handler_data = user_data;
+    if (!source->live) {
+        apply_decodebin_caps(source);
+    }
+}
+
+gboolean rct_gst_source_set_uri(RctGstSource *source, const gchar *uri)
+{
+    if (rct_gst_source_uri_is_live(uri) != source->live) {
+        return FALSE;
+    }
+    g_object_set(G_OBJECT(source->source), source->live ? "location" : "uri", uri, NULL);
+    g_free(source->uri);
+    source->uri = g_strdup(uri);
+    source->video_stream = -1;
+    return TRUE;
+}
+
+void rct_gst_source_set_codec_handler(RctGstSource *source, RctGstSourceCodecFunc handler, gpointer user_data)
+{
+    source->codec_handler = handler;
+    source->codec_handler_data = user_data;
+}
+
+GstPad *rct_gst_source_get_audio_pad(RctGstSource *source)
+{
+    GstPad *pad;
+
+    g_mutex_lock(&source->gop_lock);
+    pad = source->audio_pad ? GST_PAD(gst_object_ref(source->audio_pad)) : NULL;
+    g_mutex_unlock(&source->gop_lock);
+    return pad;
+}
+
+void rct_gst_source_set_gop_budget(RctGstSource *source, volatile gint *budget_used, gsize budget)
+{
+    rct_gst_source_clear_gop(source);
+    g_mutex_lock(&source->gop_lock);
+    source->budget_used = budget_used;
+    source->budget = budget;
+    g_mutex_unlock(&source->gop_lock);
+}
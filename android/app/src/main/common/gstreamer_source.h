@@ -0,0 +1,93 @@
+//
+//  gstreamer_source.h
+//
+//  Source front end of a player: rtspsrc ! depayloader ! identity for RTSP
+//  uris, the depayloader picked from the encoding-name of the first video
+//  pad, and uridecodebin ! identity for files and HTTP, the decodebin
+//  stopping at the demuxed stream so both feed the same parser. A front end
+//  is either active, linked to the player parser, or on standby: its session
+//  stays open and the access units since the last keyframe are cached so it
+//  can be promoted without waiting for a new keyframe. It only goes active
+//  once the parser takes the codec of its video pad.
+//
+
+#ifndef gstreamer_source_h
+#define gstreamer_source_h
+
+#include <gst/gst.h>
+#include "gstreamer_codec.h"
+
+typedef enum {
+    RCT_GST_SOURCE_STANDBY,
+    RCT_GST_SOURCE_ACTIVE
+} RctGstSourceMode;
+
+typedef struct _RctGstSource RctGstSource;
+
+// Called with the audio pad of an active front end, from a streaming thread or the activating one.
+// May be called twice for the same pad.
+typedef void (*RctGstSourceAudioPadFunc)(RctGstSource *source, GstPad *pad, gpointer user_data);
+
+// Called from a streaming thread once a video pad showed its codec, and from the activating thread when
+// the parser takes another codec. The front end stays on standby until the next activation then.
+typedef void (*RctGstSourceCodecFunc)(RctGstSource *source, RctGstCodec codec, gpointer user_data);
+
+struct _RctGstSource
+{
+    gchar *uri;
+    GstBin *bin;                        // Bin owning the elements, i.e. the player pipeline
+    GstElement *source, *depay;        // depay is NULL until the first RTP video pad, and for non-live uris
+    GstElement *output;                 // identity, linked to the parser while active
+    GstElement *depays[RCT_GST_CODEC_COUNT];   // Created on demand, kept for the sessions that follow
+    volatile gint codec;                // RctGstCodec of the video pad, UNKNOWN until one shows up
+    gint video_stream;                  // RTSP stream set up for video, -1 until select-stream picked one
+    gboolean live;                      // RTSP session, the other uris can seek
+    gulong probe_id;
+    volatile gint mode;                 // RctGstSourceMode, read by the streaming thread
+    gint64 last_used;                   // Monotonic µs, for LRU eviction
+
+    // GOP cache, filled on standby and replayed once on promotion
+    GMutex gop_lock;
+    GQueue gop;
+    gsize gop_bytes;
+    volatile gint *budget_used;         // Bytes cached by every front end sharing the budget
+    gsize budget;
+    gboolean replaying;                 // Only touched by the streaming thread
+
+    // Audio, only set up by the session when there is a handler
+    RctGstSourceAudioPadFunc audio_handler;
+    gpointer audio_handler_data;
+    GstPad *audio_pad;                  // Guarded by gop_lock
+
+    RctGstSourceCodecFunc codec_handler;
+    gpointer codec_handler_data;
+};
+
+// Creates the elements and adds them to bin, still in NULL state
+RctGstSource *rct_gst_source_new(GstBin *bin, const gchar *uri);
+void rct_gst_source_free(RctGstSource *source);
+
+// TRUE for the uris played through rtspsrc
+gboolean rct_gst_source_uri_is_live(const gchar *uri);
+
+// In NULL state, FALSE when uri needs a front end of the other kind
+gboolean rct_gst_source_set_uri(RctGstSource *source, const gchar *uri);
+
+// Brings the elements to the state of their bin
+void rct_gst_source_start(RctGstSource *source);
+
+// A front end whose codec downstream does not take stays on standby, TRUE when a codec handler was told
+gboolean rct_gst_source_activate(RctGstSource *source, GstElement *downstream);
+void rct_gst_source_deactivate(RctGstSource *source);
+
+// Before rct_gst_source_start, decides whether the audio stream is set up at all
+void rct_gst_source_set_audio_handler(RctGstSource *source, RctGstSourceAudioPadFunc handler, gpointer user_data);
+GstPad *rct_gst_source_get_audio_pad(RctGstSource *source);   // NULL until the session exposes one, unref when done
+
+// Without a handler, a codec the parser does not take is an error of the source element
+void rct_gst_source_set_codec_handler(RctGstSource *source, RctGstSourceCodecFunc handler, gpointer user_data);
+
+void rct_gst_source_set_gop_budget(RctGstSource *source, volatile gint *budget_used, gsize budget);
+void rct_gst_source_clear_gop(RctGstSource *source);
+
+#endif /* gstreamer_source_h */
@@ -0,0 +1,94 @@
+#include "gstreamer_standby_pool.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerStandbyPool"
+
+static void evict_over_capacity(RctGstStandbyPool *pool)
+{
+    while (g_queue_get_length(&pool->sources) > pool->capacity) {
+        RctGstSource *source = g_queue_pop_tail(&pool->sources);
+        LOGD("Evicting standby source %s", source->uri);
+        rct_gst_source_free(source);
+    }
+}
+
+static GList *find_uri(RctGstStandbyPool *pool, const gchar *uri)
+{
+    GList *item;
+
+    for (item = pool->sources.head; item != NULL; item = item->next) {
+        if (g_strcmp0(((RctGstSource *)item->data)->uri, uri) == 0) {
+            return item;
+        }
+    }
+    return NULL;
+}
+
+RctGstStandbyPool *rct_gst_standby_pool_new(guint capacity, gsize gop_budget)
+{
+    RctGstStandbyPool *pool = g_new0(RctGstStandbyPool, 1);
+    pool->capacity = capacity;
+    pool->gop_budget = gop_budget;
+    g_queue_init(&pool->sources);
+    return pool;
+}
+
+void rct_gst_standby_pool_free(RctGstStandbyPool *pool)
+{
+    if (!pool) {
+        return;
+    }
+    pool->capacity = 0;
+    evict_over_capacity(pool);
+    g_free(pool);
+}
+
+void rct_gst_standby_pool_configure(RctGstStandbyPool *pool, guint capacity, gsize gop_budget)
+{
+    GList *item;
+
+    LOGD("Standby pool: %u sources, %lu bytes of GOP cache", capacity, (unsigned long)gop_budget);
+    pool->capacity = capacity;
+    if (pool->gop_budget != gop_budget) {
+        pool->gop_budget = gop_budget;
+        for (item = pool->sources.head; item != NULL; item = item->next) {
+            rct_gst_source_set_gop_budget(item->data, &pool->gop_bytes, gop_budget);
+        }
+    }
+    evict_over_capacity(pool);
+}
+
+void rct_gst_standby_pool_put(RctGstStandbyPool *pool, RctGstSource *source)
+{
+    GList *existing = find_uri(pool, source->uri);
+
+    // A single session per uri, the newest one wins
+    if (existing) {
+        rct_gst_source_free(existing->data);
+        g_queue_delete_link(&pool->sources, existing);
+    }
+
+    rct_gst_source_deactivate(source);
+    rct_gst_source_set_gop_budget(source, &pool->gop_bytes, pool->gop_budget);
+    g_queue_push_head(&pool->sources, source);
+    evict_over_capacity(pool);
+}
+
+RctGstSource *rct_gst_standby_pool_take(RctGstStandbyPool *pool, const gchar *uri)
+{
+    GList *item = find_uri(pool, uri);
+    RctGstSource *source;
+
+    if (!item) {
+        return NULL;
+    }
+    source = item->data;
+    g_queue_delete_link(&pool->sources, item);
+    LOGD("Promoting standby source %s (%lu bytes cached)", uri, (unsigned long)source->gop_bytes);
+    return source;
+}
+
+gboolean rct_gst_standby_pool_contains(RctGstStandbyPool *pool, const gchar *uri)
+{
+    return find_uri(pool, uri) != NULL;
+}
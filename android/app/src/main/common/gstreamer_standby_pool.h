@@ -0,0 +1,33 @@
+//
+//  gstreamer_standby_pool.h
+//
+//  Warm standby front ends of a player. Each one keeps its RTSP session
+//  open and caches its latest GOP, so switching to its uri is a relink.
+//  Least recently used front ends are evicted first.
+//
+
+#ifndef gstreamer_standby_pool_h
+#define gstreamer_standby_pool_h
+
+#include <gst/gst.h>
+#include "gstreamer_source.h"
+
+typedef struct {
+    guint capacity;                     // Maximum number of standby front ends, 0 disables the pool
+    gsize gop_budget;                   // Bytes shared by every cached GOP, 0 for no limit
+    volatile gint gop_bytes;            // Bytes currently cached
+    GQueue sources;                     // Most recently used first
+} RctGstStandbyPool;
+
+RctGstStandbyPool *rct_gst_standby_pool_new(guint capacity, gsize gop_budget);
+void rct_gst_standby_pool_free(RctGstStandbyPool *pool);
+void rct_gst_standby_pool_configure(RctGstStandbyPool *pool, guint capacity, gsize gop_budget);
+
+// Hands a front end over to the pool, it is freed right away when the pool is disabled
+void rct_gst_standby_pool_put(RctGstStandbyPool *pool, RctGstSource *source);
+
+// Removes and returns the front end of uri, NULL when there is none
+RctGstSource *rct_gst_standby_pool_take(RctGstStandbyPool *pool, const gchar *uri);
+gboolean rct_gst_standby_pool_contains(RctGstStandbyPool *pool, const gchar *uri);
+
+#endif /* gstreamer_standby_pool_h */
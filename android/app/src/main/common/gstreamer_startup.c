@@ -0,0 +1,238 @@
+#include "gstreamer_startup.h"
+#include "gstreamer_autoplug.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerStartup"
+
+// Time the prewarm thread waits for GStreamer.init, and how often it looks
+#define INIT_TIMEOUT_US (60 * G_USEC_PER_SEC)
+#define INIT_POLL_US 5000
+
+// Time a player waits for a prewarm in progress rather than doing the same lookups next to it
+#define TEMPLATE_WAIT_US (2 * G_USEC_PER_SEC)
+
+#define DEFAULT_SINK "glimagesink"
+
+// Created once and dropped, class initialization runs on the first instance of a factory.
+// The rtpbin internals and UDP elements are only created by rtspsrc once it connects.
+static const gchar *prewarmed_factories[] = {
+    "rtspsrc", "rtpbin", "rtpsession", "rtpssrcdemux", "rtpjitterbuffer", "rtpptdemux", "udpsrc", "udpsink",
+    "rtph264depay", "h264parse", "queue", "capsfilter", "videoconvert", "videoscale", "identity"
+};
+
+static const gchar *phase_names[RCT_GST_STARTUP_PHASE_COUNT] = {
+    "library_loaded", "gst_initialized", "prewarmed", "player_created", "pipeline_built", "first_frame"
+};
+
+// Monotonic µs, 0 until reached
+static GMutex phase_lock;
+static gint64 phase_times[RCT_GST_STARTUP_PHASE_COUNT];
+
+// Pipeline template, guarded by template_lock
+static GMutex template_lock;
+static GCond template_built;
+static gboolean template_started;
+static gboolean template_ready;
+static GstElementFactory *parser_factory, *decoder_factory;
+static GstElement *spare_parser, *spare_decoder, *spare_sink;   // Floating until handed over
+
+static void log_timings(void)
+{
+    gint64 timings_us[RCT_GST_STARTUP_PHASE_COUNT];
+    GString *line = g_string_new("Startup:");
+    guint i;
+
+    rct_gst_startup_get_timings(timings_us);
+    for (i = 0; i < RCT_GST_STARTUP_PHASE_COUNT; i++) {
+        if (timings_us[i] >= 0) {
+            g_string_append_printf(line, " %s +%lld ms", phase_names[i], (long long)(timings_us[i] / 1000));
+        }
+    }
+    LOGI("%s", line->str);
+    g_string_free(line, TRUE);
+}
+
+void rct_gst_startup_mark(RctGstStartupPhase phase)
+{
+    gboolean first;
+
+    g_mutex_lock(&phase_lock);
+    first = phase_times[phase] == 0;
+    if (first) {
+        phase_times[phase] = g_get_monotonic_time();
+    }
+    g_mutex_unlock(&phase_lock);
+
+    if (first && phase == RCT_GST_STARTUP_FIRST_FRAME) {
+        log_timings();
+    }
+}
+
+void rct_gst_startup_get_timings(gint64 timings_us[RCT_GST_STARTUP_PHASE_COUNT])
+{
+    gint64 origin = G_MAXINT64;
+    guint i;
+
+    g_mutex_lock(&phase_lock);
+    for (i = 0; i < RCT_GST_STARTUP_PHASE_COUNT; i++) {
+        if (phase_times[i] != 0) {
+            origin = MIN(origin, phase_times[i]);
+        }
+    }
+    for (i = 0; i < RCT_GST_STARTUP_PHASE_COUNT; i++) {
+        timings_us[i] = phase_times[i] != 0 ? phase_times[i] - origin : -1;
+    }
+    g_mutex_unlock(&phase_lock);
+}
+
+const gchar *rct_gst_startup_phase_get_name(RctGstStartupPhase phase)
+{
+    return phase < RCT_GST_STARTUP_PHASE_COUNT ? phase_names[phase] : "unknown";
+}
+
+static void load_factory(const gchar *name)
+{
+    GstElementFactory *factory = gst_element_factory_find(name);
+    GstElement *element;
+
+    if (!factory) {
+        LOGD("%s is not in the plugin set", name);
+        return;
+    }
+    element = gst_element_factory_create(factory, NULL);
+    if (element) {
+        gst_object_unref(gst_object_ref_sink(element));
+    }
+    gst_object_unref(factory);
+}
+
+static void build_template(void)
+{
+    GstCaps *caps = gst_caps_new_empty_simple("video/x-h264");
+    GstElement *parser = gst_element_factory_make("h264parse", "parser");
+    GstElement *decoder = rct_gst_autoplug_make(GST_ELEMENT_FACTORY_TYPE_DECODER | GST_ELEMENT_FACTORY_TYPE_MEDIA_VIDEO,
+                                                caps, "decoder");
+    GstElement *sink = gst_element_factory_make(DEFAULT_SINK, "video_sink");
+
+    gst_caps_unref(caps);
+    g_mutex_lock(&template_lock);
+    if (parser && decoder) {
+        parser_factory = GST_ELEMENT_FACTORY(gst_object_ref(gst_element_get_factory(parser)));
+        decoder_factory = GST_ELEMENT_FACTORY(gst_object_ref(gst_element_get_factory(decoder)));
+        spare_parser = parser;
+        spare_decoder = decoder;
+        spare_sink = sink;
+        template_ready = TRUE;
+        LOGI("Pipeline template: %s ! %s ! %s", GST_OBJECT_NAME(parser_factory), GST_OBJECT_NAME(decoder_factory),
+             sink ? DEFAULT_SINK : "(no sink)");
+    } else {
+        LOGE("Pipeline template could not be built, players build their own chain");
+        if (parser) {
+            gst_object_unref(gst_object_ref_sink(parser));
+        }
+        if (decoder) {
+            gst_object_unref(gst_object_ref_sink(decoder));
+        }
+        if (sink) {
+            gst_object_unref(gst_object_ref_sink(sink));
+        }
+    }
+    template_started = template_ready;
+    g_cond_broadcast(&template_built);
+    g_mutex_unlock(&template_lock);
+}
+
+static gpointer prewarm(gpointer user_data)
+{
+    gint64 deadline = g_get_monotonic_time() + INIT_TIMEOUT_US;
+    gint64 started_at;
+    guint i;
+
+    while (!gst_is_initialized()) {
+        if (g_get_monotonic_time() > deadline) {
+            LOGE("GStreamer still not initialized, prewarm given up");
+            g_mutex_lock(&template_lock);
+            template_started = FALSE;
+            g_cond_broadcast(&template_built);
+            g_mutex_unlock(&template_lock);
+            return NULL;
+        }
+        g_usleep(INIT_POLL_US);
+    }
+    rct_gst_startup_mark(RCT_GST_STARTUP_GST_INITIALIZED);
+
+    started_at = g_get_monotonic_time();
+    for (i = 0; i < G_N_ELEMENTS(prewarmed_factories); i++) {
+        load_factory(prewarmed_factories[i]);
+    }
+    build_template();
+    rct_gst_startup_mark(RCT_GST_STARTUP_PREWARMED);
+    LOGI("Prewarm took %lld us", (long long)(g_get_monotonic_time() - started_at));
+    return NULL;
+}
+
+void rct_gst_startup_prewarm(void)
+{
+    GThread *thread;
+
+    g_mutex_lock(&template_lock);
+    if (template_started || template_ready) {
+        g_mutex_unlock(&template_lock);
+        return;
+    }
+    template_started = TRUE;
+    g_mutex_unlock(&template_lock);
+
+    thread = g_thread_new("rct-gst-prewarm", prewarm, NULL);
+    g_thread_unref(thread);
+}
+
+gboolean rct_gst_startup_clone_template(const gchar *sink_factory, GstElement **parser, GstElement **decoder,
+                                        GstElement **sink)
+{
+    gint64 deadline = g_get_monotonic_time() + TEMPLATE_WAIT_US;
+
+    sink_factory = sink_factory ? sink_factory : DEFAULT_SINK;
+    *parser = *decoder = *sink = NULL;
+
+    g_mutex_lock(&template_lock);
+    while (template_started && !template_ready && g_cond_wait_until(&template_built, &template_lock, deadline)) {
+    }
+    if (!template_ready) {
+        g_mutex_unlock(&template_lock);
+        return FALSE;
+    }
+    if (spare_parser) {
+        *parser = spare_parser;
+        *decoder = spare_decoder;
+        spare_parser = spare_decoder = NULL;
+    } else {
+        *parser = gst_element_factory_create(parser_factory, "parser");
+        *decoder = gst_element_factory_create(decoder_factory, "decoder");
+    }
+    if (spare_sink && g_strcmp0(sink_factory, DEFAULT_SINK) == 0) {
+        *sink = spare_sink;
+        spare_sink = NULL;
+    }
+    g_mutex_unlock(&template_lock);
+
+    if (!*sink) {
+        *sink = gst_element_factory_make(sink_factory, "video_sink");
+    }
+    if (*parser && *decoder && *sink) {
+        return TRUE;
+    }
+
+    LOGE("Pipeline template could not be cloned");
+    if (*parser) {
+        gst_object_unref(gst_object_ref_sink(*parser));
+    }
+    if (*decoder) {
+        gst_object_unref(gst_object_ref_sink(*decoder));
+    }
+    if (*sink) {
+        gst_object_unref(gst_object_ref_sink(*sink));
+    }
+    *parser = *decoder = *sink = NULL;
+    return FALSE;
+}
@@ -0,0 +1,45 @@
+//
+//  gstreamer_startup.h
+//
+//  Cold start of the process. Phases are timestamped the first time they
+//  are reached, from the library load to the first frame of the first
+//  player. The prewarm runs on a thread of its own as soon as GStreamer is
+//  initialized: it loads the factories a player needs, runs their class
+//  initialization and builds the pipeline template, a decode chain picked
+//  and created ahead of time that players clone instead of looking the
+//  registry up.
+//
+
+#ifndef gstreamer_startup_h
+#define gstreamer_startup_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_STARTUP_LIBRARY_LOADED,     // Native library loaded, origin of the other phases
+    RCT_GST_STARTUP_GST_INITIALIZED,    // gst_init done
+    RCT_GST_STARTUP_PREWARMED,          // Factories loaded and template built
+    RCT_GST_STARTUP_PLAYER_CREATED,     // First player created
+    RCT_GST_STARTUP_PIPELINE_BUILT,     // First pipeline built
+    RCT_GST_STARTUP_FIRST_FRAME,        // First frame of the first player reached its sink
+    RCT_GST_STARTUP_PHASE_COUNT
+} RctGstStartupPhase;
+
+// Only the first call of every phase counts, any thread
+void rct_gst_startup_mark(RctGstStartupPhase phase);
+
+// µs since the earliest phase reached, -1 for the phases not reached yet
+void rct_gst_startup_get_timings(gint64 timings_us[RCT_GST_STARTUP_PHASE_COUNT]);
+const gchar *rct_gst_startup_phase_get_name(RctGstStartupPhase phase);
+
+// Starts the prewarm thread, which waits for gst_init. Only the first call does anything.
+void rct_gst_startup_prewarm(void);
+
+// Parser, decoder and sink of the default chain, named as player_init names them. The prebuilt ones go
+// to the first caller, the next ones are created from the factories the template picked. Waits for a
+// prewarm in progress. FALSE without a template or when an element could not be created, nothing is
+// returned then.
+gboolean rct_gst_startup_clone_template(const gchar *sink_factory, GstElement **parser, GstElement **decoder,
+                                        GstElement **sink);
+
+#endif /* gstreamer_startup_h */
@@ -0,0 +1,282 @@
+#include "gstreamer_stats.h"
+#include "gstreamer_jitter.h"
+#include <string.h>
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerStats"
+
+// Frames in flight between two points stay well below this, queues included
+#define MARKS 64
+
+typedef enum {
+    POINT_PARSER_IN,
+    POINT_DECODER_IN,
+    POINT_DECODER_OUT,
+    POINT_SINK_IN,
+    POINT_COUNT
+} RctGstStatsPointType;
+
+typedef struct {
+    GstClockTime pts;
+    gint64 at;                          // Monotonic µs
+} RctGstStatsMark;
+
+typedef struct {
+    RctGstStatsCollector *collector;
+    RctGstStatsPointType type;
+    GstPad *pad;
+    gulong probe_id;
+    RctGstStatsMark marks[MARKS];       // Latest buffers seen here, looked up by the next point
+    guint next_mark;
+} RctGstStatsPoint;
+
+struct _RctGstStatsCollector
+{
+    GMutex lock;
+    RctGstStats stats;
+    RctGstStatsPoint points[POINT_COUNT];
+    gboolean attached;
+
+    // Bitrate window
+    guint64 bytes;
+    gint64 window_started_at;
+};
+
+static void record_latency(RctGstLatencyHistogram *histogram, gint64 latency_us)
+{
+    guint bucket = 0;
+    gint64 bound = RCT_GST_STATS_FIRST_BUCKET_US;
+
+    while (bucket < RCT_GST_STATS_BUCKETS - 1 && latency_us >= bound) {
+        bucket++;
+        bound <<= 1;
+    }
+    histogram->buckets[bucket]++;
+    histogram->count++;
+    histogram->sum_us += latency_us;
+    histogram->max_us = MAX(histogram->max_us, latency_us);
+}
+
+// Called with the lock held
+static gboolean take_mark(RctGstStatsPoint *point, GstClockTime pts, gint64 *at)
+{
+    guint i;
+
+    for (i = 0; i < MARKS; i++) {
+        if (point->marks[i].pts == pts) {
+            *at = point->marks[i].at;
+            point->marks[i].pts = GST_CLOCK_TIME_NONE;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+static GstPadProbeReturn cb_stats_point(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    RctGstStatsPoint *point = (RctGstStatsPoint *)user_data;
+    RctGstStatsCollector *collector = point->collector;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstClockTime pts = GST_BUFFER_PTS(buffer);
+    GstClockTime running_time = GST_CLOCK_TIME_NONE;
+    gint64 now = g_get_monotonic_time();
+    gint64 previous_at;
+
+    if (point->type == POINT_PARSER_IN) {
+        running_time = gst_element_get_current_running_time(GST_PAD_PARENT(pad));
+    }
+
+    g_mutex_lock(&collector->lock);
+    switch (point->type) {
+        case POINT_PARSER_IN:
+            collector->bytes += gst_buffer_get_size(buffer);
+            // With no rtspsrc latency the PTS maps to when the first packet was received
+            if (GST_CLOCK_TIME_IS_VALID(pts) && GST_CLOCK_TIME_IS_VALID(running_time) && running_time >= pts) {
+                record_latency(&collector->stats.stages[RCT_GST_STAGE_NETWORK], (gint64)(running_time - pts) / 1000);
+            }
+            break;
+
+        case POINT_DECODER_OUT:
+            collector->stats.frames_decoded++;
+            break;
+
+        case POINT_SINK_IN:
+            collector->stats.frames_rendered++;
+            break;
+
+        default:
+            break;
+    }
+
+    if (GST_CLOCK_TIME_IS_VALID(pts)) {
+        if (point->type > POINT_PARSER_IN && take_mark(&collector->points[point->type - 1], pts, &previous_at)) {
+            record_latency(&collector->stats.stages[point->type], now - previous_at);
+        }
+        if (point->type < POINT_SINK_IN) {
+            point->marks[point->next_mark].pts = pts;
+            point->marks[point->next_mark].at = now;
+            point->next_mark = (point->next_mark + 1) % MARKS;
+        }
+    }
+    g_mutex_unlock(&collector->lock);
+    return GST_PAD_PROBE_OK;
+}
+
+static void attach_point(RctGstStatsCollector *collector, RctGstStatsPointType type, GstElement *element, const gchar *pad_name)
+{
+    RctGstStatsPoint *point = &collector->points[type];
+    guint i;
+
+    point->collector = collector;
+    point->type = type;
+    point->next_mark = 0;
+    for (i = 0; i < MARKS; i++) {
+        point->marks[i].pts = GST_CLOCK_TIME_NONE;
+    }
+    point->pad = gst_element_get_static_pad(element, pad_name);
+    point->probe_id = gst_pad_add_probe(point->pad, GST_PAD_PROBE_TYPE_BUFFER, cb_stats_point, point, NULL);
+}
+
+typedef struct {
+    guint64 lost;
+    guint64 jitter_ns;
+    guint count;
+    guint latency_ms;
+    gboolean retransmission;
+} RctGstJitterbufferTotals;
+
+static void add_jitterbuffer(GstElement *jitterbuffer, gpointer user_data)
+{
+    RctGstJitterbufferTotals *totals = (RctGstJitterbufferTotals *)user_data;
+    GstStructure *structure = NULL;
+    guint64 value;
+
+    g_object_get(G_OBJECT(jitterbuffer), "stats", &structure,
+                 "latency", &totals->latency_ms, "do-retransmission", &totals->retransmission, NULL);
+    if (structure) {
+        if (gst_structure_get_uint64(structure, "num-lost", &value)) {
+            totals->lost += value;
+        }
+        if (gst_structure_get_uint64(structure, "avg-jitter", &value)) {
+            totals->jitter_ns += value;
+            totals->count++;
+        }
+        gst_structure_free(structure);
+    }
+}
+
+// Sums the loss of every rtpjitterbuffer of the session and averages their jitter
+static void read_jitterbuffers(GstElement *source, RctGstJitterbufferTotals *totals)
+{
+    memset(totals, 0, sizeof(*totals));
+    rct_gst_jitter_foreach_buffer(source, add_jitterbuffer, totals);
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstStatsCollector *rct_gst_stats_new(void)
+{
+    RctGstStatsCollector *collector = g_new0(RctGstStatsCollector, 1);
+    g_mutex_init(&collector->lock);
+    return collector;
+}
+
+void rct_gst_stats_free(RctGstStatsCollector *collector)
+{
+    if (!collector) {
+        return;
+    }
+    rct_gst_stats_detach(collector);
+    g_mutex_clear(&collector->lock);
+    g_free(collector);
+}
+
+void rct_gst_stats_attach(RctGstStatsCollector *collector, GstElement *parser, GstElement *decoder, GstElement *sink)
+{
+    if (collector->attached) {
+        return;
+    }
+
+    g_mutex_lock(&collector->lock);
+    memset(&collector->stats, 0, sizeof(collector->stats));
+    collector->bytes = 0;
+    collector->window_started_at = g_get_monotonic_time();
+    g_mutex_unlock(&collector->lock);
+
+    attach_point(collector, POINT_PARSER_IN, parser, "sink");
+    attach_point(collector, POINT_DECODER_IN, decoder, "sink");
+    attach_point(collector, POINT_DECODER_OUT, decoder, "src");
+    attach_point(collector, POINT_SINK_IN, sink, "sink");
+    collector->attached = TRUE;
+    LOGD("Statistics enabled");
+}
+
+void rct_gst_stats_detach(RctGstStatsCollector *collector)
+{
+    guint i;
+
+    if (!collector->attached) {
+        return;
+    }
+    for (i = 0; i < POINT_COUNT; i++) {
+        gst_pad_remove_probe(collector->points[i].pad, collector->points[i].probe_id);
+        gst_object_unref(collector->points[i].pad);
+        collector->points[i].pad = NULL;
+    }
+    collector->attached = FALSE;
+    LOGD("Statistics disabled");
+}
+
+gboolean rct_gst_stats_is_attached(RctGstStatsCollector *collector)
+{
+    return collector->attached;
+}
+
+void rct_gst_stats_on_qos(RctGstStatsCollector *collector, GstMessage *message)
+{
+    gint64 jitter = 0;
+
+    if (!collector->attached) {
+        return;
+    }
+
+    // Decoders and sinks post one message per frame they drop for QoS reasons
+    gst_message_parse_qos_values(message, &jitter, NULL, NULL);
+
+    g_mutex_lock(&collector->lock);
+    collector->stats.frames_dropped++;
+    if (jitter > 0 && GST_MESSAGE_SRC(message) == GST_OBJECT(GST_PAD_PARENT(collector->points[POINT_SINK_IN].pad))) {
+        collector->stats.frames_late++;
+    }
+    g_mutex_unlock(&collector->lock);
+}
+
+void rct_gst_stats_poll(RctGstStatsCollector *collector, GstElement *source, RctGstStats *stats)
+{
+    gint64 now = g_get_monotonic_time();
+    RctGstJitterbufferTotals totals;
+
+    // Outside the lock, the jitterbuffers have locks of their own
+    read_jitterbuffers(source, &totals);
+
+    g_mutex_lock(&collector->lock);
+    collector->stats.packets_lost = totals.lost;
+    collector->stats.jitter_ms = totals.count ? (gdouble)totals.jitter_ns / totals.count / 1000000.0 : 0;
+    collector->stats.latency_ms = totals.latency_ms;
+    collector->stats.retransmission = totals.retransmission;
+    if (now > collector->window_started_at) {
+        collector->stats.bitrate = collector->bytes * 8 * G_USEC_PER_SEC / (guint64)(now - collector->window_started_at);
+    }
+    collector->bytes = 0;
+    collector->window_started_at = now;
+    *stats = collector->stats;
+    g_mutex_unlock(&collector->lock);
+}
+
+void rct_gst_stats_get(RctGstStatsCollector *collector, RctGstStats *stats)
+{
+    g_mutex_lock(&collector->lock);
+    *stats = collector->stats;
+    g_mutex_unlock(&collector->lock);
+}
@@ -0,0 +1,64 @@
+//
+//  gstreamer_stats.h
+//
+//  Stream statistics of a player. Pad probes timestamp every access unit
+//  on the element boundaries and match them by PTS, giving per stage
+//  latency histograms. Probes only exist while statistics are enabled.
+//
+
+#ifndef gstreamer_stats_h
+#define gstreamer_stats_h
+
+#include <gst/gst.h>
+
+// Bucket i counts latencies below 250 µs << i, the last one is open ended
+#define RCT_GST_STATS_BUCKETS 12
+#define RCT_GST_STATS_FIRST_BUCKET_US 250
+
+typedef enum {
+    RCT_GST_STAGE_NETWORK,              // RTP timestamp to parser input: jitterbuffer and depayloading
+    RCT_GST_STAGE_DEPAY,                // Parser input to decoder input: parsing and the decode queue
+    RCT_GST_STAGE_DECODE,               // Decoder input to decoder output
+    RCT_GST_STAGE_RENDER,               // Decoder output to sink input: scaling, render queue and conversion
+    RCT_GST_STAGE_COUNT
+} RctGstStage;
+
+typedef struct {
+    guint64 count;
+    gint64 sum_us;
+    gint64 max_us;
+    guint64 buckets[RCT_GST_STATS_BUCKETS];
+} RctGstLatencyHistogram;
+
+typedef struct {
+    RctGstLatencyHistogram stages[RCT_GST_STAGE_COUNT];
+    guint64 frames_decoded;
+    guint64 frames_rendered;
+    guint64 frames_dropped;             // QoS drops reported by the decoder and the sink
+    guint64 frames_late;                // Part of the drops due to frames reaching the sink late
+    guint64 bitrate;                    // Bits per second of the compressed stream, over the last poll period
+    guint64 packets_lost;               // rtpjitterbuffer counters of the current session
+    gdouble jitter_ms;
+    guint latency_ms;                   // Jitterbuffer latency actually in use
+    gboolean retransmission;
+} RctGstStats;
+
+typedef struct _RctGstStatsCollector RctGstStatsCollector;
+
+RctGstStatsCollector *rct_gst_stats_new(void);
+void rct_gst_stats_free(RctGstStatsCollector *collector);
+
+// Installs the probes, counters start from zero
+void rct_gst_stats_attach(RctGstStatsCollector *collector, GstElement *parser, GstElement *decoder, GstElement *sink);
+void rct_gst_stats_detach(RctGstStatsCollector *collector);
+gboolean rct_gst_stats_is_attached(RctGstStatsCollector *collector);
+
+void rct_gst_stats_on_qos(RctGstStatsCollector *collector, GstMessage *message);
+
+// Closes the bitrate window, reads the jitterbuffers found inside source and returns a snapshot
+void rct_gst_stats_poll(RctGstStatsCollector *collector, GstElement *source, RctGstStats *stats);
+
+// Any thread
+void rct_gst_stats_get(RctGstStatsCollector *collector, RctGstStats *stats);
+
+#endif /* gstreamer_stats_h */
@@ -0,0 +1,375 @@
+#include "gstreamer_transport.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerTransport"
+
+// GstRTSPLowerTrans flags, the rtsp library is not linked for these four values
+#define LOWER_TRANS_UDP 0x01
+#define LOWER_TRANS_UDP_MCAST 0x02
+#define LOWER_TRANS_TCP 0x04
+#define LOWER_TRANS_HTTP 0x10
+
+static const gchar *transport_names[RCT_GST_TRANSPORT_COUNT] = { "udp", "multicast", "tcp", "http" };
+
+struct _RctGstTransportSelector
+{
+    GMainContext *context;
+    RctGstTransportFallbackFunc fallback;
+    gpointer user_data;
+
+    // Policy
+    RctGstTransport order[RCT_GST_TRANSPORT_COUNT];
+    guint count;
+    guint timeout_ms;
+    gboolean remember;
+
+    // Player thread only
+    gchar *uri;                         // Uri the position in order belongs to
+    gchar *host;
+    guint position;
+    gboolean attempt_pending;
+    GSource *timeout_source;
+    GSource *fallback_source;
+
+    // Guarded by lock, read from any thread
+    GMutex lock;
+    RctGstTransport current;
+    RctGstTransportStats stats[RCT_GST_TRANSPORT_COUNT];
+};
+
+/*****************
+ KNOWN TRANSPORTS
+ ****************/
+// Host to the last transport that worked, shared by every player
+static GMutex known_lock;
+static GHashTable *known_transports;
+
+static gboolean lookup_known(const gchar *host, RctGstTransport *transport)
+{
+    gpointer value = NULL;
+
+    g_mutex_lock(&known_lock);
+    if (known_transports && host) {
+        value = g_hash_table_lookup(known_transports, host);
+    }
+    g_mutex_unlock(&known_lock);
+    if (!value) {
+        return FALSE;
+    }
+    *transport = (RctGstTransport)(GPOINTER_TO_INT(value) - 1);
+    return TRUE;
+}
+
+static void remember_known(const gchar *host, RctGstTransport transport)
+{
+    if (!host) {
+        return;
+    }
+    g_mutex_lock(&known_lock);
+    if (!known_transports) {
+        known_transports = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    }
+    g_hash_table_replace(known_transports, g_strdup(host), GINT_TO_POINTER(transport + 1));
+    g_mutex_unlock(&known_lock);
+}
+
+static void forget_known(const gchar *host, RctGstTransport transport)
+{
+    RctGstTransport known;
+
+    if (lookup_known(host, &known) && known == transport) {
+        g_mutex_lock(&known_lock);
+        g_hash_table_remove(known_transports, host);
+        g_mutex_unlock(&known_lock);
+    }
+}
+
+static gchar *host_of(const gchar *uri)
+{
+    GstUri *parsed = uri ? gst_uri_from_string(uri) : NULL;
+    gchar *host;
+
+    if (!parsed) {
+        return NULL;
+    }
+    host = g_strdup(gst_uri_get_host(parsed));
+    gst_uri_unref(parsed);
+    return host;
+}
+
+/********
+ ATTEMPTS
+ *******/
+static void stop_source(GSource **source)
+{
+    if (*source) {
+        g_source_destroy(*source);
+        g_source_unref(*source);
+        *source = NULL;
+    }
+}
+
+static gboolean cb_fallback(gpointer user_data)
+{
+    RctGstTransportSelector *selector = (RctGstTransportSelector *)user_data;
+    RctGstTransport transport = rct_gst_transport_get_current(selector);
+
+    g_source_unref(selector->fallback_source);
+    selector->fallback_source = NULL;
+    LOGI("Falling back to %s for %s", transport_names[transport], selector->uri);
+    selector->fallback(transport, selector->user_data);
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean cb_attempt_timeout(gpointer user_data)
+{
+    RctGstTransportSelector *selector = (RctGstTransportSelector *)user_data;
+
+    g_source_unref(selector->timeout_source);
+    selector->timeout_source = NULL;
+    LOGI("No frame over %s within %u ms", transport_names[rct_gst_transport_get_current(selector)], selector->timeout_ms);
+    rct_gst_transport_failed(selector);
+    return G_SOURCE_REMOVE;
+}
+
+static guint find_position(RctGstTransportSelector *selector, RctGstTransport transport)
+{
+    guint i;
+
+    for (i = 0; i < selector->count; i++) {
+        if (selector->order[i] == transport) {
+            return i;
+        }
+    }
+    return 0;
+}
+
+// Where uri starts from, or where its sessions got to
+static guint position_for(RctGstTransportSelector *selector, const gchar *uri)
+{
+    RctGstTransport known;
+    gchar *host;
+    guint position = 0;
+
+    if (g_strcmp0(uri, selector->uri) == 0) {
+        return selector->position;
+    }
+    host = host_of(uri);
+    if (selector->remember && lookup_known(host, &known)) {
+        position = find_position(selector, known);
+    }
+    g_free(host);
+    return position;
+}
+
+static void set_current(RctGstTransportSelector *selector, guint position)
+{
+    selector->position = position;
+    g_mutex_lock(&selector->lock);
+    selector->current = selector->order[position];
+    g_mutex_unlock(&selector->lock);
+}
+
+/**********
+ PUBLIC API
+ *********/
+RctGstTransportSelector *rct_gst_transport_selector_new(GMainContext *context, RctGstTransportFallbackFunc fallback,
+                                                        gpointer user_data)
+{
+    RctGstTransportSelector *selector = g_new0(RctGstTransportSelector, 1);
+    selector->context = context;
+    selector->fallback = fallback;
+    selector->user_data = user_data;
+    g_mutex_init(&selector->lock);
+    rct_gst_transport_configure(selector, "udp,tcp", 3000, TRUE);
+    return selector;
+}
+
+void rct_gst_transport_selector_free(RctGstTransportSelector *selector)
+{
+    if (!selector) {
+        return;
+    }
+    stop_source(&selector->timeout_source);
+    stop_source(&selector->fallback_source);
+    g_mutex_clear(&selector->lock);
+    g_free(selector->uri);
+    g_free(selector->host);
+    g_free(selector);
+}
+
+void rct_gst_transport_configure(RctGstTransportSelector *selector, const gchar *order, guint timeout_ms,
+                                 gboolean remember)
+{
+    gchar **names = g_strsplit(order ? order : "", ",", -1);
+    gboolean seen[RCT_GST_TRANSPORT_COUNT] = { FALSE };
+    guint i, t;
+
+    selector->count = 0;
+    for (i = 0; names[i]; i++) {
+        g_strstrip(names[i]);
+        for (t = 0; t < RCT_GST_TRANSPORT_COUNT; t++) {
+            if (!seen[t] && g_ascii_strcasecmp(names[i], transport_names[t]) == 0) {
+                selector->order[selector->count++] = (RctGstTransport)t;
+                seen[t] = TRUE;
+            }
+        }
+    }
+    g_strfreev(names);
+    // Nothing usable, back to what rtspsrc tries on its own
+    if (selector->count == 0) {
+        LOGE("No known transport in \"%s\", using udp then tcp", order ? order : "");
+        selector->order[selector->count++] = RCT_GST_TRANSPORT_UDP;
+        selector->order[selector->count++] = RCT_GST_TRANSPORT_TCP;
+    }
+
+    selector->timeout_ms = timeout_ms;
+    selector->remember = remember;
+    g_free(selector->uri);
+    selector->uri = NULL;                   // Next session starts over
+    set_current(selector, 0);
+}
+
+RctGstTransport rct_gst_transport_apply(RctGstTransportSelector *selector, const gchar *uri, GstElement *rtspsrc)
+{
+    RctGstTransport transport = selector->order[position_for(selector, uri)];
+    guint protocols;
+
+    switch (transport) {
+        case RCT_GST_TRANSPORT_MULTICAST: protocols = LOWER_TRANS_UDP_MCAST; break;
+        case RCT_GST_TRANSPORT_TCP: protocols = LOWER_TRANS_TCP; break;
+        case RCT_GST_TRANSPORT_HTTP: protocols = LOWER_TRANS_HTTP | LOWER_TRANS_TCP; break;
+        default: protocols = LOWER_TRANS_UDP; break;
+    }
+    LOGD("Opening %s over %s", uri, transport_names[transport]);
+    g_object_set(G_OBJECT(rtspsrc), "protocols", protocols, NULL);
+    if (selector->timeout_ms > 0) {
+        // Without tcp in protocols rtspsrc errors out on its UDP timeout instead of retrying over TCP itself
+        g_object_set(G_OBJECT(rtspsrc),
+                     "timeout", (guint64)selector->timeout_ms * 1000,
+                     "tcp-timeout", (guint64)selector->timeout_ms * 1000,
+                     NULL);
+    }
+    return transport;
+}
+
+void rct_gst_transport_attempt_started(RctGstTransportSelector *selector, const gchar *uri)
+{
+    guint position = position_for(selector, uri);
+
+    stop_source(&selector->timeout_source);
+    if (g_strcmp0(uri, selector->uri) != 0) {
+        g_free(selector->uri);
+        g_free(selector->host);
+        selector->uri = g_strdup(uri);
+        selector->host = host_of(uri);
+    }
+    set_current(selector, position);
+    selector->attempt_pending = TRUE;
+
+    g_mutex_lock(&selector->lock);
+    selector->stats[selector->current].attempts++;
+    g_mutex_unlock(&selector->lock);
+
+    if (selector->timeout_ms > 0 && selector->count > 1) {
+        selector->timeout_source = g_timeout_source_new(selector->timeout_ms);
+        g_source_set_callback(selector->timeout_source, cb_attempt_timeout, selector, NULL);
+        g_source_attach(selector->timeout_source, selector->context);
+    }
+}
+
+void rct_gst_transport_attempt_cancelled(RctGstTransportSelector *selector)
+{
+    stop_source(&selector->timeout_source);
+    stop_source(&selector->fallback_source);
+    selector->attempt_pending = FALSE;
+}
+
+void rct_gst_transport_first_frame(RctGstTransportSelector *selector, gint64 ttff_us)
+{
+    RctGstTransportStats *stats;
+
+    if (!selector->attempt_pending) {
+        return;
+    }
+    stop_source(&selector->timeout_source);
+    selector->attempt_pending = FALSE;
+
+    g_mutex_lock(&selector->lock);
+    stats = &selector->stats[selector->current];
+    stats->successes++;
+    stats->last_ttff_us = ttff_us;
+    stats->best_ttff_us = stats->best_ttff_us ? MIN(stats->best_ttff_us, ttff_us) : ttff_us;
+    stats->total_ttff_us += ttff_us;
+    g_mutex_unlock(&selector->lock);
+
+    if (selector->remember) {
+        remember_known(selector->host, selector->current);
+    }
+}
+
+gboolean rct_gst_transport_failed(RctGstTransportSelector *selector)
+{
+    RctGstTransport failed = selector->current;
+
+    if (!selector->attempt_pending) {
+        return FALSE;
+    }
+    stop_source(&selector->timeout_source);
+    selector->attempt_pending = FALSE;
+
+    g_mutex_lock(&selector->lock);
+    selector->stats[failed].failures++;
+    g_mutex_unlock(&selector->lock);
+    forget_known(selector->host, failed);
+
+    // Every transport failed in a row: back to the first one, at the reconnect engine pace
+    if (selector->position + 1 >= selector->count) {
+        LOGE("No transport worked for %s", selector->uri);
+        set_current(selector, 0);
+        return FALSE;
+    }
+    set_current(selector, selector->position + 1);
+
+    // Not from inside the failing session callbacks
+    stop_source(&selector->fallback_source);
+    selector->fallback_source = g_idle_source_new();
+    g_source_set_callback(selector->fallback_source, cb_fallback, selector, NULL);
+    g_source_attach(selector->fallback_source, selector->context);
+    return TRUE;
+}
+
+RctGstTransport rct_gst_transport_get_current(RctGstTransportSelector *selector)
+{
+    RctGstTransport transport;
+
+    g_mutex_lock(&selector->lock);
+    transport = selector->current;
+    g_mutex_unlock(&selector->lock);
+    return transport;
+}
+
+void rct_gst_transport_get_stats(RctGstTransportSelector *selector, RctGstTransportStats stats[RCT_GST_TRANSPORT_COUNT])
+{
+    guint i;
+
+    g_mutex_lock(&selector->lock);
+    for (i = 0; i < RCT_GST_TRANSPORT_COUNT; i++) {
+        stats[i] = selector->stats[i];
+    }
+    g_mutex_unlock(&selector->lock);
+}
+
+const gchar *rct_gst_transport_get_name(RctGstTransport transport)
+{
+    return transport < RCT_GST_TRANSPORT_COUNT ? transport_names[transport] : "unknown";
+}
+
+void rct_gst_transport_forget_all(void)
+{
+    g_mutex_lock(&known_lock);
+    if (known_transports) {
+        g_hash_table_remove_all(known_transports);
+    }
+    g_mutex_unlock(&known_lock);
+}
@@ -0,0 +1,67 @@
+//
+//  gstreamer_transport.h
+//
+//  RTSP transport selection of a player. Every session is opened with a
+//  single lower transport, tried in the preferred order: one that gets no
+//  frame through within its timeout, or that the server refuses, hands over
+//  to the next one right away instead of waiting out rtspsrc's own UDP
+//  timeout. The transport that worked last is remembered per host, for
+//  every player of the process, and tried first next time.
+//
+
+#ifndef gstreamer_transport_h
+#define gstreamer_transport_h
+
+#include <gst/gst.h>
+
+typedef enum {
+    RCT_GST_TRANSPORT_UDP,
+    RCT_GST_TRANSPORT_MULTICAST,        // One stream shared by every viewer of the group
+    RCT_GST_TRANSPORT_TCP,              // Interleaved in the RTSP connection
+    RCT_GST_TRANSPORT_HTTP,             // RTSP over HTTP tunnelling
+    RCT_GST_TRANSPORT_COUNT
+} RctGstTransport;
+
+typedef struct {
+    guint attempts;
+    guint successes;                    // Attempts that got a first frame
+    guint failures;                     // Timed out or refused
+    gint64 last_ttff_us;                // Time to first frame, from the start of the attempt
+    gint64 best_ttff_us;
+    gint64 total_ttff_us;               // Over every success, for averages
+} RctGstTransportStats;
+
+typedef struct _RctGstTransportSelector RctGstTransportSelector;
+
+// Called on the context thread once the selector moved to the next transport
+typedef void (*RctGstTransportFallbackFunc)(RctGstTransport transport, gpointer user_data);
+
+RctGstTransportSelector *rct_gst_transport_selector_new(GMainContext *context, RctGstTransportFallbackFunc fallback,
+                                                        gpointer user_data);
+void rct_gst_transport_selector_free(RctGstTransportSelector *selector);
+
+// order is comma separated ("udp,tcp"), unknown names are skipped. timeout_ms is per transport.
+void rct_gst_transport_configure(RctGstTransportSelector *selector, const gchar *order, guint timeout_ms,
+                                 gboolean remember);
+
+// Sets the transport uri is at on an rtspsrc that has not started yet. Uris other than the one of the
+// last attempt start from their remembered transport, or the first one.
+RctGstTransport rct_gst_transport_apply(RctGstTransportSelector *selector, const gchar *uri, GstElement *rtspsrc);
+
+// An attempt runs from the start of a session until its first frame or its timeout
+void rct_gst_transport_attempt_started(RctGstTransportSelector *selector, const gchar *uri);
+void rct_gst_transport_attempt_cancelled(RctGstTransportSelector *selector);
+void rct_gst_transport_first_frame(RctGstTransportSelector *selector, gint64 ttff_us);
+
+// Session error, TRUE when it was the attempt failing and the fallback has been scheduled
+gboolean rct_gst_transport_failed(RctGstTransportSelector *selector);
+
+// Any thread
+RctGstTransport rct_gst_transport_get_current(RctGstTransportSelector *selector);
+void rct_gst_transport_get_stats(RctGstTransportSelector *selector, RctGstTransportStats stats[RCT_GST_TRANSPORT_COUNT]);
+const gchar *rct_gst_transport_get_name(RctGstTransport transport);
+
+// Process wide memory of the last transport that worked per host
+void rct_gst_transport_forget_all(void);
+
+#endif /* gstreamer_transport_h */
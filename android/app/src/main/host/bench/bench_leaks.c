@@ -0,0 +1,163 @@
+#include "bench_leaks.h"
+#include "bench_report.h"
+#include <string.h>
+#include <unistd.h>
+#include <gst/gst.h>
+
+typedef struct {
+    const gchar *name;
+    gint64 growth;
+} TypeGrowth;
+
+static gboolean has_word(const gchar *variable, const gchar *word)
+{
+    const gchar *value = g_getenv(variable);
+
+    return value && strstr(value, word) != NULL;
+}
+
+void bench_leaks_enable(gchar **argv)
+{
+    if (has_word("GOBJECT_DEBUG", "instance-count") && has_word("GST_TRACERS", "leaks")) {
+        return;
+    }
+    // Whatever was already asked for is kept, GStreamer takes tracers separated by ;
+    if (!has_word("GOBJECT_DEBUG", "instance-count")) {
+        gchar *value = g_strjoin(",", "instance-count", g_getenv("GOBJECT_DEBUG"), NULL);
+        g_setenv("GOBJECT_DEBUG", value, TRUE);
+        g_free(value);
+    }
+    if (!has_word("GST_TRACERS", "leaks")) {
+        gchar *value = g_strjoin(";", "leaks", g_getenv("GST_TRACERS"), NULL);
+        g_setenv("GST_TRACERS", value, TRUE);
+        g_free(value);
+    }
+    execv("/proc/self/exe", argv);
+    g_printerr("Could not restart with object counting, the soak only follows RSS\n");
+}
+
+static void count_instances(GType type, BenchLeakSample *sample)
+{
+    gint count = g_type_get_instance_count(type);
+    GType *children;
+    guint n_children, i;
+
+    if (count > 0) {
+        sample->objects += count;
+        g_hash_table_insert(sample->types, (gpointer)g_type_name(type), GINT_TO_POINTER(count));
+    }
+    children = g_type_children(type, &n_children);
+    for (i = 0; i < n_children; i++) {
+        count_instances(children[i], sample);
+    }
+    g_free(children);
+}
+
+static GstTracer *find_leaks_tracer(void)
+{
+    GList *tracers = gst_tracing_get_active_tracers();
+    GstTracer *found = NULL;
+    GList *l;
+
+    for (l = tracers; l; l = l->next) {
+        if (!found && g_strcmp0(G_OBJECT_TYPE_NAME(l->data), "GstLeaksTracer") == 0) {
+            found = gst_object_ref(l->data);
+        }
+    }
+    g_list_free_full(tracers, gst_object_unref);
+    return found;
+}
+
+// GObjects are left to count_instances, the tracer only adds the mini objects
+static void count_mini_objects(BenchLeakSample *sample)
+{
+    GstTracer *tracer = find_leaks_tracer();
+    GstStructure *live = NULL;
+    const GValue *list;
+    guint i;
+
+    if (!tracer) {
+        return;
+    }
+    g_signal_emit_by_name(tracer, "get-live-objects", &live);
+    gst_object_unref(tracer);
+    if (!live) {
+        return;
+    }
+
+    sample->buffers = sample->caps = 0;
+    list = gst_structure_get_value(live, "live-objects-list");
+    for (i = 0; list && i < gst_value_list_get_size(list); i++) {
+        const GstStructure *info = gst_value_get_structure(gst_value_list_get_value(list, i));
+        const GValue *object = gst_structure_get_value(info, "object");
+        const gchar *name;
+
+        if (!object || G_VALUE_HOLDS_OBJECT(object)) {
+            continue;
+        }
+        if (G_VALUE_HOLDS(object, GST_TYPE_BUFFER)) {
+            sample->buffers++;
+        } else if (G_VALUE_HOLDS(object, GST_TYPE_CAPS)) {
+            sample->caps++;
+        }
+        name = g_type_name(G_VALUE_TYPE(object));
+        g_hash_table_insert(sample->types, (gpointer)name,
+                            GINT_TO_POINTER(GPOINTER_TO_INT(g_hash_table_lookup(sample->types, name)) + 1));
+    }
+    gst_structure_free(live);
+}
+
+void bench_leaks_sample(BenchLeakSample *sample)
+{
+    sample->rss_kb = bench_rss_kb();
+    sample->objects = sample->buffers = sample->caps = -1;
+    sample->types = g_hash_table_new(g_str_hash, g_str_equal);
+
+    if (has_word("GOBJECT_DEBUG", "instance-count")) {
+        sample->objects = 0;
+        count_instances(G_TYPE_OBJECT, sample);
+    }
+    count_mini_objects(sample);
+}
+
+void bench_leaks_sample_clear(BenchLeakSample *sample)
+{
+    if (sample->types) {
+        g_hash_table_unref(sample->types);
+        sample->types = NULL;
+    }
+}
+
+static gint compare_growth(gconstpointer a, gconstpointer b)
+{
+    gint64 difference = ((const TypeGrowth *)b)->growth - ((const TypeGrowth *)a)->growth;
+
+    return difference > 0 ? 1 : difference < 0 ? -1 : 0;
+}
+
+gchar *bench_leaks_describe_growth(const BenchLeakSample *from, const BenchLeakSample *to, guint max_types)
+{
+    GArray *grown = g_array_new(FALSE, FALSE, sizeof(TypeGrowth));
+    GString *description = g_string_new(NULL);
+    GHashTableIter iter;
+    gpointer name, count;
+    guint i;
+
+    g_hash_table_iter_init(&iter, to->types);
+    while (g_hash_table_iter_next(&iter, &name, &count)) {
+        TypeGrowth growth = { name, GPOINTER_TO_INT(count) - GPOINTER_TO_INT(g_hash_table_lookup(from->types, name)) };
+
+        if (growth.growth > 0) {
+            g_array_append_val(grown, growth);
+        }
+    }
+    g_array_sort(grown, compare_growth);
+
+    for (i = 0; i < MIN(grown->len, max_types); i++) {
+        const TypeGrowth *growth = &g_array_index(grown, TypeGrowth, i);
+
+        g_string_append_printf(description, "%s%s +%" G_GINT64_FORMAT, i ? ", " : "", growth->name, growth->growth);
+    }
+    g_array_free(grown, TRUE);
+    return g_string_free(description, FALSE);
+}
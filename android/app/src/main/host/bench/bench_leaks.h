@@ -0,0 +1,34 @@
+//
+//  bench_leaks.h
+//
+//  Live object accounting for the soak. GObjects are counted per type by
+//  GLib itself when GOBJECT_DEBUG has instance-count, GstBuffers, GstCaps
+//  and the other mini objects by the leaks tracer of GStreamer. Both have
+//  to be asked for before GLib and GStreamer initialize.
+//
+
+#ifndef bench_leaks_h
+#define bench_leaks_h
+
+#include <glib.h>
+
+typedef struct {
+    gint64 rss_kb;
+    gint64 objects;                     // Live GObjects, -1 when not counted
+    gint64 buffers;                     // Live GstBuffers, -1 without the leaks tracer
+    gint64 caps;                        // Live GstCaps, -1 without the leaks tracer
+    GHashTable *types;                  // Type name -> live instances, every counted type
+} BenchLeakSample;
+
+// Restarts the process with argv when GOBJECT_DEBUG or GST_TRACERS lack the counting, returns
+// when they already had it or the restart failed
+void bench_leaks_enable(gchar **argv);
+
+void bench_leaks_sample(BenchLeakSample *sample);
+void bench_leaks_sample_clear(BenchLeakSample *sample);
+
+// "GstPad +12, GstBuffer +4", the max_types types that grew the most from one sample to the other.
+// Free with g_free.
+gchar *bench_leaks_describe_growth(const BenchLeakSample *from, const BenchLeakSample *to, guint max_types);
+
+#endif /* bench_leaks_h */
@@ -0,0 +1,193 @@
+#include "bench_player.h"
+
+static BenchPlayer *bench_from_player(RctGstPlayer *player)
+{
+    return (BenchPlayer *)rct_gst_get_configuration(player)->userData;
+}
+
+static void cb_first_frame(RctGstPlayer *player, RctGstUriSwitchMode mode, gint64 ttff_us, RctGstTransport transport)
+{
+    BenchPlayer *bench = bench_from_player(player);
+
+    g_mutex_lock(&bench->lock);
+    bench->first_frames++;
+    bench->last_ttff_us = ttff_us;
+    bench->last_mode = mode;
+    bench->last_transport = transport;
+    g_cond_broadcast(&bench->changed);
+    g_mutex_unlock(&bench->lock);
+}
+
+static void cb_element_error(RctGstPlayer *player, gchar *source, gchar *message, gchar *debug_info)
+{
+    BenchPlayer *bench = bench_from_player(player);
+
+    g_printerr("Player %p: %s: %s\n", player, source, message);
+    g_mutex_lock(&bench->lock);
+    bench->errors++;
+    g_mutex_unlock(&bench->lock);
+}
+
+static void cb_qos(RctGstPlayer *player, const RctGstQosStatus *status)
+{
+    BenchPlayer *bench = bench_from_player(player);
+
+    g_mutex_lock(&bench->lock);
+    bench->qos = *status;
+    g_mutex_unlock(&bench->lock);
+}
+
+static void cb_seek_done(RctGstPlayer *player, gint64 position_us, gint64 duration_us, gint64 latency_us)
+{
+    BenchPlayer *bench = bench_from_player(player);
+
+    g_mutex_lock(&bench->lock);
+    bench->seeks_done++;
+    bench->last_seek_done_at = g_get_monotonic_time();
+    g_cond_broadcast(&bench->changed);
+    g_mutex_unlock(&bench->lock);
+}
+
+static void cb_scrub_preview(RctGstPlayer *player, const RctGstScrubThumbnail *thumbnail)
+{
+    BenchPlayer *bench = bench_from_player(player);
+
+    g_mutex_lock(&bench->lock);
+    bench->previews++;
+    bench->last_preview_at = g_get_monotonic_time();
+    g_cond_broadcast(&bench->changed);
+    g_mutex_unlock(&bench->lock);
+}
+
+BenchPlayer *bench_player_new(void)
+{
+    BenchPlayer *bench = g_new0(BenchPlayer, 1);
+    RctGstConfiguration *configuration;
+
+    g_mutex_init(&bench->lock);
+    g_cond_init(&bench->changed);
+    bench->player = rct_gst_player_new();
+
+    configuration = rct_gst_get_configuration(bench->player);
+    configuration->videoSink = g_strdup("fakesink");
+    configuration->userData = bench;
+    configuration->onFirstFrame = cb_first_frame;
+    configuration->onElementError = cb_element_error;
+    configuration->onQos = cb_qos;
+    configuration->onSeekDone = cb_seek_done;
+    configuration->onScrubPreview = cb_scrub_preview;
+    return bench;
+}
+
+void bench_player_free(BenchPlayer *bench)
+{
+    if (!bench) {
+        return;
+    }
+    rct_gst_player_free(bench->player);
+    g_cond_clear(&bench->changed);
+    g_mutex_clear(&bench->lock);
+    g_free(bench);
+}
+
+void bench_player_start(BenchPlayer *bench, const gchar *uri)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(bench->player);
+
+    g_free(configuration->uri);
+    configuration->uri = g_strdup(uri);
+    rct_gst_init(bench->player);
+    rct_gst_set_pipeline_state(bench->player, GST_STATE_PLAYING);
+}
+
+guint bench_player_count_first_frames(BenchPlayer *bench)
+{
+    guint count;
+
+    g_mutex_lock(&bench->lock);
+    count = bench->first_frames;
+    g_mutex_unlock(&bench->lock);
+    return count;
+}
+
+gboolean bench_player_wait_first_frame(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *ttff_us)
+{
+    gint64 deadline = g_get_monotonic_time() + timeout_us;
+    gboolean shown = TRUE;
+
+    g_mutex_lock(&bench->lock);
+    while (bench->first_frames <= previous && shown) {
+        shown = g_cond_wait_until(&bench->changed, &bench->lock, deadline);
+    }
+    shown = bench->first_frames > previous;
+    if (shown && ttff_us) {
+        *ttff_us = bench->last_ttff_us;
+    }
+    g_mutex_unlock(&bench->lock);
+    return shown;
+}
+
+// Waits for *counter to go past previous, *at is read with it
+static gboolean wait_counter(BenchPlayer *bench, const guint *counter, const gint64 *at, guint previous,
+                             gint64 timeout_us, gint64 *value)
+{
+    gint64 deadline = g_get_monotonic_time() + timeout_us;
+    gboolean reached = TRUE;
+
+    g_mutex_lock(&bench->lock);
+    while (*counter <= previous && reached) {
+        reached = g_cond_wait_until(&bench->changed, &bench->lock, deadline);
+    }
+    reached = *counter > previous;
+    if (reached && value) {
+        *value = *at;
+    }
+    g_mutex_unlock(&bench->lock);
+    return reached;
+}
+
+guint bench_player_count_seeks(BenchPlayer *bench)
+{
+    guint count;
+
+    g_mutex_lock(&bench->lock);
+    count = bench->seeks_done;
+    g_mutex_unlock(&bench->lock);
+    return count;
+}
+
+gboolean bench_player_wait_seek(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *done_at)
+{
+    return wait_counter(bench, &bench->seeks_done, &bench->last_seek_done_at, previous, timeout_us, done_at);
+}
+
+guint bench_player_count_previews(BenchPlayer *bench)
+{
+    guint count;
+
+    g_mutex_lock(&bench->lock);
+    count = bench->previews;
+    g_mutex_unlock(&bench->lock);
+    return count;
+}
+
+gboolean bench_player_wait_preview(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *shown_at)
+{
+    return wait_counter(bench, &bench->previews, &bench->last_preview_at, previous, timeout_us, shown_at);
+}
+
+gdouble bench_player_get_latency_ms(BenchPlayer *bench)
+{
+    RctGstStats stats;
+    gdouble latency_us = 0;
+    guint i;
+
+    rct_gst_get_stats(bench->player, &stats);
+    for (i = 0; i < RCT_GST_STAGE_COUNT; i++) {
+        if (stats.stages[i].count == 0) {
+            return NAN;
+        }
+        latency_us += (gdouble)stats.stages[i].sum_us / stats.stages[i].count;
+    }
+    return latency_us / 1000.0;
+}
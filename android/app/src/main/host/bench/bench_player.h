@@ -0,0 +1,57 @@
+//
+//  bench_player.h
+//
+//  Backend player driven from a benchmark. Callbacks land on the player
+//  thread and are recorded under a lock, so the benchmark can block on a
+//  first frame with a timeout. Frames go to a fakesink: nothing here
+//  needs a window.
+//
+
+#ifndef bench_player_h
+#define bench_player_h
+
+#include "gstreamer_backend.h"
+
+typedef struct {
+    RctGstPlayer *player;
+
+    GMutex lock;
+    GCond changed;
+    guint first_frames;                 // onFirstFrame calls so far
+    gint64 last_ttff_us;
+    RctGstUriSwitchMode last_mode;
+    RctGstTransport last_transport;
+    guint errors;
+    RctGstQosStatus qos;                // Last transition
+    guint seeks_done;                   // onSeekDone calls so far
+    gint64 last_seek_done_at;           // Monotonic µs
+    guint previews;                     // onScrubPreview calls so far
+    gint64 last_preview_at;             // Monotonic µs
+} BenchPlayer;
+
+// Configuration is left at its defaults but for the sink, set it through player before bench_player_start
+BenchPlayer *bench_player_new(void);
+void bench_player_free(BenchPlayer *bench);
+
+// Initializes with uri, NULL for mosaics, and sets the pipeline playing
+void bench_player_start(BenchPlayer *bench, const gchar *uri);
+
+guint bench_player_count_first_frames(BenchPlayer *bench);
+
+// Waits for the first frame after the one counted in previous, FALSE on timeout
+gboolean bench_player_wait_first_frame(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *ttff_us);
+
+guint bench_player_count_seeks(BenchPlayer *bench);
+
+// Waits for the onSeekDone after the one counted in previous, FALSE on timeout. done_at is monotonic.
+gboolean bench_player_wait_seek(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *done_at);
+
+guint bench_player_count_previews(BenchPlayer *bench);
+
+// Waits for the onScrubPreview after the one counted in previous, FALSE on timeout. shown_at is monotonic.
+gboolean bench_player_wait_preview(BenchPlayer *bench, guint previous, gint64 timeout_us, gint64 *shown_at);
+
+// RTP timestamp to sink, summed over the mean of every stage. NaN while statistics are off or empty.
+gdouble bench_player_get_latency_ms(BenchPlayer *bench);
+
+#endif /* bench_player_h */
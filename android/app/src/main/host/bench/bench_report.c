@@ -0,0 +1,176 @@
+#include "bench_report.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+struct _BenchRecord
+{
+    GString *json;
+    GString *summary;                   // Same fields for stderr, while the run goes on
+};
+
+struct _BenchReport
+{
+    FILE *file;
+    gboolean owned;
+};
+
+static gint64 cpu_time_us(void)
+{
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (gint64)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * G_USEC_PER_SEC +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+void bench_sample_start(BenchSample *sample)
+{
+    sample->wall_us = g_get_monotonic_time();
+    sample->cpu_us = cpu_time_us();
+}
+
+gdouble bench_sample_cpu_percent(const BenchSample *sample)
+{
+    gint64 wall_us = g_get_monotonic_time() - sample->wall_us;
+
+    return wall_us > 0 ? 100.0 * (cpu_time_us() - sample->cpu_us) / wall_us : 0.0;
+}
+
+gint64 bench_rss_kb(void)
+{
+    long size = 0, resident = 0;
+    FILE *statm = fopen("/proc/self/statm", "r");
+
+    if (!statm) {
+        return -1;
+    }
+    if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+        resident = -1;
+    }
+    fclose(statm);
+    return resident < 0 ? -1 : (gint64)resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void append_string(GString *json, const gchar *value)
+{
+    const gchar *c;
+
+    g_string_append_c(json, '"');
+    for (c = value; *c; c++) {
+        if (*c == '"' || *c == '\\') {
+            g_string_append_printf(json, "\\%c", *c);
+        } else if ((guchar)*c < 0x20) {
+            g_string_append_printf(json, "\\u%04x", (guchar)*c);
+        } else {
+            g_string_append_c(json, *c);
+        }
+    }
+    g_string_append_c(json, '"');
+}
+
+static void append_key(BenchRecord *record, const gchar *key)
+{
+    g_string_append_c(record->json, ',');
+    append_string(record->json, key);
+    g_string_append_c(record->json, ':');
+    g_string_append_printf(record->summary, " %s=", key);
+}
+
+BenchRecord *bench_record_new(const gchar *scenario, const gchar *variant)
+{
+    BenchRecord *record = g_new0(BenchRecord, 1);
+
+    record->json = g_string_new("{\"scenario\":");
+    append_string(record->json, scenario);
+    g_string_append(record->json, ",\"variant\":");
+    append_string(record->json, variant ? variant : "");
+    record->summary = g_string_new(NULL);
+    g_string_append_printf(record->summary, "%s/%s:", scenario, variant ? variant : "");
+    return record;
+}
+
+void bench_record_set_string(BenchRecord *record, const gchar *key, const gchar *value)
+{
+    append_key(record, key);
+    if (value) {
+        append_string(record->json, value);
+    } else {
+        g_string_append(record->json, "null");
+    }
+    g_string_append(record->summary, value ? value : "-");
+}
+
+void bench_record_set_int(BenchRecord *record, const gchar *key, gint64 value)
+{
+    append_key(record, key);
+    g_string_append_printf(record->json, "%" G_GINT64_FORMAT, value);
+    g_string_append_printf(record->summary, "%" G_GINT64_FORMAT, value);
+}
+
+void bench_record_set_double(BenchRecord *record, const gchar *key, gdouble value)
+{
+    gchar buffer[G_ASCII_DTOSTR_BUF_SIZE];
+
+    append_key(record, key);
+    if (isnan(value) || isinf(value)) {
+        g_string_append(record->json, "null");
+        g_string_append(record->summary, "-");
+        return;
+    }
+    // Locale independent, a decimal comma would not be JSON
+    g_ascii_formatd(buffer, sizeof(buffer), "%.3f", value);
+    g_string_append(record->json, buffer);
+    g_string_append(record->summary, buffer);
+}
+
+BenchReport *bench_report_new(const gchar *path, GError **error)
+{
+    BenchReport *report = g_new0(BenchReport, 1);
+
+    if (!path) {
+        report->file = stdout;
+        return report;
+    }
+    report->file = fopen(path, "w");
+    if (!report->file) {
+        g_set_error(error, G_FILE_ERROR, g_file_error_from_errno(errno), "%s could not be opened", path);
+        g_free(report);
+        return NULL;
+    }
+    report->owned = TRUE;
+    return report;
+}
+
+void bench_report_free(BenchReport *report)
+{
+    if (!report) {
+        return;
+    }
+    if (report->owned) {
+        fclose(report->file);
+    } else {
+        fflush(report->file);
+    }
+    g_free(report);
+}
+
+void bench_report_write(BenchReport *report, BenchRecord *record)
+{
+    g_string_append_c(record->json, '}');
+    fprintf(report->file, "%s\n", record->json->str);
+    fflush(report->file);
+    g_printerr("%s\n", record->summary->str);
+
+    g_string_free(record->json, TRUE);
+    g_string_free(record->summary, TRUE);
+    g_free(record);
+}
+
+void bench_report_write_line(BenchReport *report, const gchar *line)
+{
+    fprintf(report->file, "%s\n", line);
+    fflush(report->file);
+}
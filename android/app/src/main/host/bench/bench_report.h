@@ -0,0 +1,46 @@
+//
+//  bench_report.h
+//
+//  Measurements and results of the benchmarks. Every result is one JSON
+//  object per line, with its scenario and variant, so runs can be diffed
+//  and plotted without parsing anything else.
+//
+
+#ifndef bench_report_h
+#define bench_report_h
+
+#include <glib.h>
+
+// CPU time of the whole process over a window, every thread included
+typedef struct {
+    gint64 wall_us;
+    gint64 cpu_us;
+} BenchSample;
+
+void bench_sample_start(BenchSample *sample);
+
+// Since bench_sample_start, 100 is one core busy all along
+gdouble bench_sample_cpu_percent(const BenchSample *sample);
+
+// Resident set size of the process
+gint64 bench_rss_kb(void);
+
+typedef struct _BenchRecord BenchRecord;
+typedef struct _BenchReport BenchReport;
+
+BenchRecord *bench_record_new(const gchar *scenario, const gchar *variant);
+void bench_record_set_string(BenchRecord *record, const gchar *key, const gchar *value);
+void bench_record_set_int(BenchRecord *record, const gchar *key, gint64 value);
+void bench_record_set_double(BenchRecord *record, const gchar *key, gdouble value);  // NaN is written as null
+
+// path NULL writes to stdout
+BenchReport *bench_report_new(const gchar *path, GError **error);
+void bench_report_free(BenchReport *report);
+
+// Writes the record on a line of its own and frees it
+void bench_report_write(BenchReport *report, BenchRecord *record);
+
+// A line some other process wrote with bench_report_write
+void bench_report_write_line(BenchReport *report, const gchar *line);
+
+#endif /* bench_report_h */
@@ -0,0 +1,143 @@
+#include "bench_server.h"
+#include <signal.h>
+#include <sys/wait.h>
+#include <gio/gio.h>
+#include <gst/gst.h>
+#include <gst/rtsp-server/rtsp-server.h>
+
+// Time the child gets to open its port
+#define SPAWN_TIMEOUT_US (10 * G_USEC_PER_SEC)
+
+// One GOP per second, as most cameras are set up
+#define FRAMERATE 30
+
+const BenchProfile bench_profiles[] = {
+    { "360p", 640, 360, 800 },
+    { "720p", 1280, 720, 2500 },
+    { "1080p", 1920, 1080, 6000 },
+};
+const guint bench_profile_count = G_N_ELEMENTS(bench_profiles);
+
+const BenchProfile *bench_profile_find(const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < bench_profile_count; i++) {
+        if (g_strcmp0(bench_profiles[i].name, name) == 0) {
+            return &bench_profiles[i];
+        }
+    }
+    return NULL;
+}
+
+static void add_mount(GstRTSPMountPoints *mounts, GstRTSPAddressPool *pool, const BenchProfile *profile,
+                      gboolean alternate)
+{
+    GstRTSPMediaFactory *factory = gst_rtsp_media_factory_new();
+    gchar *path = g_strdup_printf("/%s%s", profile->name, alternate ? "-b" : "");
+    gchar *launch = g_strdup_printf("( videotestsrc is-live=true pattern=%s ! "
+                                    "video/x-raw,width=%d,height=%d,framerate=%d/1 ! "
+                                    "x264enc tune=zerolatency speed-preset=ultrafast bitrate=%u key-int-max=%d ! "
+                                    "video/x-h264,profile=constrained-baseline ! rtph264pay name=pay0 pt=96 "
+                                    "config-interval=-1 )",
+                                    alternate ? "smpte" : "ball", profile->width, profile->height, FRAMERATE,
+                                    profile->kbps, FRAMERATE);
+
+    // One encoder per mount whatever the number of viewers
+    gst_rtsp_media_factory_set_launch(factory, launch);
+    gst_rtsp_media_factory_set_shared(factory, TRUE);
+    gst_rtsp_media_factory_set_protocols(factory, GST_RTSP_LOWER_TRANS_UDP | GST_RTSP_LOWER_TRANS_UDP_MCAST |
+                                                  GST_RTSP_LOWER_TRANS_TCP);
+    gst_rtsp_media_factory_set_address_pool(factory, pool);
+    gst_rtsp_mount_points_add_factory(mounts, path, factory);
+    g_free(launch);
+    g_free(path);
+}
+
+int bench_server_run(guint port)
+{
+    GMainLoop *loop = g_main_loop_new(NULL, FALSE);
+    GstRTSPServer *server = gst_rtsp_server_new();
+    GstRTSPMountPoints *mounts = gst_rtsp_server_get_mount_points(server);
+    GstRTSPAddressPool *pool = gst_rtsp_address_pool_new();
+    gchar *service = g_strdup_printf("%u", port);
+    guint i;
+
+    gst_rtsp_address_pool_add_range(pool, "224.3.0.0", "224.3.0.255", 5000, 5999, 1);
+    for (i = 0; i < bench_profile_count; i++) {
+        add_mount(mounts, pool, &bench_profiles[i], FALSE);
+        add_mount(mounts, pool, &bench_profiles[i], TRUE);
+    }
+    gst_rtsp_server_set_service(server, service);
+    if (gst_rtsp_server_attach(server, NULL) == 0) {
+        g_printerr("RTSP server could not listen on port %s\n", service);
+        return 1;
+    }
+    g_main_loop_run(loop);
+
+    g_free(service);
+    g_object_unref(pool);
+    g_object_unref(mounts);
+    g_object_unref(server);
+    g_main_loop_unref(loop);
+    return 0;
+}
+
+static gboolean port_open(guint port)
+{
+    GSocketClient *client = g_socket_client_new();
+    GSocketConnection *connection = g_socket_client_connect_to_host(client, "127.0.0.1", port, NULL, NULL);
+
+    g_object_unref(client);
+    if (!connection) {
+        return FALSE;
+    }
+    g_object_unref(connection);
+    return TRUE;
+}
+
+gboolean bench_server_spawn(guint port, GPid *pid, GError **error)
+{
+    gchar *port_arg = g_strdup_printf("%u", port);
+    gchar *argv[] = { "/proc/self/exe", "--serve", "--port", port_arg, NULL };
+    gint64 deadline = g_get_monotonic_time() + SPAWN_TIMEOUT_US;
+    gboolean spawned;
+
+    if (port_open(port)) {
+        g_set_error(error, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE, "port %u is already in use", port);
+        g_free(port_arg);
+        return FALSE;
+    }
+    spawned = g_spawn_async(NULL, argv, NULL, G_SPAWN_DO_NOT_REAP_CHILD, NULL, NULL, pid, error);
+    g_free(port_arg);
+    if (!spawned) {
+        return FALSE;
+    }
+
+    while (!port_open(port)) {
+        if (waitpid(*pid, NULL, WNOHANG) == *pid) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_FAILED, "RTSP server exited, is gst-rtsp-server installed?");
+            g_spawn_close_pid(*pid);
+            return FALSE;
+        }
+        if (g_get_monotonic_time() > deadline) {
+            g_set_error(error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT, "RTSP server did not start on port %u", port);
+            bench_server_stop(*pid);
+            return FALSE;
+        }
+        g_usleep(50000);
+    }
+    return TRUE;
+}
+
+void bench_server_stop(GPid pid)
+{
+    kill(pid, SIGTERM);
+    waitpid(pid, NULL, 0);
+    g_spawn_close_pid(pid);
+}
+
+gchar *bench_server_uri(guint port, const BenchProfile *profile, gboolean alternate)
+{
+    return g_strdup_printf("rtsp://127.0.0.1:%u/%s%s", port, profile->name, alternate ? "-b" : "");
+}
@@ -0,0 +1,37 @@
+//
+//  bench_server.h
+//
+//  Local RTSP stand-in for the cameras the benchmarks play. Every profile
+//  is served twice, /<name> and /<name>-b with another test pattern, so a
+//  uri switch always lands on a different stream. The server runs in a
+//  child process: its encoders never count in the CPU the players use.
+//
+
+#ifndef bench_server_h
+#define bench_server_h
+
+#include <glib.h>
+
+typedef struct {
+    const gchar *name;
+    gint width, height;
+    guint kbps;
+} BenchProfile;
+
+extern const BenchProfile bench_profiles[];
+extern const guint bench_profile_count;
+
+// NULL when no profile has that name
+const BenchProfile *bench_profile_find(const gchar *name);
+
+// Serves every profile on port until the process is killed
+int bench_server_run(guint port);
+
+// Starts this executable in serve mode, returns once the port accepts connections
+gboolean bench_server_spawn(guint port, GPid *pid, GError **error);
+void bench_server_stop(GPid pid);
+
+// rtsp://127.0.0.1:port/<name>, or its -b twin, free with g_free
+gchar *bench_server_uri(guint port, const BenchProfile *profile, gboolean alternate);
+
+#endif /* bench_server_h */
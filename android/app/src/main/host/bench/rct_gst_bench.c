@@ -0,0 +1,1130 @@
+//
+//  rct_gst_bench.c
+//
+//  Benchmarks of the native player on a Linux host. A local RTSP server
+//  stands in for the cameras, players render to a fakesink, and every
+//  scenario writes its results as JSON lines.
+//
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <gst/gst.h>
+#include "bench_leaks.h"
+#include "bench_player.h"
+#include "bench_report.h"
+#include "bench_server.h"
+#include "gstreamer_log.h"
+
+#define LOG_TAG "GStreamerBench"
+
+// Time a player gets to show its first frame
+#define FIRST_FRAME_TIMEOUT_US (15 * G_USEC_PER_SEC)
+
+// Settling time between the first frames and the measurement window
+#define WARMUP_US G_USEC_PER_SEC
+
+// Switches and resumes averaged per variant
+#define REPEATS 10
+
+typedef struct {
+    guint port;
+    gint64 duration_us;                 // Measurement window of steady state scenarios
+    guint max_players;
+    GPtrArray *profiles;                // const BenchProfile *
+    guint soak_minutes;
+    guint64 log_calls;
+    const gchar *log_level;             // Spec restored after the log scenario
+    guint startup_delay_ms;             // Between gst_init and the first player, the app mounting its view
+    BenchReport *report;
+    gboolean failed;                    // A scenario found a regression, the exit status tells
+} Bench;
+
+// Called on every player before it starts, index counts the players of the run
+typedef void (*BenchSetupFunc)(BenchPlayer *player, guint index, gpointer user_data);
+
+typedef struct {
+    BenchSetupFunc setup;
+    gpointer user_data;
+    gboolean no_uri;                    // Mosaics, the setup function sets the tiles
+    gboolean no_first_frame;            // Nothing reports a first frame, the warmup is all there is
+} BenchRunOptions;
+
+typedef struct {
+    const gchar *name;
+    const gchar *description;
+    void (*run)(Bench *bench);
+} BenchScenario;
+
+static void record_profile(BenchRecord *record, const BenchProfile *profile)
+{
+    bench_record_set_string(record, "profile", profile->name);
+    bench_record_set_int(record, "width", profile->width);
+    bench_record_set_int(record, "height", profile->height);
+    bench_record_set_int(record, "kbps", profile->kbps);
+}
+
+/************
+ STEADY STATE
+ ***********/
+// Starts count players on profile, waits for their first frames, then measures a window of
+// duration_us. CPU and RSS are the process ones: the server runs in another process.
+static void run_players(Bench *bench, const gchar *scenario, const gchar *variant, const BenchProfile *profile,
+                        guint count, const BenchRunOptions *options)
+{
+    BenchRecord *record = bench_record_new(scenario, variant);
+    BenchPlayer **players = g_new0(BenchPlayer *, count);
+    gchar *uri = bench_server_uri(bench->port, profile, FALSE);
+    gint64 rss_before = bench_rss_kb();
+    gint64 ttff_us, ttff_sum_us = 0, ttff_max_us = 0;
+    guint64 *rendered_before = g_new0(guint64, count);
+    guint64 rendered = 0, dropped = 0;
+    guint shown = 0, errors = 0, i;
+    gdouble latency_ms = 0, cpu_percent;
+    guint latencies = 0;
+    RctGstQosRung max_rung = RCT_GST_QOS_RUNG_NONE;
+    BenchSample sample;
+    RctGstStats stats;
+
+    for (i = 0; i < count; i++) {
+        players[i] = bench_player_new();
+        rct_gst_get_configuration(players[i]->player)->statsRefreshRate = 1000;
+        if (options && options->setup) {
+            options->setup(players[i], i, options->user_data);
+        }
+        bench_player_start(players[i], options && options->no_uri ? NULL : uri);
+    }
+    for (i = 0; i < count && !(options && options->no_first_frame); i++) {
+        if (bench_player_wait_first_frame(players[i], 0, FIRST_FRAME_TIMEOUT_US, &ttff_us)) {
+            ttff_sum_us += ttff_us;
+            ttff_max_us = MAX(ttff_max_us, ttff_us);
+            shown++;
+        }
+    }
+    g_usleep(WARMUP_US);
+
+    for (i = 0; i < count; i++) {
+        rct_gst_get_stats(players[i]->player, &stats);
+        rendered_before[i] = stats.frames_rendered;
+    }
+    bench_sample_start(&sample);
+    g_usleep(bench->duration_us);
+    cpu_percent = bench_sample_cpu_percent(&sample);
+
+    for (i = 0; i < count; i++) {
+        gdouble latency = bench_player_get_latency_ms(players[i]);
+
+        rct_gst_get_stats(players[i]->player, &stats);
+        rendered += stats.frames_rendered - rendered_before[i];
+        dropped += stats.frames_dropped;
+        if (!isnan(latency)) {
+            latency_ms += latency;
+            latencies++;
+        }
+        g_mutex_lock(&players[i]->lock);
+        errors += players[i]->errors;
+        max_rung = MAX(max_rung, players[i]->qos.rung);
+        g_mutex_unlock(&players[i]->lock);
+    }
+
+    record_profile(record, profile);
+    bench_record_set_int(record, "players", count);
+    if (!(options && options->no_first_frame)) {
+        bench_record_set_int(record, "first_frames", shown);
+        bench_record_set_double(record, "ttff_ms", shown ? ttff_sum_us / 1000.0 / shown : NAN);
+        bench_record_set_double(record, "ttff_max_ms", shown ? ttff_max_us / 1000.0 : NAN);
+    }
+    bench_record_set_double(record, "latency_ms", latencies ? latency_ms / latencies : NAN);
+    bench_record_set_double(record, "cpu_percent", cpu_percent);
+    bench_record_set_double(record, "cpu_percent_per_stream", cpu_percent / count);
+    bench_record_set_int(record, "rss_kb", bench_rss_kb());
+    bench_record_set_int(record, "rss_kb_per_stream", (bench_rss_kb() - rss_before) / (gint64)count);
+    bench_record_set_double(record, "fps", rendered * (gdouble)G_USEC_PER_SEC / bench->duration_us);
+    bench_record_set_int(record, "frames_dropped", dropped);
+    bench_record_set_string(record, "qos_rung", rct_gst_qos_rung_get_name(max_rung));
+    bench_record_set_int(record, "errors", errors);
+    bench_report_write(bench->report, record);
+
+    for (i = 0; i < count; i++) {
+        bench_player_free(players[i]);
+    }
+    g_free(rendered_before);
+    g_free(players);
+    g_free(uri);
+}
+
+// TTFF, CPU, RSS and latency of one stream per profile
+static void scenario_ttff(Bench *bench)
+{
+    guint i;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        run_players(bench, "ttff", "default", g_ptr_array_index(bench->profiles, i), 1, NULL);
+    }
+}
+
+// Cost of every extra player, nothing shared
+static void scenario_multi_player(Bench *bench)
+{
+    guint i, count;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        for (count = 1; count <= bench->max_players; count *= 2) {
+            run_players(bench, "multi_player", "separate", g_ptr_array_index(bench->profiles, i), count, NULL);
+        }
+    }
+}
+
+static void setup_convert(BenchPlayer *player, guint index, gpointer user_data)
+{
+    rct_gst_get_configuration(player->player)->forceVideoConvert = GPOINTER_TO_INT(user_data);
+}
+
+// videoconvert always in the chain against decoder output straight to the sink
+static void scenario_convert(Bench *bench)
+{
+    BenchRunOptions passthrough = { setup_convert, GINT_TO_POINTER(FALSE) };
+    BenchRunOptions convert = { setup_convert, GINT_TO_POINTER(TRUE) };
+    guint i;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        run_players(bench, "convert", "passthrough", g_ptr_array_index(bench->profiles, i), 1, &passthrough);
+        run_players(bench, "convert", "convert", g_ptr_array_index(bench->profiles, i), 1, &convert);
+    }
+}
+
+static void setup_pipeline_mode(BenchPlayer *player, guint index, gpointer user_data)
+{
+    rct_gst_get_configuration(player->player)->pipelineMode = (RctGstPipelineMode)GPOINTER_TO_INT(user_data);
+}
+
+static void scenario_pipelined(Bench *bench)
+{
+    BenchRunOptions single = { setup_pipeline_mode, GINT_TO_POINTER(RCT_GST_PIPELINE_SINGLE_THREAD) };
+    BenchRunOptions pipelined = { setup_pipeline_mode, GINT_TO_POINTER(RCT_GST_PIPELINE_PIPELINED) };
+    guint i;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        run_players(bench, "pipelined", "single_thread", g_ptr_array_index(bench->profiles, i), 1, &single);
+        run_players(bench, "pipelined", "pipelined", g_ptr_array_index(bench->profiles, i), 1, &pipelined);
+    }
+}
+
+static void setup_qos(BenchPlayer *player, guint index, gpointer user_data)
+{
+    rct_gst_get_configuration(player->player)->qosMaxRung = (RctGstQosRung)GPOINTER_TO_INT(user_data);
+}
+
+static gpointer burn_cpu(gpointer user_data)
+{
+    volatile gint *running = (volatile gint *)user_data;
+    volatile guint64 spin = 0;
+
+    while (g_atomic_int_get(running)) {
+        spin++;
+    }
+    return NULL;
+}
+
+// Every core kept busy while max_players decode, with and without the degradation ladder
+static void scenario_qos(Bench *bench)
+{
+    BenchRunOptions ladder = { setup_qos, GINT_TO_POINTER(RCT_GST_QOS_RUNG_LOWER_RESOLUTION) };
+    BenchRunOptions none = { setup_qos, GINT_TO_POINTER(RCT_GST_QOS_RUNG_NONE) };
+    guint cores = (guint)MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+    GThread **burners = g_new0(GThread *, cores);
+    volatile gint running = TRUE;
+    guint i;
+
+    for (i = 0; i < cores; i++) {
+        burners[i] = g_thread_new("bench-load", burn_cpu, (gpointer)&running);
+    }
+    for (i = 0; i < bench->profiles->len; i++) {
+        run_players(bench, "qos", "ladder", g_ptr_array_index(bench->profiles, i), bench->max_players, &ladder);
+        run_players(bench, "qos", "none", g_ptr_array_index(bench->profiles, i), bench->max_players, &none);
+    }
+    g_atomic_int_set(&running, FALSE);
+    for (i = 0; i < cores; i++) {
+        g_thread_join(burners[i]);
+    }
+    g_free(burners);
+}
+
+static void setup_jitter(BenchPlayer *player, guint index, gpointer user_data)
+{
+    rct_gst_get_configuration(player->player)->jitterMode = (RctGstJitterMode)GPOINTER_TO_INT(user_data);
+}
+
+static gboolean netem(const gchar *arguments)
+{
+    gchar *command = g_strdup_printf("tc qdisc %s", arguments);
+    gint status = -1;
+    gboolean done = g_spawn_command_line_sync(command, NULL, NULL, &status, NULL) && status == 0;
+
+    g_free(command);
+    return done;
+}
+
+// Delay and loss on loopback through tc netem, which needs CAP_NET_ADMIN
+static void scenario_netem(Bench *bench)
+{
+    static const struct { guint delay_ms; gdouble loss; } links[] = {
+        { 20, 0.0 }, { 50, 0.5 }, { 100, 1.0 }, { 200, 5.0 },
+    };
+    BenchRunOptions fixed = { setup_jitter, GINT_TO_POINTER(RCT_GST_JITTER_FIXED) };
+    BenchRunOptions adaptive = { setup_jitter, GINT_TO_POINTER(RCT_GST_JITTER_ADAPTIVE) };
+    const BenchProfile *profile = g_ptr_array_index(bench->profiles, 0);
+    gchar loss[G_ASCII_DTOSTR_BUF_SIZE];
+    gchar *arguments, *variant;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(links); i++) {
+        g_ascii_formatd(loss, sizeof(loss), "%.1f", links[i].loss);
+        arguments = g_strdup_printf("replace dev lo root netem delay %ums loss %s%%", links[i].delay_ms, loss);
+        if (!netem(arguments)) {
+            BenchRecord *record = bench_record_new("netem", "skipped");
+
+            bench_record_set_string(record, "reason", "tc netem failed, root is needed");
+            bench_report_write(bench->report, record);
+            g_free(arguments);
+            return;
+        }
+        variant = g_strdup_printf("fixed_%ums_%s", links[i].delay_ms, loss);
+        run_players(bench, "netem", variant, profile, 1, &fixed);
+        g_free(variant);
+        variant = g_strdup_printf("adaptive_%ums_%s", links[i].delay_ms, loss);
+        run_players(bench, "netem", variant, profile, 1, &adaptive);
+        g_free(variant);
+        g_free(arguments);
+    }
+    netem("del dev lo root");
+}
+
+static void setup_transport(BenchPlayer *player, guint index, gpointer user_data)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player->player);
+
+    g_free(configuration->transports);
+    configuration->transports = g_strdup((const gchar *)user_data);
+    configuration->rememberTransport = FALSE;
+}
+
+static void scenario_transport(Bench *bench)
+{
+    static const gchar *transports[] = { "udp", "multicast", "tcp", "http" };
+    guint i, j;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        for (j = 0; j < G_N_ELEMENTS(transports); j++) {
+            BenchRunOptions options = { setup_transport, (gpointer)transports[j] };
+
+            rct_gst_transport_forget_all();
+            run_players(bench, "transport", transports[j], g_ptr_array_index(bench->profiles, i), 1, &options);
+        }
+    }
+}
+
+static void setup_shared(BenchPlayer *player, guint index, gpointer user_data)
+{
+    rct_gst_get_configuration(player->player)->sharedDecode = GPOINTER_TO_INT(user_data);
+}
+
+// Views of the same uri, one decoder shared against one each
+static void scenario_shared_decode(Bench *bench)
+{
+    BenchRunOptions shared = { setup_shared, GINT_TO_POINTER(TRUE) };
+    BenchRunOptions separate = { setup_shared, GINT_TO_POINTER(FALSE) };
+    guint i, count;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        for (count = 1; count <= bench->max_players; count *= 2) {
+            run_players(bench, "shared_decode", "shared", g_ptr_array_index(bench->profiles, i), count, &shared);
+            run_players(bench, "shared_decode", "separate", g_ptr_array_index(bench->profiles, i), count, &separate);
+        }
+    }
+}
+
+typedef struct {
+    Bench *bench;
+    const BenchProfile *profile;
+    guint tiles;
+} MosaicSetup;
+
+static void setup_mosaic(BenchPlayer *player, guint index, gpointer user_data)
+{
+    MosaicSetup *mosaic = (MosaicSetup *)user_data;
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player->player);
+    gchar *uri = bench_server_uri(mosaic->bench->port, mosaic->profile, FALSE);
+    guint i;
+
+    configuration->mosaicColumns = (guint)ceil(sqrt(mosaic->tiles));
+    configuration->mosaicRows = (mosaic->tiles + configuration->mosaicColumns - 1) / configuration->mosaicColumns;
+    for (i = 0; i < mosaic->tiles; i++) {
+        rct_gst_set_mosaic_tile(player->player, i, uri);
+    }
+    g_free(uri);
+}
+
+// N tiles composited by one player against N players
+static void scenario_mosaic(Bench *bench)
+{
+    guint i, count;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        for (count = 2; count <= bench->max_players; count *= 2) {
+            MosaicSetup mosaic = { bench, g_ptr_array_index(bench->profiles, i), count };
+            BenchRunOptions options = { setup_mosaic, &mosaic, TRUE, TRUE };
+            gchar *variant = g_strdup_printf("mosaic_%u", count);
+
+            run_players(bench, "mosaic", variant, mosaic.profile, 1, &options);
+            g_free(variant);
+            run_players(bench, "mosaic", "players", mosaic.profile, count, NULL);
+        }
+    }
+}
+
+/************
+ TRANSITIONS
+ ***********/
+static const gchar *switch_mode_names[] = { "source_only", "full_restart", "standby", "resume", "shared" };
+
+static void setup_switch_mode(BenchPlayer *player, guint index, gpointer user_data)
+{
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player->player);
+
+    configuration->uriSwitchMode = (RctGstUriSwitchMode)GPOINTER_TO_INT(user_data);
+    if (configuration->uriSwitchMode == RCT_GST_URI_SWITCH_STANDBY) {
+        configuration->uriSwitchMode = RCT_GST_URI_SWITCH_SOURCE_ONLY;
+        configuration->standbyPoolSize = 2;
+    }
+}
+
+// Back and forth between the two mounts of a profile, the time to the first frame of the new uri
+static void measure_switches(Bench *bench, const BenchProfile *profile, RctGstUriSwitchMode mode, const gchar *variant)
+{
+    BenchRecord *record = bench_record_new("switch", variant);
+    BenchPlayer *player = bench_player_new();
+    gchar *uris[2] = { bench_server_uri(bench->port, profile, FALSE), bench_server_uri(bench->port, profile, TRUE) };
+    gint64 ttff_us, sum_us = 0, min_us = G_MAXINT64, max_us = 0;
+    guint shown = 0, errors, count, i;
+    RctGstUriSwitchMode reported = mode;
+
+    setup_switch_mode(player, 0, GINT_TO_POINTER(mode));
+    bench_player_start(player, uris[0]);
+    if (bench_player_wait_first_frame(player, 0, FIRST_FRAME_TIMEOUT_US, NULL)) {
+        if (mode == RCT_GST_URI_SWITCH_STANDBY) {
+            rct_gst_prepare_uri(player->player, uris[1]);
+        }
+        g_usleep(WARMUP_US);
+        for (i = 1; i <= REPEATS; i++) {
+            count = bench_player_count_first_frames(player);
+            rct_gst_set_uri(player->player, uris[i % 2]);
+            if (bench_player_wait_first_frame(player, count, FIRST_FRAME_TIMEOUT_US, &ttff_us)) {
+                sum_us += ttff_us;
+                min_us = MIN(min_us, ttff_us);
+                max_us = MAX(max_us, ttff_us);
+                shown++;
+                g_mutex_lock(&player->lock);
+                reported = player->last_mode;
+                g_mutex_unlock(&player->lock);
+            }
+            g_usleep(WARMUP_US / 2);
+        }
+    }
+
+    g_mutex_lock(&player->lock);
+    errors = player->errors;
+    g_mutex_unlock(&player->lock);
+
+    record_profile(record, profile);
+    bench_record_set_int(record, "switches", REPEATS);
+    bench_record_set_int(record, "first_frames", shown);
+    bench_record_set_double(record, "switch_ms", shown ? sum_us / 1000.0 / shown : NAN);
+    bench_record_set_double(record, "switch_min_ms", shown ? min_us / 1000.0 : NAN);
+    bench_record_set_double(record, "switch_max_ms", shown ? max_us / 1000.0 : NAN);
+    bench_record_set_string(record, "reported_mode", switch_mode_names[reported]);
+    bench_record_set_int(record, "errors", errors);
+    bench_report_write(bench->report, record);
+
+    bench_player_free(player);
+    g_free(uris[0]);
+    g_free(uris[1]);
+}
+
+static void scenario_switch(Bench *bench)
+{
+    guint i;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        const BenchProfile *profile = g_ptr_array_index(bench->profiles, i);
+
+        measure_switches(bench, profile, RCT_GST_URI_SWITCH_SOURCE_ONLY, "source_only");
+        measure_switches(bench, profile, RCT_GST_URI_SWITCH_FULL_RESTART, "full_restart");
+        measure_switches(bench, profile, RCT_GST_URI_SWITCH_STANDBY, "standby");
+    }
+}
+
+// Time to the first frame after a resume, and what a suspended player keeps in memory
+static void scenario_resume(Bench *bench)
+{
+    guint i, j, count, shown;
+
+    for (i = 0; i < bench->profiles->len; i++) {
+        const BenchProfile *profile = g_ptr_array_index(bench->profiles, i);
+        BenchRecord *record = bench_record_new("resume", "suspend_resume");
+        BenchPlayer *player = bench_player_new();
+        gchar *uri = bench_server_uri(bench->port, profile, FALSE);
+        gint64 rss_playing = -1, rss_suspended = -1, ttff_us, sum_us = 0, max_us = 0;
+
+        shown = 0;
+        bench_player_start(player, uri);
+        if (bench_player_wait_first_frame(player, 0, FIRST_FRAME_TIMEOUT_US, NULL)) {
+            g_usleep(WARMUP_US);
+            rss_playing = bench_rss_kb();
+            for (j = 0; j < REPEATS / 2; j++) {
+                rct_gst_suspend(player->player);
+                g_usleep(2 * WARMUP_US);
+                rss_suspended = bench_rss_kb();
+                count = bench_player_count_first_frames(player);
+                rct_gst_resume(player->player);
+                if (bench_player_wait_first_frame(player, count, FIRST_FRAME_TIMEOUT_US, &ttff_us)) {
+                    sum_us += ttff_us;
+                    max_us = MAX(max_us, ttff_us);
+                    shown++;
+                }
+                g_usleep(WARMUP_US);
+            }
+        }
+
+        record_profile(record, profile);
+        bench_record_set_int(record, "resumes", REPEATS / 2);
+        bench_record_set_int(record, "first_frames", shown);
+        bench_record_set_double(record, "resume_ms", shown ? sum_us / 1000.0 / shown : NAN);
+        bench_record_set_double(record, "resume_max_ms", shown ? max_us / 1000.0 : NAN);
+        bench_record_set_int(record, "rss_playing_kb", rss_playing);
+        bench_record_set_int(record, "rss_suspended_kb", rss_suspended);
+        bench_report_write(bench->report, record);
+
+        bench_player_free(player);
+        g_free(uri);
+    }
+}
+
+/************
+ SEEKING
+ ***********/
+// Local file the seeks and scrubs land in, a keyframe every second
+#define SCRUB_FILE_S 120
+#define SCRUB_FRAMERATE 30
+
+// Enough for a thumbnail of every keyframe of the file
+#define SCRUB_CACHE_BYTES (16 * 1024 * 1024)
+#define SCRUB_THUMBNAIL_WIDTH 160
+
+// Time the cache gets to decode its thumbnails before the first scrub
+#define SCRUB_FILL_US (5 * G_USEC_PER_SEC)
+
+// Encodes the file on profile, NULL when it could not be written
+static gchar *make_scrub_file(const BenchProfile *profile)
+{
+    gchar *path = g_build_filename(g_get_tmp_dir(), "rct_gst_bench_scrub.mp4", NULL);
+    gchar *launch = g_strdup_printf("videotestsrc num-buffers=%d pattern=ball ! "
+                                    "video/x-raw,width=%d,height=%d,framerate=%d/1 ! "
+                                    "x264enc speed-preset=ultrafast bitrate=%u key-int-max=%d ! h264parse ! "
+                                    "mp4mux ! filesink location=\"%s\"",
+                                    SCRUB_FILE_S * SCRUB_FRAMERATE, profile->width, profile->height,
+                                    SCRUB_FRAMERATE, profile->kbps, SCRUB_FRAMERATE, path);
+    GError *error = NULL;
+    GstElement *pipeline = gst_parse_launch(launch, &error);
+    GstMessage *message = NULL;
+    GstBus *bus;
+
+    g_free(launch);
+    if (!pipeline) {
+        g_printerr("Scrub file not encoded: %s\n", error->message);
+        g_clear_error(&error);
+        g_free(path);
+        return NULL;
+    }
+    bus = gst_element_get_bus(pipeline);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    message = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    if (GST_MESSAGE_TYPE(message) != GST_MESSAGE_EOS) {
+        g_printerr("Scrub file not encoded\n");
+        unlink(path);
+        g_free(path);
+        path = NULL;
+    }
+    gst_message_unref(message);
+    gst_object_unref(bus);
+    gst_object_unref(pipeline);
+    return path;
+}
+
+// Accurate seeks to their onSeekDone, then scrubs to their onScrubPreview and to the frame of their seek.
+// Times run from the call, the command dispatch included.
+static void measure_scrubs(Bench *bench, const BenchProfile *profile, const gchar *uri, gboolean cached)
+{
+    BenchRecord *record = bench_record_new("scrub", cached ? "cache" : "no_cache");
+    BenchPlayer *player = bench_player_new();
+    RctGstConfiguration *configuration = rct_gst_get_configuration(player->player);
+    gint64 position_us, issued_at, done_at, seek_sum_us = 0, seek_max_us = 0, frame_sum_us = 0;
+    gint64 preview_sum_us = 0, preview_max_us = 0;
+    guint seeks = 0, frames = 0, previews = 0, errors, count, previewed, i;
+
+    if (cached) {
+        configuration->scrubCacheBytes = SCRUB_CACHE_BYTES;
+        configuration->scrubThumbnailWidth = SCRUB_THUMBNAIL_WIDTH;
+    }
+    bench_player_start(player, uri);
+    if (bench_player_wait_first_frame(player, 0, FIRST_FRAME_TIMEOUT_US, NULL)) {
+        g_usleep(cached ? SCRUB_FILL_US : WARMUP_US);
+        for (i = 0; i < REPEATS; i++) {
+            // Spread over the file in a shuffled order, the decoder never just carries on
+            position_us = (2 * ((i * 7) % REPEATS) + 1) * (gint64)SCRUB_FILE_S * G_USEC_PER_SEC / (2 * REPEATS);
+            count = bench_player_count_seeks(player);
+            issued_at = g_get_monotonic_time();
+            rct_gst_seek(player->player, position_us, RCT_GST_SEEK_ACCURATE);
+            if (bench_player_wait_seek(player, count, FIRST_FRAME_TIMEOUT_US, &done_at)) {
+                seek_sum_us += done_at - issued_at;
+                seek_max_us = MAX(seek_max_us, done_at - issued_at);
+                seeks++;
+            }
+            g_usleep(WARMUP_US / 2);
+
+            // Across the file from the seek
+            position_us = (gint64)SCRUB_FILE_S * G_USEC_PER_SEC - position_us;
+            count = bench_player_count_seeks(player);
+            previewed = bench_player_count_previews(player);
+            issued_at = g_get_monotonic_time();
+            rct_gst_scrub(player->player, position_us);
+            if (cached && bench_player_wait_preview(player, previewed, FIRST_FRAME_TIMEOUT_US, &done_at)) {
+                preview_sum_us += done_at - issued_at;
+                preview_max_us = MAX(preview_max_us, done_at - issued_at);
+                previews++;
+            }
+            if (bench_player_wait_seek(player, count, FIRST_FRAME_TIMEOUT_US, &done_at)) {
+                frame_sum_us += done_at - issued_at;
+                frames++;
+            }
+            g_usleep(WARMUP_US / 2);
+        }
+    }
+
+    g_mutex_lock(&player->lock);
+    errors = player->errors;
+    g_mutex_unlock(&player->lock);
+
+    record_profile(record, profile);
+    bench_record_set_int(record, "file_s", SCRUB_FILE_S);
+    bench_record_set_int(record, "seeks", REPEATS);
+    bench_record_set_int(record, "seeks_done", seeks);
+    bench_record_set_double(record, "seek_ms", seeks ? seek_sum_us / 1000.0 / seeks : NAN);
+    bench_record_set_double(record, "seek_max_ms", seeks ? seek_max_us / 1000.0 : NAN);
+    bench_record_set_int(record, "scrubs", REPEATS);
+    bench_record_set_int(record, "previews", previews);
+    bench_record_set_double(record, "preview_ms", previews ? preview_sum_us / 1000.0 / previews : NAN);
+    bench_record_set_double(record, "preview_max_ms", previews ? preview_max_us / 1000.0 : NAN);
+    bench_record_set_double(record, "scrub_frame_ms", frames ? frame_sum_us / 1000.0 / frames : NAN);
+    bench_record_set_int(record, "errors", errors);
+    bench_report_write(bench->report, record);
+
+    bench_player_free(player);
+}
+
+// Seek and scrub latencies on a long local file, with and without the scrub cache
+static void scenario_scrub(Bench *bench)
+{
+    const BenchProfile *profile = g_ptr_array_index(bench->profiles, 0);
+    gchar *path = make_scrub_file(profile);
+    gchar *uri;
+
+    if (!path) {
+        bench->failed = TRUE;
+        return;
+    }
+    uri = g_filename_to_uri(path, NULL, NULL);
+    measure_scrubs(bench, profile, uri, FALSE);
+    measure_scrubs(bench, profile, uri, TRUE);
+    unlink(path);
+    g_free(uri);
+    g_free(path);
+}
+
+/************
+ LOGGING
+ ***********/
+// Lines between flushes of the enabled run, well below what the ring holds
+#define LOG_BLOCK 256
+
+static void cb_discard_log(gint level, const gchar *category, const gchar *message, gpointer user_data)
+{
+}
+
+// Only the calls are timed, the ring is emptied between blocks so no line is dropped
+static gdouble time_log_calls(guint64 calls)
+{
+    gint64 elapsed_us = 0;
+    guint64 i = 0;
+
+    while (i < calls) {
+        gint64 started_at = g_get_monotonic_time();
+        guint64 block_end = MIN(i + LOG_BLOCK, calls);
+
+        for (; i < block_end; i++) {
+            LOGD("Benchmark line %" G_GUINT64_FORMAT " of player %p", i, (gpointer)&i);
+        }
+        elapsed_us += g_get_monotonic_time() - started_at;
+        rct_gst_log_flush();
+    }
+    return elapsed_us * 1000.0 / calls;
+}
+
+// Cost of a debug line below the runtime level, and of one formatted into the ring. A line above
+// RCT_GST_LOG_MAX_LEVEL is not compiled at all.
+static void scenario_log(Bench *bench)
+{
+    static const struct {
+        const gchar *variant;
+        gint level;
+    } runs[] = {
+        { "disabled", RCT_GST_LOG_INFO },
+        { "enabled", RCT_GST_LOG_DEBUG },
+    };
+    guint i;
+
+    rct_gst_log_flush();
+    rct_gst_log_set_output(cb_discard_log, NULL);
+    for (i = 0; i < G_N_ELEMENTS(runs); i++) {
+        BenchRecord *record = bench_record_new("log", runs[i].variant);
+        guint dropped = rct_gst_log_get_dropped();
+
+        rct_gst_log_set_category_level(LOG_TAG, runs[i].level);
+        bench_record_set_int(record, "calls", bench->log_calls);
+        bench_record_set_double(record, "ns_per_call", time_log_calls(bench->log_calls));
+        bench_record_set_int(record, "dropped", rct_gst_log_get_dropped() - dropped);
+        bench_report_write(bench->report, record);
+    }
+    rct_gst_log_set_output(NULL, NULL);
+    rct_gst_log_configure(bench->log_level);
+}
+
+/************
+ SOAK
+ ***********/
+// Cycles before the baseline, pools and caches fill up first
+#define SOAK_WARMUP_CYCLES 60
+
+// Cycles between two samples of the live objects
+#define SOAK_CHECKPOINT_CYCLES 300
+
+// Growth tolerated from the baseline to the lowest of the last checkpoints, buffers in flight come and go
+#define SOAK_CHECKPOINTS_COMPARED 3
+#define SOAK_MAX_RSS_GROWTH_KB 8192
+#define SOAK_MAX_OBJECT_GROWTH 16
+#define SOAK_MAX_MINI_OBJECT_GROWTH 64
+
+// Between a pause and the next play
+#define SOAK_PAUSE_US (200 * 1000)
+
+typedef enum {
+    SOAK_SWITCH_URI,
+    SOAK_TOGGLE_STATE,
+    SOAK_SWAP_SURFACE,
+    SOAK_ACTION_COUNT
+} SoakAction;
+
+static const gchar *soak_action_names[] = { "uri_switches", "state_toggles", "surface_swaps" };
+
+// Window handles nothing draws on, fakesink is no video overlay
+static const guintptr soak_surfaces[] = { 0x1000, 0x2000 };
+
+// One churn step, FALSE when no frame came after it
+static gboolean soak_cycle(BenchPlayer *player, guint cycle, gchar **uris)
+{
+    guint round = cycle / SOAK_ACTION_COUNT;
+    guint count = bench_player_count_first_frames(player);
+
+    switch ((SoakAction)(cycle % SOAK_ACTION_COUNT)) {
+        case SOAK_SWITCH_URI:
+            rct_gst_set_uri(player->player, uris[(round + 1) % 2]);
+            return bench_player_wait_first_frame(player, count, FIRST_FRAME_TIMEOUT_US, NULL);
+
+        case SOAK_TOGGLE_STATE:
+            rct_gst_set_pipeline_state(player->player, GST_STATE_PAUSED);
+            g_usleep(SOAK_PAUSE_US);
+            rct_gst_set_pipeline_state(player->player, GST_STATE_PLAYING);
+            g_usleep(SOAK_PAUSE_US);
+            return TRUE;
+
+        case SOAK_SWAP_SURFACE:
+        default:
+            // What the view does when its surface is destroyed and another one is created
+            rct_gst_suspend(player->player);
+            rct_gst_set_drawable_surface(player->player, 0);
+            rct_gst_set_drawable_surface(player->player, soak_surfaces[round % G_N_ELEMENTS(soak_surfaces)]);
+            rct_gst_resume(player->player);
+            return bench_player_wait_first_frame(player, count, FIRST_FRAME_TIMEOUT_US, NULL);
+    }
+}
+
+static void record_checkpoint(Bench *bench, guint cycle, const BenchLeakSample *sample)
+{
+    BenchRecord *record = bench_record_new("soak", "checkpoint");
+
+    bench_record_set_int(record, "cycle", cycle);
+    bench_record_set_int(record, "rss_kb", sample->rss_kb);
+    bench_record_set_int(record, "objects", sample->objects);
+    bench_record_set_int(record, "buffers", sample->buffers);
+    bench_record_set_int(record, "caps", sample->caps);
+    bench_report_write(bench->report, record);
+}
+
+// Lowest value of the last checkpoints, minus the baseline. -1 values were not counted.
+static gint64 soak_growth(const BenchLeakSample *baseline, const BenchLeakSample *checkpoints, guint count,
+                          gsize offset)
+{
+    gint64 from = G_STRUCT_MEMBER(gint64, baseline, offset);
+    gint64 lowest = G_MAXINT64;
+    guint i;
+
+    if (from < 0 || count == 0) {
+        return 0;
+    }
+    for (i = 0; i < MIN(count, SOAK_CHECKPOINTS_COMPARED); i++) {
+        lowest = MIN(lowest, G_STRUCT_MEMBER(gint64, &checkpoints[i], offset));
+    }
+    return lowest - from;
+}
+
+// Switches uris, pauses and swaps surfaces in turn for soak_minutes, and fails when RSS or the live
+// objects grow from the baseline. Live objects are only counted with instance-count and the leaks
+// tracer, main restarts the process with them.
+static void scenario_soak(Bench *bench)
+{
+    const BenchProfile *profile = g_ptr_array_index(bench->profiles, 0);
+    BenchRecord *record = bench_record_new("soak", "churn");
+    BenchPlayer *player = bench_player_new();
+    gchar *uris[2] = { bench_server_uri(bench->port, profile, FALSE), bench_server_uri(bench->port, profile, TRUE) };
+    BenchLeakSample baseline = { 0 }, last = { 0 };
+    BenchLeakSample checkpoints[SOAK_CHECKPOINTS_COMPARED];     // Most recent first
+    guint actions[SOAK_ACTION_COUNT] = { 0 }, failures = 0, checkpoint_count = 0, cycle, i;
+    gint64 ends_at, rss_growth, object_growth, buffer_growth, caps_growth;
+    gboolean passed;
+    gchar *grown;
+
+    memset(checkpoints, 0, sizeof(checkpoints));
+    bench_player_start(player, uris[0]);
+    bench_player_wait_first_frame(player, 0, FIRST_FRAME_TIMEOUT_US, NULL);
+    ends_at = g_get_monotonic_time() + (gint64)bench->soak_minutes * 60 * G_USEC_PER_SEC;
+
+    for (cycle = 0; cycle < SOAK_WARMUP_CYCLES || g_get_monotonic_time() < ends_at; cycle++) {
+        if (!soak_cycle(player, cycle, uris)) {
+            failures++;
+        }
+        actions[cycle % SOAK_ACTION_COUNT]++;
+
+        if (cycle + 1 == SOAK_WARMUP_CYCLES) {
+            bench_leaks_sample(&baseline);
+            record_checkpoint(bench, cycle + 1, &baseline);
+        } else if (cycle + 1 > SOAK_WARMUP_CYCLES && (cycle + 1 - SOAK_WARMUP_CYCLES) % SOAK_CHECKPOINT_CYCLES == 0) {
+            bench_leaks_sample_clear(&checkpoints[SOAK_CHECKPOINTS_COMPARED - 1]);
+            memmove(&checkpoints[1], &checkpoints[0], (SOAK_CHECKPOINTS_COMPARED - 1) * sizeof(BenchLeakSample));
+            bench_leaks_sample(&checkpoints[0]);
+            checkpoint_count++;
+            record_checkpoint(bench, cycle + 1, &checkpoints[0]);
+            LOGI("Soak: %u cycles, RSS %" G_GINT64_FORMAT " kB, %" G_GINT64_FORMAT " objects, %" G_GINT64_FORMAT
+                 " buffers", cycle + 1, checkpoints[0].rss_kb, checkpoints[0].objects, checkpoints[0].buffers);
+        }
+    }
+
+    // Pipeline down to an idle player, what is still alive then was not released by the churn
+    rct_gst_set_pipeline_state(player->player, GST_STATE_NULL);
+    g_usleep(WARMUP_US);
+    bench_leaks_sample(&last);
+
+    rss_growth = soak_growth(&baseline, checkpoints, checkpoint_count, G_STRUCT_OFFSET(BenchLeakSample, rss_kb));
+    object_growth = soak_growth(&baseline, checkpoints, checkpoint_count, G_STRUCT_OFFSET(BenchLeakSample, objects));
+    buffer_growth = soak_growth(&baseline, checkpoints, checkpoint_count, G_STRUCT_OFFSET(BenchLeakSample, buffers));
+    caps_growth = soak_growth(&baseline, checkpoints, checkpoint_count, G_STRUCT_OFFSET(BenchLeakSample, caps));
+    passed = checkpoint_count > 0 &&
+             rss_growth <= SOAK_MAX_RSS_GROWTH_KB &&
+             object_growth <= SOAK_MAX_OBJECT_GROWTH &&
+             buffer_growth + caps_growth <= SOAK_MAX_MINI_OBJECT_GROWTH;
+    grown = checkpoint_count > 0 ? bench_leaks_describe_growth(&baseline, &checkpoints[0], 8) : g_strdup("");
+
+    record_profile(record, profile);
+    bench_record_set_int(record, "minutes", bench->soak_minutes);
+    bench_record_set_int(record, "cycles", cycle);
+    for (i = 0; i < SOAK_ACTION_COUNT; i++) {
+        bench_record_set_int(record, soak_action_names[i], actions[i]);
+    }
+    bench_record_set_int(record, "failures", failures);
+    bench_record_set_int(record, "checkpoints", checkpoint_count);
+    bench_record_set_int(record, "rss_growth_kb", rss_growth);
+    bench_record_set_int(record, "object_growth", baseline.objects < 0 ? -1 : object_growth);
+    bench_record_set_int(record, "buffer_growth", baseline.buffers < 0 ? -1 : buffer_growth);
+    bench_record_set_int(record, "caps_growth", baseline.caps < 0 ? -1 : caps_growth);
+    bench_record_set_int(record, "objects_stopped", last.objects);
+    bench_record_set_int(record, "buffers_stopped", last.buffers);
+    bench_record_set_string(record, "grown_types", grown);
+    bench_record_set_string(record, "result", passed ? "passed" : "failed");
+    bench_report_write(bench->report, record);
+    if (!passed) {
+        g_printerr("Soak failed: RSS +%" G_GINT64_FORMAT " kB, %s\n", rss_growth, *grown ? grown : "no type grew");
+        bench->failed = TRUE;
+    }
+
+    bench_player_free(player);
+    bench_leaks_sample_clear(&baseline);
+    bench_leaks_sample_clear(&last);
+    for (i = 0; i < SOAK_CHECKPOINTS_COMPARED; i++) {
+        bench_leaks_sample_clear(&checkpoints[i]);
+    }
+    g_free(grown);
+    g_free(uris[0]);
+    g_free(uris[1]);
+}
+
+/************
+ COLD START
+ ***********/
+// Child process side: one player in a fresh process, prewarmed or not, its startup phases as one record
+static int run_cold_start(Bench *bench, const gchar *mode)
+{
+    const BenchProfile *profile = g_ptr_array_index(bench->profiles, 0);
+    BenchRecord *record = bench_record_new("startup", mode);
+    gchar *uri = bench_server_uri(bench->port, profile, FALSE);
+    gint64 timings_us[RCT_GST_STARTUP_PHASE_COUNT], ttff_us = -1;
+    BenchPlayer *player;
+    gboolean shown;
+    guint i;
+
+    if (g_strcmp0(mode, "prewarm") == 0) {
+        rct_gst_startup_prewarm();
+    }
+    g_usleep((gulong)bench->startup_delay_ms * 1000);
+    player = bench_player_new();
+    bench_player_start(player, uri);
+    shown = bench_player_wait_first_frame(player, 0, FIRST_FRAME_TIMEOUT_US, &ttff_us);
+
+    rct_gst_startup_get_timings(timings_us);
+    record_profile(record, profile);
+    bench_record_set_int(record, "delay_ms", bench->startup_delay_ms);
+    for (i = 0; i < RCT_GST_STARTUP_PHASE_COUNT; i++) {
+        gchar *key = g_strdup_printf("%s_ms", rct_gst_startup_phase_get_name((RctGstStartupPhase)i));
+
+        bench_record_set_double(record, key, timings_us[i] >= 0 ? timings_us[i] / 1000.0 : NAN);
+        g_free(key);
+    }
+    // From the player creation, what the view waits for
+    bench_record_set_double(record, "player_to_first_frame_ms",
+                            timings_us[RCT_GST_STARTUP_FIRST_FRAME] >= 0
+                                ? (timings_us[RCT_GST_STARTUP_FIRST_FRAME] -
+                                   timings_us[RCT_GST_STARTUP_PLAYER_CREATED]) / 1000.0
+                                : NAN);
+    bench_record_set_double(record, "ttff_ms", shown ? ttff_us / 1000.0 : NAN);
+    bench_record_set_int(record, "rss_kb", bench_rss_kb());
+    bench_report_write(bench->report, record);
+
+    bench_player_free(player);
+    g_free(uri);
+    return shown ? 0 : 1;
+}
+
+// Every run is a new process, nothing is warm but what the mode prewarms
+static void scenario_startup(Bench *bench)
+{
+    static const gchar *modes[] = { "plain", "prewarm" };
+    const BenchProfile *profile = g_ptr_array_index(bench->profiles, 0);
+    gchar *port = g_strdup_printf("%u", bench->port);
+    gchar *delay = g_strdup_printf("%u", bench->startup_delay_ms);
+    gchar *output, **lines;
+    guint i, j, k;
+
+    for (i = 0; i < REPEATS / 2; i++) {
+        for (j = 0; j < G_N_ELEMENTS(modes); j++) {
+            gchar *argv[] = { "/proc/self/exe", "--cold-start", (gchar *)modes[j], "--port", port,
+                              "--profiles", (gchar *)profile->name, "--startup-delay", delay, NULL };
+
+            output = NULL;
+            if (!g_spawn_sync(NULL, argv, NULL, G_SPAWN_DEFAULT, NULL, NULL, &output, NULL, NULL, NULL)) {
+                continue;
+            }
+            lines = g_strsplit(output, "\n", -1);
+            for (k = 0; lines[k]; k++) {
+                if (*g_strstrip(lines[k])) {
+                    bench_report_write_line(bench->report, lines[k]);
+                }
+            }
+            g_strfreev(lines);
+            g_free(output);
+        }
+    }
+    g_free(port);
+    g_free(delay);
+}
+
+static const BenchScenario scenarios[] = {
+    { "ttff", "time to first frame, CPU, RSS and latency of one stream", scenario_ttff },
+    { "switch", "uri switch latency per switch mode", scenario_switch },
+    { "multi_player", "players side by side, nothing shared", scenario_multi_player },
+    { "convert", "forced videoconvert against passthrough", scenario_convert },
+    { "pipelined", "single streaming thread against queues", scenario_pipelined },
+    { "resume", "resume latency and suspended RSS", scenario_resume },
+    { "scrub", "seek and scrub preview latency, with and without the scrub cache", scenario_scrub },
+    { "qos", "degradation ladder with every core busy", scenario_qos },
+    { "netem", "delay and loss on loopback, needs root", scenario_netem },
+    { "transport", "time to first frame per RTSP transport", scenario_transport },
+    { "shared_decode", "decode CPU against the number of views", scenario_shared_decode },
+    { "mosaic", "mosaic of N tiles against N players", scenario_mosaic },
+    { "log", "cost per debug line", scenario_log },
+    { "soak", "uri, state and surface churn, fails on RSS or live object growth", scenario_soak },
+    { "startup", "cold start phases, with and without prewarm", scenario_startup },
+};
+
+// Scenarios run when none is asked for, the others take long or need root
+static const gchar *default_scenarios = "ttff,switch,multi_player,convert,pipelined,resume,scrub,log,startup";
+
+static const BenchScenario *find_scenario(const gchar *name)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(scenarios); i++) {
+        if (g_strcmp0(scenarios[i].name, name) == 0) {
+            return &scenarios[i];
+        }
+    }
+    return NULL;
+}
+
+static void list_scenarios(void)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(scenarios); i++) {
+        g_print("%-14s %s\n", scenarios[i].name, scenarios[i].description);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    gboolean serve = FALSE, list = FALSE;
+    gint port = 8554, duration = 10, max_players = 8, soak_minutes = 60, startup_delay = 300;
+    gint64 log_calls = 1000000;
+    gchar *output = NULL, *scenario_names = NULL, *profile_names = NULL, *cold_start = NULL, *log_level = NULL;
+    gchar **names;
+    GOptionEntry entries[] = {
+        { "scenarios", 's', 0, G_OPTION_ARG_STRING, &scenario_names, "Comma separated scenarios to run", "LIST" },
+        { "list", 'l', 0, G_OPTION_ARG_NONE, &list, "List the scenarios", NULL },
+        { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, "JSON lines file, stdout by default", "FILE" },
+        { "profiles", 'p', 0, G_OPTION_ARG_STRING, &profile_names, "Comma separated profiles, 360p,720p,1080p", "LIST" },
+        { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Seconds measured per run", "S" },
+        { "players", 'n', 0, G_OPTION_ARG_INT, &max_players, "Most players run at once", "N" },
+        { "soak-minutes", 0, 0, G_OPTION_ARG_INT, &soak_minutes, "Length of the soak", "M" },
+        { "log-calls", 0, 0, G_OPTION_ARG_INT64, &log_calls, "Lines timed by the log scenario", "N" },
+        { "log", 0, 0, G_OPTION_ARG_STRING, &log_level, "Native log levels, info,GStreamerSource:debug", "SPEC" },
+        { "startup-delay", 0, 0, G_OPTION_ARG_INT, &startup_delay, "Milliseconds from gst_init to the first "
+          "player in the startup scenario", "MS" },
+        { "port", 0, 0, G_OPTION_ARG_INT, &port, "Port of the local RTSP server", "PORT" },
+        { "serve", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_NONE, &serve, NULL, NULL },
+        { "cold-start", 0, G_OPTION_FLAG_HIDDEN, G_OPTION_ARG_STRING, &cold_start, NULL, NULL },
+        { NULL }
+    };
+    GOptionContext *context = g_option_context_new("- native player benchmarks");
+    GError *error = NULL;
+    Bench bench = { 0 };
+    GPid server;
+    gchar **original_argv = g_strdupv(argv);
+    guint i;
+    int status;
+
+    rct_gst_startup_mark(RCT_GST_STARTUP_LIBRARY_LOADED);
+    g_option_context_add_main_entries(context, entries, NULL);
+    g_option_context_add_group(context, gst_init_get_option_group());
+    if (!g_option_context_parse(context, &argc, &argv, &error)) {
+        g_printerr("%s\n", error->message);
+        return 2;
+    }
+    g_option_context_free(context);
+    if (!rct_gst_log_configure(log_level ? log_level : "info")) {
+        g_printerr("Invalid log levels %s\n", log_level);
+        return 2;
+    }
+    gst_init(NULL, NULL);
+    rct_gst_startup_mark(RCT_GST_STARTUP_GST_INITIALIZED);
+
+    if (serve) {
+        return bench_server_run(port);
+    }
+    if (list) {
+        list_scenarios();
+        return 0;
+    }
+
+    bench.port = port;
+    bench.duration_us = (gint64)MAX(duration, 1) * G_USEC_PER_SEC;
+    bench.max_players = MAX(max_players, 1);
+    bench.soak_minutes = MAX(soak_minutes, 1);
+    bench.log_calls = MAX(log_calls, 1);
+    bench.log_level = log_level ? log_level : "info";
+    bench.startup_delay_ms = MAX(startup_delay, 0);
+    bench.profiles = g_ptr_array_new();
+    names = g_strsplit(profile_names ? profile_names : "360p,720p,1080p", ",", -1);
+    for (i = 0; names[i]; i++) {
+        const BenchProfile *profile = bench_profile_find(g_strstrip(names[i]));
+
+        if (!profile) {
+            g_printerr("Unknown profile %s\n", names[i]);
+            return 2;
+        }
+        g_ptr_array_add(bench.profiles, (gpointer)profile);
+    }
+    g_strfreev(names);
+    if (cold_start) {
+        bench.report = bench_report_new(NULL, NULL);
+        status = run_cold_start(&bench, cold_start);
+        bench_report_free(bench.report);
+        return status;
+    }
+    names = g_strsplit(scenario_names ? scenario_names : default_scenarios, ",", -1);
+    for (i = 0; names[i]; i++) {
+        if (!find_scenario(g_strstrip(names[i]))) {
+            g_printerr("Unknown scenario %s, --list shows them\n", names[i]);
+            return 2;
+        }
+        // Counting slows every allocation down, the other scenarios of the run pay for it as well
+        if (g_strcmp0(names[i], "soak") == 0) {
+            bench_leaks_enable(original_argv);
+        }
+    }
+
+    bench.report = bench_report_new(output, &error);
+    if (!bench.report) {
+        g_printerr("%s\n", error->message);
+        return 1;
+    }
+    if (!bench_server_spawn(bench.port, &server, &error)) {
+        g_printerr("%s\n", error->message);
+        bench_report_free(bench.report);
+        return 1;
+    }
+
+    for (i = 0; names[i]; i++) {
+        LOGI("Running %s", names[i]);
+        find_scenario(names[i])->run(&bench);
+    }
+
+    bench_server_stop(server);
+    bench_report_free(bench.report);
+    g_ptr_array_free(bench.profiles, TRUE);
+    g_strfreev(names);
+    g_free(output);
+    g_free(scenario_names);
+    g_free(profile_names);
+    g_free(log_level);
+    g_strfreev(original_argv);
+    rct_gst_log_flush();
+    return bench.failed ? 1 : 0;
+}
@@ -0,0 +1,157 @@
+//
+//  test_command_queue.c
+//
+//  Commands reach the handler in posting order, from one producer or from
+//  several at once, and the ones never handled are freed with the queue.
+//
+
+#include <gst/gst.h>
+#include "gstreamer_command_queue.h"
+
+#define PRODUCERS 4
+#define COMMANDS_PER_PRODUCER 10000
+
+typedef struct {
+    GArray *handled;                    // RctGstCommand copies, owned pointers are freed once handled
+} Recorder;
+
+static void record(RctGstCommand *command, gpointer user_data)
+{
+    Recorder *recorder = (Recorder *)user_data;
+
+    g_array_append_val(recorder->handled, *command);
+}
+
+static void drain(GMainContext *context)
+{
+    while (g_main_context_iteration(context, FALSE)) {
+    }
+}
+
+static void test_posting_order(void)
+{
+    static const RctGstCommandType posted[] = {
+        RCT_GST_COMMAND_INIT, RCT_GST_COMMAND_SET_URI, RCT_GST_COMMAND_SET_PIPELINE_STATE,
+        RCT_GST_COMMAND_SET_STATS_REFRESH_RATE, RCT_GST_COMMAND_SUSPEND, RCT_GST_COMMAND_RESUME
+    };
+    GMainContext *context = g_main_context_new();
+    Recorder recorder = { g_array_new(FALSE, FALSE, sizeof(RctGstCommand)) };
+    RctGstCommandQueue *queue = rct_gst_command_queue_new(context, record, &recorder);
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS(posted); i++) {
+        RctGstCommand *command = rct_gst_command_new(posted[i]);
+
+        if (posted[i] == RCT_GST_COMMAND_SET_URI) {
+            command->args.uri = g_strdup("rtsp://127.0.0.1/stream");
+        }
+        rct_gst_command_queue_push(queue, command);
+    }
+    g_assert_cmpuint(recorder.handled->len, ==, 0);
+
+    drain(context);
+    g_assert_cmpuint(recorder.handled->len, ==, G_N_ELEMENTS(posted));
+    for (i = 0; i < G_N_ELEMENTS(posted); i++) {
+        g_assert_cmpint(g_array_index(recorder.handled, RctGstCommand, i).type, ==, posted[i]);
+    }
+
+    rct_gst_command_queue_free(queue);
+    g_array_free(recorder.handled, TRUE);
+    g_main_context_unref(context);
+}
+
+typedef struct {
+    RctGstCommandQueue *queue;
+    guint producer;
+} Producer;
+
+static gpointer produce(gpointer data)
+{
+    Producer *producer = (Producer *)data;
+    guint i;
+
+    for (i = 0; i < COMMANDS_PER_PRODUCER; i++) {
+        RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_STATS_REFRESH_RATE);
+
+        command->args.refresh_rate = producer->producer * COMMANDS_PER_PRODUCER + i;
+        rct_gst_command_queue_push(producer->queue, command);
+    }
+    return NULL;
+}
+
+// Commands of one producer keep their order, whatever the interleaving with the others
+static void test_concurrent_producers(void)
+{
+    GMainContext *context = g_main_context_new();
+    Recorder recorder = { g_array_new(FALSE, FALSE, sizeof(RctGstCommand)) };
+    RctGstCommandQueue *queue = rct_gst_command_queue_new(context, record, &recorder);
+    Producer producers[PRODUCERS];
+    GThread *threads[PRODUCERS];
+    guint next[PRODUCERS] = { 0 };
+    guint i;
+
+    for (i = 0; i < PRODUCERS; i++) {
+        producers[i].queue = queue;
+        producers[i].producer = i;
+        threads[i] = g_thread_new("producer", produce, &producers[i]);
+    }
+    while (recorder.handled->len < PRODUCERS * COMMANDS_PER_PRODUCER) {
+        g_main_context_iteration(context, TRUE);
+    }
+    for (i = 0; i < PRODUCERS; i++) {
+        g_thread_join(threads[i]);
+    }
+    drain(context);
+    g_assert_cmpuint(recorder.handled->len, ==, PRODUCERS * COMMANDS_PER_PRODUCER);
+
+    for (i = 0; i < recorder.handled->len; i++) {
+        guint value = g_array_index(recorder.handled, RctGstCommand, i).args.refresh_rate;
+        guint producer = value / COMMANDS_PER_PRODUCER;
+
+        g_assert_cmpuint(producer, <, PRODUCERS);
+        g_assert_cmpuint(value % COMMANDS_PER_PRODUCER, ==, next[producer]);
+        next[producer]++;
+    }
+
+    rct_gst_command_queue_free(queue);
+    g_array_free(recorder.handled, TRUE);
+    g_main_context_unref(context);
+}
+
+// Freeing the queue frees what is still pending, the handler is not called
+static void test_free_pending(void)
+{
+    GMainContext *context = g_main_context_new();
+    Recorder recorder = { g_array_new(FALSE, FALSE, sizeof(RctGstCommand)) };
+    RctGstCommandQueue *queue = rct_gst_command_queue_new(context, record, &recorder);
+    RctGstCommand *command = rct_gst_command_new(RCT_GST_COMMAND_SET_URI);
+
+    command->args.uri = g_strdup("rtsp://127.0.0.1/stream");
+    rct_gst_command_queue_push(queue, command);
+    rct_gst_command_queue_push(queue, rct_gst_command_new(RCT_GST_COMMAND_QUIT));
+    rct_gst_command_queue_free(queue);
+
+    drain(context);
+    g_assert_cmpuint(recorder.handled->len, ==, 0);
+    g_array_free(recorder.handled, TRUE);
+    g_main_context_unref(context);
+}
+
+static void test_type_names(void)
+{
+    guint type;
+
+    for (type = RCT_GST_COMMAND_INIT; type <= RCT_GST_COMMAND_QUIT; type++) {
+        g_assert_cmpstr(rct_gst_command_type_get_name((RctGstCommandType)type), !=, "unknown");
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/command-queue/posting-order", test_posting_order);
+    g_test_add_func("/command-queue/concurrent-producers", test_concurrent_producers);
+    g_test_add_func("/command-queue/free-pending", test_free_pending);
+    g_test_add_func("/command-queue/type-names", test_type_names);
+    return g_test_run();
+}
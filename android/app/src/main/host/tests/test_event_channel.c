@@ -0,0 +1,271 @@
+//
+//  test_event_channel.c
+//
+//  Coalescing of a drained batch, the bounded ring dropping what does not
+//  fit, and RELEASE, which is never merged across nor dropped.
+//
+
+#include <gst/gst.h>
+#include "gstreamer_event_channel.h"
+
+#define MAX_EVENTS 64
+
+static gint target_a;
+static gint target_b;
+
+static void push_state(RctGstEventChannel *channel, gpointer target, GstState old_state, GstState new_state)
+{
+    RctGstEvent event = { RCT_GST_EVENT_STATE_CHANGED, target };
+
+    event.args.state.old_state = old_state;
+    event.args.state.new_state = new_state;
+    g_assert_true(rct_gst_event_channel_push(channel, &event));
+}
+
+static gboolean push_stats(RctGstEventChannel *channel, gpointer target, guint64 frames)
+{
+    RctGstEvent event = { RCT_GST_EVENT_STATS, target };
+
+    event.args.stats = g_new0(RctGstStats, 1);
+    event.args.stats->frames_rendered = frames;
+    return rct_gst_event_channel_push(channel, &event);
+}
+
+static void push_simple(RctGstEventChannel *channel, gpointer target, RctGstEventType type)
+{
+    RctGstEvent event = { type, target };
+
+    g_assert_true(rct_gst_event_channel_push(channel, &event));
+}
+
+// Delivered events only, cleared once checked
+static guint drain_delivered(RctGstEventChannel *channel, RctGstEvent *delivered)
+{
+    RctGstEvent events[MAX_EVENTS];
+    guint count = rct_gst_event_channel_drain(channel, events, MAX_EVENTS, 0);
+    guint delivered_count = 0;
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        if (!events[i].dropped) {
+            delivered[delivered_count++] = events[i];
+        }
+    }
+    return delivered_count;
+}
+
+static void clear_all(RctGstEvent *events, guint count)
+{
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        rct_gst_event_clear(&events[i]);
+    }
+}
+
+static void test_state_transitions(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(16);
+    RctGstEvent events[MAX_EVENTS];
+    guint count;
+
+    push_state(channel, &target_a, GST_STATE_NULL, GST_STATE_READY);
+    push_state(channel, &target_b, GST_STATE_PAUSED, GST_STATE_PLAYING);
+    push_state(channel, &target_a, GST_STATE_READY, GST_STATE_PAUSED);
+    push_state(channel, &target_a, GST_STATE_PAUSED, GST_STATE_PLAYING);
+    push_state(channel, &target_b, GST_STATE_PLAYING, GST_STATE_PAUSED);
+
+    // Every transition reaches the listeners, in posting order
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 5);
+    g_assert_true(events[0].target == &target_a);
+    g_assert_cmpint(events[0].args.state.new_state, ==, GST_STATE_READY);
+    g_assert_true(events[1].target == &target_b);
+    g_assert_cmpint(events[1].args.state.new_state, ==, GST_STATE_PLAYING);
+    g_assert_cmpint(events[2].args.state.new_state, ==, GST_STATE_PAUSED);
+    g_assert_cmpint(events[3].args.state.new_state, ==, GST_STATE_PLAYING);
+    g_assert_true(events[4].target == &target_b);
+    g_assert_cmpint(events[4].args.state.new_state, ==, GST_STATE_PAUSED);
+
+    rct_gst_event_channel_free(channel);
+}
+
+static void test_latest_wins_and_order(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(16);
+    RctGstEventChannelStats stats;
+    RctGstEvent events[MAX_EVENTS];
+    guint count;
+
+    g_assert_true(push_stats(channel, &target_a, 1));
+    push_simple(channel, &target_a, RCT_GST_EVENT_EOS);
+    g_assert_true(push_stats(channel, &target_a, 2));
+    g_assert_true(push_stats(channel, &target_a, 3));
+    g_assert_true(push_stats(channel, &target_b, 10));
+    g_assert_true(push_stats(channel, &target_a, 4));
+
+    // Only back to back snapshots of one target fold, the latest in place; anything in between keeps them apart
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 5);
+    g_assert_cmpuint(events[0].args.stats->frames_rendered, ==, 1);
+    g_assert_cmpint(events[1].type, ==, RCT_GST_EVENT_EOS);
+    g_assert_cmpuint(events[2].args.stats->frames_rendered, ==, 3);
+    g_assert_true(events[3].target == &target_b);
+    g_assert_cmpuint(events[3].args.stats->frames_rendered, ==, 10);
+    g_assert_true(events[4].target == &target_a);
+    g_assert_cmpuint(events[4].args.stats->frames_rendered, ==, 4);
+    clear_all(events, count);
+
+    rct_gst_event_channel_get_stats(channel, &stats);
+    g_assert_cmpuint(stats.pushed, ==, 6);
+    g_assert_cmpuint(stats.coalesced, ==, 1);
+    g_assert_cmpuint(stats.batches, ==, 1);
+    rct_gst_event_channel_free(channel);
+}
+
+static void test_volume_concatenated(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(16);
+    RctGstEvent events[MAX_EVENTS];
+    guint count;
+    guint i;
+
+    for (i = 0; i < 3; i++) {
+        RctGstEvent event = { RCT_GST_EVENT_VOLUME_CHANGED, &target_a };
+
+        event.args.volume.levels = g_new0(RctGstAudioLevel, 2);
+        event.args.volume.levels[0].rms = 2 * i;
+        event.args.volume.levels[1].rms = 2 * i + 1;
+        event.args.volume.count = 2;
+        g_assert_true(rct_gst_event_channel_push(channel, &event));
+    }
+
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 1);
+    g_assert_cmpuint(events[0].args.volume.count, ==, 6);
+    for (i = 0; i < 6; i++) {
+        g_assert_cmpfloat(events[0].args.volume.levels[i].rms, ==, i);
+    }
+    clear_all(events, count);
+    rct_gst_event_channel_free(channel);
+}
+
+static void test_qos_never_coalesced(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(16);
+    RctGstEvent events[MAX_EVENTS];
+
+    push_simple(channel, &target_a, RCT_GST_EVENT_QOS);
+    push_simple(channel, &target_a, RCT_GST_EVENT_QOS);
+    g_assert_cmpuint(drain_delivered(channel, events), ==, 2);
+    rct_gst_event_channel_free(channel);
+}
+
+// A target address reused after its release is another receiver
+static void test_release_boundary(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(16);
+    RctGstEvent events[MAX_EVENTS];
+    guint count;
+
+    g_assert_true(push_stats(channel, &target_a, 1));
+    push_state(channel, &target_a, GST_STATE_PAUSED, GST_STATE_PLAYING);
+    push_simple(channel, &target_a, RCT_GST_EVENT_RELEASE);
+    g_assert_true(push_stats(channel, &target_a, 2));
+    push_state(channel, &target_a, GST_STATE_PLAYING, GST_STATE_PAUSED);
+
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 5);
+    g_assert_cmpuint(events[0].args.stats->frames_rendered, ==, 1);
+    g_assert_cmpint(events[1].args.state.new_state, ==, GST_STATE_PLAYING);
+    g_assert_cmpint(events[2].type, ==, RCT_GST_EVENT_RELEASE);
+    g_assert_cmpuint(events[3].args.stats->frames_rendered, ==, 2);
+    g_assert_cmpint(events[4].args.state.old_state, ==, GST_STATE_PLAYING);
+    clear_all(events, count);
+    rct_gst_event_channel_free(channel);
+}
+
+static void test_full_ring_drops(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(3);
+    RctGstEventChannelStats stats;
+    RctGstEvent events[MAX_EVENTS];
+    guint count;
+    guint i;
+
+    // Rounded up to 4
+    for (i = 0; i < 4; i++) {
+        push_simple(channel, &target_a, RCT_GST_EVENT_QOS);
+    }
+    g_assert_false(push_stats(channel, &target_a, 1));
+
+    rct_gst_event_channel_get_stats(channel, &stats);
+    g_assert_cmpuint(stats.pushed, ==, 4);
+    g_assert_cmpuint(stats.dropped, ==, 1);
+
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 4);
+    g_assert_true(push_stats(channel, &target_a, 2));
+    count = drain_delivered(channel, events);
+    g_assert_cmpuint(count, ==, 1);
+    clear_all(events, count);
+    rct_gst_event_channel_free(channel);
+}
+
+static gpointer push_release(gpointer data)
+{
+    RctGstEvent event = { RCT_GST_EVENT_RELEASE, &target_a };
+
+    return GINT_TO_POINTER(rct_gst_event_channel_push((RctGstEventChannel *)data, &event));
+}
+
+// RELEASE waits for room in a full ring instead of being dropped, and wakes the consumer up
+static void test_release_never_dropped(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(2);
+    RctGstEvent events[MAX_EVENTS];
+    GThread *producer;
+    guint count = 0;
+    guint drained;
+    gboolean released = FALSE;
+
+    push_simple(channel, &target_a, RCT_GST_EVENT_QOS);
+    push_simple(channel, &target_a, RCT_GST_EVENT_QOS);
+    producer = g_thread_new("release", push_release, channel);
+
+    while (!released) {
+        drained = rct_gst_event_channel_drain(channel, events, MAX_EVENTS, G_USEC_PER_SEC);
+        for (guint i = 0; i < drained; i++) {
+            released = released || events[i].type == RCT_GST_EVENT_RELEASE;
+        }
+        count += drained;
+    }
+    g_assert_true(GPOINTER_TO_INT(g_thread_join(producer)));
+    g_assert_cmpuint(count, ==, 3);
+    rct_gst_event_channel_free(channel);
+}
+
+static void test_drain_timeout(void)
+{
+    RctGstEventChannel *channel = rct_gst_event_channel_new(4);
+    RctGstEvent events[MAX_EVENTS];
+    gint64 started = g_get_monotonic_time();
+
+    g_assert_cmpuint(rct_gst_event_channel_drain(channel, events, MAX_EVENTS, 20 * G_TIME_SPAN_MILLISECOND), ==, 0);
+    g_assert_cmpint(g_get_monotonic_time() - started, >=, 20 * G_TIME_SPAN_MILLISECOND);
+    rct_gst_event_channel_free(channel);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_test_add_func("/event-channel/state-transitions", test_state_transitions);
+    g_test_add_func("/event-channel/latest-wins-and-order", test_latest_wins_and_order);
+    g_test_add_func("/event-channel/volume-concatenated", test_volume_concatenated);
+    g_test_add_func("/event-channel/qos-never-coalesced", test_qos_never_coalesced);
+    g_test_add_func("/event-channel/release-boundary", test_release_boundary);
+    g_test_add_func("/event-channel/full-ring-drops", test_full_ring_drops);
+    g_test_add_func("/event-channel/release-never-dropped", test_release_never_dropped);
+    g_test_add_func("/event-channel/drain-timeout", test_drain_timeout);
+    return g_test_run();
+}
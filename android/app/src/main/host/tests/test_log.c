@@ -0,0 +1,138 @@
+//
+//  test_log.c
+//
+//  Level specs of rct_gst_log_configure, checked through the lines two
+//  categories let out.
+//
+
+#include <string.h>
+#include "gstreamer_log.h"
+
+typedef struct {
+    GMutex lock;
+    guint lines[2];                     // TestA, TestB
+} Capture;
+
+static Capture capture;
+
+static void capture_line(gint level, const gchar *category, const gchar *message, gpointer user_data)
+{
+    g_mutex_lock(&capture.lock);
+    if (strcmp(category, "TestA") == 0) {
+        capture.lines[0]++;
+    } else if (strcmp(category, "TestB") == 0) {
+        capture.lines[1]++;
+    }
+    g_mutex_unlock(&capture.lock);
+}
+
+#define LOG_TAG "TestA"
+static void log_a(void)
+{
+    LOGE("error");
+    LOGI("info");
+    LOGD("debug");
+}
+#undef LOG_TAG
+
+#define LOG_TAG "TestB"
+static void log_b(void)
+{
+    LOGE("error");
+    LOGI("info");
+    LOGD("debug");
+}
+#undef LOG_TAG
+
+// Lines each category let out of its error, info and debug one
+static void assert_lines(guint expected_a, guint expected_b)
+{
+    rct_gst_log_flush();
+    g_mutex_lock(&capture.lock);
+    capture.lines[0] = capture.lines[1] = 0;
+    g_mutex_unlock(&capture.lock);
+
+    log_a();
+    log_b();
+    rct_gst_log_flush();
+
+    g_mutex_lock(&capture.lock);
+    g_assert_cmpuint(capture.lines[0], ==, expected_a);
+    g_assert_cmpuint(capture.lines[1], ==, expected_b);
+    g_mutex_unlock(&capture.lock);
+}
+
+static void test_default_level(void)
+{
+    g_assert_true(rct_gst_log_configure("info"));
+    assert_lines(2, 2);
+    g_assert_true(rct_gst_log_configure("debug"));
+    assert_lines(3, 3);
+    g_assert_true(rct_gst_log_configure("none"));
+    assert_lines(0, 0);
+    g_assert_true(rct_gst_log_configure("1"));
+    assert_lines(1, 1);
+}
+
+static void test_category_overrides(void)
+{
+    g_assert_true(rct_gst_log_configure("error,TestA:debug"));
+    assert_lines(3, 1);
+    g_assert_true(rct_gst_log_configure(" TestB:2 , none "));
+    assert_lines(0, 2);
+    g_assert_true(rct_gst_log_configure("TestA:ERROR,TestB:Debug"));
+    assert_lines(1, 3);
+
+    // Overrides of the previous spec are gone, the default applies to both again
+    g_assert_true(rct_gst_log_configure("info"));
+    assert_lines(2, 2);
+
+    // Empty items are skipped, the last default wins
+    g_assert_true(rct_gst_log_configure(",debug,,error,"));
+    assert_lines(1, 1);
+}
+
+static void test_invalid_spec_changes_nothing(void)
+{
+    static const gchar *invalid[] = {
+        "verbose",
+        "debug,TestA:loud",
+        "TestA:",
+        ":debug",
+        "TestA:4",
+        "info,ThisCategoryNameIsMuchLongerThanTheSixtyFourBytesACategoryCanHold:debug"
+    };
+    guint i;
+
+    g_assert_true(rct_gst_log_configure("error,TestB:debug"));
+    for (i = 0; i < G_N_ELEMENTS(invalid); i++) {
+        g_assert_false(rct_gst_log_configure(invalid[i]));
+        assert_lines(1, 3);
+    }
+    g_assert_false(rct_gst_log_configure(NULL));
+    assert_lines(1, 3);
+}
+
+static void test_set_levels(void)
+{
+    g_assert_true(rct_gst_log_configure("info"));
+    rct_gst_log_set_category_level("TestA", RCT_GST_LOG_NONE);
+    assert_lines(0, 2);
+    rct_gst_log_set_level(RCT_GST_LOG_DEBUG);
+    assert_lines(0, 3);
+    rct_gst_log_set_category_level("TestA", RCT_GST_LOG_DEBUG + 1);
+    assert_lines(3, 3);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, NULL);
+    g_mutex_init(&capture.lock);
+    rct_gst_log_set_output(capture_line, NULL);
+
+    g_test_add_func("/log/default-level", test_default_level);
+    g_test_add_func("/log/category-overrides", test_category_overrides);
+    g_test_add_func("/log/invalid-spec-changes-nothing", test_invalid_spec_changes_nothing);
+    g_test_add_func("/log/set-levels", test_set_levels);
+    return g_test_run();
+}
@@ -9,6 +9,7 @@ import com.facebook.react.common.MapBuilder;
 import com.facebook.react.uimanager.SimpleViewManager;
 import com.facebook.react.uimanager.ThemedReactContext;
 import com.facebook.react.uimanager.annotations.ReactProp;
+import com.gstreamertest.utils.EaglUIView;
 import com.gstreamertest.utils.manager.Command;
 import com.gstreamertest.RCTGstPlayerController;
 
@@ -21,7 +22,11 @@ import java.util.Map;
 public class RCTGstPlayer extends SimpleViewManager<View> {
 
     private static final String LOG_TAG = "RCTGstPlayer";
-    private RCTGstPlayerController playerController;
+
+    // Every view owns its own controller (and native player), this view manager is shared
+    private static RCTGstPlayerController getController(View view) {
+        return (RCTGstPlayerController) ((EaglUIView) view).getSurfaceHolderManager();
+    }
 
     @Override
     public String getName() {
@@ -32,21 +37,188 @@ public class RCTGstPlayer extends SimpleViewManager<View> {
     @Override
     protected View createViewInstance(ThemedReactContext reactContext) {
         Log.d(LOG_TAG, "createViewInstance() called");
-        this.playerController = new RCTGstPlayerController(reactContext);
-        return this.playerController.getView();
+        RCTGstPlayerController playerController = new RCTGstPlayerController(reactContext);
+        return playerController.getView();
+    }
+
+    @Override
+    public void onDropViewInstance(View view) {
+        Log.d(LOG_TAG, "onDropViewInstance() called");
+        getController(view).release();
+        super.onDropViewInstance(view);
     }
 
     // Shared properties
     @ReactProp(name = "uri")
     public void setUri(View controllerView, String uri) {
         Log.d(LOG_TAG, "setUri() called with uri: " + uri);
-        this.playerController.setRctGstUri(uri);
+        getController(controllerView).setRctGstUri(uri);
     }
 
     @ReactProp(name = "isDebugging")
     public void setIsDebugging(View controllerView, boolean isDebugging) {
         Log.d(LOG_TAG, "setIsDebugging() called with isDebugging: " + isDebugging);
-        this.playerController.setRctGstDebugging(isDebugging);
+        getController(controllerView).setRctGstDebugging(isDebugging);
+    }
+
+    @ReactProp(name = "standbyPoolSize")
+    public void setStandbyPoolSize(View controllerView, int standbyPoolSize) {
+        Log.d(LOG_TAG, "setStandbyPoolSize() called with standbyPoolSize: " + standbyPoolSize);
+        getController(controllerView).setRctGstStandbyPoolSize(standbyPoolSize);
+    }
+
+    @ReactProp(name = "standbyGopBudget")
+    public void setStandbyGopBudget(View controllerView, double standbyGopBudget) {
+        Log.d(LOG_TAG, "setStandbyGopBudget() called with standbyGopBudget: " + standbyGopBudget);
+        getController(controllerView).setRctGstStandbyGopBudget((long) standbyGopBudget);
+    }
+
+    @ReactProp(name = "reconnectInitialDelay", defaultInt = 500)
+    public void setReconnectInitialDelay(View controllerView, int reconnectInitialDelay) {
+        Log.d(LOG_TAG, "setReconnectInitialDelay() called with reconnectInitialDelay: " + reconnectInitialDelay);
+        getController(controllerView).setRctGstReconnectInitialDelay(reconnectInitialDelay);
+    }
+
+    @ReactProp(name = "reconnectMaxDelay", defaultInt = 30000)
+    public void setReconnectMaxDelay(View controllerView, int reconnectMaxDelay) {
+        Log.d(LOG_TAG, "setReconnectMaxDelay() called with reconnectMaxDelay: " + reconnectMaxDelay);
+        getController(controllerView).setRctGstReconnectMaxDelay(reconnectMaxDelay);
+    }
+
+    @ReactProp(name = "reconnectJitter", defaultDouble = 0.2)
+    public void setReconnectJitter(View controllerView, double reconnectJitter) {
+        Log.d(LOG_TAG, "setReconnectJitter() called with reconnectJitter: " + reconnectJitter);
+        getController(controllerView).setRctGstReconnectJitter(reconnectJitter);
+    }
+
+    @ReactProp(name = "stallTimeout", defaultInt = 10000)
+    public void setStallTimeout(View controllerView, int stallTimeout) {
+        Log.d(LOG_TAG, "setStallTimeout() called with stallTimeout: " + stallTimeout);
+        getController(controllerView).setRctGstStallTimeout(stallTimeout);
+    }
+
+    @ReactProp(name = "statsRefreshRate")
+    public void setStatsRefreshRate(View controllerView, int statsRefreshRate) {
+        Log.d(LOG_TAG, "setStatsRefreshRate() called with statsRefreshRate: " + statsRefreshRate);
+        getController(controllerView).setRctGstStatsRefreshRate(statsRefreshRate);
+    }
+
+    @ReactProp(name = "qosMaxRung", defaultInt = 4)
+    public void setQosMaxRung(View controllerView, int qosMaxRung) {
+        Log.d(LOG_TAG, "setQosMaxRung() called with qosMaxRung: " + qosMaxRung);
+        getController(controllerView).setRctGstQosMaxRung(qosMaxRung);
+    }
+
+    @ReactProp(name = "qosMaxLateness", defaultInt = 100)
+    public void setQosMaxLateness(View controllerView, int qosMaxLateness) {
+        Log.d(LOG_TAG, "setQosMaxLateness() called with qosMaxLateness: " + qosMaxLateness);
+        getController(controllerView).setRctGstQosMaxLateness(qosMaxLateness);
+    }
+
+    @ReactProp(name = "jitterMode")
+    public void setJitterMode(View controllerView, int jitterMode) {
+        Log.d(LOG_TAG, "setJitterMode() called with jitterMode: " + jitterMode);
+        getController(controllerView).setRctGstJitterMode(jitterMode);
+    }
+
+    @ReactProp(name = "jitterMinLatency")
+    public void setJitterMinLatency(View controllerView, int jitterMinLatency) {
+        Log.d(LOG_TAG, "setJitterMinLatency() called with jitterMinLatency: " + jitterMinLatency);
+        getController(controllerView).setRctGstJitterMinLatency(jitterMinLatency);
+    }
+
+    @ReactProp(name = "jitterMaxLatency", defaultInt = 1000)
+    public void setJitterMaxLatency(View controllerView, int jitterMaxLatency) {
+        Log.d(LOG_TAG, "setJitterMaxLatency() called with jitterMaxLatency: " + jitterMaxLatency);
+        getController(controllerView).setRctGstJitterMaxLatency(jitterMaxLatency);
+    }
+
+    @ReactProp(name = "jitterTargetLoss", defaultDouble = 0.01)
+    public void setJitterTargetLoss(View controllerView, double jitterTargetLoss) {
+        Log.d(LOG_TAG, "setJitterTargetLoss() called with jitterTargetLoss: " + jitterTargetLoss);
+        getController(controllerView).setRctGstJitterTargetLoss(jitterTargetLoss);
+    }
+
+    @ReactProp(name = "sharedDecode")
+    public void setSharedDecode(View controllerView, boolean sharedDecode) {
+        Log.d(LOG_TAG, "setSharedDecode() called with sharedDecode: " + sharedDecode);
+        getController(controllerView).setRctGstSharedDecode(sharedDecode);
+    }
+
+    @ReactProp(name = "transports")
+    public void setTransports(View controllerView, @Nullable String transports) {
+        Log.d(LOG_TAG, "setTransports() called with transports: " + transports);
+        getController(controllerView).setRctGstTransports(transports != null ? transports : "udp,tcp");
+    }
+
+    @ReactProp(name = "transportTimeout", defaultInt = 3000)
+    public void setTransportTimeout(View controllerView, int transportTimeout) {
+        Log.d(LOG_TAG, "setTransportTimeout() called with transportTimeout: " + transportTimeout);
+        getController(controllerView).setRctGstTransportTimeout(transportTimeout);
+    }
+
+    @ReactProp(name = "rememberTransport", defaultBoolean = true)
+    public void setRememberTransport(View controllerView, boolean rememberTransport) {
+        Log.d(LOG_TAG, "setRememberTransport() called with rememberTransport: " + rememberTransport);
+        getController(controllerView).setRctGstRememberTransport(rememberTransport);
+    }
+
+    @ReactProp(name = "mosaicColumns")
+    public void setMosaicColumns(View controllerView, int mosaicColumns) {
+        Log.d(LOG_TAG, "setMosaicColumns() called with mosaicColumns: " + mosaicColumns);
+        getController(controllerView).setRctGstMosaicColumns(mosaicColumns);
+    }
+
+    @ReactProp(name = "mosaicRows")
+    public void setMosaicRows(View controllerView, int mosaicRows) {
+        Log.d(LOG_TAG, "setMosaicRows() called with mosaicRows: " + mosaicRows);
+        getController(controllerView).setRctGstMosaicRows(mosaicRows);
+    }
+
+    @ReactProp(name = "mosaicUris")
+    public void setMosaicUris(View controllerView, @Nullable ReadableArray mosaicUris) {
+        Log.d(LOG_TAG, "setMosaicUris() called with mosaicUris: " + mosaicUris);
+        String[] uris = new String[mosaicUris != null ? mosaicUris.size() : 0];
+        for (int i = 0; i < uris.length; i++) {
+            uris[i] = mosaicUris.isNull(i) ? null : mosaicUris.getString(i);
+        }
+        getController(controllerView).setRctGstMosaicUris(uris);
+    }
+
+    @ReactProp(name = "dvrMaxDuration")
+    public void setDvrMaxDuration(View controllerView, int dvrMaxDuration) {
+        Log.d(LOG_TAG, "setDvrMaxDuration() called with dvrMaxDuration: " + dvrMaxDuration);
+        getController(controllerView).setRctGstDvrMaxDuration(dvrMaxDuration);
+    }
+
+    @ReactProp(name = "dvrMaxBytes")
+    public void setDvrMaxBytes(View controllerView, double dvrMaxBytes) {
+        Log.d(LOG_TAG, "setDvrMaxBytes() called with dvrMaxBytes: " + dvrMaxBytes);
+        getController(controllerView).setRctGstDvrMaxBytes((long) dvrMaxBytes);
+    }
+
+    @ReactProp(name = "scrubCacheBytes")
+    public void setScrubCacheBytes(View controllerView, double scrubCacheBytes) {
+        Log.d(LOG_TAG, "setScrubCacheBytes() called with scrubCacheBytes: " + scrubCacheBytes);
+        getController(controllerView).setRctGstScrubCacheBytes((long) scrubCacheBytes);
+    }
+
+    @ReactProp(name = "scrubThumbnailWidth", defaultInt = 160)
+    public void setScrubThumbnailWidth(View controllerView, int scrubThumbnailWidth) {
+        Log.d(LOG_TAG, "setScrubThumbnailWidth() called with scrubThumbnailWidth: " + scrubThumbnailWidth);
+        getController(controllerView).setRctGstScrubThumbnailWidth(scrubThumbnailWidth);
+    }
+
+    @ReactProp(name = "logLevel")
+    public void setLogLevel(View controllerView, @Nullable String logLevel) {
+        Log.d(LOG_TAG, "setLogLevel() called with logLevel: " + logLevel);
+        getController(controllerView).setRctGstLogLevel(logLevel);
+    }
+
+    @ReactProp(name = "audioLevelRefreshRate")
+    public void setAudioLevelRefreshRate(View controllerView, int audioLevelRefreshRate) {
+        Log.d(LOG_TAG, "setAudioLevelRefreshRate() called with audioLevelRefreshRate: " + audioLevelRefreshRate);
+        getController(controllerView).setRctGstAudioLevelRefreshRate(audioLevelRefreshRate);
     }
 
     // Methods
@@ -59,7 +231,58 @@ public class RCTGstPlayer extends SimpleViewManager<View> {
 
         // setState
         if (Command.is(commandType, Command.setState)) {
-            this.playerController.setRctGstState(args.getInt(0));
+            getController(view).setRctGstState(args.getInt(0));
+        }
+
+        // prepareUri
+        if (Command.is(commandType, Command.prepareUri)) {
+            getController(view).prepareRctGstUri(args.getString(0));
+        }
+
+        // suspend
+        if (Command.is(commandType, Command.suspend)) {
+            getController(view).suspendRctGst();
+        }
+
+        // resume
+        if (Command.is(commandType, Command.resume)) {
+            getController(view).resumeRctGst();
+        }
+
+        // timeshift
+        if (Command.is(commandType, Command.timeshift)) {
+            getController(view).timeshiftRctGst(args.getInt(0));
+        }
+
+        // exportClip
+        if (Command.is(commandType, Command.exportClip)) {
+            getController(view).exportRctGstClip(args.getString(0), args.getInt(1), args.getInt(2), args.getInt(3));
+        }
+
+        // seek
+        if (Command.is(commandType, Command.seek)) {
+            getController(view).seekRctGst(args.getInt(0), args.getInt(1));
+        }
+
+        // setRate
+        if (Command.is(commandType, Command.setRate)) {
+            getController(view).setRctGstRate(args.getDouble(0));
+        }
+
+        // scrub
+        if (Command.is(commandType, Command.scrub)) {
+            getController(view).scrubRctGst(args.getInt(0));
+        }
+
+        // snapshot
+        if (Command.is(commandType, Command.snapshot)) {
+            getController(view).snapshotRctGst(args.getInt(0), args.getInt(1), args.getInt(2),
+                    args.isNull(3) ? null : args.getString(3));
+        }
+
+        // dumpGraph
+        if (Command.is(commandType, Command.dumpGraph)) {
+            getController(view).dumpRctGstGraph(args.getString(0));
         }
 
         // recreateView is ignored on purpose : Not needed on android (wrong impl of vtdec on ios)
@@ -92,6 +315,26 @@ public class RCTGstPlayer extends SimpleViewManager<View> {
                         "onEOS", MapBuilder.of("registrationName", "onEOS")
                 ).put(
                         "onElementError", MapBuilder.of("registrationName", "onElementError")
+                ).put(
+                        "onFirstFrame", MapBuilder.of("registrationName", "onFirstFrame")
+                ).put(
+                        "onCommandDone", MapBuilder.of("registrationName", "onCommandDone")
+                ).put(
+                        "onReconnect", MapBuilder.of("registrationName", "onReconnect")
+                ).put(
+                        "onStats", MapBuilder.of("registrationName", "onStats")
+                ).put(
+                        "onVolumeChanged", MapBuilder.of("registrationName", "onVolumeChanged")
+                ).put(
+                        "onQos", MapBuilder.of("registrationName", "onQos")
+                ).put(
+                        "onDvrExport", MapBuilder.of("registrationName", "onDvrExport")
+                ).put(
+                        "onSeekDone", MapBuilder.of("registrationName", "onSeekDone")
+                ).put(
+                        "onScrubPreview", MapBuilder.of("registrationName", "onScrubPreview")
+                ).put(
+                        "onSnapshot", MapBuilder.of("registrationName", "onSnapshot")
                 ).build();
     }
 }
@@ -1,5 +1,9 @@
 package com.gstreamertest;
 
+import android.content.Context;
+import android.graphics.Bitmap;
+import android.net.wifi.WifiManager;
+import android.util.Base64;
 import android.util.Log;
 import android.view.Surface;
 import android.view.SurfaceHolder;
@@ -8,6 +12,7 @@ import android.widget.Toast;
 
 import com.facebook.react.bridge.Arguments;
 import com.facebook.react.bridge.ReactContext;
+import com.facebook.react.bridge.WritableArray;
 import com.facebook.react.bridge.WritableMap;
 import com.facebook.react.uimanager.events.RCTEventEmitter;
 import com.gstreamertest.utils.EaglUIView;
@@ -16,6 +21,9 @@ import com.gstreamertest.utils.RCTGstConfiguration;
 
 import org.freedesktop.gstreamer.GStreamer;
 
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+
 /**
  * Created by vishal singh on 16/o6/2024.
  */
@@ -24,27 +32,129 @@ public class RCTGstPlayerController implements RCTGstConfigurationCallable, Surf
 
     private static final String LOG_TAG = "RCTGstPlayerController";
 
+    // Stage order and histogram layout of native statistics
+    private static final String[] STATS_STAGES = { "network", "depay", "decode", "render" };
+    private static final int STATS_BUCKETS = 12;
+
+    // Degradation ladder rungs, indexed by their native value
+    private static final String[] QOS_RUNGS = { "none", "drop_late", "skip_non_reference", "keyframes_only", "lower_resolution" };
+
+    // RTSP lower transports, indexed by their native value
+    private static final String[] TRANSPORTS = { "udp", "multicast", "tcp", "http" };
+
+    // Native events of every player are delivered in batches by this one thread
+    private static Thread eventDrain;
+    private static final int EVENT_DRAIN_TIMEOUT_MS = 1000;
+
     private boolean isInited = false;
 
+    // Warm standby sessions (count and shared GOP cache bytes)
+    private int standbyPoolSize = 0;
+    private long standbyGopBudget = 8 * 1024 * 1024;
+
+    // Reconnect policy (ms, except jitter which is a fraction of the delay)
+    private int reconnectInitialDelay = 500;
+    private int reconnectMaxDelay = 30000;
+    private double reconnectJitter = 0.2;
+    private int stallTimeout = 10000;
+
+    // QoS policy (highest rung, lateness in ms)
+    private int qosMaxRung = 4;
+    private int qosMaxLateness = 100;
+
+    // Jitterbuffer policy (0 fixed, 1 adaptive; latencies in ms, loss as a fraction of the packets)
+    private int jitterMode = 0;
+    private int jitterMinLatency = 0;
+    private int jitterMaxLatency = 1000;
+    private double jitterTargetLoss = 0.01;
+
+    // Transport policy (comma separated order, ms per attempt)
+    private String transports = "udp,tcp";
+    private int transportTimeout = 3000;
+    private boolean rememberTransport = true;
+
+    // Mosaic grid (0 columns is a single stream) and the uri of every tile, row by row
+    private int mosaicColumns = 0;
+    private int mosaicRows = 0;
+    private String[] mosaicUris = new String[0];
+
+    // Timeshift ring bounds (ms, bytes), read on init when one of them is set
+    private int dvrMaxDuration = 0;
+    private long dvrMaxBytes = 0;
+
+    // Scrub preview cache of file and HTTP uris (bytes, 0 disables; thumbnail width in pixels)
+    private long scrubCacheBytes = 0;
+    private int scrubThumbnailWidth = 160;
+
+    // Wifi drops multicast packets unless a lock is held
+    private WifiManager.MulticastLock multicastLock;
+
+    // Handle on the native player owned by this controller (0 once released)
+    private long nativePlayer;
+
     private RCTGstConfiguration configuration;
     private EaglUIView view;
     private ReactContext context;
 
     // Native methods
     private native String nativeRCTGstGetGStreamerInfo();
-    private native void nativeRCTGstSetDrawableSurface(Surface drawableSurface);
-    private native void nativeRCTGstSetUri(String uri);
-    private native void nativeRCTGstSetAudioLevelRefreshRate(int audioLevelRefreshRate);
-    private native void nativeRCTGstSetDebugging(boolean isDebugging);
-    private native void nativeRCTGstSetPipelineState(int state);
-    private native void nativeRCTGstInitAndRun(RCTGstConfiguration configuration);
+    private native String nativeRCTGstGetElementChain(long player);
+    private native long nativeRCTGstPlayerNew();
+    private native void nativeRCTGstPlayerFree(long player);
+    private native void nativeRCTGstSetDrawableSurface(long player, Surface drawableSurface);
+    private native void nativeRCTGstSetSurfaceSize(long player, int width, int height);
+    private native void nativeRCTGstSetUri(long player, String uri);
+    private native void nativeRCTGstSetAudioLevelRefreshRate(long player, int audioLevelRefreshRate);
+    private native void nativeRCTGstSetDebugging(long player, boolean isDebugging);
+    private native void nativeRCTGstSetPipelineState(long player, int state);
+    private native void nativeRCTGstSuspend(long player);
+    private native void nativeRCTGstResume(long player);
+    private native void nativeRCTGstPrepareUri(long player, String uri);
+    private native void nativeRCTGstSetStandbyPool(long player, int capacity, long gopBudget);
+    private native void nativeRCTGstSetReconnectPolicy(long player, int initialDelay, int maxDelay, double jitter, int stallTimeout);
+    private native void nativeRCTGstSetStatsRefreshRate(long player, int refreshRate);
+    private native void nativeRCTGstSetQosPolicy(long player, int maxRung, int maxLateness);
+    private native void nativeRCTGstSetJitterPolicy(long player, int mode, int minLatency, int maxLatency, double targetLoss);
+    private native void nativeRCTGstSetTransportPolicy(long player, String transports, int timeout, boolean remember);
+    private native void nativeRCTGstSetMosaicLayout(long player, int columns, int rows);
+    private native void nativeRCTGstSetMosaicTile(long player, int index, String uri);
+    private native void nativeRCTGstSetDvrPolicy(long player, int maxDuration, long maxBytes);
+    private native void nativeRCTGstTimeshift(long player, int offset);
+    private native void nativeRCTGstExportClip(long player, String path, int offset, int duration, int format);
+    private native void nativeRCTGstSetScrubCache(long player, long maxBytes, int width);
+    private native void nativeRCTGstSeek(long player, long positionUs, int mode);
+    private native void nativeRCTGstSetRate(long player, double rate);
+    private native void nativeRCTGstScrub(long player, long positionUs);
+    private native void nativeRCTGstSnapshot(long player, int id, int format, int maxSize, String path);
+    private native void nativeRCTGstDumpGraph(long player, String path);
+    private native void nativeRCTGstSetLogLevel(String spec);
+    private native void nativeRCTGstInitAndRun(long player, RCTGstConfiguration configuration);
+    private static native int nativeRCTGstDrainEvents(int timeoutMs);
+
+    private static synchronized void startEventDrain() {
+        if (eventDrain != null) {
+            return;
+        }
+        eventDrain = new Thread(new Runnable() {
+            @Override
+            public void run() {
+                while (true) {
+                    nativeRCTGstDrainEvents(EVENT_DRAIN_TIMEOUT_MS);
+                }
+            }
+        }, "rct-gst-events");
+        eventDrain.setDaemon(true);
+        eventDrain.start();
+    }
 
     // Configuration callbacks
     @Override
-    public void onInit() {
-        Log.d(LOG_TAG, "onInit() called");
+    public void onInit(String element_chain) {
+        Log.d(LOG_TAG, "onInit() called with element chain: " + element_chain);
+        WritableMap event = Arguments.createMap();
+        event.putString("element_chain", element_chain);
         context.getJSModule(RCTEventEmitter.class).receiveEvent(
-                view.getId(), "onPlayerInit", null
+                view.getId(), "onPlayerInit", event
         );
     }
 
@@ -60,12 +170,21 @@ public class RCTGstPlayerController implements RCTGstConfigurationCallable, Surf
     }
 
     @Override
-    public void onVolumeChanged(double rms, double peak, double decay) {
-        Log.d(LOG_TAG, "onVolumeChanged() called with rms: " + rms + ", peak: " + peak + ", decay: " + decay);
+    public void onVolumeChanged(double[] rms, double[] peak, double[] decay) {
         WritableMap event = Arguments.createMap();
-        event.putDouble("rms", rms);
-        event.putDouble("peak", peak);
-        event.putDouble("decay", decay);
+        WritableArray levels = Arguments.createArray();
+        for (int i = 0; i < rms.length; i++) {
+            WritableMap level = Arguments.createMap();
+            level.putDouble("rms", rms[i]);
+            level.putDouble("peak", peak[i]);
+            level.putDouble("decay", decay[i]);
+            levels.pushMap(level);
+        }
+        // Latest measurement at the top level, the whole batch in levels
+        event.putDouble("rms", rms[rms.length - 1]);
+        event.putDouble("peak", peak[peak.length - 1]);
+        event.putDouble("decay", decay[decay.length - 1]);
+        event.putArray("levels", levels);
         context.getJSModule(RCTEventEmitter.class).receiveEvent(
                 view.getId(), "onVolumeChanged", event
         );
@@ -101,16 +220,180 @@ public class RCTGstPlayerController implements RCTGstConfigurationCallable, Surf
         );
     }
 
+    @Override
+    public void onFirstFrame(int mode, long ttff_us, int transport) {
+        Log.d(LOG_TAG, "onFirstFrame() called with mode: " + mode + ", ttff_us: " + ttff_us + ", transport: " + transport);
+        WritableMap event = Arguments.createMap();
+        event.putInt("mode", mode);
+        event.putDouble("ttff_us", ttff_us);
+        event.putInt("transport", transport);
+        event.putString("transport_name", TRANSPORTS[transport]);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onFirstFrame", event
+        );
+    }
+
+    @Override
+    public void onCommandDone(int command, int result, long latency_us) {
+        Log.d(LOG_TAG, "onCommandDone() called with command: " + command + ", result: " + result + ", latency_us: " + latency_us);
+        WritableMap event = Arguments.createMap();
+        event.putInt("command", command);
+        event.putInt("result", result);
+        event.putDouble("latency_us", latency_us);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onCommandDone", event
+        );
+    }
+
+    @Override
+    public void onReconnect(boolean degraded, int errors, int stalls, int attempts, int recoveries,
+                            int consecutive_failures, long degraded_us, long next_attempt_in_us) {
+        Log.d(LOG_TAG, "onReconnect() called with degraded: " + degraded + ", consecutive_failures: " + consecutive_failures);
+        WritableMap event = Arguments.createMap();
+        event.putBoolean("degraded", degraded);
+        event.putInt("errors", errors);
+        event.putInt("stalls", stalls);
+        event.putInt("attempts", attempts);
+        event.putInt("recoveries", recoveries);
+        event.putInt("consecutive_failures", consecutive_failures);
+        event.putDouble("degraded_us", degraded_us);
+        event.putDouble("next_attempt_in_us", next_attempt_in_us);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onReconnect", event
+        );
+    }
+
+    @Override
+    public void onStats(long frames_decoded, long frames_rendered, long frames_dropped, long frames_late,
+                        long bitrate, long packets_lost, double jitter_ms, int latency_ms, boolean retransmission,
+                        long[] stages) {
+        WritableMap event = Arguments.createMap();
+        event.putDouble("frames_decoded", frames_decoded);
+        event.putDouble("frames_rendered", frames_rendered);
+        event.putDouble("frames_dropped", frames_dropped);
+        event.putDouble("frames_late", frames_late);
+        event.putDouble("bitrate", bitrate);
+        event.putDouble("packets_lost", packets_lost);
+        event.putDouble("jitter_ms", jitter_ms);
+        event.putInt("latency_ms", latency_ms);
+        event.putBoolean("retransmission", retransmission);
+
+        WritableMap latencies = Arguments.createMap();
+        int stageLength = 3 + STATS_BUCKETS;
+        for (int i = 0; i < STATS_STAGES.length; i++) {
+            int offset = i * stageLength;
+            WritableMap stage = Arguments.createMap();
+            WritableArray histogram = Arguments.createArray();
+            stage.putDouble("count", stages[offset]);
+            stage.putDouble("sum_us", stages[offset + 1]);
+            stage.putDouble("max_us", stages[offset + 2]);
+            for (int j = 0; j < STATS_BUCKETS; j++) {
+                histogram.pushDouble(stages[offset + 3 + j]);
+            }
+            stage.putArray("histogram", histogram);
+            latencies.putMap(STATS_STAGES[i], stage);
+        }
+        event.putMap("latencies", latencies);
+
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onStats", event
+        );
+    }
+
+    @Override
+    public void onQos(int rung, int previous_rung, int transitions, double late_ratio, double queue_fill,
+                      long frames_dropped_late, long frames_skipped) {
+        WritableMap event = Arguments.createMap();
+        event.putInt("rung", rung);
+        event.putString("rung_name", QOS_RUNGS[rung]);
+        event.putInt("previous_rung", previous_rung);
+        event.putInt("transitions", transitions);
+        event.putDouble("late_ratio", late_ratio);
+        event.putDouble("queue_fill", queue_fill);
+        event.putDouble("frames_dropped_late", frames_dropped_late);
+        event.putDouble("frames_skipped", frames_skipped);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onQos", event
+        );
+    }
+
+    @Override
+    public void onDvrExport(String path, boolean success, long duration_us) {
+        WritableMap event = Arguments.createMap();
+        event.putString("path", path);
+        event.putBoolean("success", success);
+        event.putDouble("duration_us", duration_us);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onDvrExport", event
+        );
+    }
+
+    @Override
+    public void onSeekDone(long position_us, long duration_us, long latency_us) {
+        WritableMap event = Arguments.createMap();
+        event.putDouble("position_us", position_us);
+        event.putDouble("duration_us", duration_us);
+        event.putDouble("latency_us", latency_us);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onSeekDone", event
+        );
+    }
+
+    // Runs on the event drain thread, the JPEG is small enough to cross the bridge as a data uri
+    @Override
+    public void onScrubPreview(long position_us, int width, int height, ByteBuffer pixels) {
+        Bitmap bitmap = Bitmap.createBitmap(width, height, Bitmap.Config.ARGB_8888);
+        bitmap.copyPixelsFromBuffer(pixels);
+        ByteArrayOutputStream jpeg = new ByteArrayOutputStream();
+        bitmap.compress(Bitmap.CompressFormat.JPEG, 80, jpeg);
+        bitmap.recycle();
+
+        WritableMap event = Arguments.createMap();
+        event.putDouble("position_us", position_us);
+        event.putInt("width", width);
+        event.putInt("height", height);
+        event.putString("uri", "data:image/jpeg;base64," + Base64.encodeToString(jpeg.toByteArray(), Base64.NO_WRAP));
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onScrubPreview", event
+        );
+    }
+
+    @Override
+    public void onSnapshot(int id, boolean success, String error, String path, byte[] data, int width, int height,
+                           long position_us) {
+        WritableMap event = Arguments.createMap();
+        event.putInt("id", id);
+        event.putBoolean("success", success);
+        event.putString("error", error);
+        event.putString("path", path);
+        if (data != null) {
+            // PNG files start with 0x89 'P', anything else is a JPEG
+            String mime = data.length > 1 && data[0] == (byte) 0x89 && data[1] == 'P' ? "image/png" : "image/jpeg";
+            event.putString("uri", "data:" + mime + ";base64," + Base64.encodeToString(data, Base64.NO_WRAP));
+        } else if (path != null) {
+            event.putString("uri", "file://" + path);
+        }
+        event.putInt("width", width);
+        event.putInt("height", height);
+        event.putDouble("position_us", position_us);
+        context.getJSModule(RCTEventEmitter.class).receiveEvent(
+                view.getId(), "onSnapshot", event
+        );
+    }
+
     // Surface callbacks
     @Override
     public void surfaceCreated(SurfaceHolder holder) {
         Log.d(LOG_TAG, "surfaceCreated() called");
+        if (isReleased()) {
+            return;
+        }
         if (!isInited) {
             Log.d(LOG_TAG, "Initializing GStreamer with surface: " + holder.getSurface());
             // Preparing configuration
             this.configuration.setInitialDrawableSurface(holder.getSurface());
             // Init and run our pipeline
-            nativeRCTGstInitAndRun(this.configuration);
+            nativeRCTGstInitAndRun(this.nativePlayer, this.configuration);
             // Init done
             this.isInited = true;
         }
@@ -119,14 +402,22 @@ public class RCTGstPlayerController implements RCTGstConfigurationCallable, Surf
     @Override
     public void surfaceChanged(SurfaceHolder holder, int format, int width, int height) {
         Log.d(LOG_TAG, "surfaceChanged() called with format: " + format + ", width: " + width + ", height: " + height);
-        nativeRCTGstSetDrawableSurface(holder.getSurface());
-        Log.d(LOG_TAG, "surfaceChanged() called with formattttttttttttttttttttttttttttttt: " + format + ", width: " + width + ", height: " + height);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetDrawableSurface(this.nativePlayer, holder.getSurface());
+        // Frames larger than the surface get downscaled natively
+        nativeRCTGstSetSurfaceSize(this.nativePlayer, width, height);
 
     }
 
     @Override
     public void surfaceDestroyed(SurfaceHolder holder) {
         Log.d(LOG_TAG, "surfaceDestroyed() called");
+        // Also called once the view is gone, after release()
+        if (this.nativePlayer != 0) {
+            nativeRCTGstSetDrawableSurface(this.nativePlayer, null);
+        }
     }
 
     // Constructor
@@ -142,51 +433,387 @@ public class RCTGstPlayerController implements RCTGstConfigurationCallable, Surf
     }
     String version = nativeRCTGstGetGStreamerInfo();
     Log.d(LOG_TAG, "GStreamer version: " + version);
+    this.nativePlayer = nativeRCTGstPlayerNew();
+    startEventDrain();
     this.view = new EaglUIView(this.context, this);
     this.configuration = new RCTGstConfiguration(this);
 }
 
-// @Override
-// public void onUriChanged(String new_uri) {
-//     if (new_uri != null) {
-//         Log.d(LOG_TAG, "onUriChanged() called with new_uri: " + new_uri);
-//     } else {
-//         Log.d(LOG_TAG, "onUriChanged() called with null new_uri");
-//     }
-//     WritableMap event = Arguments.createMap();
-//     event.putString("new_uri", new_uri);
-//     context.getJSModule(RCTEventEmitter.class).receiveEvent(
-//             view.getId(), "onUriChanged", event
-//     );
-// }
-
-
     View getView() {
         Log.d(LOG_TAG, "getView() called");
         return this.view;
     }
 
+    // Calls after release() are ignored, the native player is gone
+    private boolean isReleased() {
+        if (this.nativePlayer == 0) {
+            Log.w(LOG_TAG, "Player already released, call ignored");
+            return true;
+        }
+        return false;
+    }
+
+    // Releases the native player, the controller can't be used afterwards
+    void release() {
+        Log.d(LOG_TAG, "release() called");
+        if (this.nativePlayer != 0) {
+            nativeRCTGstPlayerFree(this.nativePlayer);
+            this.nativePlayer = 0;
+        }
+        updateMulticastLock(false);
+    }
+
     // Manager Shared properties
     void setRctGstUri(String uri) {
         Log.d(LOG_TAG, "setRctGstUri() called with uri: " + uri);
-        nativeRCTGstSetUri(uri);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetUri(this.nativePlayer, uri);
     }
 
 
     void setRctGstAudioLevelRefreshRate(int audioLevelRefreshRate) {
         Log.d(LOG_TAG, "setRctGstAudioLevelRefreshRate() called with rate: " + audioLevelRefreshRate);
-        nativeRCTGstSetAudioLevelRefreshRate(audioLevelRefreshRate);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetAudioLevelRefreshRate(this.nativePlayer, audioLevelRefreshRate);
     }
 
     void setRctGstDebugging(boolean isDebugging) {
         Log.d(LOG_TAG, "setRctGstDebugging() called with isDebugging: " + isDebugging);
-        nativeRCTGstSetDebugging(isDebugging);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetDebugging(this.nativePlayer, isDebugging);
+    }
+
+    void setRctGstStandbyPoolSize(int standbyPoolSize) {
+        Log.d(LOG_TAG, "setRctGstStandbyPoolSize() called with size: " + standbyPoolSize);
+        if (isReleased()) {
+            return;
+        }
+        this.standbyPoolSize = standbyPoolSize;
+        nativeRCTGstSetStandbyPool(this.nativePlayer, this.standbyPoolSize, this.standbyGopBudget);
+    }
+
+    void setRctGstStandbyGopBudget(long standbyGopBudget) {
+        Log.d(LOG_TAG, "setRctGstStandbyGopBudget() called with budget: " + standbyGopBudget);
+        if (isReleased()) {
+            return;
+        }
+        this.standbyGopBudget = standbyGopBudget;
+        nativeRCTGstSetStandbyPool(this.nativePlayer, this.standbyPoolSize, this.standbyGopBudget);
+    }
+
+    void setRctGstReconnectInitialDelay(int reconnectInitialDelay) {
+        Log.d(LOG_TAG, "setRctGstReconnectInitialDelay() called with delay: " + reconnectInitialDelay);
+        this.reconnectInitialDelay = reconnectInitialDelay;
+        applyReconnectPolicy();
+    }
+
+    void setRctGstReconnectMaxDelay(int reconnectMaxDelay) {
+        Log.d(LOG_TAG, "setRctGstReconnectMaxDelay() called with delay: " + reconnectMaxDelay);
+        this.reconnectMaxDelay = reconnectMaxDelay;
+        applyReconnectPolicy();
+    }
+
+    void setRctGstReconnectJitter(double reconnectJitter) {
+        Log.d(LOG_TAG, "setRctGstReconnectJitter() called with jitter: " + reconnectJitter);
+        this.reconnectJitter = reconnectJitter;
+        applyReconnectPolicy();
+    }
+
+    void setRctGstStallTimeout(int stallTimeout) {
+        Log.d(LOG_TAG, "setRctGstStallTimeout() called with timeout: " + stallTimeout);
+        this.stallTimeout = stallTimeout;
+        applyReconnectPolicy();
+    }
+
+    void setRctGstStatsRefreshRate(int statsRefreshRate) {
+        Log.d(LOG_TAG, "setRctGstStatsRefreshRate() called with rate: " + statsRefreshRate);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetStatsRefreshRate(this.nativePlayer, statsRefreshRate);
+    }
+
+    void setRctGstQosMaxRung(int qosMaxRung) {
+        Log.d(LOG_TAG, "setRctGstQosMaxRung() called with rung: " + qosMaxRung);
+        if (isReleased()) {
+            return;
+        }
+        this.qosMaxRung = qosMaxRung;
+        nativeRCTGstSetQosPolicy(this.nativePlayer, this.qosMaxRung, this.qosMaxLateness);
+    }
+
+    void setRctGstQosMaxLateness(int qosMaxLateness) {
+        Log.d(LOG_TAG, "setRctGstQosMaxLateness() called with lateness: " + qosMaxLateness);
+        if (isReleased()) {
+            return;
+        }
+        this.qosMaxLateness = qosMaxLateness;
+        nativeRCTGstSetQosPolicy(this.nativePlayer, this.qosMaxRung, this.qosMaxLateness);
+    }
+
+    void setRctGstJitterMode(int jitterMode) {
+        Log.d(LOG_TAG, "setRctGstJitterMode() called with mode: " + jitterMode);
+        this.jitterMode = jitterMode;
+        applyJitterPolicy();
+    }
+
+    void setRctGstJitterMinLatency(int jitterMinLatency) {
+        Log.d(LOG_TAG, "setRctGstJitterMinLatency() called with latency: " + jitterMinLatency);
+        this.jitterMinLatency = jitterMinLatency;
+        applyJitterPolicy();
+    }
+
+    void setRctGstJitterMaxLatency(int jitterMaxLatency) {
+        Log.d(LOG_TAG, "setRctGstJitterMaxLatency() called with latency: " + jitterMaxLatency);
+        this.jitterMaxLatency = jitterMaxLatency;
+        applyJitterPolicy();
+    }
+
+    void setRctGstJitterTargetLoss(double jitterTargetLoss) {
+        Log.d(LOG_TAG, "setRctGstJitterTargetLoss() called with loss: " + jitterTargetLoss);
+        this.jitterTargetLoss = jitterTargetLoss;
+        applyJitterPolicy();
+    }
+
+    // Only read on init, a running player keeps its mode
+    void setRctGstSharedDecode(boolean sharedDecode) {
+        Log.d(LOG_TAG, "setRctGstSharedDecode() called with sharedDecode: " + sharedDecode);
+        if (this.isInited) {
+            Log.w(LOG_TAG, "sharedDecode only applies before the player is initialized");
+            return;
+        }
+        this.configuration.setSharedDecode(sharedDecode);
+    }
+
+    void setRctGstTransports(String transports) {
+        Log.d(LOG_TAG, "setRctGstTransports() called with transports: " + transports);
+        this.transports = transports;
+        applyTransportPolicy();
+    }
+
+    void setRctGstTransportTimeout(int transportTimeout) {
+        Log.d(LOG_TAG, "setRctGstTransportTimeout() called with timeout: " + transportTimeout);
+        this.transportTimeout = transportTimeout;
+        applyTransportPolicy();
+    }
+
+    void setRctGstRememberTransport(boolean rememberTransport) {
+        Log.d(LOG_TAG, "setRctGstRememberTransport() called with remember: " + rememberTransport);
+        this.rememberTransport = rememberTransport;
+        applyTransportPolicy();
+    }
+
+    // Grid is read on init, a player initialized without one stays a single stream
+    void setRctGstMosaicColumns(int mosaicColumns) {
+        Log.d(LOG_TAG, "setRctGstMosaicColumns() called with columns: " + mosaicColumns);
+        if (isReleased()) {
+            return;
+        }
+        this.mosaicColumns = mosaicColumns;
+        nativeRCTGstSetMosaicLayout(this.nativePlayer, this.mosaicColumns, this.mosaicRows);
+    }
+
+    void setRctGstMosaicRows(int mosaicRows) {
+        Log.d(LOG_TAG, "setRctGstMosaicRows() called with rows: " + mosaicRows);
+        if (isReleased()) {
+            return;
+        }
+        this.mosaicRows = mosaicRows;
+        nativeRCTGstSetMosaicLayout(this.nativePlayer, this.mosaicColumns, this.mosaicRows);
+    }
+
+    // Only the tiles whose uri changed are posted, the other ones keep their session
+    void setRctGstMosaicUris(String[] mosaicUris) {
+        Log.d(LOG_TAG, "setRctGstMosaicUris() called with " + mosaicUris.length + " uris");
+        if (isReleased()) {
+            return;
+        }
+        int count = Math.max(mosaicUris.length, this.mosaicUris.length);
+        for (int i = 0; i < count; i++) {
+            String uri = i < mosaicUris.length ? mosaicUris[i] : null;
+            String previous = i < this.mosaicUris.length ? this.mosaicUris[i] : null;
+            if (uri == null ? previous != null : !uri.equals(previous)) {
+                nativeRCTGstSetMosaicTile(this.nativePlayer, i, uri);
+            }
+        }
+        this.mosaicUris = mosaicUris;
+    }
+
+    void setRctGstDvrMaxDuration(int dvrMaxDuration) {
+        Log.d(LOG_TAG, "setRctGstDvrMaxDuration() called with duration: " + dvrMaxDuration);
+        if (isReleased()) {
+            return;
+        }
+        this.dvrMaxDuration = dvrMaxDuration;
+        nativeRCTGstSetDvrPolicy(this.nativePlayer, this.dvrMaxDuration, this.dvrMaxBytes);
+    }
+
+    void setRctGstDvrMaxBytes(long dvrMaxBytes) {
+        Log.d(LOG_TAG, "setRctGstDvrMaxBytes() called with bytes: " + dvrMaxBytes);
+        if (isReleased()) {
+            return;
+        }
+        this.dvrMaxBytes = dvrMaxBytes;
+        nativeRCTGstSetDvrPolicy(this.nativePlayer, this.dvrMaxDuration, this.dvrMaxBytes);
+    }
+
+    void setRctGstScrubCacheBytes(long scrubCacheBytes) {
+        Log.d(LOG_TAG, "setRctGstScrubCacheBytes() called with bytes: " + scrubCacheBytes);
+        if (isReleased()) {
+            return;
+        }
+        this.scrubCacheBytes = scrubCacheBytes;
+        nativeRCTGstSetScrubCache(this.nativePlayer, this.scrubCacheBytes, this.scrubThumbnailWidth);
+    }
+
+    void setRctGstScrubThumbnailWidth(int scrubThumbnailWidth) {
+        Log.d(LOG_TAG, "setRctGstScrubThumbnailWidth() called with width: " + scrubThumbnailWidth);
+        if (isReleased()) {
+            return;
+        }
+        this.scrubThumbnailWidth = scrubThumbnailWidth;
+        nativeRCTGstSetScrubCache(this.nativePlayer, this.scrubCacheBytes, this.scrubThumbnailWidth);
+    }
+
+    private void applyTransportPolicy() {
+        if (isReleased()) {
+            return;
+        }
+        updateMulticastLock(this.transports.contains("multicast"));
+        nativeRCTGstSetTransportPolicy(this.nativePlayer, this.transports, this.transportTimeout, this.rememberTransport);
+    }
+
+    private void updateMulticastLock(boolean needed) {
+        if (needed && this.multicastLock == null) {
+            WifiManager wifiManager = (WifiManager) context.getApplicationContext().getSystemService(Context.WIFI_SERVICE);
+            if (wifiManager == null)
+                return;
+            this.multicastLock = wifiManager.createMulticastLock(LOG_TAG);
+            this.multicastLock.setReferenceCounted(false);
+            this.multicastLock.acquire();
+        } else if (!needed && this.multicastLock != null) {
+            this.multicastLock.release();
+            this.multicastLock = null;
+        }
+    }
+
+    private void applyJitterPolicy() {
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetJitterPolicy(this.nativePlayer, this.jitterMode, this.jitterMinLatency, this.jitterMaxLatency,
+                this.jitterTargetLoss);
+    }
+
+    private void applyReconnectPolicy() {
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetReconnectPolicy(this.nativePlayer, this.reconnectInitialDelay, this.reconnectMaxDelay,
+                this.reconnectJitter, this.stallTimeout);
     }
 
     // Manager methods
     void setRctGstState(int state) {
         Log.d(LOG_TAG, "setRctGstState() called with state: " + state);
-        nativeRCTGstSetPipelineState(state);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetPipelineState(this.nativePlayer, state);
+    }
+
+    // Keeps the session alive without decoding nor rendering, e.g. while the app is in background
+    void suspendRctGst() {
+        Log.d(LOG_TAG, "suspendRctGst() called");
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSuspend(this.nativePlayer);
+    }
+
+    void resumeRctGst() {
+        Log.d(LOG_TAG, "resumeRctGst() called");
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstResume(this.nativePlayer);
+    }
+
+    void prepareRctGstUri(String uri) {
+        Log.d(LOG_TAG, "prepareRctGstUri() called with uri: " + uri);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstPrepareUri(this.nativePlayer, uri);
+    }
+
+    void timeshiftRctGst(int offset) {
+        Log.d(LOG_TAG, "timeshiftRctGst() called with offset: " + offset);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstTimeshift(this.nativePlayer, offset);
+    }
+
+    void exportRctGstClip(String path, int offset, int duration, int format) {
+        Log.d(LOG_TAG, "exportRctGstClip() called with path: " + path + ", offset: " + offset + ", duration: " + duration);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstExportClip(this.nativePlayer, path, offset, duration, format);
+    }
+
+    // Positions in ms, mode 0 accurate, 1 nearest keyframe
+    void seekRctGst(int position, int mode) {
+        Log.d(LOG_TAG, "seekRctGst() called with position: " + position + ", mode: " + mode);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSeek(this.nativePlayer, position * 1000L, mode);
+    }
+
+    void setRctGstRate(double rate) {
+        Log.d(LOG_TAG, "setRctGstRate() called with rate: " + rate);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSetRate(this.nativePlayer, rate);
+    }
+
+    void scrubRctGst(int position) {
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstScrub(this.nativePlayer, position * 1000L);
+    }
+
+    // Format 0 JPEG, 1 PNG; maxSize 0 keeps the frame size; path null returns the image in the event
+    void snapshotRctGst(int id, int format, int maxSize, String path) {
+        Log.d(LOG_TAG, "snapshotRctGst() called with id: " + id + ", path: " + path);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstSnapshot(this.nativePlayer, id, format, maxSize, path);
+    }
+
+    void dumpRctGstGraph(String path) {
+        Log.d(LOG_TAG, "dumpRctGstGraph() called with path: " + path);
+        if (isReleased()) {
+            return;
+        }
+        nativeRCTGstDumpGraph(this.nativePlayer, path);
+    }
+
+    // Null goes back to the default, info for every category
+    void setRctGstLogLevel(String logLevel) {
+        Log.d(LOG_TAG, "setRctGstLogLevel() called with logLevel: " + logLevel);
+        nativeRCTGstSetLogLevel(logLevel != null ? logLevel : "info");
     }
 
     // External C Libraries
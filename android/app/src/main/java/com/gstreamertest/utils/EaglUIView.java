@@ -11,12 +11,20 @@ import android.view.SurfaceView;
 
 public class EaglUIView extends SurfaceView {
 
+    // Surface callbacks owner, i.e. the player controller of this view
+    private SurfaceHolder.Callback surfaceHolderManager;
+
+    public SurfaceHolder.Callback getSurfaceHolderManager() {
+        return surfaceHolderManager;
+    }
+
     public Surface getHandle() {
         return this.getHolder().getSurface();
     }
 
     public EaglUIView(Context context, SurfaceHolder.Callback sufaceHolderManager) {
         super(context);
+        this.surfaceHolderManager = sufaceHolderManager;
         this.getHolder().addCallback(sufaceHolderManager);
     }
 }
@@ -52,6 +52,17 @@ public class RCTGstConfiguration {
         isDebugging = debugging;
     }
 
+    // Views of the same uri share one session and decoder, read on init
+    private boolean sharedDecode;
+
+    public boolean isSharedDecode() {
+        return sharedDecode;
+    }
+
+    public void setSharedDecode(boolean sharedDecode) {
+        this.sharedDecode = sharedDecode;
+    }
+
     // Callbacks implementations
     private RCTGstConfigurationCallable RCTGstConfigurationCallable;
 
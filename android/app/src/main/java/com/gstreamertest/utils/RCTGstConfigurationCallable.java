@@ -5,14 +5,14 @@ package com.gstreamertest.utils;
  */
 
 public interface RCTGstConfigurationCallable {
-    // Called when the player is ready
-    void onInit();
+    // Called when the player is ready, with the element chain actually built
+    void onInit(String element_chain);
 
     // Called method when GStreamer state changes
     void onStateChanged(int old_state, int new_state);
 
-    // Called method when current media volume changes
-    void onVolumeChanged(double rms, double peak, double decay);
+    // Called every audioLevelRefreshRate ms with the measurements taken meanwhile, oldest first
+    void onVolumeChanged(double[] rms, double[] peak, double[] decay);
 
     // Called when changing uri is over
     void onUriChanged(String new_uri);
@@ -23,4 +23,38 @@ public interface RCTGstConfigurationCallable {
     // Called when an error occurs
     void onElementError(String source, String message, String debug_info);
 
+    // Called when the first frame of a new uri, or after a resume, is displayed
+    // (mode: 0 source only, 1 full restart, 2 standby, 3 resume, 4 shared; transport: 0 udp, 1 multicast, 2 tcp, 3 http)
+    void onFirstFrame(int mode, long ttff_us, int transport);
+
+    // Called when a posted command (state, uri, surface...) has been applied natively
+    void onCommandDone(int command, int result, long latency_us);
+
+    // Called when a reconnect gets scheduled and when the stream recovers
+    void onReconnect(boolean degraded, int errors, int stalls, int attempts, int recoveries,
+                     int consecutive_failures, long degraded_us, long next_attempt_in_us);
+
+    // Called every stats refresh period, stages holds per stage (count, sum_us, max_us, buckets...)
+    void onStats(long frames_decoded, long frames_rendered, long frames_dropped, long frames_late,
+                 long bitrate, long packets_lost, double jitter_ms, int latency_ms, boolean retransmission,
+                 long[] stages);
+
+    // Called when overload moves the degradation ladder one rung up or down
+    // (rung: 0 none, 1 drop late, 2 skip non reference, 3 keyframes only, 4 lower resolution)
+    void onQos(int rung, int previous_rung, int transitions, double late_ratio, double queue_fill,
+               long frames_dropped_late, long frames_skipped);
+
+    // Called once a clip export is over, the file at path is complete when success is set
+    void onDvrExport(String path, boolean success, long duration_us);
+
+    // Called when the first frame after a seek is displayed
+    void onSeekDone(long position_us, long duration_us, long latency_us);
+
+    // Called on scrub with the nearest cached thumbnail, RGBA pixels only valid during the call
+    void onScrubPreview(long position_us, int width, int height, java.nio.ByteBuffer pixels);
+
+    // Called once per snapshot request, with the file written or the encoded image in data
+    void onSnapshot(int id, boolean success, String error, String path, byte[] data, int width, int height,
+                    long position_us);
+
 }
@@ -10,7 +10,7 @@ import java.util.Map;
 public enum Command {
 
     // callable methods from JS
-    setState, recreateView;
+    setState, recreateView, prepareUri, suspend, resume, timeshift, exportClip, seek, setRate, scrub, snapshot, dumpGraph;
 
     // Index for js association
     private int index;
@@ -5,7 +5,35 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE := rctgstplayer
-LOCAL_SRC_FILES := rctgstplayer.c $(LOCAL_PATH)/../common/gstreamer_backend.c
+LOCAL_SRC_FILES := rctgstplayer.c \
+                   $(LOCAL_PATH)/../common/gstreamer_backend.c \
+                   $(LOCAL_PATH)/../common/gstreamer_audio_level.c \
+                   $(LOCAL_PATH)/../common/gstreamer_autoplug.c \
+                   $(LOCAL_PATH)/../common/gstreamer_codec.c \
+                   $(LOCAL_PATH)/../common/gstreamer_command_queue.c \
+                   $(LOCAL_PATH)/../common/gstreamer_dvr.c \
+                   $(LOCAL_PATH)/../common/gstreamer_event_channel.c \
+                   $(LOCAL_PATH)/../common/gstreamer_jitter.c \
+                   $(LOCAL_PATH)/../common/gstreamer_log.c \
+                   $(LOCAL_PATH)/../common/gstreamer_mosaic.c \
+                   $(LOCAL_PATH)/../common/gstreamer_qos.c \
+                   $(LOCAL_PATH)/../common/gstreamer_reconnect.c \
+                   $(LOCAL_PATH)/../common/gstreamer_scrub.c \
+                   $(LOCAL_PATH)/../common/gstreamer_shared_decode.c \
+                   $(LOCAL_PATH)/../common/gstreamer_snapshot.c \
+                   $(LOCAL_PATH)/../common/gstreamer_source.c \
+                   $(LOCAL_PATH)/../common/gstreamer_standby_pool.c \
+                   $(LOCAL_PATH)/../common/gstreamer_startup.c \
+                   $(LOCAL_PATH)/../common/gstreamer_stats.c \
+                   $(LOCAL_PATH)/../common/gstreamer_transport.c
+
+# Factories and pipeline template prewarmed from JNI_OnLoad, 0 leaves everything to the first view
+RCT_GST_PREWARM ?= 1
+LOCAL_CFLAGS += -DRCT_GST_PREWARM=$(RCT_GST_PREWARM)
+
+# Native log lines above this level are compiled out: 0 none, 1 error, 2 info, 3 debug
+RCT_GST_LOG_MAX_LEVEL ?= 3
+LOCAL_CFLAGS += -DRCT_GST_LOG_MAX_LEVEL=$(RCT_GST_LOG_MAX_LEVEL)
 
 LOCAL_SHARED_LIBRARIES := gstreamer_android
 LOCAL_LDLIBS := -llog -landroid
@@ -29,6 +57,13 @@ endif
 GSTREAMER_NDK_BUILD_PATH := $(GSTREAMER_ROOT)/share/gst-android/ndk-build/
 
 include $(GSTREAMER_NDK_BUILD_PATH)/plugins.mk
+# Plugins linked in, every one of them is registered by GStreamer.init. "minimal" only has what the
+# player uses, "full" the whole set of the SDK groups. RCT_GST_EXTRA_PLUGINS is added to either.
+RCT_GST_PLUGIN_SET ?= minimal
+# SDKs older than 1.22 ship these as "videoconvert videoscale"
+RCT_GST_VIDEO_CONVERT_PLUGINS ?= videoconvertscale
+
+ifeq ($(RCT_GST_PLUGIN_SET),full)
 GSTREAMER_PLUGINS := $(GSTREAMER_PLUGINS_CORE) \
                      $(GSTREAMER_PLUGINS_PLAYBACK) \
                      $(GSTREAMER_PLUGINS_CODECS) \
@@ -40,6 +75,17 @@ GSTREAMER_PLUGINS := $(GSTREAMER_PLUGINS_CORE) \
                      $(GSTREAMER_PLUGINS_VIS) \
                      $(GSTREAMER_PLUGINS_EFFECTS) \
                      $(GSTREAMER_PLUGINS_NET_RESTRICTED)
+else
+# Sources, depayloaders and jitterbuffer
+GSTREAMER_PLUGINS := coreelements app rtsp rtp rtpmanager udp soup playback typefindfunctions
+# Demuxers of the files uridecodebin plays, MP4 comes with isomp4 and TS is what clip export writes
+GSTREAMER_PLUGINS += matroska mpegtsdemux
+# Parsing, decoding and rendering, jpegformat parses MJPEG
+GSTREAMER_PLUGINS += videoparsersbad jpegformat androidmedia libav opengl $(RCT_GST_VIDEO_CONVERT_PLUGINS)
+# Audio metering, mosaics, clip export and snapshots. libav has no G.711, the usual camera audio.
+GSTREAMER_PLUGINS += audioparsers audioconvert mulaw alaw level compositor isomp4 mpegtsmux jpeg png
+endif
+GSTREAMER_PLUGINS += $(RCT_GST_EXTRA_PLUGINS)
 
 GSTREAMER_EXTRA_DEPS := gstreamer-player-1.0 gstreamer-video-1.0 glib-2.0 gobject-2.0
 GSTREAMER_EXTRA_LIBS      := -liconv
@@ -1,18 +1,23 @@
 #include <string.h>
 #include <jni.h>
-#include <android/log.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
 #include <gst/gst.h>
 #include "../common/gstreamer_backend.h"
-#include <pthread.h>
+#include "../common/gstreamer_event_channel.h"
+#include "../common/gstreamer_log.h"
 
 #define LOG_TAG "RCTGstPlayerController"
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
 
-ANativeWindow *native_window;
+// Per player JNI state, stored in the configuration userData of its backend player
+typedef struct {
+    jobject app;
+    ANativeWindow *native_window;
+    ANativeWindow *retired_native_window;   // Previous window, kept until the player thread switched away from it
+} RctGstJniPlayer;
+
+#define JNI_PLAYER(player) ((RctGstJniPlayer *)rct_gst_get_configuration(player)->userData)
+#define PLAYER_FROM_HANDLE(handle) ((RctGstPlayer *)(intptr_t)(handle))
 
 // Java callbacks
 static jmethodID on_player_init_id;
@@ -20,56 +25,35 @@ static jmethodID on_state_changed_id;
 static jmethodID on_uri_changed_id;
 static jmethodID on_eos_id;
 static jmethodID on_element_error_id;
+static jmethodID on_first_frame_id;
+static jmethodID on_command_done_id;
+static jmethodID on_reconnect_id;
+static jmethodID on_stats_id;
+static jmethodID on_volume_changed_id;
+static jmethodID on_qos_id;
+static jmethodID on_dvr_export_id;
+static jmethodID on_seek_done_id;
+static jmethodID on_scrub_preview_id;
+static jmethodID on_snapshot_id;
 
 // Global context
-pthread_t gst_app_thread;
-static pthread_key_t current_jni_env;
-jobject app;
-
 static JavaVM *jvm;
 
-/* Register this thread with the VM */
-static JNIEnv *attach_current_thread(void) {
-    JNIEnv *env;
-    JavaVMAttachArgs args;
-
-    args.version = JNI_VERSION_1_6;
-    args.name = NULL;
-    args.group = NULL;
-
-    if ((*jvm)->AttachCurrentThread(jvm, &env, &args) < 0) {
-        LOGE("Failed to attach current thread");
-        return NULL;
-    }
-
-    LOGD("Thread attached: %p", env);
-    return env;
-}
-
-/* Unregister this thread from the VM */
-static void detach_current_thread(void *env) {
-    LOGD("Detaching thread %p", g_thread_self());
-    (*jvm)->DetachCurrentThread(jvm);
-    LOGD("Thread detached: %p", env);
-}
-
-/* Retrieve the JNI environment for this thread */
-static JNIEnv *get_jni_env(void) {
-    JNIEnv *env;
-
-    if ((env = pthread_getspecific(current_jni_env)) == NULL) {
-        env = attach_current_thread();
-        pthread_setspecific(current_jni_env, env);
-    }
-
-    return env;
-}
+// Every player posts its events there, the Java drain thread delivers them
+static RctGstEventChannel *events;
+#define EVENT_CHANNEL_CAPACITY 256
+#define EVENT_BATCH_SIZE 64
 
 // Bindings methods
 static jstring native_rct_gst_get_gstreamer_info(JNIEnv* env, jobject thiz) {
     (void)env;
     (void)thiz;
 
+    // The controller asks right after GStreamer.init, which may have failed
+    if (gst_is_initialized()) {
+        rct_gst_startup_mark(RCT_GST_STARTUP_GST_INITIALIZED);
+    }
+
     LOGD("Getting GStreamer info");
     char *version_utf8 = rct_gst_get_info();
     if (version_utf8 != NULL) {
@@ -83,138 +67,785 @@ static jstring native_rct_gst_get_gstreamer_info(JNIEnv* env, jobject thiz) {
     return version_jstring;
 }
 
+static jstring native_rct_gst_get_element_chain(JNIEnv* env, jobject thiz, jlong handle) {
+    (void)thiz;
+
+    gchar *element_chain = rct_gst_get_element_chain(PLAYER_FROM_HANDLE(handle));
+    jstring element_chain_jstring = element_chain ? (*env)->NewStringUTF(env, element_chain) : NULL;
+    g_free(element_chain);
+    return element_chain_jstring;
+}
 
-static void native_rct_gst_set_drawable_surface(JNIEnv* env, jobject thiz, jobject surface) {
+static jlong native_rct_gst_player_new(JNIEnv* env, jobject thiz) {
     (void)env;
+
+    RctGstPlayer *player = rct_gst_player_new();
+    RctGstJniPlayer *jni_player = g_new0(RctGstJniPlayer, 1);
+    jni_player->app = (*env)->NewGlobalRef(env, thiz);
+    rct_gst_get_configuration(player)->userData = jni_player;
+
+    LOGD("Created native player %p", player);
+    return (jlong)(intptr_t)player;
+}
+
+static void native_rct_gst_player_free(JNIEnv* env, jobject thiz, jlong handle) {
     (void)thiz;
 
+    RctGstPlayer *player = PLAYER_FROM_HANDLE(handle);
+    if (player == NULL) {
+        return;
+    }
+
+    // Joins the player thread, no callback can run past this point
+    RctGstJniPlayer *jni_player = JNI_PLAYER(player);
+    rct_gst_player_free(player);
+
+    if (jni_player->native_window != NULL) {
+        ANativeWindow_release(jni_player->native_window);
+    }
+    if (jni_player->retired_native_window != NULL) {
+        ANativeWindow_release(jni_player->retired_native_window);
+    }
+    // Events still queued go out first, the global ref is dropped once they are delivered
+    RctGstEvent event = { RCT_GST_EVENT_RELEASE };
+    event.target = jni_player;
+    rct_gst_event_channel_push(events, &event);
+    LOGD("Freed native player %p", player);
+}
+
+static void native_rct_gst_set_drawable_surface(JNIEnv* env, jobject thiz, jlong handle, jobject surface) {
+    (void)env;
+    (void)thiz;
+
+    RctGstPlayer *player = PLAYER_FROM_HANDLE(handle);
+    RctGstJniPlayer *jni_player = JNI_PLAYER(player);
+
+    // Surface destroyed: the sink lets go of the window once suspended, the window itself is retired by the next one
     if (surface == NULL) {
         LOGI("Surface is NULL");
+        rct_gst_set_drawable_surface(player, 0);
         return;
     }
 
-    native_window = ANativeWindow_fromSurface(env, surface);
+    ANativeWindow *native_window = ANativeWindow_fromSurface(env, surface);
     if (native_window == NULL) {
         LOGE("Failed to get native window from surface");
         return;
     }
 
+    // The surface switch is asynchronous, so the current window stays alive until the next one
+    if (jni_player->retired_native_window != NULL) {
+        ANativeWindow_release(jni_player->retired_native_window);
+    }
+    jni_player->retired_native_window = jni_player->native_window;
+    jni_player->native_window = native_window;
+
     LOGI("Setting drawable surface: %p", native_window);
-    LOGD("Before calling rct_gst_set_drawable_surface in native_rct_gst_set_drawable_surface");
-    rct_gst_set_drawable_surface((guintptr)native_window);
-    LOGD("After calling rct_gst_set_drawable_surface in native_rct_gst_set_drawable_surface");
+    rct_gst_set_drawable_surface(player, (guintptr)native_window);
 }
 
-static void native_rct_gst_set_pipeline_state(JNIEnv* env, jobject thiz, jint state) {
+static void native_rct_gst_set_surface_size(JNIEnv* env, jobject thiz, jlong handle, jint width, jint height) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting surface size: %dx%d", width, height);
+    rct_gst_set_surface_size(PLAYER_FROM_HANDLE(handle), width, height);
+}
+
+static void native_rct_gst_set_pipeline_state(JNIEnv* env, jobject thiz, jlong handle, jint state) {
     (void)env;
     (void)thiz;
 
     LOGI("Setting pipeline state: %d", state);
-    rct_gst_set_pipeline_state((GstState) state);
+    rct_gst_set_pipeline_state(PLAYER_FROM_HANDLE(handle), (GstState) state);
+}
+
+static void native_rct_gst_suspend(JNIEnv* env, jobject thiz, jlong handle) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Suspending");
+    rct_gst_suspend(PLAYER_FROM_HANDLE(handle));
+}
+
+static void native_rct_gst_resume(JNIEnv* env, jobject thiz, jlong handle) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Resuming");
+    rct_gst_resume(PLAYER_FROM_HANDLE(handle));
 }
 
-static void native_rct_gst_set_uri(JNIEnv* env, jobject thiz, jstring uri_j) {
+static void native_rct_gst_set_uri(JNIEnv* env, jobject thiz, jlong handle, jstring uri_j) {
     (void)env;
     (void)thiz;
 
     const gchar *uri = (*env)->GetStringUTFChars(env, uri_j, 0);
     LOGI("Setting URI: %s", uri);
-    rct_gst_set_uri(g_strdup(uri));  // Duplicate the URI here as well.
+    rct_gst_set_uri(PLAYER_FROM_HANDLE(handle), (gchar *)uri);     // The command keeps its own copy
     (*env)->ReleaseStringUTFChars(env, uri_j, uri);
 }
 
-static void native_rct_gst_set_debugging(JNIEnv* env, jobject thiz, jboolean is_debugging) {
+static void native_rct_gst_prepare_uri(JNIEnv* env, jobject thiz, jlong handle, jstring uri_j) {
+    (void)thiz;
+
+    const gchar *uri = (*env)->GetStringUTFChars(env, uri_j, 0);
+    LOGI("Preparing standby URI: %s", uri);
+    rct_gst_prepare_uri(PLAYER_FROM_HANDLE(handle), (gchar *)uri);
+    (*env)->ReleaseStringUTFChars(env, uri_j, uri);
+}
+
+static void native_rct_gst_set_standby_pool(JNIEnv* env, jobject thiz, jlong handle, jint capacity, jlong gop_budget) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting standby pool: %d sources, %lld bytes", capacity, (long long)gop_budget);
+    rct_gst_set_standby_pool(PLAYER_FROM_HANDLE(handle), (guint)MAX(capacity, 0), (gsize)MAX(gop_budget, 0));
+}
+
+static void native_rct_gst_set_reconnect_policy(JNIEnv* env, jobject thiz, jlong handle, jint initial_delay,
+                                                jint max_delay, jdouble jitter, jint stall_timeout) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting reconnect policy: %d-%d ms, jitter %f, stall timeout %d ms", initial_delay, max_delay, jitter, stall_timeout);
+    rct_gst_set_reconnect_policy(PLAYER_FROM_HANDLE(handle), (guint)MAX(initial_delay, 0), (guint)MAX(max_delay, 0),
+                                 jitter, (guint)MAX(stall_timeout, 0));
+}
+
+static void native_rct_gst_set_stats_refresh_rate(JNIEnv* env, jobject thiz, jlong handle, jint refresh_rate) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting stats refresh rate: %d ms", refresh_rate);
+    rct_gst_set_stats_refresh_rate(PLAYER_FROM_HANDLE(handle), (guint)MAX(refresh_rate, 0));
+}
+
+static void native_rct_gst_set_qos_policy(JNIEnv* env, jobject thiz, jlong handle, jint max_rung, jint max_lateness) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting QoS policy: rung %d, %d ms lateness", max_rung, max_lateness);
+    rct_gst_set_qos_policy(PLAYER_FROM_HANDLE(handle), (RctGstQosRung)CLAMP(max_rung, 0, RCT_GST_QOS_RUNG_COUNT - 1),
+                           (guint)MAX(max_lateness, 0));
+}
+
+static void native_rct_gst_set_jitter_policy(JNIEnv* env, jobject thiz, jlong handle, jint mode, jint min_latency,
+                                             jint max_latency, jdouble target_loss) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting jitter policy: mode %d, %d-%d ms, target loss %f", mode, min_latency, max_latency, target_loss);
+    rct_gst_set_jitter_policy(PLAYER_FROM_HANDLE(handle),
+                              mode == RCT_GST_JITTER_ADAPTIVE ? RCT_GST_JITTER_ADAPTIVE : RCT_GST_JITTER_FIXED,
+                              (guint)MAX(min_latency, 0), (guint)MAX(max_latency, 0), target_loss);
+}
+
+static void native_rct_gst_set_transport_policy(JNIEnv* env, jobject thiz, jlong handle, jstring transports_j,
+                                                jint timeout, jboolean remember) {
+    (void)thiz;
+
+    const gchar *transports = (*env)->GetStringUTFChars(env, transports_j, 0);
+    LOGI("Setting transport policy: %s, %d ms per transport, remember %d", transports, timeout, remember);
+    rct_gst_set_transport_policy(PLAYER_FROM_HANDLE(handle), transports, (guint)MAX(timeout, 0), remember);
+    (*env)->ReleaseStringUTFChars(env, transports_j, transports);
+}
+
+static void native_rct_gst_set_mosaic_layout(JNIEnv* env, jobject thiz, jlong handle, jint columns, jint rows) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting mosaic layout: %dx%d", columns, rows);
+    rct_gst_set_mosaic_layout(PLAYER_FROM_HANDLE(handle), (guint)MAX(columns, 0), (guint)MAX(rows, 0));
+}
+
+// uri_j null removes the tile
+static void native_rct_gst_set_mosaic_tile(JNIEnv* env, jobject thiz, jlong handle, jint index, jstring uri_j) {
+    (void)thiz;
+
+    if (index < 0) {
+        return;
+    }
+    if (uri_j == NULL) {
+        LOGI("Removing mosaic tile %d", index);
+        rct_gst_set_mosaic_tile(PLAYER_FROM_HANDLE(handle), (guint)index, NULL);
+        return;
+    }
+    const gchar *uri = (*env)->GetStringUTFChars(env, uri_j, 0);
+    LOGI("Setting mosaic tile %d: %s", index, uri);
+    rct_gst_set_mosaic_tile(PLAYER_FROM_HANDLE(handle), (guint)index, uri);
+    (*env)->ReleaseStringUTFChars(env, uri_j, uri);
+}
+
+static void native_rct_gst_set_dvr_policy(JNIEnv* env, jobject thiz, jlong handle, jint max_duration, jlong max_bytes) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting DVR policy: %d ms, %lld bytes", max_duration, (long long)max_bytes);
+    rct_gst_set_dvr_policy(PLAYER_FROM_HANDLE(handle), (guint)MAX(max_duration, 0), (gsize)MAX(max_bytes, 0));
+}
+
+static void native_rct_gst_timeshift(JNIEnv* env, jobject thiz, jlong handle, jint offset) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Timeshift: %d ms behind live", offset);
+    rct_gst_timeshift(PLAYER_FROM_HANDLE(handle), (guint)MAX(offset, 0));
+}
+
+static void native_rct_gst_export_clip(JNIEnv* env, jobject thiz, jlong handle, jstring path_j, jint offset,
+                                       jint duration, jint format) {
+    (void)thiz;
+
+    const gchar *path = (*env)->GetStringUTFChars(env, path_j, 0);
+    LOGI("Exporting clip to %s: %d ms behind live, %d ms long", path, offset, duration);
+    rct_gst_export_clip(PLAYER_FROM_HANDLE(handle), (guint)MAX(offset, 0), (guint)MAX(duration, 0), path,
+                        format == RCT_GST_DVR_FORMAT_TS ? RCT_GST_DVR_FORMAT_TS : RCT_GST_DVR_FORMAT_MP4);
+    (*env)->ReleaseStringUTFChars(env, path_j, path);
+}
+
+static void native_rct_gst_set_scrub_cache(JNIEnv* env, jobject thiz, jlong handle, jlong max_bytes, jint width) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting scrub cache: %lld bytes, %d px wide", (long long)max_bytes, width);
+    rct_gst_set_scrub_cache(PLAYER_FROM_HANDLE(handle), (gsize)MAX(max_bytes, 0), width);
+}
+
+static void native_rct_gst_seek(JNIEnv* env, jobject thiz, jlong handle, jlong position_us, jint mode) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Seeking to %lld us", (long long)position_us);
+    rct_gst_seek(PLAYER_FROM_HANDLE(handle), position_us,
+                 mode == RCT_GST_SEEK_KEYFRAME ? RCT_GST_SEEK_KEYFRAME : RCT_GST_SEEK_ACCURATE);
+}
+
+static void native_rct_gst_set_rate(JNIEnv* env, jobject thiz, jlong handle, jdouble rate) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting rate: %f", rate);
+    rct_gst_set_rate(PLAYER_FROM_HANDLE(handle), rate);
+}
+
+static void native_rct_gst_scrub(JNIEnv* env, jobject thiz, jlong handle, jlong position_us) {
+    (void)env;
+    (void)thiz;
+
+    rct_gst_scrub(PLAYER_FROM_HANDLE(handle), position_us);
+}
+
+static void native_rct_gst_dump_graph(JNIEnv* env, jobject thiz, jlong handle, jstring path_j) {
+    (void)thiz;
+
+    const gchar *path = (*env)->GetStringUTFChars(env, path_j, 0);
+    LOGI("Dumping pipeline graph to %s", path);
+    rct_gst_dump_graph(PLAYER_FROM_HANDLE(handle), path);
+    (*env)->ReleaseStringUTFChars(env, path_j, path);
+}
+
+// Levels are shared by every player
+static void native_rct_gst_set_log_level(JNIEnv* env, jobject thiz, jstring spec_j) {
+    (void)thiz;
+
+    const gchar *spec = (*env)->GetStringUTFChars(env, spec_j, 0);
+    rct_gst_log_configure(spec);
+    (*env)->ReleaseStringUTFChars(env, spec_j, spec);
+}
+
+// Snapshot in flight, freed once its result is posted
+typedef struct {
+    RctGstPlayer *player;
+    gint id;
+} SnapshotRequest;
+
+void native_on_snapshot(const RctGstSnapshot *snapshot, gpointer user_data);
+
+static void native_rct_gst_snapshot(JNIEnv* env, jobject thiz, jlong handle, jint id, jint format, jint max_size,
+                                    jstring path_j) {
+    (void)thiz;
+
+    SnapshotRequest *request = g_new0(SnapshotRequest, 1);
+    const gchar *path = path_j ? (*env)->GetStringUTFChars(env, path_j, 0) : NULL;
+
+    request->player = PLAYER_FROM_HANDLE(handle);
+    request->id = id;
+    LOGI("Snapshot %d to %s", id, path ? path : "bytes");
+    rct_gst_snapshot(request->player, format == RCT_GST_SNAPSHOT_PNG ? RCT_GST_SNAPSHOT_PNG : RCT_GST_SNAPSHOT_JPEG,
+                     MAX(max_size, 0), path, native_on_snapshot, request);
+    if (path) {
+        (*env)->ReleaseStringUTFChars(env, path_j, path);
+    }
+}
+
+static void native_rct_gst_set_audio_level_refresh_rate(JNIEnv* env, jobject thiz, jlong handle, jint refresh_rate) {
+    (void)env;
+    (void)thiz;
+
+    LOGI("Setting audio level refresh rate: %d ms", refresh_rate);
+    rct_gst_set_audio_level_refresh_rate(PLAYER_FROM_HANDLE(handle), (guint)MAX(refresh_rate, 0));
+}
+
+static void native_rct_gst_set_debugging(JNIEnv* env, jobject thiz, jlong handle, jboolean is_debugging) {
     (void)env;
     (void)thiz;
     
     LOGI("Setting debugging: %s", is_debugging ? "true" : "false");
-    rct_gst_set_debugging(is_debugging);
+    rct_gst_set_debugging(PLAYER_FROM_HANDLE(handle), is_debugging);
+}
+
+/****************************
+ CALLBACKS, ON THE PLAYER THREAD
+ ***************************/
+// Only post events: no JNI, no bridge, nothing that may block
+static void post_event(RctGstPlayer *player, RctGstEvent *event) {
+    event->target = JNI_PLAYER(player);
+    rct_gst_event_channel_push(events, event);
 }
 
-void native_on_init() {
-    JNIEnv *env = get_jni_env();
-    LOGD("Calling onInit callback");
-    (*env)->CallVoidMethod(env, app, on_player_init_id);
+void native_on_init(RctGstPlayer *player) {
+    RctGstEvent event = { RCT_GST_EVENT_INIT };
+    LOGD("Posting onInit");
+    event.args.element_chain = rct_gst_get_element_chain(player);
+    post_event(player, &event);
 }
 
-void native_on_state_changed(GstState old_state, GstState new_state) {
-    JNIEnv *env = get_jni_env();
+void native_on_state_changed(RctGstPlayer *player, GstState old_state, GstState new_state) {
+    RctGstEvent event = { RCT_GST_EVENT_STATE_CHANGED };
     LOGI("State changed from %d to %d", old_state, new_state);
-    (*env)->CallVoidMethod(env, app, on_state_changed_id, (jint)old_state, (jint)new_state);
+    event.args.state.old_state = old_state;
+    event.args.state.new_state = new_state;
+    post_event(player, &event);
 }
 
-void native_on_uri_changed(gchar *_new_uri) {
-    JNIEnv *env = get_jni_env();
-    jstring new_uri = (*env)->NewStringUTF(env, _new_uri);
+void native_on_uri_changed(RctGstPlayer *player, gchar *_new_uri) {
+    RctGstEvent event = { RCT_GST_EVENT_URI_CHANGED };
     LOGI("URI changed: %s", _new_uri);
-    (*env)->CallVoidMethod(env, app, on_uri_changed_id, new_uri);
+    event.args.uri = g_strdup(_new_uri);
+    post_event(player, &event);
 }
 
-void native_on_eos() {
-    JNIEnv *env = get_jni_env();
+void native_on_eos(RctGstPlayer *player) {
+    RctGstEvent event = { RCT_GST_EVENT_EOS };
     LOGD("End of stream (EOS) reached");
-    (*env)->CallVoidMethod(env, app, on_eos_id);
+    post_event(player, &event);
 }
 
-void native_on_element_error(gchar *_source, gchar *_message, gchar *_debug_info) {
-    JNIEnv *env = get_jni_env();
-
-    jstring source = (*env)->NewStringUTF(env, _source);
-    jstring message = (*env)->NewStringUTF(env, _message);
-    jstring debug_info = (*env)->NewStringUTF(env, _debug_info);
+void native_on_element_error(RctGstPlayer *player, gchar *_source, gchar *_message, gchar *_debug_info) {
+    RctGstEvent event = { RCT_GST_EVENT_ELEMENT_ERROR };
     LOGE("Element error - Source: %s, Message: %s, Debug info: %s", _source, _message, _debug_info);
-    (*env)->CallVoidMethod(env, app, on_element_error_id, source, message, debug_info);
+    event.args.error.source = g_strdup(_source);
+    event.args.error.message = g_strdup(_message);
+    event.args.error.debug_info = g_strdup(_debug_info);
+    post_event(player, &event);
+}
+
+void native_on_first_frame(RctGstPlayer *player, RctGstUriSwitchMode mode, gint64 ttff_us, RctGstTransport transport) {
+    RctGstEvent event = { RCT_GST_EVENT_FIRST_FRAME };
+    LOGI("First frame after uri switch in %lld us over %s", (long long)ttff_us, rct_gst_transport_get_name(transport));
+    event.args.first_frame.mode = mode;
+    event.args.first_frame.ttff_us = ttff_us;
+    event.args.first_frame.transport = transport;
+    post_event(player, &event);
+}
+
+void native_on_command_done(RctGstPlayer *player, RctGstCommandType command, gint result, gint64 latency_us) {
+    RctGstEvent event = { RCT_GST_EVENT_COMMAND_DONE };
+    event.args.command_done.command = command;
+    event.args.command_done.result = result;
+    event.args.command_done.latency_us = latency_us;
+    post_event(player, &event);
+}
+
+void native_on_reconnect(RctGstPlayer *player, const RctGstReconnectStats *stats) {
+    RctGstEvent event = { RCT_GST_EVENT_RECONNECT };
+    LOGI("Reconnect: degraded %d, %u consecutive failures", stats->degraded, stats->consecutive_failures);
+    event.args.reconnect = *stats;
+    post_event(player, &event);
+}
+
+void native_on_stats(RctGstPlayer *player, const RctGstStats *stats) {
+    RctGstEvent event = { RCT_GST_EVENT_STATS };
+    event.args.stats = g_new(RctGstStats, 1);
+    *event.args.stats = *stats;
+    post_event(player, &event);
+}
+
+void native_on_qos(RctGstPlayer *player, const RctGstQosStatus *status) {
+    RctGstEvent event = { RCT_GST_EVENT_QOS };
+    LOGI("QoS: %s -> %s", rct_gst_qos_rung_get_name(status->previous_rung), rct_gst_qos_rung_get_name(status->rung));
+    event.args.qos = *status;
+    post_event(player, &event);
+}
+
+void native_on_dvr_export(RctGstPlayer *player, const gchar *path, gboolean success, gint64 duration_us) {
+    RctGstEvent event = { RCT_GST_EVENT_DVR_EXPORT };
+    event.args.dvr_export.path = g_strdup(path);
+    event.args.dvr_export.success = success;
+    event.args.dvr_export.duration_us = duration_us;
+    post_event(player, &event);
+}
+
+void native_on_seek_done(RctGstPlayer *player, gint64 position_us, gint64 duration_us, gint64 latency_us) {
+    RctGstEvent event = { RCT_GST_EVENT_SEEK_DONE };
+    LOGI("Seek done in %lld us", (long long)latency_us);
+    event.args.seek_done.position_us = position_us;
+    event.args.seek_done.duration_us = duration_us;
+    event.args.seek_done.latency_us = latency_us;
+    post_event(player, &event);
+}
+
+// The thumbnail is shared with the cache, not copied
+void native_on_scrub_preview(RctGstPlayer *player, const RctGstScrubThumbnail *thumbnail) {
+    RctGstEvent event = { RCT_GST_EVENT_SCRUB_PREVIEW };
+    event.args.scrub_preview = *thumbnail;
+    event.args.scrub_preview.pixels = gst_buffer_ref(thumbnail->pixels);
+    post_event(player, &event);
+}
+
+// Snapshot worker thread
+void native_on_snapshot(const RctGstSnapshot *snapshot, gpointer user_data) {
+    SnapshotRequest *request = (SnapshotRequest *)user_data;
+    RctGstEvent event = { RCT_GST_EVENT_SNAPSHOT };
+
+    event.args.snapshot.id = request->id;
+    event.args.snapshot.success = snapshot->success;
+    event.args.snapshot.error = g_strdup(snapshot->error);
+    event.args.snapshot.path = g_strdup(snapshot->path);
+    event.args.snapshot.bytes = snapshot->bytes ? g_bytes_ref(snapshot->bytes) : NULL;
+    event.args.snapshot.width = snapshot->width;
+    event.args.snapshot.height = snapshot->height;
+    event.args.snapshot.position_us = snapshot->position_us;
+    post_event(request->player, &event);
+    g_free(request);
+}
+
+void native_on_volume_changed(RctGstPlayer *player, const RctGstAudioLevel *levels, guint count) {
+    RctGstEvent event = { RCT_GST_EVENT_VOLUME_CHANGED };
+    // g_memdup is deprecated and g_memdup2 needs GLib 2.68
+    event.args.volume.levels = g_new(RctGstAudioLevel, count);
+    if (count > 0) {
+        memcpy(event.args.volume.levels, levels, count * sizeof(RctGstAudioLevel));
+    }
+    event.args.volume.count = count;
+    post_event(player, &event);
+}
+
+/******************************
+ DELIVERY, ON THE JAVA DRAIN THREAD
+ *****************************/
+// Histograms are flattened per stage as count, sum_us, max_us then the buckets
+#define STATS_STAGE_LENGTH (3 + RCT_GST_STATS_BUCKETS)
+
+static void deliver_stats(JNIEnv *env, jobject app, const RctGstStats *stats) {
+    jlong stages[RCT_GST_STAGE_COUNT * STATS_STAGE_LENGTH];
+    jlongArray stages_j;
+    guint i, j;
+
+    for (i = 0; i < RCT_GST_STAGE_COUNT; i++) {
+        jlong *stage = &stages[i * STATS_STAGE_LENGTH];
+        stage[0] = (jlong)stats->stages[i].count;
+        stage[1] = (jlong)stats->stages[i].sum_us;
+        stage[2] = (jlong)stats->stages[i].max_us;
+        for (j = 0; j < RCT_GST_STATS_BUCKETS; j++) {
+            stage[3 + j] = (jlong)stats->stages[i].buckets[j];
+        }
+    }
+    stages_j = (*env)->NewLongArray(env, G_N_ELEMENTS(stages));
+    (*env)->SetLongArrayRegion(env, stages_j, 0, G_N_ELEMENTS(stages), stages);
+
+    (*env)->CallVoidMethod(env, app, on_stats_id,
+                           (jlong)stats->frames_decoded, (jlong)stats->frames_rendered, (jlong)stats->frames_dropped,
+                           (jlong)stats->frames_late, (jlong)stats->bitrate, (jlong)stats->packets_lost,
+                           (jdouble)stats->jitter_ms, (jint)stats->latency_ms, (jboolean)stats->retransmission,
+                           stages_j);
+    (*env)->DeleteLocalRef(env, stages_j);
+}
+
+// One array per field, oldest measurement first
+static void deliver_volume(JNIEnv *env, jobject app, const RctGstAudioLevel *levels, guint count) {
+    jdouble *values = g_new(jdouble, count * 3);
+    jdoubleArray rms_j = (*env)->NewDoubleArray(env, count);
+    jdoubleArray peak_j = (*env)->NewDoubleArray(env, count);
+    jdoubleArray decay_j = (*env)->NewDoubleArray(env, count);
+    guint i;
+
+    for (i = 0; i < count; i++) {
+        values[i] = levels[i].rms;
+        values[count + i] = levels[i].peak;
+        values[2 * count + i] = levels[i].decay;
+    }
+    (*env)->SetDoubleArrayRegion(env, rms_j, 0, count, values);
+    (*env)->SetDoubleArrayRegion(env, peak_j, 0, count, values + count);
+    (*env)->SetDoubleArrayRegion(env, decay_j, 0, count, values + 2 * count);
+    g_free(values);
+
+    (*env)->CallVoidMethod(env, app, on_volume_changed_id, rms_j, peak_j, decay_j);
+    (*env)->DeleteLocalRef(env, rms_j);
+    (*env)->DeleteLocalRef(env, peak_j);
+    (*env)->DeleteLocalRef(env, decay_j);
+}
+
+// Java copies the pixels out during the call, the direct buffer only wraps the mapped thumbnail
+static void deliver_scrub_preview(JNIEnv *env, jobject app, const RctGstScrubThumbnail *thumbnail) {
+    GstMapInfo map;
+    jobject pixels_j;
+
+    if (!gst_buffer_map(thumbnail->pixels, &map, GST_MAP_READ)) {
+        return;
+    }
+    pixels_j = (*env)->NewDirectByteBuffer(env, map.data, (jlong)map.size);
+    if (pixels_j) {
+        (*env)->CallVoidMethod(env, app, on_scrub_preview_id, (jlong)thumbnail->position_us, (jint)thumbnail->width,
+                               (jint)thumbnail->height, pixels_j);
+        (*env)->DeleteLocalRef(env, pixels_j);
+    }
+    gst_buffer_unmap(thumbnail->pixels, &map);
+}
+
+static void deliver_snapshot(JNIEnv *env, jobject app, RctGstEvent *event) {
+    jstring error_j = event->args.snapshot.error ? (*env)->NewStringUTF(env, event->args.snapshot.error) : NULL;
+    jstring path_j = event->args.snapshot.path ? (*env)->NewStringUTF(env, event->args.snapshot.path) : NULL;
+    jbyteArray data_j = NULL;
+
+    if (event->args.snapshot.bytes) {
+        gsize size;
+        gconstpointer data = g_bytes_get_data(event->args.snapshot.bytes, &size);
+        data_j = (*env)->NewByteArray(env, size);
+        (*env)->SetByteArrayRegion(env, data_j, 0, size, data);
+    }
+    (*env)->CallVoidMethod(env, app, on_snapshot_id, (jint)event->args.snapshot.id,
+                           (jboolean)event->args.snapshot.success, error_j, path_j, data_j,
+                           (jint)event->args.snapshot.width, (jint)event->args.snapshot.height,
+                           (jlong)event->args.snapshot.position_us);
+    if (error_j) {
+        (*env)->DeleteLocalRef(env, error_j);
+    }
+    if (path_j) {
+        (*env)->DeleteLocalRef(env, path_j);
+    }
+    if (data_j) {
+        (*env)->DeleteLocalRef(env, data_j);
+    }
+}
+
+static void deliver_event(JNIEnv *env, RctGstEvent *event) {
+    RctGstJniPlayer *jni_player = (RctGstJniPlayer *)event->target;
+    jobject app = jni_player->app;
+    jstring strings[3] = { NULL, NULL, NULL };
+    guint i;
+
+    switch (event->type) {
+        case RCT_GST_EVENT_INIT:
+            strings[0] = event->args.element_chain ? (*env)->NewStringUTF(env, event->args.element_chain) : NULL;
+            (*env)->CallVoidMethod(env, app, on_player_init_id, strings[0]);
+            break;
+
+        case RCT_GST_EVENT_STATE_CHANGED:
+            (*env)->CallVoidMethod(env, app, on_state_changed_id,
+                                   (jint)event->args.state.old_state, (jint)event->args.state.new_state);
+            break;
+
+        case RCT_GST_EVENT_URI_CHANGED:
+            strings[0] = (*env)->NewStringUTF(env, event->args.uri);
+            (*env)->CallVoidMethod(env, app, on_uri_changed_id, strings[0]);
+            break;
+
+        case RCT_GST_EVENT_EOS:
+            (*env)->CallVoidMethod(env, app, on_eos_id);
+            break;
+
+        case RCT_GST_EVENT_ELEMENT_ERROR:
+            strings[0] = (*env)->NewStringUTF(env, event->args.error.source);
+            strings[1] = (*env)->NewStringUTF(env, event->args.error.message);
+            strings[2] = (*env)->NewStringUTF(env, event->args.error.debug_info);
+            (*env)->CallVoidMethod(env, app, on_element_error_id, strings[0], strings[1], strings[2]);
+            break;
+
+        case RCT_GST_EVENT_FIRST_FRAME:
+            (*env)->CallVoidMethod(env, app, on_first_frame_id,
+                                   (jint)event->args.first_frame.mode, (jlong)event->args.first_frame.ttff_us,
+                                   (jint)event->args.first_frame.transport);
+            break;
+
+        case RCT_GST_EVENT_COMMAND_DONE:
+            (*env)->CallVoidMethod(env, app, on_command_done_id, (jint)event->args.command_done.command,
+                                   (jint)event->args.command_done.result, (jlong)event->args.command_done.latency_us);
+            break;
+
+        case RCT_GST_EVENT_RECONNECT:
+            (*env)->CallVoidMethod(env, app, on_reconnect_id, (jboolean)event->args.reconnect.degraded,
+                                   (jint)event->args.reconnect.errors, (jint)event->args.reconnect.stalls,
+                                   (jint)event->args.reconnect.attempts, (jint)event->args.reconnect.recoveries,
+                                   (jint)event->args.reconnect.consecutive_failures,
+                                   (jlong)event->args.reconnect.degraded_us, (jlong)event->args.reconnect.next_attempt_in_us);
+            break;
+
+        case RCT_GST_EVENT_STATS:
+            deliver_stats(env, app, event->args.stats);
+            break;
+
+        case RCT_GST_EVENT_VOLUME_CHANGED:
+            deliver_volume(env, app, event->args.volume.levels, event->args.volume.count);
+            break;
+
+        case RCT_GST_EVENT_QOS:
+            (*env)->CallVoidMethod(env, app, on_qos_id, (jint)event->args.qos.rung, (jint)event->args.qos.previous_rung,
+                                   (jint)event->args.qos.transitions, (jdouble)event->args.qos.late_ratio,
+                                   (jdouble)event->args.qos.queue_fill, (jlong)event->args.qos.frames_dropped_late,
+                                   (jlong)event->args.qos.frames_skipped);
+            break;
+
+        case RCT_GST_EVENT_DVR_EXPORT:
+            strings[0] = (*env)->NewStringUTF(env, event->args.dvr_export.path);
+            (*env)->CallVoidMethod(env, app, on_dvr_export_id, strings[0], (jboolean)event->args.dvr_export.success,
+                                   (jlong)event->args.dvr_export.duration_us);
+            break;
+
+        case RCT_GST_EVENT_SEEK_DONE:
+            (*env)->CallVoidMethod(env, app, on_seek_done_id, (jlong)event->args.seek_done.position_us,
+                                   (jlong)event->args.seek_done.duration_us, (jlong)event->args.seek_done.latency_us);
+            break;
+
+        case RCT_GST_EVENT_SCRUB_PREVIEW:
+            deliver_scrub_preview(env, app, &event->args.scrub_preview);
+            break;
+
+        case RCT_GST_EVENT_SNAPSHOT:
+            deliver_snapshot(env, app, event);
+            break;
+
+        case RCT_GST_EVENT_RELEASE:
+            // Nothing of this player is left in the channel
+            (*env)->DeleteGlobalRef(env, app);
+            g_free(jni_player);
+            break;
+    }
+
+    for (i = 0; i < G_N_ELEMENTS(strings); i++) {
+        if (strings[i]) {
+            (*env)->DeleteLocalRef(env, strings[i]);
+        }
+    }
+    // A throwing listener must not take the other events of the batch down with it
+    if ((*env)->ExceptionCheck(env)) {
+        (*env)->ExceptionDescribe(env);
+        (*env)->ExceptionClear(env);
+    }
 }
 
-static void native_rct_gst_init_and_run(JNIEnv* env, jobject thiz, jobject j_configuration) {
+// Blocks up to timeout_ms, then delivers one coalesced batch. Returns the number of events delivered.
+static jint native_rct_gst_drain_events(JNIEnv* env, jclass klass, jint timeout_ms) {
+    (void)klass;
+
+    RctGstEvent batch[EVENT_BATCH_SIZE];
+    guint count = rct_gst_event_channel_drain(events, batch, EVENT_BATCH_SIZE, (gint64)MAX(timeout_ms, 0) * 1000);
+    guint i;
+    jint delivered = 0;
+
+    for (i = 0; i < count; i++) {
+        if (!batch[i].dropped) {
+            deliver_event(env, &batch[i]);
+            delivered++;
+        }
+        rct_gst_event_clear(&batch[i]);
+    }
+    return delivered;
+}
+
+static void native_rct_gst_init_and_run(JNIEnv* env, jobject thiz, jlong handle, jobject j_configuration) {
+    (void)thiz;
+
     LOGD("Initializing and running GStreamer");
-    RctGstConfiguration* configuration = rct_gst_get_configuration();
+    RctGstPlayer *player = PLAYER_FROM_HANDLE(handle);
+    RctGstJniPlayer *jni_player = JNI_PLAYER(player);
+    RctGstConfiguration* configuration = rct_gst_get_configuration(player);
     jclass configuration_class = (*env)->GetObjectClass(env, j_configuration);
 
-    // Creating native code internal data gst_app_thread
-    app = (*env)->NewGlobalRef(env, thiz);
-
     // Defining initial drawable surface (ids)
     jfieldID ids_field_id = (*env)->GetFieldID(env, configuration_class, "initialDrawableSurface", "Landroid/view/Surface;");
     jobject surface = (*env)->GetObjectField(env, j_configuration, ids_field_id);
-    native_window = ANativeWindow_fromSurface(env, surface);
-    configuration->initialDrawableSurface = (guintptr)native_window;
-    LOGI("Initial drawable surface set: %p", native_window);
+    // Without a surface yet the first one comes through set_drawable_surface
+    ANativeWindow *native_window = surface != NULL ? ANativeWindow_fromSurface(env, surface) : NULL;
+    if (native_window != NULL) {
+        // Run again, the window the previous pipeline drew to is retired like on a surface change
+        if (jni_player->retired_native_window != NULL) {
+            ANativeWindow_release(jni_player->retired_native_window);
+        }
+        jni_player->retired_native_window = jni_player->native_window;
+        jni_player->native_window = native_window;
+    } else if (surface != NULL) {
+        LOGE("Failed to get native window from the initial surface");
+    }
+    configuration->initialDrawableSurface = (guintptr)jni_player->native_window;
+    LOGI("Initial drawable surface set: %p", jni_player->native_window);
 
-    // Getting all callbacks
-    jclass klass = (*env)->FindClass(env, "com/gstreamertest/RCTGstPlayerController");  // Updated path
-    on_player_init_id = (*env)->GetMethodID(env, klass, "onInit", "()V");
-    on_state_changed_id = (*env)->GetMethodID(env, klass, "onStateChanged", "(II)V");
-    on_uri_changed_id = (*env)->GetMethodID(env, klass, "onUriChanged", "(Ljava/lang/String;)V");
-    on_eos_id = (*env)->GetMethodID(env, klass, "onEOS", "()V");
-    on_element_error_id = (*env)->GetMethodID(env, klass, "onElementError", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+    jfieldID shared_decode_field_id = (*env)->GetFieldID(env, configuration_class, "sharedDecode", "Z");
+    configuration->sharedDecode = (*env)->GetBooleanField(env, j_configuration, shared_decode_field_id);
 
     configuration->onInit = native_on_init;
     configuration->onStateChanged = native_on_state_changed;
     configuration->onUriChanged = native_on_uri_changed;
     configuration->onEOS = native_on_eos;
     configuration->onElementError = native_on_element_error;
-
-    rct_gst_init(configuration);
-    LOGD("GStreamer initialized");
-
-    pthread_create(&gst_app_thread, NULL, (void *)&rct_gst_run_loop, NULL);
-    LOGD("GStreamer run loop started");
+    configuration->onFirstFrame = native_on_first_frame;
+    configuration->onCommandDone = native_on_command_done;
+    configuration->onReconnect = native_on_reconnect;
+    configuration->onStats = native_on_stats;
+    configuration->onVolumeChanged = native_on_volume_changed;
+    configuration->onQos = native_on_qos;
+    configuration->onDvrExport = native_on_dvr_export;
+    configuration->onSeekDone = native_on_seek_done;
+    configuration->onScrubPreview = native_on_scrub_preview;
+
+    // Returns right away, the pipeline is built on the player thread
+    rct_gst_init(player);
+    LOGD("GStreamer initialization posted");
 }
 
 static JNINativeMethod native_methods[] = {
     { "nativeRCTGstGetGStreamerInfo", "()Ljava/lang/String;", (void *) native_rct_gst_get_gstreamer_info },
-    { "nativeRCTGstInitAndRun", "(Lcom/gstreamertest/utils/RCTGstConfiguration;)V", (void *) native_rct_gst_init_and_run },
-    { "nativeRCTGstSetPipelineState", "(I)V", (void *) native_rct_gst_set_pipeline_state },
-    { "nativeRCTGstSetDrawableSurface", "(Landroid/view/Surface;)V", (void *) native_rct_gst_set_drawable_surface },
-    { "nativeRCTGstSetUri", "(Ljava/lang/String;)V", (void *) native_rct_gst_set_uri },
-    { "nativeRCTGstSetDebugging", "(Z)V", (void *) native_rct_gst_set_debugging }
+    { "nativeRCTGstGetElementChain", "(J)Ljava/lang/String;", (void *) native_rct_gst_get_element_chain },
+    { "nativeRCTGstPlayerNew", "()J", (void *) native_rct_gst_player_new },
+    { "nativeRCTGstPlayerFree", "(J)V", (void *) native_rct_gst_player_free },
+    { "nativeRCTGstInitAndRun", "(JLcom/gstreamertest/utils/RCTGstConfiguration;)V", (void *) native_rct_gst_init_and_run },
+    { "nativeRCTGstSetPipelineState", "(JI)V", (void *) native_rct_gst_set_pipeline_state },
+    { "nativeRCTGstSuspend", "(J)V", (void *) native_rct_gst_suspend },
+    { "nativeRCTGstResume", "(J)V", (void *) native_rct_gst_resume },
+    { "nativeRCTGstSetDrawableSurface", "(JLandroid/view/Surface;)V", (void *) native_rct_gst_set_drawable_surface },
+    { "nativeRCTGstSetSurfaceSize", "(JII)V", (void *) native_rct_gst_set_surface_size },
+    { "nativeRCTGstSetUri", "(JLjava/lang/String;)V", (void *) native_rct_gst_set_uri },
+    { "nativeRCTGstSetDebugging", "(JZ)V", (void *) native_rct_gst_set_debugging },
+    { "nativeRCTGstPrepareUri", "(JLjava/lang/String;)V", (void *) native_rct_gst_prepare_uri },
+    { "nativeRCTGstSetStandbyPool", "(JIJ)V", (void *) native_rct_gst_set_standby_pool },
+    { "nativeRCTGstSetReconnectPolicy", "(JIIDI)V", (void *) native_rct_gst_set_reconnect_policy },
+    { "nativeRCTGstSetStatsRefreshRate", "(JI)V", (void *) native_rct_gst_set_stats_refresh_rate },
+    { "nativeRCTGstSetQosPolicy", "(JII)V", (void *) native_rct_gst_set_qos_policy },
+    { "nativeRCTGstSetJitterPolicy", "(JIIID)V", (void *) native_rct_gst_set_jitter_policy },
+    { "nativeRCTGstSetTransportPolicy", "(JLjava/lang/String;IZ)V", (void *) native_rct_gst_set_transport_policy },
+    { "nativeRCTGstSetMosaicLayout", "(JII)V", (void *) native_rct_gst_set_mosaic_layout },
+    { "nativeRCTGstSetMosaicTile", "(JILjava/lang/String;)V", (void *) native_rct_gst_set_mosaic_tile },
+    { "nativeRCTGstSetDvrPolicy", "(JIJ)V", (void *) native_rct_gst_set_dvr_policy },
+    { "nativeRCTGstTimeshift", "(JI)V", (void *) native_rct_gst_timeshift },
+    { "nativeRCTGstExportClip", "(JLjava/lang/String;III)V", (void *) native_rct_gst_export_clip },
+    { "nativeRCTGstSetScrubCache", "(JJI)V", (void *) native_rct_gst_set_scrub_cache },
+    { "nativeRCTGstSeek", "(JJI)V", (void *) native_rct_gst_seek },
+    { "nativeRCTGstSetRate", "(JD)V", (void *) native_rct_gst_set_rate },
+    { "nativeRCTGstScrub", "(JJ)V", (void *) native_rct_gst_scrub },
+    { "nativeRCTGstSnapshot", "(JIIILjava/lang/String;)V", (void *) native_rct_gst_snapshot },
+    { "nativeRCTGstDumpGraph", "(JLjava/lang/String;)V", (void *) native_rct_gst_dump_graph },
+    { "nativeRCTGstSetLogLevel", "(Ljava/lang/String;)V", (void *) native_rct_gst_set_log_level },
+    { "nativeRCTGstSetAudioLevelRefreshRate", "(JI)V", (void *) native_rct_gst_set_audio_level_refresh_rate },
+    { "nativeRCTGstDrainEvents", "(I)I", (void *) native_rct_gst_drain_events }
 };
 
 // Called by JNI
 jint JNI_OnLoad(JavaVM *vm, void *reserved) {
     JNIEnv *env = NULL;
 
+    rct_gst_startup_mark(RCT_GST_STARTUP_LIBRARY_LOADED);
+
     // Storing global context
     jvm = vm;
 
@@ -234,7 +865,30 @@ jint JNI_OnLoad(JavaVM *vm, void *reserved) {
         return 0;
     }
 
-    pthread_key_create(&current_jni_env, detach_current_thread);
+    // Getting all callbacks, shared by every player instance
+    on_player_init_id = (*env)->GetMethodID(env, klass, "onInit", "(Ljava/lang/String;)V");
+    on_state_changed_id = (*env)->GetMethodID(env, klass, "onStateChanged", "(II)V");
+    on_uri_changed_id = (*env)->GetMethodID(env, klass, "onUriChanged", "(Ljava/lang/String;)V");
+    on_eos_id = (*env)->GetMethodID(env, klass, "onEOS", "()V");
+    on_element_error_id = (*env)->GetMethodID(env, klass, "onElementError", "(Ljava/lang/String;Ljava/lang/String;Ljava/lang/String;)V");
+    on_first_frame_id = (*env)->GetMethodID(env, klass, "onFirstFrame", "(IJI)V");
+    on_command_done_id = (*env)->GetMethodID(env, klass, "onCommandDone", "(IIJ)V");
+    on_reconnect_id = (*env)->GetMethodID(env, klass, "onReconnect", "(ZIIIIIJJ)V");
+    on_stats_id = (*env)->GetMethodID(env, klass, "onStats", "(JJJJJJDIZ[J)V");
+    on_volume_changed_id = (*env)->GetMethodID(env, klass, "onVolumeChanged", "([D[D[D)V");
+    on_qos_id = (*env)->GetMethodID(env, klass, "onQos", "(IIIDDJJ)V");
+    on_dvr_export_id = (*env)->GetMethodID(env, klass, "onDvrExport", "(Ljava/lang/String;ZJ)V");
+    on_seek_done_id = (*env)->GetMethodID(env, klass, "onSeekDone", "(JJJ)V");
+    on_scrub_preview_id = (*env)->GetMethodID(env, klass, "onScrubPreview", "(JIILjava/nio/ByteBuffer;)V");
+    on_snapshot_id = (*env)->GetMethodID(env, klass, "onSnapshot",
+                                         "(IZLjava/lang/String;Ljava/lang/String;[BIIJ)V");
+
+    events = rct_gst_event_channel_new(EVENT_CHANNEL_CAPACITY);
+
+#if RCT_GST_PREWARM
+    // Waits for GStreamer.init on its own thread, the first view finds the factories loaded
+    rct_gst_startup_prewarm();
+#endif
     LOGD("JNI_OnLoad completed");
 
     return JNI_VERSION_1_6;